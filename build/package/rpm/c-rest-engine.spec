@@ -9,8 +9,10 @@ URL:           http://www.github.com/vmware/c-rest-engine
 BuildArch:     x86_64
 BuildRequires: coreutils >= 8.22
 BuildRequires: openssl-devel >= 1.0.1
+BuildRequires: zlib-devel
 Requires:      coreutils >= 8.22
 Requires:      openssl >= 1.0.1
+Requires:      zlib
 
 %if "%{_debug}" == "1"
 %define __strip /bin/true
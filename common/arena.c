@@ -0,0 +1,381 @@
+/* C-REST-Engine
+*
+* Copyright (c) 2017 VMware, Inc. All Rights Reserved.
+*
+* This product is licensed to you under the Apache 2.0 license (the "License").
+* You may not use this product except in compliance with the Apache 2.0 License.
+*
+* This product may include a number of subcomponents with separate copyright
+* notices and license terms. Your use of these subcomponents is subject to the
+* terms and conditions of the subcomponent's license, as noted in the LICENSE file.
+*
+*/
+
+/**** Bump pointer arena, slabs of the base size are kept per thread and reused ****/
+
+#include "includes.h"
+
+#define VM_REST_ARENA_ROUND(n)       (((n) + (VM_REST_ARENA_ALIGN - 1)) & ~((size_t)VM_REST_ARENA_ALIGN - 1))
+#define VM_REST_ARENA_SLAB_HEADER    VM_REST_ARENA_ROUND(sizeof(VM_REST_ARENA_SLAB))
+
+typedef struct _VM_REST_ARENA_CACHE
+{
+    PVM_REST_ARENA_SLAB              pSlabs;
+    uint32_t                         nSlabs;
+
+} VM_REST_ARENA_CACHE, *PVM_REST_ARENA_CACHE;
+
+static pthread_once_t                    gArenaOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t                     gArenaCacheKey;
+
+static
+void
+VmRESTArenaCreateCacheKey(
+    void
+    );
+
+static
+void
+VmRESTArenaFreeCache(
+    void*                            pData
+    );
+
+static
+PVM_REST_ARENA_CACHE
+VmRESTArenaGetCache(
+    void
+    );
+
+static
+uint32_t
+VmRESTArenaGetSlab(
+    size_t                           nData,
+    PVM_REST_ARENA_SLAB*             ppSlab
+    );
+
+static
+void
+VmRESTArenaPutSlab(
+    PVM_REST_ARENA_SLAB              pSlab
+    );
+
+uint32_t
+VmRESTArenaCreate(
+    PVM_REST_ARENA*                  ppArena
+    )
+{
+    uint32_t                         dwError = 0;
+    PVM_REST_ARENA_SLAB              pSlab = NULL;
+    PVM_REST_ARENA                   pArena = NULL;
+
+    if (!ppArena)
+    {
+        dwError = EINVAL;
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    dwError = VmRESTArenaGetSlab(
+                  0,
+                  &pSlab
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    /**** Arena itself is the first allocation of its first slab ****/
+    pArena = (PVM_REST_ARENA)((char*)pSlab + VM_REST_ARENA_SLAB_HEADER);
+    pSlab->nUsed = VM_REST_ARENA_ROUND(sizeof(VM_REST_ARENA));
+    pArena->pSlab = pSlab;
+    pArena->pLast = NULL;
+
+    *ppArena = pArena;
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+uint32_t
+VmRESTArenaAllocate(
+    PVM_REST_ARENA                   pArena,
+    size_t                           nSize,
+    void**                           ppMemory
+    )
+{
+    uint32_t                         dwError = 0;
+    size_t                           nRounded = 0;
+    PVM_REST_ARENA_SLAB              pSlab = NULL;
+    void*                            pMemory = NULL;
+
+    if (!pArena || !nSize || !ppMemory)
+    {
+        dwError = EINVAL;
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    nRounded = VM_REST_ARENA_ROUND(nSize);
+    pSlab = pArena->pSlab;
+
+    if ((pSlab->nSize - pSlab->nUsed) < nRounded)
+    {
+        dwError = VmRESTArenaGetSlab(
+                      nRounded,
+                      &pSlab
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        if (pSlab->nSize > VM_REST_ARENA_SLAB_SIZE)
+        {
+            /**** Oversized slab holds this block only, keep bumping in the current one ****/
+            pSlab->pNext = pArena->pSlab->pNext;
+            pArena->pSlab->pNext = pSlab;
+        }
+        else
+        {
+            pSlab->pNext = pArena->pSlab;
+            pArena->pSlab = pSlab;
+        }
+    }
+
+    pMemory = (char*)pSlab + VM_REST_ARENA_SLAB_HEADER + pSlab->nUsed;
+    pSlab->nUsed += nRounded;
+
+    /**** Callers expect calloc semantics, reused slabs are not clean ****/
+    memset(pMemory, 0, nSize);
+
+    pArena->pLast = (pSlab == pArena->pSlab) ? pMemory : NULL;
+    *ppMemory = pMemory;
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+uint32_t
+VmRESTArenaReallocate(
+    PVM_REST_ARENA                   pArena,
+    void*                            pMemory,
+    size_t                           nOldSize,
+    size_t                           nNewSize,
+    void**                           ppNewMemory
+    )
+{
+    uint32_t                         dwError = 0;
+    size_t                           nOldRounded = 0;
+    size_t                           nNewRounded = 0;
+    PVM_REST_ARENA_SLAB              pSlab = NULL;
+    void*                            pNewMemory = NULL;
+
+    if (!pArena || !ppNewMemory || (nNewSize < nOldSize))
+    {
+        dwError = EINVAL;
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    if (!pMemory)
+    {
+        dwError = VmRESTArenaAllocate(
+                      pArena,
+                      nNewSize,
+                      ppNewMemory
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+        goto cleanup;
+    }
+
+    nOldRounded = VM_REST_ARENA_ROUND(nOldSize);
+    nNewRounded = VM_REST_ARENA_ROUND(nNewSize);
+    pSlab = pArena->pSlab;
+
+    /**** Last block of the current slab grows in place ****/
+    if ((pMemory == pArena->pLast) && ((pSlab->nSize - pSlab->nUsed) >= (nNewRounded - nOldRounded)))
+    {
+        pSlab->nUsed += (nNewRounded - nOldRounded);
+        memset((char*)pMemory + nOldSize, 0, (nNewSize - nOldSize));
+        *ppNewMemory = pMemory;
+        goto cleanup;
+    }
+
+    dwError = VmRESTArenaAllocate(
+                  pArena,
+                  nNewSize,
+                  &pNewMemory
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    memcpy(pNewMemory, pMemory, nOldSize);
+
+    *ppNewMemory = pNewMemory;
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+void
+VmRESTArenaFree(
+    PVM_REST_ARENA                   pArena
+    )
+{
+    PVM_REST_ARENA_SLAB              pSlab = NULL;
+    PVM_REST_ARENA_SLAB              pNext = NULL;
+
+    if (!pArena)
+    {
+        return;
+    }
+
+    /**** Arena lives in one of these slabs, do not touch it after this point ****/
+    pSlab = pArena->pSlab;
+    while (pSlab)
+    {
+        pNext = pSlab->pNext;
+        VmRESTArenaPutSlab(pSlab);
+        pSlab = pNext;
+    }
+}
+
+static
+void
+VmRESTArenaCreateCacheKey(
+    void
+    )
+{
+    pthread_key_create(&gArenaCacheKey, VmRESTArenaFreeCache);
+}
+
+static
+void
+VmRESTArenaFreeCache(
+    void*                            pData
+    )
+{
+    PVM_REST_ARENA_CACHE             pCache = (PVM_REST_ARENA_CACHE)pData;
+    PVM_REST_ARENA_SLAB              pSlab = NULL;
+
+    if (pCache)
+    {
+        while (pCache->pSlabs)
+        {
+            pSlab = pCache->pSlabs;
+            pCache->pSlabs = pSlab->pNext;
+            VmRESTFreeMemory(pSlab);
+        }
+        VmRESTFreeMemory(pCache);
+    }
+}
+
+static
+PVM_REST_ARENA_CACHE
+VmRESTArenaGetCache(
+    void
+    )
+{
+    PVM_REST_ARENA_CACHE             pCache = NULL;
+
+    pthread_once(&gArenaOnce, VmRESTArenaCreateCacheKey);
+
+    pCache = (PVM_REST_ARENA_CACHE)pthread_getspecific(gArenaCacheKey);
+    if (!pCache)
+    {
+        /**** No cache only means no reuse, allocation still works ****/
+        if (VmRESTAllocateMemory(sizeof(VM_REST_ARENA_CACHE), (void**)&pCache) != 0)
+        {
+            return NULL;
+        }
+        if (pthread_setspecific(gArenaCacheKey, pCache) != 0)
+        {
+            VmRESTFreeMemory(pCache);
+            return NULL;
+        }
+    }
+
+    return pCache;
+}
+
+static
+uint32_t
+VmRESTArenaGetSlab(
+    size_t                           nData,
+    PVM_REST_ARENA_SLAB*             ppSlab
+    )
+{
+    uint32_t                         dwError = 0;
+    size_t                           nSize = VM_REST_ARENA_SLAB_SIZE;
+    PVM_REST_ARENA_CACHE             pCache = NULL;
+    PVM_REST_ARENA_SLAB              pSlab = NULL;
+
+    if (nData > (VM_REST_ARENA_SLAB_SIZE / 2))
+    {
+        nSize = (nData > VM_REST_ARENA_SLAB_SIZE) ? nData : VM_REST_ARENA_SLAB_SIZE;
+    }
+
+    if (nSize == VM_REST_ARENA_SLAB_SIZE)
+    {
+        pCache = VmRESTArenaGetCache();
+        if (pCache && pCache->pSlabs)
+        {
+            pSlab = pCache->pSlabs;
+            pCache->pSlabs = pSlab->pNext;
+            pCache->nSlabs--;
+        }
+    }
+
+    if (!pSlab)
+    {
+        /**** Plain malloc, the arena clears what it hands out ****/
+        pSlab = (PVM_REST_ARENA_SLAB)malloc(VM_REST_ARENA_SLAB_HEADER + nSize);
+        if (!pSlab)
+        {
+            dwError = ENOMEM;
+            BAIL_ON_VMREST_ERROR(dwError);
+        }
+    }
+
+    pSlab->pNext = NULL;
+    pSlab->nSize = nSize;
+    pSlab->nUsed = 0;
+
+    *ppSlab = pSlab;
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+static
+void
+VmRESTArenaPutSlab(
+    PVM_REST_ARENA_SLAB              pSlab
+    )
+{
+    PVM_REST_ARENA_CACHE             pCache = NULL;
+
+    if (pSlab->nSize == VM_REST_ARENA_SLAB_SIZE)
+    {
+        pCache = VmRESTArenaGetCache();
+        if (pCache && (pCache->nSlabs < VM_REST_ARENA_CACHED_SLABS))
+        {
+            pSlab->pNext = pCache->pSlabs;
+            pCache->pSlabs = pSlab;
+            pCache->nSlabs++;
+            return;
+        }
+    }
+
+    VmRESTFreeMemory(pSlab);
+}
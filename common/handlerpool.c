@@ -0,0 +1,290 @@
+/* C-REST-Engine
+*
+* Copyright (c) 2017 VMware, Inc. All Rights Reserved.
+*
+* This product is licensed to you under the Apache 2.0 license (the "License").
+* You may not use this product except in compliance with the Apache 2.0 License.
+*
+* This product may include a number of subcomponents with separate copyright
+* notices and license terms. Your use of these subcomponents is subject to the
+* terms and conditions of the subcomponent's license, as noted in the LICENSE file.
+*
+*/
+
+/**** Bounded pool of threads running application callbacks for the I/O workers ****/
+
+#include "includes.h"
+
+static
+DWORD
+VmRESTHandlerThreadProc(
+    PVOID                            pData
+    );
+
+uint32_t
+VmRESTHandlerPoolStart(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVMREST_HANDLER_POOL*            ppPool
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    PVMREST_HANDLER_POOL             pPool = NULL;
+    uint32_t                         nThreads = 0;
+    uint32_t                         iThr = 0;
+
+    if (!pRESTHandle || !pRESTHandle->pRESTConfig || !ppPool)
+    {
+        dwError = ERROR_INVALID_PARAMETER;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    nThreads = pRESTHandle->pRESTConfig->nHandlerThr;
+
+    dwError = VmRESTAllocateMemory(
+                  sizeof(VMREST_HANDLER_POOL),
+                  (PVOID*)&pPool
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    pPool->pRESTHandle = pRESTHandle;
+    pPool->nSize = pRESTHandle->pRESTConfig->nHandlerQueueSize;
+
+    dwError = VmRESTAllocateMutex(&pPool->pMutex);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTAllocateCondition(&pPool->pCond);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTAllocateMemory(
+                  sizeof(VMREST_HANDLER_JOB) * pPool->nSize,
+                  (PVOID*)&pPool->pJobs
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTAllocateMemory(
+                  sizeof(VMREST_THREAD) * nThreads,
+                  (PVOID*)&pPool->pThreads
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    for (; iThr < nThreads; iThr++)
+    {
+        dwError = VmRESTCreateThread(
+                      &pPool->pThreads[iThr],
+                      FALSE,
+                      (PVMREST_START_ROUTINE)&VmRESTHandlerThreadProc,
+                      pPool
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        pPool->nThreads++;
+    }
+
+    VMREST_LOG_INFO(pRESTHandle,"C-REST-ENGINE: Started %u handler threads, queue size %u", pPool->nThreads, pPool->nSize);
+
+    *ppPool = pPool;
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    VMREST_LOG_ERROR(pRESTHandle,"Failed to start handler pool, dwError %u", dwError);
+
+    if (ppPool)
+    {
+        *ppPool = NULL;
+    }
+
+    VmRESTHandlerPoolFree(pPool);
+
+    goto cleanup;
+}
+
+uint32_t
+VmRESTHandlerPoolSubmit(
+    PVMREST_HANDLER_POOL             pPool,
+    PVM_SOCKET                       pSocket,
+    PREST_REQUEST                    pRequest,
+    BOOLEAN*                         pbQueued
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    BOOLEAN                          bLocked = FALSE;
+    PVMREST_HANDLER_JOB              pJob = NULL;
+
+    if (!pPool || !pSocket || !pRequest || !pbQueued)
+    {
+        dwError = ERROR_INVALID_PARAMETER;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    *pbQueued = FALSE;
+
+    dwError = VmRESTLockMutex(pPool->pMutex);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    bLocked = TRUE;
+
+    /**** Full or stopping pool, caller runs the callback itself ****/
+    if (pPool->bStop || (pPool->nQueued == pPool->nSize))
+    {
+        goto cleanup;
+    }
+
+    pJob = &pPool->pJobs[(pPool->iHead + pPool->nQueued) % pPool->nSize];
+    pJob->pSocket = pSocket;
+    pJob->pRequest = pRequest;
+    pPool->nQueued++;
+
+    dwError = VmRESTConditionSignal(pPool->pCond);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    *pbQueued = TRUE;
+
+cleanup:
+
+    if (bLocked)
+    {
+        VmRESTUnlockMutex(pPool->pMutex);
+    }
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+void
+VmRESTHandlerPoolStop(
+    PVMREST_HANDLER_POOL             pPool
+    )
+{
+    uint32_t                         iThr = 0;
+
+    if (!pPool || !pPool->pMutex)
+    {
+        return;
+    }
+
+    /**** Threads drain what is already queued before they exit ****/
+    VmRESTLockMutex(pPool->pMutex);
+    pPool->bStop = TRUE;
+    VmRESTConditionBroadcast(pPool->pCond);
+    VmRESTUnlockMutex(pPool->pMutex);
+
+    for (; iThr < pPool->nThreads; iThr++)
+    {
+        VmRESTThreadJoin(&pPool->pThreads[iThr], NULL);
+    }
+    pPool->nThreads = 0;
+}
+
+void
+VmRESTHandlerPoolFree(
+    PVMREST_HANDLER_POOL             pPool
+    )
+{
+    if (!pPool)
+    {
+        return;
+    }
+
+    VmRESTHandlerPoolStop(pPool);
+
+    if (pPool->pThreads)
+    {
+        VmRESTFreeMemory(pPool->pThreads);
+        pPool->pThreads = NULL;
+    }
+    if (pPool->pJobs)
+    {
+        VmRESTFreeMemory(pPool->pJobs);
+        pPool->pJobs = NULL;
+    }
+    if (pPool->pCond)
+    {
+        VmRESTFreeCondition(pPool->pCond);
+        pPool->pCond = NULL;
+    }
+    if (pPool->pMutex)
+    {
+        VmRESTFreeMutex(pPool->pMutex);
+        pPool->pMutex = NULL;
+    }
+
+    VmRESTFreeMemory(pPool);
+}
+
+static
+DWORD
+VmRESTHandlerThreadProc(
+    PVOID                            pData
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    PVMREST_HANDLER_POOL             pPool = (PVMREST_HANDLER_POOL)pData;
+    PVMREST_HANDLE                   pRESTHandle = pPool->pRESTHandle;
+    VMREST_HANDLER_JOB               job = {0};
+
+    dwError = VmwSockThreadInit(pRESTHandle);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    for (;;)
+    {
+        dwError = VmRESTLockMutex(pPool->pMutex);
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        while ((pPool->nQueued == 0) && !pPool->bStop)
+        {
+            VmRESTConditionWait(pPool->pCond, pPool->pMutex);
+        }
+
+        if (pPool->nQueued == 0)
+        {
+            VmRESTUnlockMutex(pPool->pMutex);
+            break;
+        }
+
+        job = pPool->pJobs[pPool->iHead];
+        pPool->iHead = (pPool->iHead + 1) % pPool->nSize;
+        pPool->nQueued--;
+
+        VmRESTUnlockMutex(pPool->pMutex);
+
+        /**** Socket is not watched while the callback runs, nothing else touches it ****/
+        dwError = VmRESTRunApplicationCallback(
+                      pRESTHandle,
+                      job.pRequest
+                      );
+        if (dwError == REST_ENGINE_RESPONSE_PENDING)
+        {
+            /**** Application completes the response, and posts it, on its own ****/
+            dwError = REST_ENGINE_SUCCESS;
+            continue;
+        }
+
+        /**** Keep alive, re-arm and free happen back on the owning I/O loop ****/
+        dwError = VmwSockPostCompletion(
+                      pRESTHandle,
+                      job.pSocket,
+                      job.pRequest
+                      );
+        if (dwError)
+        {
+            VMREST_LOG_ERROR(pRESTHandle,"Failed to hand completed request back to its event queue, dwError %u, closing connection", dwError);
+            VmRESTCommonDropRequest(
+                pRESTHandle,
+                job.pSocket,
+                job.pRequest
+                );
+            dwError = REST_ENGINE_SUCCESS;
+        }
+    }
+
+error:
+
+    return dwError;
+}
@@ -16,6 +16,20 @@
 #define NSECS_PER_MSEC        1000000
 #define EXTRA_LOG_MESSAGE_LEN 128
 #define MAX_LOG_MESSAGE_LEN   4096
+#define LOG_RECORD_ALIGN      8
+#define LOG_RECORD_PAD        (-1)
+#define LOG_FULL_WAIT_USEC    1000
+
+/**** One record in a log ring, message is NUL terminated and padded to LOG_RECORD_ALIGN ****/
+typedef struct _VMREST_LOG_RECORD
+{
+    uint32_t                         nSize;
+    int32_t                          level;
+    struct timeval                   tv;
+    unsigned long                    threadId;
+    char                             message[];
+
+} VMREST_LOG_RECORD, *PVMREST_LOG_RECORD;
 
 static const char *
 logLevelToTag(
@@ -28,6 +42,68 @@ logLevelToSysLogLevel(
     int                              level
     );
 
+static
+void
+VmRESTLogWrite(
+    PVMREST_HANDLE                   pRESTHandle,
+    int                              level,
+    struct timeval const*            pTv,
+    unsigned long                    threadId,
+    char const*                      pszMessage
+    );
+
+static
+uint32_t
+VmRESTAsyncLogStart(
+    PVMREST_HANDLE                   pRESTHandle
+    );
+
+static
+void
+VmRESTAsyncLogStop(
+    PVMREST_HANDLE                   pRESTHandle
+    );
+
+static
+DWORD
+VmRESTAsyncLogThreadProc(
+    PVOID                            pData
+    );
+
+static
+BOOLEAN
+VmRESTAsyncLogDrain(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVMREST_ASYNC_LOG                pAsyncLog
+    );
+
+static
+BOOLEAN
+VmRESTAsyncLogPush(
+    PVMREST_ASYNC_LOG                pAsyncLog,
+    int                              level,
+    struct timeval const*            pTv,
+    char const*                      pszMessage
+    );
+
+static
+void
+VmRESTAsyncLogWake(
+    PVMREST_ASYNC_LOG                pAsyncLog
+    );
+
+static
+PVMREST_LOG_RING
+VmRESTAsyncLogGetRing(
+    PVMREST_ASYNC_LOG                pAsyncLog
+    );
+
+static
+void
+VmRESTAsyncLogReleaseRing(
+    void*                            pData
+    );
+
 uint32_t
 VmRESTLogInitialize(
     PVMREST_HANDLE                   pRESTHandle
@@ -51,6 +127,14 @@ VmRESTLogInitialize(
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
+    if (pRESTHandle->pRESTConfig->useAsyncLog)
+    {
+        dwError = VmRESTAsyncLogStart(
+                      pRESTHandle
+                      );
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
 cleanup:
 
     return dwError;
@@ -66,6 +150,12 @@ VmRESTLogTerminate(
     PVMREST_HANDLE                   pRESTHandle
     )
 {
+    /**** Log thread writes everything still queued before the file goes away ****/
+    if (pRESTHandle && pRESTHandle->pAsyncLog != NULL)
+    {
+        VmRESTAsyncLogStop(pRESTHandle);
+    }
+
     if (pRESTHandle && pRESTHandle->logFile != NULL)
     {
        fclose(pRESTHandle->logFile);
@@ -80,14 +170,12 @@ VmRESTLog(
     const char*       fmt,
     ...)
 {
-    char        extraLogMessage[EXTRA_LOG_MESSAGE_LEN] = {0};
     char        logMessage[MAX_LOG_MESSAGE_LEN];
-    struct      tm* tm_info = NULL;
     struct      timeval tv = {0};
+    PVMREST_ASYNC_LOG pAsyncLog = NULL;
+    BOOLEAN     bQueued = FALSE;
 	
     va_list     va;
-    const char* logLevelTag = "";
-    int sysLogLevel = 0;
 
     if (!pRESTHandle || !pRESTHandle->pRESTConfig)
     {
@@ -102,23 +190,64 @@ VmRESTLog(
         va_end( va );
         gettimeofday(&tv, NULL);
 
-        tm_info = localtime(&tv.tv_sec);
-        logLevelTag = logLevelToTag(level);
-        strftime(extraLogMessage, sizeof(extraLogMessage) - 1, "%F %T", tm_info);   
-
-        if (pRESTHandle->pRESTConfig->useSysLog)
+        /**** Queued records are timestamped here, formatted and written by the log thread ****/
+        if (__atomic_load_n(&pRESTHandle->pAsyncLog, __ATOMIC_SEQ_CST) != NULL)
         {
-            sysLogLevel = logLevelToSysLogLevel(level);
-            syslog(sysLogLevel, "%s:%lu t@%lu %-3.7s: %s\n", extraLogMessage, (long unsigned)(tv.tv_usec), (unsigned long) pthread_self(),(logLevelTag? logLevelTag : "UNKNOWN"),logMessage);
+            /**** Stop waits for every user it may have raced with before the last drain ****/
+            __atomic_add_fetch(&pRESTHandle->nAsyncLogUsers, 1, __ATOMIC_SEQ_CST);
+            pAsyncLog = __atomic_load_n(&pRESTHandle->pAsyncLog, __ATOMIC_SEQ_CST);
+            if (pAsyncLog)
+            {
+                bQueued = VmRESTAsyncLogPush(pAsyncLog, level, &tv, logMessage);
+            }
+            __atomic_sub_fetch(&pRESTHandle->nAsyncLogUsers, 1, __ATOMIC_RELEASE);
+
+            if (bQueued)
+            {
+                return;
+            }
         }
-        else if (pRESTHandle->logFile != NULL)
+
+        VmRESTLogWrite(pRESTHandle, level, &tv, (unsigned long) pthread_self(), logMessage);
+
+        if (!pRESTHandle->pRESTConfig->useSysLog && pRESTHandle->logFile != NULL)
         {
-            fprintf(pRESTHandle->logFile, "%s:%lu t@%lu %-3.7s: %s\n", extraLogMessage, (long unsigned)(tv.tv_usec), (unsigned long) pthread_self(),(logLevelTag? logLevelTag : "UNKNOWN"),logMessage);
             fflush( pRESTHandle->logFile );
         }
     }
 }
 
+static
+void
+VmRESTLogWrite(
+    PVMREST_HANDLE                   pRESTHandle,
+    int                              level,
+    struct timeval const*            pTv,
+    unsigned long                    threadId,
+    char const*                      pszMessage
+    )
+{
+    char                             extraLogMessage[EXTRA_LOG_MESSAGE_LEN] = {0};
+    struct tm                        tmInfo = {0};
+    time_t                           sec = pTv->tv_sec;
+    const char*                      logLevelTag = "";
+    int                              sysLogLevel = 0;
+
+    localtime_r(&sec, &tmInfo);
+    logLevelTag = logLevelToTag(level);
+    strftime(extraLogMessage, sizeof(extraLogMessage) - 1, "%F %T", &tmInfo);
+
+    if (pRESTHandle->pRESTConfig->useSysLog)
+    {
+        sysLogLevel = logLevelToSysLogLevel(level);
+        syslog(sysLogLevel, "%s:%lu t@%lu %-3.7s: %s\n", extraLogMessage, (long unsigned)(pTv->tv_usec), threadId,(logLevelTag? logLevelTag : "UNKNOWN"),pszMessage);
+    }
+    else if (pRESTHandle->logFile != NULL)
+    {
+        fprintf(pRESTHandle->logFile, "%s:%lu t@%lu %-3.7s: %s\n", extraLogMessage, (long unsigned)(pTv->tv_usec), threadId,(logLevelTag? logLevelTag : "UNKNOWN"),pszMessage);
+    }
+}
+
 static const char *
 logLevelToTag(
     int level
@@ -158,4 +287,371 @@ logLevelToSysLogLevel(
    }
 }
 
+static
+uint32_t
+VmRESTAsyncLogStart(
+    PVMREST_HANDLE                   pRESTHandle
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    PVMREST_ASYNC_LOG                pAsyncLog = NULL;
+    BOOLEAN                          bKey = FALSE;
+    BOOLEAN                          bMutex = FALSE;
+    BOOLEAN                          bCond = FALSE;
+
+    dwError = VmRESTAllocateMemory(
+                  sizeof(VMREST_ASYNC_LOG),
+                  (void**)&pAsyncLog
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = pthread_key_create(&pAsyncLog->ringKey, VmRESTAsyncLogReleaseRing);
+    BAIL_ON_VMREST_ERROR(dwError);
+    bKey = TRUE;
+
+    dwError = pthread_mutex_init(&pAsyncLog->mutex, NULL);
+    BAIL_ON_VMREST_ERROR(dwError);
+    bMutex = TRUE;
+
+    dwError = pthread_cond_init(&pAsyncLog->cond, NULL);
+    BAIL_ON_VMREST_ERROR(dwError);
+    bCond = TRUE;
+
+    pAsyncLog->flushIntervalMSec = pRESTHandle->pRESTConfig->asyncLogFlushMSec;
+    pAsyncLog->bBlockOnFull = pRESTHandle->pRESTConfig->asyncLogBlockOnFull;
+    pAsyncLog->bStop = FALSE;
+    pAsyncLog->pRESTHandle = pRESTHandle;
+
+    /**** Visible before the thread starts, records queued meanwhile wait in the rings ****/
+    pRESTHandle->pAsyncLog = pAsyncLog;
+
+    dwError = VmRESTCreateThread(
+                  &pAsyncLog->thread,
+                  FALSE,
+                  VmRESTAsyncLogThreadProc,
+                  pAsyncLog
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    fprintf(stderr, "Async logging start failed, error code %u\n", dwError);
+    pRESTHandle->pAsyncLog = NULL;
+    if (pAsyncLog)
+    {
+        while (pAsyncLog->pRings)
+        {
+            PVMREST_LOG_RING         pRing = pAsyncLog->pRings;
+            pAsyncLog->pRings = pRing->pNext;
+            VmRESTFreeMemory(pRing);
+        }
+        if (bCond)
+        {
+            pthread_cond_destroy(&pAsyncLog->cond);
+        }
+        if (bMutex)
+        {
+            pthread_mutex_destroy(&pAsyncLog->mutex);
+        }
+        if (bKey)
+        {
+            pthread_key_delete(pAsyncLog->ringKey);
+        }
+        VmRESTFreeMemory(pAsyncLog);
+    }
+    dwError = REST_ENGINE_FAILURE;
+    goto cleanup;
+}
+
+static
+void
+VmRESTAsyncLogStop(
+    PVMREST_HANDLE                   pRESTHandle
+    )
+{
+    PVMREST_ASYNC_LOG                pAsyncLog = pRESTHandle->pAsyncLog;
+    PVMREST_LOG_RING                 pRing = NULL;
+
+    /**** Anything logged from here on is written synchronously ****/
+    __atomic_store_n(&pRESTHandle->pAsyncLog, NULL, __ATOMIC_SEQ_CST);
+
+    /**** Records pushed by loggers that still saw the queue land before the last drain ****/
+    while (__atomic_load_n(&pRESTHandle->nAsyncLogUsers, __ATOMIC_ACQUIRE) != 0)
+    {
+        usleep(LOG_FULL_WAIT_USEC);
+    }
+
+    pthread_mutex_lock(&pAsyncLog->mutex);
+    __atomic_store_n(&pAsyncLog->bStop, TRUE, __ATOMIC_RELAXED);
+    pthread_cond_signal(&pAsyncLog->cond);
+    pthread_mutex_unlock(&pAsyncLog->mutex);
+
+    VmRESTThreadJoin(&pAsyncLog->thread, NULL);
+
+    pthread_key_delete(pAsyncLog->ringKey);
+
+    while (pAsyncLog->pRings)
+    {
+        pRing = pAsyncLog->pRings;
+        pAsyncLog->pRings = pRing->pNext;
+        VmRESTFreeMemory(pRing);
+    }
 
+    pthread_cond_destroy(&pAsyncLog->cond);
+    pthread_mutex_destroy(&pAsyncLog->mutex);
+    VmRESTFreeMemory(pAsyncLog);
+}
+
+static
+DWORD
+VmRESTAsyncLogThreadProc(
+    PVOID                            pData
+    )
+{
+    PVMREST_ASYNC_LOG                pAsyncLog = (PVMREST_ASYNC_LOG)pData;
+    PVMREST_HANDLE                   pRESTHandle = pAsyncLog->pRESTHandle;
+    struct timespec                  ts = {0};
+    BOOLEAN                          bStop = FALSE;
+
+    while (!bStop)
+    {
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += pAsyncLog->flushIntervalMSec / 1000;
+        ts.tv_nsec += (long)(pAsyncLog->flushIntervalMSec % 1000) * NSECS_PER_MSEC;
+        if (ts.tv_nsec >= 1000000000L)
+        {
+            ts.tv_sec++;
+            ts.tv_nsec -= 1000000000L;
+        }
+
+        pthread_mutex_lock(&pAsyncLog->mutex);
+        if (!pAsyncLog->bStop && !__atomic_load_n(&pAsyncLog->bWakeup, __ATOMIC_RELAXED))
+        {
+            pthread_cond_timedwait(&pAsyncLog->cond, &pAsyncLog->mutex, &ts);
+        }
+        bStop = pAsyncLog->bStop;
+        pthread_mutex_unlock(&pAsyncLog->mutex);
+
+        __atomic_store_n(&pAsyncLog->bWakeup, 0, __ATOMIC_RELAXED);
+
+        /**** One flush per batch, the last pass runs after stop was requested ****/
+        if (VmRESTAsyncLogDrain(pRESTHandle, pAsyncLog) &&
+            !pRESTHandle->pRESTConfig->useSysLog && pRESTHandle->logFile != NULL)
+        {
+            fflush(pRESTHandle->logFile);
+        }
+    }
+
+    return 0;
+}
+
+static
+BOOLEAN
+VmRESTAsyncLogDrain(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVMREST_ASYNC_LOG                pAsyncLog
+    )
+{
+    PVMREST_LOG_RING                 pRing = NULL;
+    PVMREST_LOG_RECORD               pRecord = NULL;
+    uint64_t                         head = 0;
+    uint64_t                         tail = 0;
+    uint64_t                         dropped = 0;
+    char                             dropMessage[EXTRA_LOG_MESSAGE_LEN] = {0};
+    struct timeval                   tv = {0};
+    BOOLEAN                          bWritten = FALSE;
+
+    pRing = __atomic_load_n(&pAsyncLog->pRings, __ATOMIC_ACQUIRE);
+    while (pRing)
+    {
+        tail = pRing->tail;
+        head = __atomic_load_n(&pRing->head, __ATOMIC_ACQUIRE);
+
+        while (tail != head)
+        {
+            pRecord = (PVMREST_LOG_RECORD)(pRing->buffer + (tail % VMREST_LOG_RING_SIZE));
+            if (pRecord->level != LOG_RECORD_PAD)
+            {
+                VmRESTLogWrite(pRESTHandle, pRecord->level, &pRecord->tv, pRecord->threadId, pRecord->message);
+                bWritten = TRUE;
+            }
+            tail += pRecord->nSize;
+        }
+
+        /**** Space goes back to the producer only after its records are written ****/
+        __atomic_store_n(&pRing->tail, tail, __ATOMIC_RELEASE);
+
+        dropped = __atomic_exchange_n(&pRing->dropped, 0, __ATOMIC_RELAXED);
+        if (dropped > 0)
+        {
+            gettimeofday(&tv, NULL);
+            snprintf(dropMessage, sizeof(dropMessage), "%llu log records dropped, log ring full", (unsigned long long)dropped);
+            VmRESTLogWrite(pRESTHandle, VMREST_LOG_LEVEL_WARNING, &tv, (unsigned long) pthread_self(), dropMessage);
+            bWritten = TRUE;
+        }
+
+        pRing = pRing->pNext;
+    }
+
+    return bWritten;
+}
+
+/**** FALSE when the record could not be queued and should be written synchronously ****/
+static
+BOOLEAN
+VmRESTAsyncLogPush(
+    PVMREST_ASYNC_LOG                pAsyncLog,
+    int                              level,
+    struct timeval const*            pTv,
+    char const*                      pszMessage
+    )
+{
+    PVMREST_LOG_RING                 pRing = NULL;
+    PVMREST_LOG_RECORD               pRecord = NULL;
+    size_t                           nMessage = strlen(pszMessage);
+    uint32_t                         nSize = 0;
+    uint32_t                         nContiguous = 0;
+    uint32_t                         nNeeded = 0;
+    uint64_t                         head = 0;
+    uint64_t                         tail = 0;
+
+    pRing = VmRESTAsyncLogGetRing(pAsyncLog);
+    if (!pRing)
+    {
+        return FALSE;
+    }
+
+    nSize = (uint32_t)((sizeof(VMREST_LOG_RECORD) + nMessage + 1 + (LOG_RECORD_ALIGN - 1)) & ~(LOG_RECORD_ALIGN - 1));
+    head = pRing->head;
+
+    /**** A record never wraps, the rest of the ring is skipped with a pad record ****/
+    nContiguous = (uint32_t)(VMREST_LOG_RING_SIZE - (head % VMREST_LOG_RING_SIZE));
+    nNeeded = (nContiguous < nSize) ? (nContiguous + nSize) : nSize;
+
+    for (;;)
+    {
+        tail = __atomic_load_n(&pRing->tail, __ATOMIC_ACQUIRE);
+        if ((VMREST_LOG_RING_SIZE - (head - tail)) >= nNeeded)
+        {
+            break;
+        }
+
+        if (!pAsyncLog->bBlockOnFull || __atomic_load_n(&pAsyncLog->bStop, __ATOMIC_RELAXED))
+        {
+            __atomic_add_fetch(&pRing->dropped, 1, __ATOMIC_RELAXED);
+            return TRUE;
+        }
+
+        /**** Block policy, wake the log thread and wait for it to make room ****/
+        VmRESTAsyncLogWake(pAsyncLog);
+        usleep(LOG_FULL_WAIT_USEC);
+    }
+
+    if (nContiguous < nSize)
+    {
+        pRecord = (PVMREST_LOG_RECORD)(pRing->buffer + (head % VMREST_LOG_RING_SIZE));
+        pRecord->nSize = nContiguous;
+        pRecord->level = LOG_RECORD_PAD;
+        head += nContiguous;
+    }
+
+    pRecord = (PVMREST_LOG_RECORD)(pRing->buffer + (head % VMREST_LOG_RING_SIZE));
+    pRecord->nSize = nSize;
+    pRecord->level = level;
+    pRecord->tv = *pTv;
+    pRecord->threadId = (unsigned long) pthread_self();
+    memcpy(pRecord->message, pszMessage, nMessage + 1);
+
+    __atomic_store_n(&pRing->head, (head + nSize), __ATOMIC_RELEASE);
+
+    /**** Drain early once a ring is half full rather than wait out the interval ****/
+    if ((head + nSize - tail) > (VMREST_LOG_RING_SIZE / 2))
+    {
+        VmRESTAsyncLogWake(pAsyncLog);
+    }
+
+    return TRUE;
+}
+
+/**** At most one signal per drain pass, producers stay off the mutex otherwise ****/
+static
+void
+VmRESTAsyncLogWake(
+    PVMREST_ASYNC_LOG                pAsyncLog
+    )
+{
+    if (__atomic_exchange_n(&pAsyncLog->bWakeup, 1, __ATOMIC_RELAXED) == 0)
+    {
+        pthread_mutex_lock(&pAsyncLog->mutex);
+        pthread_cond_signal(&pAsyncLog->cond);
+        pthread_mutex_unlock(&pAsyncLog->mutex);
+    }
+}
+
+static
+PVMREST_LOG_RING
+VmRESTAsyncLogGetRing(
+    PVMREST_ASYNC_LOG                pAsyncLog
+    )
+{
+    PVMREST_LOG_RING                 pRing = NULL;
+    uint32_t                         bFree = 0;
+
+    pRing = (PVMREST_LOG_RING)pthread_getspecific(pAsyncLog->ringKey);
+    if (pRing)
+    {
+        return pRing;
+    }
+
+    /**** Rings of exited threads are reused, records they left behind are still drained ****/
+    pRing = __atomic_load_n(&pAsyncLog->pRings, __ATOMIC_ACQUIRE);
+    while (pRing)
+    {
+        bFree = 0;
+        if (__atomic_compare_exchange_n(&pRing->bInUse, &bFree, 1, FALSE, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        {
+            break;
+        }
+        pRing = pRing->pNext;
+    }
+
+    if (!pRing)
+    {
+        if (VmRESTAllocateMemory(sizeof(VMREST_LOG_RING), (void**)&pRing) != 0)
+        {
+            return NULL;
+        }
+        pRing->bInUse = 1;
+
+        pRing->pNext = __atomic_load_n(&pAsyncLog->pRings, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&pAsyncLog->pRings, &pRing->pNext, pRing, FALSE, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        {
+        }
+    }
+
+    if (pthread_setspecific(pAsyncLog->ringKey, pRing) != 0)
+    {
+        __atomic_store_n(&pRing->bInUse, 0, __ATOMIC_RELEASE);
+        return NULL;
+    }
+
+    return pRing;
+}
+
+static
+void
+VmRESTAsyncLogReleaseRing(
+    void*                            pData
+    )
+{
+    PVMREST_LOG_RING                 pRing = (PVMREST_LOG_RING)pData;
+
+    if (pRing)
+    {
+        __atomic_store_n(&pRing->bInUse, 0, __ATOMIC_RELEASE);
+    }
+}
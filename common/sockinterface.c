@@ -21,6 +21,22 @@ VmRESTSockContextFree(
     uint32_t                         waitSeconds
     );
 
+static
+DWORD
+VmRESTStartReactor(
+    PVMREST_HANDLE                   pRESTHandle,
+    DWORD                            dwFlags,
+    PVMREST_SOCK_REACTOR             pReactor
+    );
+
+static
+DWORD
+VmRESTStopReactor(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVMREST_SOCK_REACTOR             pReactor,
+    uint32_t                         waitSecond
+    );
+
 static
 DWORD
 VmRESTHandleSocketEvent(
@@ -65,6 +81,13 @@ VmRESTOnConnectionTimeout(
     PVM_SOCKET                       pSocket
     );
 
+static
+DWORD
+VmRESTOnRequestCompleted(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket
+    );
+
 DWORD
 VmRESTInitProtocolServer(
     PVMREST_HANDLE                   pRESTHandle
@@ -109,8 +132,8 @@ VmRESTStartProtocolServer(
     DWORD                            dwFlags = VM_SOCK_CREATE_FLAGS_REUSE_ADDR |
                                                VM_SOCK_CREATE_FLAGS_NON_BLOCK;
     DWORD                            iThr = 0;
+    DWORD                            iReactor = 0;
     PVM_WORKER_THREAD_DATA           pThreadData = NULL;
-    BOOLEAN                          bNoIpV6 = FALSE;
 
     if (!pRESTHandle || !(pRESTHandle->pRESTConfig))
     {
@@ -124,56 +147,43 @@ VmRESTStartProtocolServer(
     dwError = VmRESTAllocateMutex(&pSockContext->pMutex);
     BAIL_ON_VMREST_ERROR(dwError);
 
-    /**** Handle IPv4 case ****/
-
-    dwError = VmwSockStartServer(
-                         pRESTHandle,
-                        dwFlags | VM_SOCK_CREATE_FLAGS_TCP |
-                                  VM_SOCK_CREATE_FLAGS_IPV4,
-                        &pSockContext->pListenerTCP
-                        );
-    BAIL_ON_VMREST_ERROR(dwError);
-
-#ifdef AF_INET6
-    /**** Handle IPv6 case ****/
-
-    dwError = VmwSockStartServer(
-                   pRESTHandle,
-                   dwFlags | VM_SOCK_CREATE_FLAGS_TCP |
-                          VM_SOCK_CREATE_FLAGS_IPV6,
-                   &pSockContext->pListenerTCP6
-                   );
-    if (dwError != REST_ENGINE_SUCCESS)
+    /**** Handler pool comes first, I/O workers hand requests to it as soon as they run ****/
+    if (pRESTHandle->pRESTConfig->nHandlerThr > 0)
     {
-        VMREST_LOG_WARNING(pRESTHandle,"%s","Problem in IpV6 configuation.. Server listening ONLY on IPv4 Address !!");
-        bNoIpV6 = TRUE;
+        dwError = VmRESTHandlerPoolStart(
+                      pRESTHandle,
+                      &pSockContext->pHandlerPool
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
     }
-#endif
 
-    dwError = VmwSockCreateEventQueue(
-                  pRESTHandle,
-                  &pSockContext->pEventQueue
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
+    /**** Per worker reactor: each worker gets its own SO_REUSEPORT listener and event queue ****/
+    if (pRESTHandle->pRESTConfig->usePerWorkerReactor)
+    {
+        VMREST_LOG_INFO(pRESTHandle,"C-REST-ENGINE: Starting %u per worker reactors", pRESTHandle->pRESTConfig->nWorkerThr);
+        dwFlags |= VM_SOCK_CREATE_FLAGS_REUSE_PORT;
+        pSockContext->dwNumReactors = pRESTHandle->pRESTConfig->nWorkerThr;
+    }
+    else
+    {
+        pSockContext->dwNumReactors = 1;
+    }
 
-    dwError = VmwSockAddEventToQueueInLock(
-                  pRESTHandle,
-                  pSockContext->pEventQueue,
-                  pSockContext->pListenerTCP
+    dwError = VmRESTAllocateMemory(
+                  sizeof(VMREST_SOCK_REACTOR) * pSockContext->dwNumReactors,
+                  (PVOID*)&pSockContext->pReactors
                   );
     BAIL_ON_VMREST_ERROR(dwError);
 
-#ifdef AF_INET6
-    if (!bNoIpV6)
+    for (; iReactor < pSockContext->dwNumReactors; iReactor++)
     {
-        dwError = VmwSockAddEventToQueueInLock(
+        dwError = VmRESTStartReactor(
                       pRESTHandle,
-                      pSockContext->pEventQueue,
-                      pSockContext->pListenerTCP6
+                      dwFlags,
+                      &pSockContext->pReactors[iReactor]
                       );
         BAIL_ON_VMREST_ERROR(dwError);
     }
-#endif
 
     dwError = VmRESTAllocateMemory(
                   sizeof(PVMREST_THREAD) * ((int)(pRESTHandle->pRESTConfig->nWorkerThr)),
@@ -191,6 +201,7 @@ VmRESTStartProtocolServer(
                   );
         BAIL_ON_VMREST_ERROR(dwError);
         pThreadData->pSockContext = pSockContext;
+        pThreadData->pReactor = &pSockContext->pReactors[iThr % pSockContext->dwNumReactors];
         pThreadData-> pRESTHandle =  pRESTHandle;
 
         dwError = VmRESTAllocateMemory(
@@ -210,9 +221,6 @@ VmRESTStartProtocolServer(
         pThreadData = NULL;
     }
 
-     pRESTHandle->pSockContext = pSockContext;
-
-
 cleanup:
 
     return dwError;
@@ -276,13 +284,13 @@ VmRESTSockWorkerThreadProc(
     DWORD                            dwError = 0;
     PVM_WORKER_THREAD_DATA           pWorkerData = (PVM_WORKER_THREAD_DATA)pData;
     PVMREST_HANDLE                   pRESTHandle = NULL;
-    PVMREST_SOCK_CONTEXT             pSockContext = NULL;
+    PVM_SOCK_EVENT_QUEUE             pEventQueue = NULL;
     PVM_SOCKET                       pSocket = NULL;
 
     if (pWorkerData != NULL)
     {
         pRESTHandle = pWorkerData-> pRESTHandle;
-        pSockContext = pWorkerData->pSockContext;
+        pEventQueue = pWorkerData->pReactor->pEventQueue;
         VmRESTFreeMemory(pWorkerData);
         pWorkerData = NULL;
     }
@@ -291,13 +299,16 @@ VmRESTSockWorkerThreadProc(
         return NULL;
     }
 
+    dwError = VmwSockThreadInit(pRESTHandle);
+    BAIL_ON_VMREST_ERROR(dwError);
+
     for(;;)
     {
         VM_SOCK_EVENT_TYPE eventType = VM_SOCK_EVENT_TYPE_UNKNOWN;
 
         dwError = VmwSockWaitForEvent(
                         pRESTHandle,
-                        pSockContext->pEventQueue,
+                        pEventQueue,
                         -1,
                         &pSocket,
                         &eventType);
@@ -310,7 +321,7 @@ VmRESTSockWorkerThreadProc(
                          pRESTHandle,
                         pSocket,
                         eventType,
-                        pSockContext->pEventQueue,
+                        pEventQueue,
                         dwError);
 
         if (dwError == ERROR_SUCCESS ||
@@ -381,6 +392,15 @@ VmRESTHandleSocketEvent(
              BAIL_ON_VMREST_ERROR(dwError);
              break;
 
+        case VM_SOCK_EVENT_TYPE_REQUEST_COMPLETED:
+             VMREST_LOG_DEBUG(pRESTHandle,"%s","EVENT-HANDLER: Handler thread completed request");
+             dwError = VmRESTOnRequestCompleted(
+                          pRESTHandle,
+                          pSocket
+                          );
+             BAIL_ON_VMREST_ERROR(dwError);
+             break;
+
         case VM_SOCK_EVENT_TYPE_UNKNOWN:
              VMREST_LOG_DEBUG(pRESTHandle,"%s","EVENT-HANDLER: Unknown Socket Event, do nothing");
              break;
@@ -477,6 +497,7 @@ VmRESTTcpReceiveNewData(
     uint32_t                         nBufLen = 0;
     BOOLEAN                          bNextIO = FALSE;
     BOOLEAN                          bKeepConnOpen = FALSE;
+    BOOLEAN                          bQueued = FALSE;
 
     if (!pSocket || !pRESTHandle || !pQueue)
     {
@@ -526,6 +547,13 @@ VmRESTTcpReceiveNewData(
             bNextIO = TRUE;
             dwError = REST_ENGINE_SUCCESS;
         }
+        else if ((dwError == VMREST_APPLICATION_CB_QUEUED) || (dwError == REST_ENGINE_RESPONSE_PENDING))
+        {
+            /**** Socket and request come back with a completion event ****/
+            bQueued = TRUE;
+            dwError = REST_ENGINE_SUCCESS;
+            goto cleanup;
+        }
         BAIL_ON_VMREST_ERROR(dwError);
     }
     else if (nBufLen == 0)
@@ -567,7 +595,7 @@ VmRESTTcpReceiveNewData(
 
 cleanup:
 
-    if (!bNextIO && dwError != REST_ENGINE_ERROR_DOUBLE_FAILURE)
+    if (!bNextIO && !bQueued && dwError != REST_ENGINE_ERROR_DOUBLE_FAILURE)
     {
 
         if (!bKeepConnOpen)
@@ -600,6 +628,79 @@ error:
     goto cleanup;
 }
 
+static
+DWORD
+VmRESTOnRequestCompleted(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    PREST_REQUEST                    pRequest = NULL;
+    BOOLEAN                          bKeepConnOpen = FALSE;
+
+    dwError = VmwSockGetRequestHandle(
+                  pRESTHandle,
+                  pSocket,
+                  &pRequest
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    if (pRequest == NULL)
+    {
+        dwError = ERROR_INVALID_STATE;
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    /**** Same tail as an inline callback, on the I/O thread that owns the socket ****/
+    dwError = VmRESTEntertainPersistentConn(
+                  pRESTHandle,
+                  pRequest,
+                  &bKeepConnOpen
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmwSockSetRequestHandle(
+                  pRESTHandle,
+                  pSocket,
+                  NULL,
+                  0,
+                  bKeepConnOpen
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+cleanup:
+
+    if (dwError != REST_ENGINE_ERROR_DOUBLE_FAILURE)
+    {
+        if (!bKeepConnOpen)
+        {
+            VMREST_LOG_DEBUG(pRESTHandle,"%s","Calling closed connection....");
+            VmRESTDisconnectClient(
+                pRESTHandle,
+                pSocket
+                );
+        }
+
+        if (pRequest)
+        {
+            VmRESTFreeRequestHandle(
+                pRESTHandle,
+                pRequest
+                );
+            pRequest = NULL;
+        }
+    }
+
+    return dwError;
+
+error:
+
+    VMREST_LOG_ERROR(pRESTHandle,"ERROR code %u", dwError);
+
+    goto cleanup;
+}
+
 static
 uint32_t
 VmRESTSockContextFree(
@@ -609,6 +710,7 @@ VmRESTSockContextFree(
     )
 {
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    DWORD                            iReactor = 0;
 
     if (!pRESTHandle || !pSockContext)
     {
@@ -616,42 +718,30 @@ VmRESTSockContextFree(
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
+    /**** Let queued callbacks finish, workers still take their completions and run new requests inline ****/
+    VmRESTHandlerPoolStop(pSockContext->pHandlerPool);
 
-    if (pSockContext->pListenerTCP)
-    {
-        dwError = VmwSockDeleteEventFromQueue(
-                      pRESTHandle,
-                      pSockContext->pEventQueue,
-                      pSockContext->pListenerTCP
-                      );
-        BAIL_ON_VMREST_ERROR(dwError);
-        VmwSockClose( pRESTHandle, pSockContext->pListenerTCP);
-    }
-    if (pSockContext->pListenerTCP6)
-    {
-        dwError = VmwSockDeleteEventFromQueue(
-                      pRESTHandle,
-                      pSockContext->pEventQueue,
-                      pSockContext->pListenerTCP6
-                      );
-        BAIL_ON_VMREST_ERROR(dwError);
-        VmwSockClose( pRESTHandle, pSockContext->pListenerTCP6);
-    }
-
-    if (pSockContext->pEventQueue)
+    if (pSockContext->pReactors)
     {
-        dwError = VmwSockCloseEventQueue(pRESTHandle, pSockContext->pEventQueue, waitSecond);
-    }
-    BAIL_ON_VMREST_ERROR(dwError);
+        for (; iReactor < pSockContext->dwNumReactors; iReactor++)
+        {
+            dwError = VmRESTStopReactor(
+                          pRESTHandle,
+                          &pSockContext->pReactors[iReactor],
+                          waitSecond
+                          );
+            BAIL_ON_VMREST_ERROR(dwError);
+        }
 
-    if (pSockContext->pListenerTCP)
-    {
-        VmwSockRelease( pRESTHandle, pSockContext->pListenerTCP);
+        VmRESTFreeMemory(pSockContext->pReactors);
+        pSockContext->pReactors = NULL;
+        pSockContext->dwNumReactors = 0;
     }
 
-    if (pSockContext->pListenerTCP6)
+    if (pSockContext->pHandlerPool)
     {
-        VmwSockRelease( pRESTHandle, pSockContext->pListenerTCP6);
+        VmRESTHandlerPoolFree(pSockContext->pHandlerPool);
+        pSockContext->pHandlerPool = NULL;
     }
 
     if (pSockContext->pWorkerThreads)
@@ -685,6 +775,136 @@ error:
 
 }
 
+static
+DWORD
+VmRESTStartReactor(
+    PVMREST_HANDLE                   pRESTHandle,
+    DWORD                            dwFlags,
+    PVMREST_SOCK_REACTOR             pReactor
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    BOOLEAN                          bNoIpV6 = FALSE;
+
+    /**** Handle IPv4 case ****/
+
+    dwError = VmwSockStartServer(
+                         pRESTHandle,
+                        dwFlags | VM_SOCK_CREATE_FLAGS_TCP |
+                                  VM_SOCK_CREATE_FLAGS_IPV4,
+                        &pReactor->pListenerTCP
+                        );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+#ifdef AF_INET6
+    /**** Handle IPv6 case ****/
+
+    dwError = VmwSockStartServer(
+                   pRESTHandle,
+                   dwFlags | VM_SOCK_CREATE_FLAGS_TCP |
+                          VM_SOCK_CREATE_FLAGS_IPV6,
+                   &pReactor->pListenerTCP6
+                   );
+    if (dwError != REST_ENGINE_SUCCESS)
+    {
+        VMREST_LOG_WARNING(pRESTHandle,"%s","Problem in IpV6 configuation.. Server listening ONLY on IPv4 Address !!");
+        bNoIpV6 = TRUE;
+    }
+#endif
+
+    dwError = VmwSockCreateEventQueue(
+                  pRESTHandle,
+                  &pReactor->pEventQueue
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmwSockAddEventToQueueInLock(
+                  pRESTHandle,
+                  pReactor->pEventQueue,
+                  pReactor->pListenerTCP
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+#ifdef AF_INET6
+    if (!bNoIpV6)
+    {
+        dwError = VmwSockAddEventToQueueInLock(
+                      pRESTHandle,
+                      pReactor->pEventQueue,
+                      pReactor->pListenerTCP6
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+#endif
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+static
+DWORD
+VmRESTStopReactor(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVMREST_SOCK_REACTOR             pReactor,
+    uint32_t                         waitSecond
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+
+    if (pReactor->pListenerTCP)
+    {
+        dwError = VmwSockDeleteEventFromQueue(
+                      pRESTHandle,
+                      pReactor->pEventQueue,
+                      pReactor->pListenerTCP
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+        VmwSockClose( pRESTHandle, pReactor->pListenerTCP);
+    }
+    if (pReactor->pListenerTCP6)
+    {
+        dwError = VmwSockDeleteEventFromQueue(
+                      pRESTHandle,
+                      pReactor->pEventQueue,
+                      pReactor->pListenerTCP6
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+        VmwSockClose( pRESTHandle, pReactor->pListenerTCP6);
+    }
+
+    if (pReactor->pEventQueue)
+    {
+        dwError = VmwSockCloseEventQueue(pRESTHandle, pReactor->pEventQueue, waitSecond);
+        pReactor->pEventQueue = NULL;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    if (pReactor->pListenerTCP)
+    {
+        VmwSockRelease( pRESTHandle, pReactor->pListenerTCP);
+        pReactor->pListenerTCP = NULL;
+    }
+
+    if (pReactor->pListenerTCP6)
+    {
+        VmwSockRelease( pRESTHandle, pReactor->pListenerTCP6);
+        pReactor->pListenerTCP6 = NULL;
+    }
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
 static
 DWORD
 VmRESTDisconnectClient(
@@ -712,6 +932,33 @@ error:
     goto cleanup;
 }
 
+/**** Completion could not be posted, end the connection here the way the I/O loop would ****/
+void
+VmRESTCommonDropRequest(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    PREST_REQUEST                    pRequest
+    )
+{
+    if (!pRESTHandle || !pSocket)
+    {
+        return;
+    }
+
+    VmRESTDisconnectClient(
+        pRESTHandle,
+        pSocket
+        );
+
+    if (pRequest)
+    {
+        VmRESTFreeRequestHandle(
+            pRESTHandle,
+            pRequest
+            );
+    }
+}
+
 uint32_t
 VmRESTCommonWriteDataAtOnce(
     PVMREST_HANDLE                   pRESTHandle,
@@ -739,6 +986,108 @@ error:
     goto cleanup;
 }
 
+uint32_t
+VmRESTCommonWriteDataVec(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    PVM_SOCK_IO_VEC                  pVec,
+    uint32_t                         nVec
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+
+    dwError = VmwSockWritev(
+                  pRESTHandle,
+                  pSocket,
+                  pVec,
+                  nVec
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+uint32_t
+VmRESTCommonSendFile(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    int                              fd,
+    uint64_t                         offset,
+    uint64_t                         nBytes
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    char*                            pBuffer = NULL;
+    uint32_t                         nChunk = 0;
+    long                             nRead = 0;
+
+    dwError = VmwSockSendFile(
+                  pRESTHandle,
+                  pSocket,
+                  fd,
+                  offset,
+                  nBytes
+                  );
+    if (dwError != ERROR_NOT_SUPPORTED)
+    {
+        BAIL_ON_VMREST_ERROR(dwError);
+        goto cleanup;
+    }
+
+    /**** Transport has no send file, the file is read and written through this worker ****/
+    dwError = VmRESTAllocateMemory(
+                  VMREST_SEND_FILE_BUFFER_SIZE,
+                  (PVOID*)&pBuffer
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    while (nBytes > 0)
+    {
+        nChunk = (nBytes < VMREST_SEND_FILE_BUFFER_SIZE) ? (uint32_t)nBytes : VMREST_SEND_FILE_BUFFER_SIZE;
+#ifndef WIN32
+        nRead = (long)pread(fd, pBuffer, nChunk, (off_t)offset);
+#else
+        nRead = (_lseeki64(fd, (__int64)offset, SEEK_SET) < 0) ? -1 : (long)_read(fd, pBuffer, nChunk);
+#endif
+        if (nRead <= 0)
+        {
+            VMREST_LOG_ERROR(pRESTHandle,"Read of file fd %d at offset %llu failed, errno %d", fd, (unsigned long long)offset, errno);
+            dwError = VMREST_TRANSPORT_SOCK_WRITE_FAILED;
+        }
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        dwError = VmwSockWrite(
+                      pRESTHandle,
+                      pSocket,
+                      pBuffer,
+                      (uint32_t)nRead
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        offset += nRead;
+        nBytes -= nRead;
+    }
+
+cleanup:
+
+    if (pBuffer)
+    {
+        VmRESTFreeMemory(pBuffer);
+    }
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
 uint32_t
 VmRESTCommonGetPeerInfo(
     PVMREST_HANDLE                   pRESTHandle,
@@ -381,6 +381,30 @@ error:
     return dwError;
 }
 
+DWORD
+VmRESTConditionBroadcast(
+    PVMREST_COND                     pCondition
+)
+{
+    DWORD                            dwError = ERROR_SUCCESS;
+
+    if ( ( pCondition == NULL )
+         ||
+         ( pCondition->bInitialized == FALSE )
+       )
+    {
+        dwError = ERROR_INVALID_PARAMETER;
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    dwError = pthread_cond_broadcast( &(pCondition->cond) );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+error:
+
+    return dwError;
+}
+
 static
 PVOID
 ThreadFunction(
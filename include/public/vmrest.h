@@ -50,7 +50,9 @@
 #define     REST_ENGINE_SSL_CONFIG_FILE                    113
 #define     REST_ENGINE_NO_DEBUG_LOGGING                   114
 #define     REST_ENGINE_BAD_LOG_LEVEL                      115
+#define     REST_ENGINE_ERROR_INSTANCE_STOPPED             116
 #define     REST_ENGINE_MORE_IO_REQUIRED                   7001
+#define     REST_ENGINE_RESPONSE_PENDING                   7002
 #define     REST_ENGINE_IO_COMPLETED                       0
 
 
@@ -125,6 +127,24 @@ typedef struct _REST_CONF
     char*                            pszDaemonName;
     bool                             isSecure;
     bool                             useSysLog;
+    bool                             usePerWorkerReactor;
+    bool                             useIoUring;
+    bool                             useAsyncLog;
+    bool                             asyncLogBlockOnFull;
+    uint32_t                         asyncLogFlushMSec;
+    uint32_t                         nHandlerThr;
+    uint32_t                         nHandlerQueueSize;
+    uint32_t                         nResponseChunkSize;
+    bool                             useCompression;
+    uint32_t                         compressionLevel;
+    uint32_t                         compressionMinSize;
+    uint32_t                         nResponseCacheSize;
+    uint32_t                         nSSLSessionCacheSize;
+    uint32_t                         SSLSessionTimeoutSec;
+    uint32_t                         SSLTicketKeyRotateSec;
+    bool                             useSSLMemoryBIO;
+    bool                             useKTLS;
+    uint32_t                         maxOutputPerConnMB;
     VMREST_LOG_LEVEL                 debugLogLevel;
 } REST_CONF, *PREST_CONF;
 
@@ -135,6 +155,20 @@ typedef struct _REST_ENDPOINT
     struct _REST_ENDPOINT*            next;
 } REST_ENDPOINT, *PREST_ENDPOINT;
 
+typedef struct _REST_TLS_STATS
+{
+    uint64_t                         nHandshakes;
+    uint64_t                         nHandshakeFailures;
+    uint64_t                         handshakeTimeUSec;
+    uint64_t                         handshakeMaxUSec;
+    uint64_t                         handshakeWorkUSec;
+    uint64_t                         nResumed;
+    uint64_t                         nSessionCacheHits;
+    uint64_t                         nSessionCacheMisses;
+    uint64_t                         nKTLS;
+    uint64_t                         nKTLSFallbacks;
+} REST_TLS_STATS, *PREST_TLS_STATS;
+
 /*
  * @brief Rest engine initialization
  *
@@ -188,6 +222,9 @@ VmRESTStart(
  * @param[out]                       ppEndpoint Optionally return the endpoint registration object
  *                                   NOT SUPPORTED CURRENTLY. Use Find API.
  * @return                           Returns 0 for Success
+ *
+ * Endpoints can also be added while the instance is started, requests keep
+ * being served from the previous route table until the new one is published.
  */
 VMREST_API
 uint32_t
@@ -226,6 +263,9 @@ VmRESTFreeEndPoint(
 /**
  * @brief Unregister an endpoint
  * @return                           Returns 0 for success
+ *
+ * Endpoints can be removed while the instance is started, requests already
+ * routed to the endpoint still complete with its handlers.
  */
 VMREST_API
 uint32_t
@@ -415,10 +455,10 @@ VmRESTGetWildCardByIndex(
     );
 
 /*
- * @brief Set length of data in response object(< 4096 bytes) or NULL for chunked.
+ * @brief Set length of data in response object or NULL for chunked.
  *
  * @param[in]                        Reference to HTTP Request object.
- * @param[in]                        Data Length if less than 4096 else NULL.
+ * @param[in]                        Data Length as a decimal string (up to 64 bits), NULL for chunked.
  * @return                           Returns 0 for success
  */
 VMREST_API 
@@ -463,6 +503,8 @@ VmRESTSetFailureResponse(
 
 /*
  * @brief Set data in response object to be send back to client.
+ *        With Content-Length set, the body may be passed in any number of calls
+ *        of any size; each call is written straight to the socket.
  *
  * @param[in]                        Handle to Library instance.
  * @param[in]                        Reference to HTTP Response object.
@@ -507,8 +549,114 @@ VmRESTSetDataZC(
     uint32_t                         nBytes
     );
 
+/*
+ * @brief Send a region of an open file as the complete response body.
+ * Make sure VmRESTSetDataLength() is not used to set data length before call to this.
+ * This API sets data length in HTTP response equals to nBytes and sends the header.
+ * The body is streamed with sendfile() on plain sockets and read in large chunks
+ * on TLS sockets; the transfer continues in the background once the socket is full,
+ * so the calling worker is not held for the duration of the transfer.
+ *
+ * @param[in]                        Handle to Library instance.
+ * @param[in]                        Reference to HTTP Response object.
+ * @param[in]                        Open file descriptor. The engine keeps its own
+ *                                   duplicate, caller may close fd once this returns.
+ * @param[in]                        Offset in the file of the first byte to send.
+ * @param[in]                        Number of bytes to send.
+ * @return                           Returns REST_ENGINE_SUCCESS for success,
+ *                                   or Error codes.
+ */
+
+VMREST_API
+uint32_t
+VmRESTSetDataFromFd(
+    PVMREST_HANDLE                   pRESTHandle,
+    PREST_RESPONSE*                  ppResponse,
+    int                              fd,
+    uint64_t                         offset,
+    uint64_t                         nBytes
+    );
+
+/*
+ * @brief Finish a response that a callback left pending.
+ * A callback returns REST_ENGINE_RESPONSE_PENDING to keep the request and
+ * response after it returns. Headers and data are then set with the usual
+ * APIs from any one thread at a time, and this call hands the request back
+ * to the event loop that owns the connection. The request and response must
+ * not be touched once this returns. Once VmRESTStop() stopped waiting for
+ * pending responses the call is refused with REST_ENGINE_ERROR_INSTANCE_STOPPED.
+ *
+ * @param[in]                        Handle to Library instance.
+ * @param[in]                        Reference to HTTP Request object.
+ * @param[in]                        0 if the response is complete, else an error code;
+ *                                   a failure response is then sent as if the callback
+ *                                   had returned it.
+ * @return                           Returns 0 for success
+ */
+VMREST_API
+uint32_t
+VmRESTCompleteResponse(
+    PVMREST_HANDLE                   pRESTHandle,
+    PREST_REQUEST                    pRequest,
+    uint32_t                         dwStatus
+    );
+
+/*
+ * @brief Let the engine keep this GET response and answer the same request from its cache.
+ * Call before the first VmRESTSetData(). ETag and Last-Modified are added unless already
+ * set. Once the response went out in full with status 200, later GET requests for the same
+ * URI, and the same values of the request headers named in Vary, are answered from the
+ * cache until nMaxAgeSec runs out, with 304 when If-None-Match or If-Modified-Since allow.
+ * Nothing is kept when nResponseCacheSize is 0 in the config, or the request is not a GET.
+ *
+ * @param[in]                        Handle to Library instance.
+ * @param[in]                        Reference to HTTP Response object.
+ * @param[in]                        Seconds the response may be served from the cache.
+ * @return                           Returns 0 for success
+ */
+VMREST_API
+uint32_t
+VmRESTSetCacheable(
+    PVMREST_HANDLE                   pRESTHandle,
+    PREST_RESPONSE*                  ppResponse,
+    uint32_t                         nMaxAgeSec
+    );
+
+/*
+ * @brief Drop cached responses whose request URI starts with the given prefix.
+ *
+ * @param[in]                        Handle to Library instance.
+ * @param[in]                        URI prefix, e.g. "/v1/pkg/". NULL or "" drops every entry.
+ * @return                           Returns 0 for success
+ */
+VMREST_API
+uint32_t
+VmRESTInvalidateCache(
+    PVMREST_HANDLE                   pRESTHandle,
+    char const*                      pcszURIPrefix
+    );
+
+/*
+ * @brief Read the TLS handshake counters of this instance. Counters only grow, sample
+ * them twice to get a rate. Completed handshakes add their time from accept to the
+ * last handshake message to handshakeTimeUSec, handshakeWorkUSec is the time the
+ * workers spent running the handshake. Failures include handshakes that timed out.
+ *
+ * @param[in]                        Handle to Library instance.
+ * @param[out]                       Counters, all zero when the instance is not secure.
+ * @return                           Returns 0 for success
+ */
+VMREST_API
+uint32_t
+VmRESTGetTLSStats(
+    PVMREST_HANDLE                   pRESTHandle,
+    PREST_TLS_STATS                  pStats
+    );
+
 /**
  * @brief Stop the REST Engine
+ * Responses left pending are first given up to waitSeconds to be completed.
+ *
  * @param[in]                        Handle to Library instance.
  * @param[in]                        Time to wait for clean shutdown
  * @return                           Returns 0 for success
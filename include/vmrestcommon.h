@@ -51,16 +51,34 @@ VmRESTLog(
    ...);
 
 
+/**** Levels above the floor are compiled out, configure --with-log-floor sets it ****/
+#ifndef VMREST_LOG_LEVEL_FLOOR
+#define VMREST_LOG_LEVEL_FLOOR VMREST_LOG_LEVEL_DEBUG
+#endif
+
+#if defined(__GNUC__)
+#define VMREST_LOG_UNLIKELY(x) __builtin_expect(!!(x), 0)
+#else
+#define VMREST_LOG_UNLIKELY(x) (x)
+#endif
+
 #if 1 //ndef WIN32
 
 
-#define VMREST_LOG_( Level, Format, ... )          \
-    do                                             \
-    {                                              \
-        VmRESTLog(                                 \
-               Level,                              \
-               Format,                             \
-               ##__VA_ARGS__);                     \
+/**** Level is checked before any argument is evaluated, a disabled statement is one branch ****/
+#define VMREST_LOG_( pRESTHandle, Level, Format, ... )                      \
+    do                                                                      \
+    {                                                                       \
+        if (((Level) <= VMREST_LOG_LEVEL_FLOOR) &&                          \
+            VMREST_LOG_UNLIKELY((pRESTHandle) &&                            \
+                ((int)(Level) <= (pRESTHandle)->debugLogLevel)))            \
+        {                                                                   \
+            VmRESTLog(                                                      \
+                   pRESTHandle,                                             \
+                   Level,                                                   \
+                   Format,                                                  \
+                   ##__VA_ARGS__);                                          \
+        }                                                                   \
     } while (0)
 
 #define VMREST_LOG_GENERAL_( pRESTHandle,Level, Format, ... ) \
@@ -209,6 +227,59 @@ typedef struct _VMREST_RWLOCK
 
 } VMREST_RWLOCK, *PVMREST_RWLOCK;
 
+/**** Arena slabs, base size ones are cached per thread and reused ****/
+#define VM_REST_ARENA_SLAB_SIZE       (16 * 1024)
+#define VM_REST_ARENA_CACHED_SLABS    16
+#define VM_REST_ARENA_ALIGN           16
+
+typedef struct _VM_REST_ARENA_SLAB
+{
+    struct _VM_REST_ARENA_SLAB*      pNext;
+    size_t                           nSize;
+    size_t                           nUsed;
+
+} VM_REST_ARENA_SLAB, *PVM_REST_ARENA_SLAB;
+
+/**** Bump allocator, everything in it is released together ****/
+typedef struct _VM_REST_ARENA
+{
+    PVM_REST_ARENA_SLAB              pSlab;
+    void*                            pLast;
+
+} VM_REST_ARENA, *PVM_REST_ARENA;
+
+
+/**** Listener(s) and the event queue polling them ****/
+typedef struct _VMREST_SOCK_REACTOR
+{
+    PVM_SOCKET                       pListenerTCP;
+    PVM_SOCKET                       pListenerTCP6;
+    PVM_SOCK_EVENT_QUEUE             pEventQueue;
+
+} VMREST_SOCK_REACTOR, *PVMREST_SOCK_REACTOR;
+
+typedef struct _VMREST_HANDLER_JOB
+{
+    PVM_SOCKET                       pSocket;
+    PREST_REQUEST                    pRequest;
+
+} VMREST_HANDLER_JOB, *PVMREST_HANDLER_JOB;
+
+/**** Application callbacks run here, off the I/O threads, requests go back to the queue of their socket ****/
+typedef struct _VMREST_HANDLER_POOL
+{
+    PVMREST_MUTEX                    pMutex;
+    PVMREST_COND                     pCond;
+    PVMREST_HANDLE                   pRESTHandle;
+    PVMREST_HANDLER_JOB              pJobs;
+    uint32_t                         nSize;
+    uint32_t                         iHead;
+    uint32_t                         nQueued;
+    PVMREST_THREAD                   pThreads;
+    uint32_t                         nThreads;
+    BOOLEAN                          bStop;
+
+} VMREST_HANDLER_POOL, *PVMREST_HANDLER_POOL;
 
 typedef struct _VMREST_SOCK_CONTEXT
 {
@@ -216,11 +287,11 @@ typedef struct _VMREST_SOCK_CONTEXT
     uint8_t                          bShutdown;
     PVM_SOCKET                       pListenerUDP;
     PVM_SOCKET                       pListenerUDP6;
-    PVM_SOCKET                       pListenerTCP;
-    PVM_SOCKET                       pListenerTCP6;
-    PVM_SOCK_EVENT_QUEUE             pEventQueue;
+    PVMREST_SOCK_REACTOR             pReactors;
+    uint32_t                         dwNumReactors;
     PVMREST_THREAD*                  pWorkerThreads;
     uint32_t                         dwNumThreads;
+    PVMREST_HANDLER_POOL             pHandlerPool;
 
 } VMREST_SOCK_CONTEXT, *PVMREST_SOCK_CONTEXT;
 
@@ -228,12 +299,52 @@ typedef struct _SOCK_SSL_INFO
 {
     SSL_CTX*                         sslContext;
     uint32_t                         isSecure;
-    bool                             bQueueInUse;
+    uint32_t                         nQueueInUse;
     uint32_t                         isCertSet;
     uint32_t                         isKeySet;
+    uint64_t                         nHandshakes;
+    uint64_t                         nHandshakeFailures;
+    uint64_t                         handshakeTimeUSec;
+    uint64_t                         handshakeMaxUSec;
+    uint64_t                         handshakeWorkUSec;
+    uint64_t                         nResumed;
+    uint64_t                         nSessionCacheHits;
+    uint64_t                         nSessionCacheMisses;
+    uint64_t                         nKTLS;
+    uint64_t                         nKTLSFallbacks;
 
 } VM_SOCK_SSL_INFO, *PVM_SOCK_SSL_INFO;
 
+/**** Async logging, every logging thread owns a ring that only the log thread drains ****/
+#define VMREST_LOG_RING_SIZE              (64 * 1024)
+#define VMREST_LOG_DEFAULT_FLUSH_MSEC     100
+
+typedef struct _VMREST_LOG_RING
+{
+    uint64_t                         head;
+    uint64_t                         tail;
+    uint64_t                         dropped;
+    uint32_t                         bInUse;
+    struct _VMREST_LOG_RING*         pNext;
+    char                             buffer[VMREST_LOG_RING_SIZE];
+
+} VMREST_LOG_RING, *PVMREST_LOG_RING;
+
+typedef struct _VMREST_ASYNC_LOG
+{
+    struct _VMREST_HANDLE*           pRESTHandle;
+    pthread_key_t                    ringKey;
+    PVMREST_LOG_RING                 pRings;
+    pthread_mutex_t                  mutex;
+    pthread_cond_t                   cond;
+    VMREST_THREAD                    thread;
+    uint32_t                         flushIntervalMSec;
+    BOOLEAN                          bBlockOnFull;
+    BOOLEAN                          bStop;
+    uint32_t                         bWakeup;
+
+} VMREST_ASYNC_LOG, *PVMREST_ASYNC_LOG;
+
 /*********** REST engine Configuration struct *************/
 
 typedef struct _REST_CONFIG
@@ -246,6 +357,24 @@ typedef struct _REST_CONFIG
     long                             SSLCtxOptionsFlag;
     bool                             isSecure;
     bool                             useSysLog;
+    bool                             usePerWorkerReactor;
+    bool                             useIoUring;
+    bool                             useAsyncLog;
+    bool                             asyncLogBlockOnFull;
+    uint32_t                         asyncLogFlushMSec;
+    uint32_t                         nHandlerThr;
+    uint32_t                         nHandlerQueueSize;
+    uint32_t                         nResponseChunkSize;
+    bool                             useCompression;
+    uint32_t                         compressionLevel;
+    uint32_t                         compressionMinSize;
+    uint32_t                         nResponseCacheSize;
+    uint32_t                         nSSLSessionCacheSize;
+    uint32_t                         SSLSessionTimeoutSec;
+    uint32_t                         SSLTicketKeyRotateSec;
+    bool                             useSSLMemoryBIO;
+    bool                             useKTLS;
+    uint32_t                         maxOutputPerConnMB;
     char                             pszSSLCertificate[MAX_PATH_LEN];
     char                             pszSSLKey[MAX_PATH_LEN];
     char                             pszDebugLogFile[MAX_PATH_LEN];
@@ -262,6 +391,8 @@ typedef struct _VMREST_HANDLE
     int                              debugLogLevel;
     int                              instanceState;
     FILE*                            logFile;
+    PVMREST_ASYNC_LOG                pAsyncLog;
+    uint32_t                         nAsyncLogUsers;
     PVM_SOCK_PACKAGE                 pPackage;
     PVM_SOCK_SSL_INFO                pSSLInfo;
     PREST_PROCESSOR                  pHttpHandler;
@@ -273,6 +404,7 @@ typedef struct _VMREST_HANDLE
 typedef struct _VM_WORKER_THREAD_DATA
 {
     PVMREST_SOCK_CONTEXT             pSockContext;
+    PVMREST_SOCK_REACTOR             pReactor;
     PVMREST_HANDLE                   pRESTHandle;
 
 }VM_WORKER_THREAD_DATA, *PVM_WORKER_THREAD_DATA;
@@ -319,6 +451,30 @@ VmRESTCommonWriteDataAtOnce(
     uint32_t                         bytes
     );
 
+uint32_t
+VmRESTCommonWriteDataVec(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    PVM_SOCK_IO_VEC                  pVec,
+    uint32_t                         nVec
+    );
+
+uint32_t
+VmRESTCommonSendFile(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    int                              fd,
+    uint64_t                         offset,
+    uint64_t                         nBytes
+    );
+
+void
+VmRESTCommonDropRequest(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    PREST_REQUEST                    pRequest
+    );
+
 uint32_t
 VmRESTCommonGetPeerInfo(
     PVMREST_HANDLE                   pRESTHandle,
@@ -350,6 +506,12 @@ VmRESTProcessBuffer(
     uint32_t*                        nProcessed
     );
 
+uint32_t
+VmRESTRunApplicationCallback(
+    PVMREST_HANDLE                   pRESTHandle,
+    PREST_REQUEST                    pRequest
+    );
+
 uint32_t
 VmRESTEntertainPersistentConn(
     PVMREST_HANDLE                   pRESTHandle,
@@ -374,6 +536,64 @@ VmRESTUnSetConfig(
     void
     );
 
+/************ handlerpool.c API's ****************/
+
+uint32_t
+VmRESTHandlerPoolStart(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVMREST_HANDLER_POOL*            ppPool
+    );
+
+uint32_t
+VmRESTHandlerPoolSubmit(
+    PVMREST_HANDLER_POOL             pPool,
+    PVM_SOCKET                       pSocket,
+    PREST_REQUEST                    pRequest,
+    BOOLEAN*                         pbQueued
+    );
+
+void
+VmRESTHandlerPoolStop(
+    PVMREST_HANDLER_POOL             pPool
+    );
+
+void
+VmRESTHandlerPoolFree(
+    PVMREST_HANDLER_POOL             pPool
+    );
+
+/************ handlerpool.c API's End ****************/
+
+/************ arena.c API's ****************/
+
+uint32_t
+VmRESTArenaCreate(
+    PVM_REST_ARENA*                  ppArena
+    );
+
+uint32_t
+VmRESTArenaAllocate(
+    PVM_REST_ARENA                   pArena,
+    size_t                           nSize,
+    void**                           ppMemory
+    );
+
+uint32_t
+VmRESTArenaReallocate(
+    PVM_REST_ARENA                   pArena,
+    void*                            pMemory,
+    size_t                           nOldSize,
+    size_t                           nNewSize,
+    void**                           ppNewMemory
+    );
+
+void
+VmRESTArenaFree(
+    PVM_REST_ARENA                   pArena
+    );
+
+/************ arena.c API's End ****************/
+
 /************ threads.c API's ****************/
 
 DWORD
@@ -449,6 +669,11 @@ VmRESTConditionSignal(
     PVMREST_COND                     pCondition
     );
 
+DWORD
+VmRESTConditionBroadcast(
+    PVMREST_COND                     pCondition
+    );
+
 DWORD
 VmRESTCreateThread(
     PVMREST_THREAD                   pThread,
@@ -35,6 +35,7 @@
 #define VMREST_APPLICATION_NO_METHOD_DELETE_CB          61018
 #define VMREST_APPLICATION_NO_METHOD_TRACE_CB           61019
 #define VMREST_APPLICATION_NO_METHOD_CONNECT_CB         61020
+#define VMREST_APPLICATION_CB_QUEUED                    61021
 
 
 #define VMREST_TRANSPORT_INVALID_PARAM                  61100
@@ -89,11 +90,33 @@
 #define VMREST_DEFAULT_CLIENT_COUNT                     100
 #define VMREST_DEFAULT_CONN_TIMEOUT_SEC                 60
 #define VMREST_DEFAULT_CONN_PAYLOAD_LIMIT_MB            25
+#define VMREST_DEFAULT_CONN_OUTPUT_LIMIT_MB             8
 
 #define VMREST_MAX_WORKER_THR_COUNT                     100
 #define VMREST_MAX_CLIENT_COUNT                         10000
 #define VMREST_MAX_CONN_TIMEOUT_SEC                     600
 #define VMREST_MAX_CONN_PAYLOAD_LIMIT_MB                50
+#define VMREST_MAX_CONN_OUTPUT_LIMIT_MB                 1024
+
+#define VMREST_DEFAULT_HANDLER_QUEUE_SIZE               1024
+#define VMREST_MAX_HANDLER_THR_COUNT                    100
+#define VMREST_MAX_HANDLER_QUEUE_SIZE                   65536
+#define VMREST_DEFAULT_RESPONSE_CHUNK_SIZE              65536
+#define VMREST_MAX_RESPONSE_CHUNK_SIZE                  (16 * 1024 * 1024)
+#define VMREST_DEFAULT_COMPRESSION_LEVEL                6
+#define VMREST_MAX_COMPRESSION_LEVEL                    9
+#define VMREST_DEFAULT_COMPRESSION_MIN_SIZE             1024
+#define VMREST_MAX_DEFLATE_POOL_SIZE                    64
+#define VMREST_MAX_CHUNK_BUFFER_POOL_SIZE               64
+#define VMREST_MAX_RESPONSE_CACHE_SIZE                  (1024 * 1024 * 1024)
+#define VMREST_RESPONSE_CACHE_SHARDS                    16
+#define VMREST_MAX_SSL_SESSION_CACHE_SIZE               (1024 * 1024)
+#define VMREST_SSL_SESSION_CACHE_SHARDS                 16
+#define VMREST_DEFAULT_SSL_SESSION_TIMEOUT_SEC          300
+#define VMREST_MAX_SSL_SESSION_TIMEOUT_SEC              86400
+#define VMREST_DEFAULT_SSL_TICKET_KEY_ROTATE_SEC        3600
+#define VMREST_SSL_TICKET_KEYS                          8
+#define VMREST_SEND_FILE_BUFFER_SIZE                    65536
 
 
 #define TRUE                             1
@@ -45,10 +45,17 @@ typedef UINT32                           VM_SOCK_CREATE_FLAGS;
 #define VM_SOCK_CREATE_FLAGS_REUSE_ADDR  0x00000010
 #define VM_SOCK_CREATE_FLAGS_NON_BLOCK   0x00000020
 #define VM_SOCK_IS_SSL                   0x00000040
+#define VM_SOCK_CREATE_FLAGS_REUSE_PORT  0x00000080
 
 typedef struct _VM_SOCKET*               PVM_SOCKET;
 typedef struct _VM_SOCK_EVENT_QUEUE*     PVM_SOCK_EVENT_QUEUE;
 
+typedef struct _VM_SOCK_IO_VEC
+{
+    char*                                pBuffer;
+    uint32_t                             nBytes;
+} VM_SOCK_IO_VEC, *PVM_SOCK_IO_VEC;
+
 typedef enum
 {
     VM_SOCK_EVENT_TYPE_UNKNOWN = 0,
@@ -70,6 +77,7 @@ typedef enum
     VM_SOCK_EVENT_TYPE_UDP_FWD_RESPONSE_DATA_READ,
     VM_SOCK_EVENT_TYPE_CONNECTION_TIMEOUT,
     VM_SOCK_EVENT_TYPE_CONNECTION_CLOSED,
+    VM_SOCK_EVENT_TYPE_REQUEST_COMPLETED,
     VM_SOCK_EVENT_TYPE_MAX,
 } VM_SOCK_EVENT_TYPE, *PVM_SOCK_EVENT_TYPE;
 
@@ -222,6 +230,45 @@ VmwSockWrite(
     uint32_t                         nBufLen
 );
 
+/**
+ * @brief Writes a list of buffers to the socket, in order, as one stream
+ *
+ * @param[in]     pRESTHandle  Handle to library instance.
+ * @param[in]     pSocket      Pointer to socket
+ * @param[in]     pVec         Buffers to be written
+ * @param[in]     nVec         Number of entries in pVec
+ *
+ * @return 0 on success
+ */
+DWORD
+VmwSockWritev(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    PVM_SOCK_IO_VEC                  pVec,
+    uint32_t                         nVec
+);
+
+/**
+ * @brief Sends nBytes of a file, starting at offset, to the socket. The
+ *        transfer continues in the background once the socket is full.
+ *
+ * @param[in]     pRESTHandle  Handle to library instance.
+ * @param[in]     pSocket      Pointer to socket
+ * @param[in]     fd           Open file descriptor, duplicated by the call
+ * @param[in]     offset       Offset in the file to start from
+ * @param[in]     nBytes       Number of bytes to send
+ *
+ * @return 0 on success, ERROR_NOT_SUPPORTED if the transport cannot do it
+ */
+DWORD
+VmwSockSendFile(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    int                              fd,
+    uint64_t                         offset,
+    uint64_t                         nBytes
+);
+
 /**
  * @brief Releases current reference to socket
  * @param[in] Handle to library instance.
@@ -268,6 +315,25 @@ VmwSockSetRequestHandle(
     BOOLEAN                          bPersistentConn
     );
 
+/**
+ * @brief Hands a request whose callback ran off the I/O threads back to the
+ *        event queue of its socket. The queue reports it as
+ *        VM_SOCK_EVENT_TYPE_REQUEST_COMPLETED and the request handle of the
+ *        socket is set to pRequest.
+ *
+ * @param[in]     pRESTHandle  Handle to library instance.
+ * @param[in]     pSocket      Pointer to socket, not watched by its queue
+ * @param[in]     pRequest     Request handled on the socket
+ *
+ * @return 0 on success, ERROR_NOT_SUPPORTED if the transport cannot do it
+ */
+DWORD
+VmwSockPostCompletion(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    PREST_REQUEST                    pRequest
+    );
+
 DWORD
 VmwSockGetPeerInfo(
     PVMREST_HANDLE                   pRESTHandle,
@@ -277,6 +343,20 @@ VmwSockGetPeerInfo(
     int*                             pPortNo
     );
 
+/**
+ * @brief Prepares the calling thread for socket I/O, e.g. the per thread
+ *        state of the TLS library. Called once by every I/O and handler
+ *        thread before it touches a socket.
+ *
+ * @param[in]     pRESTHandle  Handle to library instance.
+ *
+ * @return 0 on success, also when the transport has nothing to prepare
+ */
+DWORD
+VmwSockThreadInit(
+    PVMREST_HANDLE                   pRESTHandle
+    );
+
 typedef enum
 {
     VM_SOCK_PROTOCOL_UNKNOWN = 0,
@@ -293,7 +373,8 @@ typedef enum
     VM_SOCK_TYPE_SIGNAL,
     VM_SOCK_TYPE_TIMER,
     VM_SOCK_TYPE_TCP_V4,
-    VM_SOCK_TYPE_TCP_V6
+    VM_SOCK_TYPE_TCP_V6,
+    VM_SOCK_TYPE_COMPLETION
 } VM_SOCK_TYPE;
 
 typedef DWORD (*PFN_START_SERVER_SOCKET)(
@@ -347,6 +428,21 @@ typedef DWORD (*PFN_WRITE)(
                     uint32_t            nBufLen
                     );
 
+typedef DWORD (*PFN_WRITEV)(
+                    PVMREST_HANDLE      pRESTHandle,
+                    PVM_SOCKET          pSocket,
+                    PVM_SOCK_IO_VEC     pVec,
+                    uint32_t            nVec
+                    );
+
+typedef DWORD (*PFN_SEND_FILE)(
+                    PVMREST_HANDLE      pRESTHandle,
+                    PVM_SOCKET          pSocket,
+                    int                 fd,
+                    uint64_t            offset,
+                    uint64_t            nBytes
+                    );
+
 typedef VOID (*PFN_RELEASE_SOCKET)(
                     PVMREST_HANDLE       pRESTHandle,
                     PVM_SOCKET           pSocket
@@ -371,6 +467,16 @@ typedef DWORD(*PFN_SET_REQUEST_HANDLE)(
                     BOOLEAN               bPersistentConn
                     );
 
+typedef DWORD(*PFN_POST_COMPLETION)(
+                    PVMREST_HANDLE        pRESTHandle,
+                    PVM_SOCKET            pSocket,
+                    PREST_REQUEST         pRequest
+                    );
+
+typedef DWORD(*PFN_THREAD_INIT)(
+                    PVMREST_HANDLE        pRESTHandle
+                    );
+
 typedef DWORD(*PFN_GET_PEER_INFO)(
                     PVMREST_HANDLE        pRESTHandle,
                     PVM_SOCKET            pSocket,
@@ -389,9 +495,13 @@ typedef struct _VM_SOCK_PACKAGE
     PFN_CLOSE_EVENT_QUEUE               pfnCloseEventQueue;
     PFN_READ                            pfnRead;
     PFN_WRITE                           pfnWrite;
+    PFN_WRITEV                          pfnWritev;
+    PFN_SEND_FILE                       pfnSendFile;
     PFN_RELEASE_SOCKET                  pfnReleaseSocket;
     PFN_CLOSE_SOCKET                    pfnCloseSocket;
     PFN_GET_REQUEST_HANDLE              pfnGetRequestHandle;
     PFN_SET_REQUEST_HANDLE              pfnSetRequestHandle;
     PFN_GET_PEER_INFO                   pfnGetPeerInfo;
+    PFN_POST_COMPLETION                 pfnPostCompletion;
+    PFN_THREAD_INIT                     pfnThreadInit;
 } VM_SOCK_PACKAGE, *PVM_SOCK_PACKAGE;
@@ -23,23 +23,34 @@ typedef void* (PFN_VMREST_THR_ROUTINE)(void*);
 #define MAX_STATUS_LEN              4
 #define MAX_REA_PHRASE_LEN          32
 #define MAX_STOP_WAIT_SECONDS       600
+#define PENDING_POLL_USEC           10000
+
+/**** Requests are still answered while VmRESTStop() lets pending responses finish ****/
+#define VMREST_INSTANCE_SERVING(pRESTHandle) \
+    (((pRESTHandle)->instanceState == VMREST_INSTANCE_STARTED) || ((pRESTHandle)->instanceState == VMREST_INSTANCE_STOPPING))
 #define HTTP_VER_LEN                8
 #define HTTP_CHUNK_DATA_MIN_LEN     3
 #define HTTP_CHUNKED_DATA_LEN       8
 #define HTTP_MIN_CHUNK_DATA_LEN     3
 #define HTTP_CRLF_LEN               2
+#define HTTP_SCAN_NOT_FOUND         0xFFFFFFFF
 
 #define MAX_KEY_VAL_PARAM_LEN      1024
 #define MAX_URL_PARAMS_ARR_SIZE    5
+#define MAX_URI_WILD_CARDS         16
 #define MAX_EXTRA_CRLF_BUF_SIZE    10
 #define MAX_DATA_BUFFER_LEN        4096
 #define MAX_REQ_LIN_LEN            11264
 #define MAX_CLIENT_IP_ADDR_LEN     47
 #define MAX_CONTENT_LEN_STR_SIZE   10
+#define MAX_FILE_LEN_STR_SIZE      21
 
 #define MAX_HTTP_HEADER_ATTR_LEN   64
 #define MAX_HTTP_HEADER_VAL_LEN    8192
 
+#define HTTP_REQUEST_HEAD_SIZE     512
+#define HTTP_REQUEST_HEADER_SLOTS  16
+
 #define DEFAULT_WORKER_THR_CNT     "5"
 #define DEFAULT_CLIENT_CNT         "5"
 #define DEFAULT_DEBUG_FILE         "/tmp/restServer.log"
@@ -52,6 +63,21 @@ typedef void* (PFN_VMREST_THR_ROUTINE)(void*);
 #define HTTP_HEADER_STR_CONTENT_LENGTH            "Content-Length"
 #define HTTP_HEADER_STR_TRANSFER_ENCODING         "Transfer-Encoding"
 #define HTTP_HEADER_STR_EXPECT                    "Expect"
+#define HTTP_HEADER_STR_ACCEPT_ENCODING           "Accept-Encoding"
+#define HTTP_HEADER_STR_CONTENT_ENCODING          "Content-Encoding"
+#define HTTP_HEADER_STR_VARY                      "Vary"
+#define HTTP_DEFLATE_WINDOW_BITS                  15
+#define HTTP_GZIP_WINDOW_BITS                     (15 + 16)
+#define HTTP_DEFLATE_MAX_WRITE                    (1024 * 1024 * 1024)
+#define HTTP_HEADER_STR_ETAG                      "ETag"
+#define HTTP_HEADER_STR_LAST_MODIFIED             "Last-Modified"
+#define HTTP_HEADER_STR_IF_NONE_MATCH             "If-None-Match"
+#define HTTP_HEADER_STR_IF_MODIFIED_SINCE         "If-Modified-Since"
+#define HTTP_HEADER_STR_CONNECTION                "Connection"
+#define HTTP_DATE_FORMAT                          "%a, %d %b %Y %H:%M:%S GMT"
+#define HTTP_DATE_LEN                             64
+#define HTTP_CACHE_BUCKETS                        256
+#define HTTP_CACHE_BUF_SIZE                       4096
 #define HTTP_STATUSCODE_STR_100                   "100"
 #define HTTP_REASON_STR_CONTINUE                  "Continue"
 #define HTTP_VALID_METHODS_COUNT                  8
@@ -63,13 +89,21 @@ typedef enum _HTTP_PAYLOAD_TYPE
     HTTP_PAYLOAD_TRANSFER_ENCODING
 }HTTP_PAYLOAD_TYPE;
 
+typedef enum _VM_REST_ROUTE_NODE_TYPE
+{
+    VM_REST_ROUTE_STATIC         = 0,
+    VM_REST_ROUTE_WILDCARD,
+    VM_REST_ROUTE_CATCHALL
+}VM_REST_ROUTE_NODE_TYPE;
+
 typedef enum _VM_REST_INSTANCE_STATE
 {
     VMREST_INSTANCE_UNINITIALIZED      = -1,
     VMREST_INSTANCE_INITIALIZED        = 1,
     VMREST_INSTANCE_STARTED            = 2,
     VMREST_INSTANCE_STOPPED            = 3,
-    VMREST_INSTANCE_SHUTDOWN           = 4
+    VMREST_INSTANCE_SHUTDOWN           = 4,
+    VMREST_INSTANCE_STOPPING           = 5
 }VM_REST_INSTANCE_STATE;
 
 typedef enum _VM_REST_PROCESSING_STATE
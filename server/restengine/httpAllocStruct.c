@@ -13,54 +13,20 @@
 
 #include "includes.h"
 
-static
-uint32_t
-VmRESTAllocateRequestLine(
-    PVM_REST_HTTP_REQUEST_LINE*      ppReqLine
-    );
-
-static
-void
-VmRESTFreeRequestLine(
-    PVM_REST_HTTP_REQUEST_LINE       pReqLine
-    );
-
 static
 uint32_t
 VmRESTAllocateStatusLine(
+    PVM_REST_ARENA                   pArena,
     PVM_REST_HTTP_STATUS_LINE*       ppStatusLine
     );
 
-static
-void
-VmRESTFreeStatusLine(
-    PVM_REST_HTTP_STATUS_LINE        pStatusLine
-    );
-
 static
 uint32_t
 VmRESTAllocateMiscQueue(
+    PVM_REST_ARENA                   pArena,
     PMISC_HEADER_QUEUE*              ppMiscHeaderQueue
     );
 
-static
-void
-VmRESTFreeMiscQueue(
-    PMISC_HEADER_QUEUE               pMiscHeaderQueue
-    );
-
-static
-uint32_t
-VmRESTAllocateMessageBody(
-    PVM_REST_HTTP_MESSAGE_BODY*      ppMsgBody
-    );
-
-static
-void
-VmRESTFreeMessageBody(
-    PVM_REST_HTTP_MESSAGE_BODY       pMsgBody
-    );
-
 
 uint32_t
 VmRESTAllocateHTTPRequestPacket(
@@ -68,36 +34,31 @@ VmRESTAllocateHTTPRequestPacket(
     )
 {
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    PVM_REST_ARENA                   pArena = NULL;
     PVM_REST_HTTP_REQUEST_PACKET     pReqPacket = NULL;
-    PVM_REST_HTTP_REQUEST_LINE       pReqLine = NULL;
-    PMISC_HEADER_QUEUE               pMiscHeaderQueue = NULL;
 
-    dwError = VmRESTAllocateMemory(
-                  sizeof(VM_REST_HTTP_REQUEST_PACKET),
-                  (void**)&pReqPacket
+    /**** Everything owned by the request comes from its arena, except the payload ****/
+    dwError = VmRESTArenaCreate(
+                  &pArena
                   );
     BAIL_ON_VMREST_ERROR(dwError);
 
-    dwError = VmRESTAllocateRequestLine(
-                  &pReqLine
+    /**** Request line and headers live in pszHead, allocated on first use ****/
+    dwError = VmRESTArenaAllocate(
+                  pArena,
+                  sizeof(VM_REST_HTTP_REQUEST_PACKET),
+                  (void**)&pReqPacket
                   );
     BAIL_ON_VMREST_ERROR(dwError);
-    pReqPacket->requestLine = pReqLine;
 
-    dwError = VmRESTAllocateMiscQueue(
-                  &pMiscHeaderQueue
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
-    pReqPacket->miscHeader = pMiscHeaderQueue;
+    pReqPacket->pArena = pArena;
 
     *ppReqPacket = pReqPacket;
 
 cleanup:
     return dwError;
 error:
-    VmRESTFreeHTTPRequestPacket(
-        &pReqPacket
-        );
+    VmRESTArenaFree(pArena);
     *ppReqPacket = NULL;
     goto cleanup;
 }
@@ -111,25 +72,14 @@ VmRESTFreeHTTPRequestPacket(
     pReqPacket = *ppReqPacket;
     if (pReqPacket)
     {
-        if (pReqPacket->requestLine)
-        {
-            VmRESTFreeRequestLine(pReqPacket->requestLine);
-        }
-        if (pReqPacket->miscHeader)
-        {
-            VmRESTFreeMiscQueue(pReqPacket->miscHeader);
-        }
-
         if (pReqPacket->pszPayload)
         {
             VmRESTFreeMemory(pReqPacket->pszPayload);
             pReqPacket->pszPayload = NULL;
         }
 
-        pReqPacket->requestLine = NULL;
-        pReqPacket->miscHeader = NULL;
-
-        VmRESTFreeMemory(pReqPacket);
+        /**** Releases the packet itself along with its response ****/
+        VmRESTArenaFree(pReqPacket->pArena);
 
         *ppReqPacket = NULL;
     }
@@ -137,34 +87,34 @@ VmRESTFreeHTTPRequestPacket(
 
 uint32_t
 VmRESTAllocateHTTPResponsePacket(
+    PVM_REST_ARENA                   pArena,
     PVM_REST_HTTP_RESPONSE_PACKET*   ppResPacket
     )
 {
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
     PVM_REST_HTTP_RESPONSE_PACKET    pResPacket = NULL;
     PVM_REST_HTTP_STATUS_LINE        pStatusLine = NULL;
-    PVM_REST_HTTP_MESSAGE_BODY       pMessageBody = NULL;
     PMISC_HEADER_QUEUE               pMiscHeaderQueue = NULL;
 
-    dwError = VmRESTAllocateMemory(
+    /**** No free counterpart, the response goes away with the request arena ****/
+    dwError = VmRESTArenaAllocate(
+                  pArena,
                   sizeof(VM_REST_HTTP_RESPONSE_PACKET),
                   (void**)&pResPacket
                   );
     BAIL_ON_VMREST_ERROR(dwError);
 
+    pResPacket->pArena = pArena;
+
     dwError = VmRESTAllocateStatusLine(
+                  pArena,
                   &pStatusLine
                   );
     BAIL_ON_VMREST_ERROR(dwError);
     pResPacket->statusLine = pStatusLine;
 
-    dwError = VmRESTAllocateMessageBody(
-                  &pMessageBody
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
-    pResPacket->messageBody = pMessageBody;
-
     dwError = VmRESTAllocateMiscQueue(
+                  pArena,
                   &pMiscHeaderQueue
                   );
     BAIL_ON_VMREST_ERROR(dwError);
@@ -175,46 +125,10 @@ VmRESTAllocateHTTPResponsePacket(
 cleanup:
     return dwError;
 error:
-    VmRESTFreeHTTPResponsePacket(
-        &pResPacket
-        );
     *ppResPacket = NULL;
     goto cleanup;
 }
 
-void
-VmRESTFreeHTTPResponsePacket(
-    PVM_REST_HTTP_RESPONSE_PACKET*   ppResPacket
-    )
-{
-    PVM_REST_HTTP_RESPONSE_PACKET    pResPacket = NULL;
-
-    pResPacket = *ppResPacket;
-    if (pResPacket)
-    {
-        if (pResPacket->statusLine)
-        {
-            VmRESTFreeStatusLine(pResPacket->statusLine);
-        }
-        if (pResPacket->messageBody)
-        {
-            VmRESTFreeMessageBody(pResPacket->messageBody);
-        }
-        if (pResPacket->miscHeader)
-        {
-            VmRESTFreeMiscQueue(pResPacket->miscHeader);
-        }
-
-        pResPacket->statusLine = NULL;
-        pResPacket->messageBody = NULL;
-        pResPacket->miscHeader = NULL;
-
-        VmRESTFreeMemory(pResPacket);
-
-        *ppResPacket = NULL;
-    }
-}
-
 uint32_t
 VmRESTAllocateEndPoint(
      PREST_ENDPOINT*                 ppEndPoint
@@ -405,51 +319,18 @@ VmRESTFreeHandle(
 }
 
 
-static
-uint32_t
-VmRESTAllocateRequestLine(
-    PVM_REST_HTTP_REQUEST_LINE*      ppReqLine
-    )
-{
-    uint32_t                         dwError = REST_ENGINE_SUCCESS;
-    PVM_REST_HTTP_REQUEST_LINE       pReqLine = NULL;
-
-    dwError = VmRESTAllocateMemory(
-                  sizeof(VM_REST_HTTP_REQUEST_LINE),
-                  (void**)&pReqLine
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
-
-    *ppReqLine = pReqLine;
-
-cleanup:
-    return dwError;
-error:
-    goto cleanup;
-}
-
-static
-void
-VmRESTFreeRequestLine(
-    PVM_REST_HTTP_REQUEST_LINE       pReqLine
-    )
-{
-    if (pReqLine)
-    {
-        VmRESTFreeMemory(pReqLine);
-    }
-}
-
 static
 uint32_t
 VmRESTAllocateStatusLine(
+    PVM_REST_ARENA                   pArena,
     PVM_REST_HTTP_STATUS_LINE*       ppStatusLine
     )
 {
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
     PVM_REST_HTTP_STATUS_LINE        pStatusLine = NULL;
 
-    dwError = VmRESTAllocateMemory(
+    dwError = VmRESTArenaAllocate(
+                  pArena,
                   sizeof(VM_REST_HTTP_STATUS_LINE),
                   (void**)&pStatusLine
                   );
@@ -463,64 +344,18 @@ error:
     goto cleanup;
 }
 
-static
-void
-VmRESTFreeStatusLine(
-    PVM_REST_HTTP_STATUS_LINE        pStatusLine
-    )
-{
-    if (pStatusLine)
-    {
-        VmRESTFreeMemory(pStatusLine
-            );
-    }
-}
-
-uint32_t
-VmRESTAllocateMessageBody(
-    PVM_REST_HTTP_MESSAGE_BODY*      ppMsgBody
-    )
-{
-    uint32_t                         dwError = REST_ENGINE_SUCCESS;
-    PVM_REST_HTTP_MESSAGE_BODY       pMsgBody = NULL;
-
-    dwError = VmRESTAllocateMemory(
-                  sizeof(VM_REST_HTTP_MESSAGE_BODY),
-                  (void**)&pMsgBody
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
-
-    *ppMsgBody = pMsgBody;
-
-cleanup:
-    return dwError;
-error:
-    goto cleanup;
-}
-
-static
-void
-VmRESTFreeMessageBody(
-    PVM_REST_HTTP_MESSAGE_BODY       pMsgBody
-    )
-{
-    if (pMsgBody)
-    {
-        VmRESTFreeMemory(pMsgBody
-            );
-    }
-}
-
 static
 uint32_t
 VmRESTAllocateMiscQueue(
+    PVM_REST_ARENA                   pArena,
     PMISC_HEADER_QUEUE*              ppMiscHeaderQueue
     )
 {
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
     PMISC_HEADER_QUEUE               pMiscQueue = NULL;
 
-    dwError = VmRESTAllocateMemory(
+    dwError = VmRESTArenaAllocate(
+                  pArena,
                   sizeof(MISC_HEADER_QUEUE),
                   (void**)&pMiscQueue
                   );
@@ -535,20 +370,3 @@ cleanup:
 error:
     goto cleanup;
 }
-
-static
-void
-VmRESTFreeMiscQueue(
-    PMISC_HEADER_QUEUE               pMiscHeaderQueue
-    )
-{
-    if (pMiscHeaderQueue)
-    {
-        VmRESTRemoveAllHTTPMiscHeader(
-            pMiscHeaderQueue
-            );
-        VmRESTFreeMemory(pMiscHeaderQueue
-            );
-    }
-}
-
@@ -0,0 +1,1205 @@
+/* C-REST-Engine
+*
+* Copyright (c) 2017 VMware, Inc. All Rights Reserved.
+*
+* This product is licensed to you under the Apache 2.0 license (the "License").
+* You may not use this product except in compliance with the Apache 2.0 License.
+*
+* This product may include a number of subcomponents with separate copyright
+* notices and license terms. Your use of these subcomponents is subject to the
+* terms and conditions of the subcomponent's license, as noted in the LICENSE file.
+*
+*/
+
+/**** Cache of GET responses the application marked cacheable, served without calling it ****/
+
+#include "includes.h"
+
+static
+uint32_t
+VmRESTCacheInsert(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_REST_HTTP_RESPONSE_PACKET    pResPacket
+    );
+
+static
+uint32_t
+VmRESTCacheBuildKey(
+    PVM_REST_HTTP_REQUEST_PACKET     pRequest,
+    char**                           ppszKey
+    );
+
+static
+uint32_t
+VmRESTCacheVaryValues(
+    PVM_REST_HTTP_REQUEST_PACKET     pRequest,
+    char const*                      pszVaryNames,
+    char**                           ppszValues
+    );
+
+static
+char const*
+VmRESTCacheRequestHeader(
+    PVM_REST_HTTP_REQUEST_PACKET     pRequest,
+    char const*                      pszName,
+    size_t                           nName
+    );
+
+static
+BOOLEAN
+VmRESTCacheAppend(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_REST_HTTP_RESPONSE_PACKET    pResPacket,
+    char const*                      pData,
+    size_t                           nData
+    );
+
+static
+void
+VmRESTCacheAbort(
+    PVM_REST_HTTP_RESPONSE_PACKET    pResPacket
+    );
+
+static
+void
+VmRESTCacheUnlink(
+    PVM_REST_CACHE_SHARD             pShard,
+    PVM_REST_CACHE_ENTRY             pEntry
+    );
+
+static
+void
+VmRESTCacheUnref(
+    PVM_REST_CACHE_SHARD             pShard,
+    PVM_REST_CACHE_ENTRY             pEntry
+    );
+
+static
+BOOLEAN
+VmRESTCacheETagMatch(
+    char const*                      pszList,
+    char const*                      pszETag
+    );
+
+static
+BOOLEAN
+VmRESTCacheParseDate(
+    char const*                      pszDate,
+    time_t*                          pTime
+    );
+
+static
+uint64_t
+VmRESTCacheHash(
+    char const*                      pszKey
+    );
+
+static
+time_t
+VmRESTCacheNow(
+    void
+    );
+
+uint32_t
+VmRESTCacheInit(
+    PVMREST_HANDLE                   pRESTHandle
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    PREST_ENG_GLOBALS                pGlobals = NULL;
+    PVM_REST_CACHE_SHARD             pShards = NULL;
+    uint32_t                         i = 0;
+
+    if (!pRESTHandle || !pRESTHandle->pInstanceGlobal || !pRESTHandle->pRESTConfig)
+    {
+        dwError = REST_ERROR_INVALID_HANDLER;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    pGlobals = pRESTHandle->pInstanceGlobal;
+    pGlobals->pCacheShards = NULL;
+
+    /**** Off unless the application gave it a budget ****/
+    if (pRESTHandle->pRESTConfig->nResponseCacheSize == 0)
+    {
+        goto cleanup;
+    }
+
+    dwError = VmRESTAllocateMemory(
+                  sizeof(VM_REST_CACHE_SHARD) * VMREST_RESPONSE_CACHE_SHARDS,
+                  (void**)&pShards
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    for (i = 0; i < VMREST_RESPONSE_CACHE_SHARDS; i++)
+    {
+        dwError = VmRESTAllocateMutex(
+                      &pShards[i].pMutex
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    pGlobals->nCacheShardBytes = pRESTHandle->pRESTConfig->nResponseCacheSize / VMREST_RESPONSE_CACHE_SHARDS;
+    pGlobals->cacheETagSeq = 0;
+    pGlobals->cacheStartTime = time(NULL);
+    pGlobals->pCacheShards = pShards;
+    pShards = NULL;
+
+cleanup:
+    return dwError;
+error:
+    if (pShards)
+    {
+        for (i = 0; i < VMREST_RESPONSE_CACHE_SHARDS; i++)
+        {
+            if (pShards[i].pMutex)
+            {
+                VmRESTFreeMutex(pShards[i].pMutex);
+            }
+        }
+        VmRESTFreeMemory(pShards);
+    }
+    goto cleanup;
+}
+
+void
+VmRESTCacheShutdown(
+    PVMREST_HANDLE                   pRESTHandle
+    )
+{
+    PREST_ENG_GLOBALS                pGlobals = NULL;
+    PVM_REST_CACHE_SHARD             pShard = NULL;
+    PVM_REST_CACHE_ENTRY             pEntry = NULL;
+    uint32_t                         i = 0;
+
+    if (!pRESTHandle || !pRESTHandle->pInstanceGlobal || !pRESTHandle->pInstanceGlobal->pCacheShards)
+    {
+        return;
+    }
+
+    pGlobals = pRESTHandle->pInstanceGlobal;
+
+    /**** Engine is stopped, no request holds an entry any more ****/
+    for (i = 0; i < VMREST_RESPONSE_CACHE_SHARDS; i++)
+    {
+        pShard = &pGlobals->pCacheShards[i];
+
+        while (pShard->pLRUHead != NULL)
+        {
+            pEntry = pShard->pLRUHead;
+            pShard->pLRUHead = pEntry->pNextLRU;
+            VmRESTFreeMemory(pEntry);
+        }
+
+        VmRESTFreeMutex(pShard->pMutex);
+    }
+
+    VmRESTFreeMemory(pGlobals->pCacheShards);
+    pGlobals->pCacheShards = NULL;
+}
+
+uint32_t
+VmRESTCacheMark(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_REST_HTTP_RESPONSE_PACKET    pResPacket,
+    uint32_t                         nMaxAgeSec
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    PREST_ENG_GLOBALS                pGlobals = NULL;
+    PVM_REST_HTTP_REQUEST_PACKET     pRequest = NULL;
+    char*                            pszValue = NULL;
+    char                             pszETag[HTTP_DATE_LEN] = {0};
+    char                             pszDate[HTTP_DATE_LEN] = {0};
+    uint64_t                         seq = 0;
+    time_t                           now = 0;
+    struct tm                        tmNow = {0};
+
+    if (!pRESTHandle || !pResPacket || !pResPacket->requestPacket || (nMaxAgeSec == 0))
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid params");
+        dwError = VMREST_HTTP_INVALID_PARAMS;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    /**** Headers below must go out with the response ****/
+    if (pResPacket->bHeaderSent)
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"%s","Response marked cacheable after its header was sent");
+        dwError = VMREST_HTTP_VALIDATION_FAILED;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    pGlobals = pRESTHandle->pInstanceGlobal;
+    pRequest = pResPacket->requestPacket;
+
+    if (!pGlobals->pCacheShards || (strcmp(VmRESTGetRequestSpan(pRequest, &pRequest->requestLine.method), "GET") != 0))
+    {
+        goto cleanup;
+    }
+
+    /**** Validators, unless the application has its own ****/
+    dwError = VmRESTGetHttpResponseHeader(
+                  pResPacket,
+                  HTTP_HEADER_STR_ETAG,
+                  &pszValue
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    if (pszValue == NULL)
+    {
+        seq = __atomic_add_fetch(&pGlobals->cacheETagSeq, 1, __ATOMIC_RELAXED);
+        snprintf(pszETag, sizeof(pszETag), "\"%lx-%llx\"", (unsigned long)pGlobals->cacheStartTime, (unsigned long long)seq);
+
+        dwError = VmRESTSetHTTPMiscHeader(
+                      pResPacket->pArena,
+                      pResPacket->miscHeader,
+                      HTTP_HEADER_STR_ETAG,
+                      pszETag
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    pszValue = NULL;
+    dwError = VmRESTGetHttpResponseHeader(
+                  pResPacket,
+                  HTTP_HEADER_STR_LAST_MODIFIED,
+                  &pszValue
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    if (pszValue == NULL)
+    {
+        now = time(NULL);
+        gmtime_r(&now, &tmNow);
+        strftime(pszDate, sizeof(pszDate), HTTP_DATE_FORMAT, &tmNow);
+
+        dwError = VmRESTSetHTTPMiscHeader(
+                      pResPacket->pArena,
+                      pResPacket->miscHeader,
+                      HTTP_HEADER_STR_LAST_MODIFIED,
+                      pszDate
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    pResPacket->cacheMaxAge = nMaxAgeSec;
+
+cleanup:
+    return dwError;
+error:
+    goto cleanup;
+}
+
+void
+VmRESTCacheCapture(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_REST_HTTP_RESPONSE_PACKET    pResPacket,
+    PVM_SOCK_IO_VEC                  pVec,
+    uint32_t                         nVec,
+    BOOLEAN                          bHeader
+    )
+{
+    PVM_REST_HTTP_HEADER_NODE        pNode = NULL;
+    uint32_t                         i = 0;
+
+    if (!pRESTHandle || !pResPacket || (pResPacket->cacheMaxAge == 0))
+    {
+        return;
+    }
+
+    if (bHeader)
+    {
+        if (strcmp(pResPacket->statusLine->statusCode, "200") != 0)
+        {
+            VmRESTCacheAbort(pResPacket);
+            return;
+        }
+
+        /**** Connection belongs to the request being answered, it is added back on every hit ****/
+        for (pNode = pResPacket->miscHeader->head; pNode != NULL; pNode = pNode->next)
+        {
+            if (strcasecmp(pNode->header, HTTP_HEADER_STR_CONNECTION) == 0)
+            {
+                continue;
+            }
+
+            if (!VmRESTCacheAppend(pRESTHandle, pResPacket, pNode->header, strlen(pNode->header)) ||
+                !VmRESTCacheAppend(pRESTHandle, pResPacket, ":", 1) ||
+                !VmRESTCacheAppend(pRESTHandle, pResPacket, pNode->value, strlen(pNode->value)) ||
+                !VmRESTCacheAppend(pRESTHandle, pResPacket, "\r\n", 2))
+            {
+                return;
+            }
+        }
+
+        if (!VmRESTCacheAppend(pRESTHandle, pResPacket, "\r\n", 2))
+        {
+            return;
+        }
+
+        i = 1;
+    }
+
+    for (; i < nVec; i++)
+    {
+        if (!VmRESTCacheAppend(pRESTHandle, pResPacket, pVec[i].pBuffer, pVec[i].nBytes))
+        {
+            return;
+        }
+    }
+}
+
+void
+VmRESTCacheRelease(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_REST_HTTP_RESPONSE_PACKET    pResPacket
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+
+    if (!pRESTHandle || !pResPacket)
+    {
+        return;
+    }
+
+    /**** Only a response that went out in full is worth keeping ****/
+    if ((pResPacket->cacheMaxAge > 0) && pResPacket->bPayloadDone && pResPacket->pCache)
+    {
+        dwError = VmRESTCacheInsert(
+                      pRESTHandle,
+                      pResPacket
+                      );
+        if (dwError)
+        {
+            VMREST_LOG_WARNING(pRESTHandle,"Response not cached, error %u", dwError);
+        }
+    }
+
+    VmRESTCacheAbort(pResPacket);
+}
+
+uint32_t
+VmRESTCacheServe(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_REST_HTTP_REQUEST_PACKET     pRequest,
+    BOOLEAN*                         pbServed
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    PREST_ENG_GLOBALS                pGlobals = NULL;
+    PVM_REST_CACHE_SHARD             pShard = NULL;
+    PVM_REST_CACHE_ENTRY             pEntry = NULL;
+    PVM_REST_CACHE_ENTRY             pNext = NULL;
+    PVM_REST_HTTP_RESPONSE_PACKET    pResponse = NULL;
+    char*                            pszKey = NULL;
+    char*                            pszValues = NULL;
+    char const*                      pszCond = NULL;
+    char*                            pszHeader = NULL;
+    uint32_t                         nHeaderBytes = 0;
+    uint64_t                         hash = 0;
+    time_t                           now = 0;
+    time_t                           since = 0;
+    BOOLEAN                          bLocked = FALSE;
+    BOOLEAN                          bNotModified = FALSE;
+    VM_SOCK_IO_VEC                   vec[2];
+
+    if (!pRESTHandle || !pRequest || !pRequest->pResponse || !pbServed)
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid params");
+        dwError = VMREST_HTTP_INVALID_PARAMS;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    *pbServed = FALSE;
+    pGlobals = pRESTHandle->pInstanceGlobal;
+
+    if (!pGlobals->pCacheShards || (strcmp(VmRESTGetRequestSpan(pRequest, &pRequest->requestLine.method), "GET") != 0))
+    {
+        goto cleanup;
+    }
+
+    dwError = VmRESTCacheBuildKey(
+                  pRequest,
+                  &pszKey
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    hash = VmRESTCacheHash(pszKey);
+    pShard = &pGlobals->pCacheShards[hash % VMREST_RESPONSE_CACHE_SHARDS];
+    now = VmRESTCacheNow();
+
+    dwError = VmRESTLockMutex(pShard->pMutex);
+    BAIL_ON_VMREST_ERROR(dwError);
+    bLocked = TRUE;
+
+    for (pEntry = pShard->pBuckets[(hash / VMREST_RESPONSE_CACHE_SHARDS) % HTTP_CACHE_BUCKETS]; pEntry != NULL; pEntry = pNext)
+    {
+        pNext = pEntry->pNextHash;
+
+        if ((pEntry->hash != hash) || (strcmp(pEntry->pszKey, pszKey) != 0))
+        {
+            continue;
+        }
+
+        if (pEntry->expiry <= now)
+        {
+            VmRESTCacheUnlink(pShard, pEntry);
+            continue;
+        }
+
+        /**** Same URI, one entry per set of values of the headers it varies on ****/
+        dwError = VmRESTCacheVaryValues(
+                      pRequest,
+                      pEntry->pszVaryNames,
+                      &pszValues
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        if (strcmp(pEntry->pszVaryValues, pszValues) == 0)
+        {
+            break;
+        }
+    }
+
+    if (pEntry == NULL)
+    {
+        goto cleanup;
+    }
+
+    /**** Most recently used, and kept alive until it is written out ****/
+    pEntry->nRef++;
+    if (pShard->pLRUHead != pEntry)
+    {
+        pEntry->pPrevLRU->pNextLRU = pEntry->pNextLRU;
+        if (pEntry->pNextLRU)
+        {
+            pEntry->pNextLRU->pPrevLRU = pEntry->pPrevLRU;
+        }
+        else
+        {
+            pShard->pLRUTail = pEntry->pPrevLRU;
+        }
+        pEntry->pPrevLRU = NULL;
+        pEntry->pNextLRU = pShard->pLRUHead;
+        pShard->pLRUHead->pPrevLRU = pEntry;
+        pShard->pLRUHead = pEntry;
+    }
+
+    VmRESTUnlockMutex(pShard->pMutex);
+    bLocked = FALSE;
+
+    /**** If-Modified-Since only counts when there is no If-None-Match ****/
+    pszCond = VmRESTCacheRequestHeader(pRequest, HTTP_HEADER_STR_IF_NONE_MATCH, strlen(HTTP_HEADER_STR_IF_NONE_MATCH));
+    if (pszCond != NULL)
+    {
+        bNotModified = VmRESTCacheETagMatch(pszCond, pEntry->pszETag);
+    }
+    else
+    {
+        pszCond = VmRESTCacheRequestHeader(pRequest, HTTP_HEADER_STR_IF_MODIFIED_SINCE, strlen(HTTP_HEADER_STR_IF_MODIFIED_SINCE));
+        if ((pszCond != NULL) && (pEntry->lastModified != 0) && VmRESTCacheParseDate(pszCond, &since))
+        {
+            bNotModified = (pEntry->lastModified <= since);
+        }
+    }
+
+    pResponse = pRequest->pResponse;
+
+    /**** Status line and Connection are this request's own ****/
+    dwError = VmRESTSetSuccessResponse(
+                  pRequest,
+                  &pResponse
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    if (bNotModified)
+    {
+        dwError = VmRESTSetHttpStatusCode(&pResponse, "304");
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        dwError = VmRESTSetHttpReasonPhrase(&pResponse, "Not Modified");
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        if (pEntry->pszETag[0] != '\0')
+        {
+            dwError = VmRESTSetHttpHeader(&pResponse, HTTP_HEADER_STR_ETAG, pEntry->pszETag);
+            BAIL_ON_VMREST_ERROR(dwError);
+        }
+
+        if (pEntry->pszLastModified[0] != '\0')
+        {
+            dwError = VmRESTSetHttpHeader(&pResponse, HTTP_HEADER_STR_LAST_MODIFIED, pEntry->pszLastModified);
+            BAIL_ON_VMREST_ERROR(dwError);
+        }
+
+        if (pEntry->pszVaryNames[0] != '\0')
+        {
+            dwError = VmRESTSetHttpHeader(&pResponse, HTTP_HEADER_STR_VARY, pEntry->pszVaryNames);
+            BAIL_ON_VMREST_ERROR(dwError);
+        }
+
+        dwError = VmRESTSendHeader(
+                      pRESTHandle,
+                      &pResponse
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+    else
+    {
+        dwError = VmRESTBuildResponseHeaderStream(
+                      pResponse,
+                      &pszHeader,
+                      &nHeaderBytes
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        /**** Blank line that ends the head is already in the cached bytes ****/
+        vec[0].pBuffer = pszHeader;
+        vec[0].nBytes = nHeaderBytes - 2;
+        vec[1].pBuffer = pEntry->pData;
+        vec[1].nBytes = (uint32_t)pEntry->nData;
+
+        dwError = VmRESTCommonWriteDataVec(
+                      pRESTHandle,
+                      pRequest->pSocket,
+                      vec,
+                      2
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    pResponse->bHeaderSent = TRUE;
+    pRequest->state = PROCESS_INVALID;
+    *pbServed = TRUE;
+
+    VMREST_LOG_DEBUG(pRESTHandle,"Served %s from response cache%s", pszKey, bNotModified ? ", not modified" : "");
+
+cleanup:
+    if (bLocked)
+    {
+        VmRESTUnlockMutex(pShard->pMutex);
+        bLocked = FALSE;
+    }
+    if (pEntry)
+    {
+        VmRESTCacheUnref(pShard, pEntry);
+    }
+    return dwError;
+error:
+    /**** Entry was not referenced if the lookup itself failed ****/
+    if (bLocked)
+    {
+        VmRESTUnlockMutex(pShard->pMutex);
+        bLocked = FALSE;
+        pEntry = NULL;
+    }
+    goto cleanup;
+}
+
+void
+VmRESTCacheInvalidate(
+    PVMREST_HANDLE                   pRESTHandle,
+    char const*                      pszURIPrefix
+    )
+{
+    PREST_ENG_GLOBALS                pGlobals = NULL;
+    PVM_REST_CACHE_SHARD             pShard = NULL;
+    PVM_REST_CACHE_ENTRY             pEntry = NULL;
+    PVM_REST_CACHE_ENTRY             pNext = NULL;
+    size_t                           nPrefix = 0;
+    uint32_t                         i = 0;
+
+    if (!pRESTHandle || !pRESTHandle->pInstanceGlobal || !pRESTHandle->pInstanceGlobal->pCacheShards)
+    {
+        return;
+    }
+
+    pGlobals = pRESTHandle->pInstanceGlobal;
+    nPrefix = pszURIPrefix ? strlen(pszURIPrefix) : 0;
+
+    /**** A prefix can match in every shard, each one is locked on its own ****/
+    for (i = 0; i < VMREST_RESPONSE_CACHE_SHARDS; i++)
+    {
+        pShard = &pGlobals->pCacheShards[i];
+
+        VmRESTLockMutex(pShard->pMutex);
+        for (pEntry = pShard->pLRUHead; pEntry != NULL; pEntry = pNext)
+        {
+            pNext = pEntry->pNextLRU;
+            if ((nPrefix == 0) || (strncmp(pEntry->pszURI, pszURIPrefix, nPrefix) == 0))
+            {
+                VmRESTCacheUnlink(pShard, pEntry);
+            }
+        }
+        VmRESTUnlockMutex(pShard->pMutex);
+    }
+}
+
+static
+uint32_t
+VmRESTCacheInsert(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_REST_HTTP_RESPONSE_PACKET    pResPacket
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    PREST_ENG_GLOBALS                pGlobals = pRESTHandle->pInstanceGlobal;
+    PVM_REST_HTTP_REQUEST_PACKET     pRequest = pResPacket->requestPacket;
+    PVM_REST_CACHE_SHARD             pShard = NULL;
+    PVM_REST_CACHE_ENTRY             pEntry = NULL;
+    PVM_REST_CACHE_ENTRY             pOld = NULL;
+    PVM_REST_CACHE_ENTRY             pNext = NULL;
+    PVM_REST_CACHE_ENTRY*            ppBucket = NULL;
+    char*                            pszKey = NULL;
+    char*                            pszVary = NULL;
+    char*                            pszValues = NULL;
+    char*                            pszETag = NULL;
+    char*                            pszLastModified = NULL;
+    char*                            curr = NULL;
+    size_t                           nKey = 0;
+    size_t                           nVary = 0;
+    size_t                           nValues = 0;
+    size_t                           nETag = 0;
+    size_t                           nLastModified = 0;
+    size_t                           nTotal = 0;
+
+    dwError = VmRESTGetHttpResponseHeader(pResPacket, HTTP_HEADER_STR_VARY, &pszVary);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    /**** Varies on something other than request headers ****/
+    if ((pszVary != NULL) && (strchr(pszVary, '*') != NULL))
+    {
+        goto cleanup;
+    }
+
+    dwError = VmRESTGetHttpResponseHeader(pResPacket, HTTP_HEADER_STR_ETAG, &pszETag);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTGetHttpResponseHeader(pResPacket, HTTP_HEADER_STR_LAST_MODIFIED, &pszLastModified);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTCacheBuildKey(
+                  pRequest,
+                  &pszKey
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTCacheVaryValues(
+                  pRequest,
+                  pszVary,
+                  &pszValues
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    nKey = strlen(pszKey) + 1;
+    nVary = (pszVary ? strlen(pszVary) : 0) + 1;
+    nValues = strlen(pszValues) + 1;
+    nETag = (pszETag ? strlen(pszETag) : 0) + 1;
+    nLastModified = (pszLastModified ? strlen(pszLastModified) : 0) + 1;
+    nTotal = sizeof(VM_REST_CACHE_ENTRY) + nKey + nVary + nValues + nETag + nLastModified + pResPacket->nCache;
+
+    if (nTotal > pGlobals->nCacheShardBytes)
+    {
+        goto cleanup;
+    }
+
+    /**** Entry, its strings and the response bytes in one block ****/
+    dwError = VmRESTAllocateMemory(
+                  nTotal,
+                  (void**)&pEntry
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    curr = (char*)(pEntry + 1);
+
+    pEntry->pszKey = curr;
+    memcpy(curr, pszKey, nKey);
+    curr += nKey;
+    pEntry->pszURI = strchr(pEntry->pszKey, ' ') + 1;
+
+    pEntry->pszVaryNames = curr;
+    memcpy(curr, pszVary ? pszVary : "", nVary);
+    curr += nVary;
+
+    pEntry->pszVaryValues = curr;
+    memcpy(curr, pszValues, nValues);
+    curr += nValues;
+
+    pEntry->pszETag = curr;
+    memcpy(curr, pszETag ? pszETag : "", nETag);
+    curr += nETag;
+
+    pEntry->pszLastModified = curr;
+    memcpy(curr, pszLastModified ? pszLastModified : "", nLastModified);
+    curr += nLastModified;
+
+    pEntry->pData = curr;
+    memcpy(curr, pResPacket->pCache, pResPacket->nCache);
+    pEntry->nData = pResPacket->nCache;
+
+    pEntry->nCost = nTotal;
+    pEntry->hash = VmRESTCacheHash(pEntry->pszKey);
+    pEntry->expiry = VmRESTCacheNow() + pResPacket->cacheMaxAge;
+    if (!VmRESTCacheParseDate(pEntry->pszLastModified, &pEntry->lastModified))
+    {
+        pEntry->lastModified = 0;
+    }
+
+    pShard = &pGlobals->pCacheShards[pEntry->hash % VMREST_RESPONSE_CACHE_SHARDS];
+    ppBucket = &pShard->pBuckets[(pEntry->hash / VMREST_RESPONSE_CACHE_SHARDS) % HTTP_CACHE_BUCKETS];
+
+    dwError = VmRESTLockMutex(pShard->pMutex);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    /**** Newer copy of the same variant replaces the old one ****/
+    for (pOld = *ppBucket; pOld != NULL; pOld = pNext)
+    {
+        pNext = pOld->pNextHash;
+        if ((pOld->hash == pEntry->hash) &&
+            (strcmp(pOld->pszKey, pEntry->pszKey) == 0) &&
+            (strcmp(pOld->pszVaryValues, pEntry->pszVaryValues) == 0))
+        {
+            VmRESTCacheUnlink(pShard, pOld);
+        }
+    }
+
+    pEntry->pNextHash = *ppBucket;
+    *ppBucket = pEntry;
+
+    pEntry->pNextLRU = pShard->pLRUHead;
+    if (pShard->pLRUHead)
+    {
+        pShard->pLRUHead->pPrevLRU = pEntry;
+    }
+    pShard->pLRUHead = pEntry;
+    if (pShard->pLRUTail == NULL)
+    {
+        pShard->pLRUTail = pEntry;
+    }
+    pShard->nBytes += pEntry->nCost;
+
+    /**** Least recently used go first until the shard is back in budget ****/
+    while ((pShard->nBytes > pGlobals->nCacheShardBytes) && (pShard->pLRUTail != pEntry))
+    {
+        VmRESTCacheUnlink(pShard, pShard->pLRUTail);
+    }
+
+    VmRESTUnlockMutex(pShard->pMutex);
+    pEntry = NULL;
+
+cleanup:
+    return dwError;
+error:
+    if (pEntry)
+    {
+        VmRESTFreeMemory(pEntry);
+    }
+    goto cleanup;
+}
+
+static
+uint32_t
+VmRESTCacheBuildKey(
+    PVM_REST_HTTP_REQUEST_PACKET     pRequest,
+    char**                           ppszKey
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    char const*                      pszMethod = NULL;
+    char const*                      pszURI = NULL;
+    char*                            pszKey = NULL;
+    size_t                           nMethod = 0;
+    size_t                           nURI = 0;
+
+    pszMethod = VmRESTGetRequestSpan(pRequest, &pRequest->requestLine.method);
+    pszURI = VmRESTGetRequestSpan(pRequest, &pRequest->requestLine.uri);
+    nMethod = strlen(pszMethod);
+    nURI = strlen(pszURI);
+
+    /**** URI as the router saw it, query string included ****/
+    dwError = VmRESTArenaAllocate(
+                  pRequest->pArena,
+                  nMethod + 1 + nURI + 1,
+                  (void**)&pszKey
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    memcpy(pszKey, pszMethod, nMethod);
+    pszKey[nMethod] = ' ';
+    memcpy(pszKey + nMethod + 1, pszURI, nURI);
+
+    *ppszKey = pszKey;
+
+cleanup:
+    return dwError;
+error:
+    goto cleanup;
+}
+
+static
+uint32_t
+VmRESTCacheVaryValues(
+    PVM_REST_HTTP_REQUEST_PACKET     pRequest,
+    char const*                      pszVaryNames,
+    char**                           ppszValues
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    char const*                      pszName = NULL;
+    char const*                      pszValue = NULL;
+    char const*                      p = NULL;
+    char*                            pszValues = NULL;
+    char*                            curr = NULL;
+    size_t                           nName = 0;
+    size_t                           nValues = 1;
+    uint32_t                         pass = 0;
+
+    /**** First pass sizes the result, second pass fills it, one '\n' after each value ****/
+    for (pass = 0; pass < 2; pass++)
+    {
+        if (pass == 1)
+        {
+            dwError = VmRESTArenaAllocate(
+                          pRequest->pArena,
+                          nValues,
+                          (void**)&pszValues
+                          );
+            BAIL_ON_VMREST_ERROR(dwError);
+            curr = pszValues;
+        }
+
+        p = pszVaryNames ? pszVaryNames : "";
+        while (*p != '\0')
+        {
+            while ((*p == ' ') || (*p == '\t') || (*p == ','))
+            {
+                p++;
+            }
+
+            pszName = p;
+            while ((*p != '\0') && (*p != ',') && (*p != ' ') && (*p != '\t'))
+            {
+                p++;
+            }
+            nName = p - pszName;
+
+            if (nName == 0)
+            {
+                continue;
+            }
+
+            pszValue = VmRESTCacheRequestHeader(pRequest, pszName, nName);
+            pszValue = pszValue ? pszValue : "";
+
+            if (pass == 0)
+            {
+                nValues += strlen(pszValue) + 1;
+            }
+            else
+            {
+                memcpy(curr, pszValue, strlen(pszValue));
+                curr += strlen(pszValue);
+                *curr++ = '\n';
+            }
+        }
+    }
+
+    *ppszValues = pszValues;
+
+cleanup:
+    return dwError;
+error:
+    goto cleanup;
+}
+
+static
+char const*
+VmRESTCacheRequestHeader(
+    PVM_REST_HTTP_REQUEST_PACKET     pRequest,
+    char const*                      pszName,
+    size_t                           nName
+    )
+{
+    char const*                      pszHeader = NULL;
+    uint32_t                         i = 0;
+
+    for (i = 0; i < pRequest->nHeaders; i++)
+    {
+        pszHeader = VmRESTGetRequestSpan(pRequest, &pRequest->pHeaders[i].header);
+        if ((strncasecmp(pszHeader, pszName, nName) == 0) && (pszHeader[nName] == '\0'))
+        {
+            return VmRESTGetRequestSpan(pRequest, &pRequest->pHeaders[i].value);
+        }
+    }
+
+    return NULL;
+}
+
+static
+BOOLEAN
+VmRESTCacheAppend(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_REST_HTTP_RESPONSE_PACKET    pResPacket,
+    char const*                      pData,
+    size_t                           nData
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    size_t                           nNewSize = 0;
+    char*                            pszNew = NULL;
+
+    /**** Bigger than a shard can hold, it would never be kept ****/
+    if ((pResPacket->nCache + nData) > pRESTHandle->pInstanceGlobal->nCacheShardBytes)
+    {
+        VmRESTCacheAbort(pResPacket);
+        return FALSE;
+    }
+
+    if ((pResPacket->nCache + nData) > pResPacket->nCacheSize)
+    {
+        nNewSize = (pResPacket->nCacheSize > 0) ? (pResPacket->nCacheSize * 2) : HTTP_CACHE_BUF_SIZE;
+        while (nNewSize < (pResPacket->nCache + nData))
+        {
+            nNewSize *= 2;
+        }
+
+        dwError = VmRESTReallocateMemory(
+                      pResPacket->pCache,
+                      (void**)&pszNew,
+                      nNewSize
+                      );
+        if (dwError)
+        {
+            VmRESTCacheAbort(pResPacket);
+            return FALSE;
+        }
+
+        pResPacket->pCache = pszNew;
+        pResPacket->nCacheSize = nNewSize;
+    }
+
+    memcpy(pResPacket->pCache + pResPacket->nCache, pData, nData);
+    pResPacket->nCache += nData;
+
+    return TRUE;
+}
+
+static
+void
+VmRESTCacheAbort(
+    PVM_REST_HTTP_RESPONSE_PACKET    pResPacket
+    )
+{
+    if (pResPacket->pCache)
+    {
+        VmRESTFreeMemory(pResPacket->pCache);
+        pResPacket->pCache = NULL;
+    }
+    pResPacket->nCache = 0;
+    pResPacket->nCacheSize = 0;
+    pResPacket->cacheMaxAge = 0;
+}
+
+static
+void
+VmRESTCacheUnlink(
+    PVM_REST_CACHE_SHARD             pShard,
+    PVM_REST_CACHE_ENTRY             pEntry
+    )
+{
+    PVM_REST_CACHE_ENTRY*            ppNode = NULL;
+
+    /**** Called with the shard lock held ****/
+    ppNode = &pShard->pBuckets[(pEntry->hash / VMREST_RESPONSE_CACHE_SHARDS) % HTTP_CACHE_BUCKETS];
+    while (*ppNode != NULL)
+    {
+        if (*ppNode == pEntry)
+        {
+            *ppNode = pEntry->pNextHash;
+            break;
+        }
+        ppNode = &(*ppNode)->pNextHash;
+    }
+
+    if (pEntry->pPrevLRU)
+    {
+        pEntry->pPrevLRU->pNextLRU = pEntry->pNextLRU;
+    }
+    else
+    {
+        pShard->pLRUHead = pEntry->pNextLRU;
+    }
+
+    if (pEntry->pNextLRU)
+    {
+        pEntry->pNextLRU->pPrevLRU = pEntry->pPrevLRU;
+    }
+    else
+    {
+        pShard->pLRUTail = pEntry->pPrevLRU;
+    }
+
+    pShard->nBytes -= pEntry->nCost;
+
+    /**** A hit still writing it out frees it when done ****/
+    if (pEntry->nRef > 0)
+    {
+        pEntry->bRemoved = TRUE;
+    }
+    else
+    {
+        VmRESTFreeMemory(pEntry);
+    }
+}
+
+static
+void
+VmRESTCacheUnref(
+    PVM_REST_CACHE_SHARD             pShard,
+    PVM_REST_CACHE_ENTRY             pEntry
+    )
+{
+    BOOLEAN                          bFree = FALSE;
+
+    VmRESTLockMutex(pShard->pMutex);
+    pEntry->nRef--;
+    bFree = (pEntry->bRemoved && (pEntry->nRef == 0));
+    VmRESTUnlockMutex(pShard->pMutex);
+
+    if (bFree)
+    {
+        VmRESTFreeMemory(pEntry);
+    }
+}
+
+static
+BOOLEAN
+VmRESTCacheETagMatch(
+    char const*                      pszList,
+    char const*                      pszETag
+    )
+{
+    char const*                      p = pszList;
+    char const*                      pszTag = NULL;
+    size_t                           nTag = 0;
+    size_t                           nETag = 0;
+
+    if (pszETag[0] == '\0')
+    {
+        return FALSE;
+    }
+
+    /**** Weak comparison, W/ is ignored on both sides ****/
+    if (strncmp(pszETag, "W/", 2) == 0)
+    {
+        pszETag += 2;
+    }
+    nETag = strlen(pszETag);
+
+    while (*p != '\0')
+    {
+        while ((*p == ' ') || (*p == '\t') || (*p == ','))
+        {
+            p++;
+        }
+
+        pszTag = p;
+        while ((*p != '\0') && (*p != ',') && (*p != ' ') && (*p != '\t'))
+        {
+            p++;
+        }
+        nTag = p - pszTag;
+
+        if ((nTag == 1) && (*pszTag == '*'))
+        {
+            return TRUE;
+        }
+
+        if ((nTag > 2) && (strncmp(pszTag, "W/", 2) == 0))
+        {
+            pszTag += 2;
+            nTag -= 2;
+        }
+
+        if ((nTag == nETag) && (strncmp(pszTag, pszETag, nTag) == 0))
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+static
+BOOLEAN
+VmRESTCacheParseDate(
+    char const*                      pszDate,
+    time_t*                          pTime
+    )
+{
+    static char const*               months[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
+                                                 "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
+    struct tm                        tmDate = {0};
+    char                             month[4] = {0};
+    int                              i = 0;
+
+    /**** IMF-fixdate only, e.g. "Sun, 06 Nov 1994 08:49:37 GMT" ****/
+    if (sscanf(pszDate, "%*3s, %2d %3s %4d %2d:%2d:%2d GMT",
+               &tmDate.tm_mday, month, &tmDate.tm_year,
+               &tmDate.tm_hour, &tmDate.tm_min, &tmDate.tm_sec) != 6)
+    {
+        return FALSE;
+    }
+
+    for (i = 0; i < 12; i++)
+    {
+        if (strcmp(month, months[i]) == 0)
+        {
+            break;
+        }
+    }
+
+    if (i == 12)
+    {
+        return FALSE;
+    }
+
+    tmDate.tm_mon = i;
+    tmDate.tm_year -= 1900;
+    *pTime = timegm(&tmDate);
+
+    return (*pTime != (time_t)-1);
+}
+
+static
+uint64_t
+VmRESTCacheHash(
+    char const*                      pszKey
+    )
+{
+    uint64_t                         hash = 14695981039346656037ULL;
+
+    /**** FNV-1a ****/
+    while (*pszKey != '\0')
+    {
+        hash ^= (unsigned char)*pszKey++;
+        hash *= 1099511628211ULL;
+    }
+
+    return hash;
+}
+
+static
+time_t
+VmRESTCacheNow(
+    void
+    )
+{
+    struct timespec                  ts = {0};
+
+    /**** Expiry does not move with the wall clock ****/
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ts.tv_sec;
+}
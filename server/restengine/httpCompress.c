@@ -0,0 +1,825 @@
+/* C-REST-Engine
+*
+* Copyright (c) 2017 VMware, Inc. All Rights Reserved.
+*
+* This product is licensed to you under the Apache 2.0 license (the "License").
+* You may not use this product except in compliance with the Apache 2.0 License.
+*
+* This product may include a number of subcomponents with separate copyright
+* notices and license terms. Your use of these subcomponents is subject to the
+* terms and conditions of the subcomponent's license, as noted in the LICENSE file.
+*
+*/
+
+/**** gzip and deflate response bodies, streams are pooled per library instance ****/
+
+#include "includes.h"
+
+static
+int
+VmRESTDeflateNegotiate(
+    PVM_REST_HTTP_REQUEST_PACKET     pRequest
+    );
+
+static
+BOOLEAN
+VmRESTDeflateVaryHasToken(
+    char const*                      pszVary,
+    char const*                      pszToken
+    );
+
+static
+uint32_t
+VmRESTDeflateGet(
+    PVMREST_HANDLE                   pRESTHandle,
+    int                              windowBits,
+    PVM_REST_DEFLATE*                ppDeflate
+    );
+
+static
+void
+VmRESTDeflateFree(
+    PVM_REST_DEFLATE                 pDeflate
+    );
+
+static
+uint32_t
+VmRESTDeflateSendChunk(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_REST_HTTP_RESPONSE_PACKET    pResPacket,
+    char const*                      pszData,
+    uint32_t                         nData,
+    BOOLEAN                          bLast
+    );
+
+uint32_t
+VmRESTDeflateInit(
+    PVMREST_HANDLE                   pRESTHandle
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+
+    if (!pRESTHandle || !pRESTHandle->pInstanceGlobal)
+    {
+        dwError = REST_ERROR_INVALID_HANDLER;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTAllocateMutex(
+                  &pRESTHandle->pInstanceGlobal->pDeflateMutex
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    pRESTHandle->pInstanceGlobal->pDeflatePool = NULL;
+    pRESTHandle->pInstanceGlobal->nDeflatePool = 0;
+
+cleanup:
+    return dwError;
+error:
+    goto cleanup;
+}
+
+void
+VmRESTDeflateShutdown(
+    PVMREST_HANDLE                   pRESTHandle
+    )
+{
+    PREST_ENG_GLOBALS                pGlobals = NULL;
+    PVM_REST_DEFLATE                 pDeflate = NULL;
+
+    if (!pRESTHandle || !pRESTHandle->pInstanceGlobal)
+    {
+        return;
+    }
+
+    pGlobals = pRESTHandle->pInstanceGlobal;
+
+    /**** Engine is stopped, no response holds a stream any more ****/
+    while (pGlobals->pDeflatePool != NULL)
+    {
+        pDeflate = pGlobals->pDeflatePool;
+        pGlobals->pDeflatePool = pDeflate->pNext;
+        VmRESTDeflateFree(pDeflate);
+    }
+    pGlobals->nDeflatePool = 0;
+
+    if (pGlobals->pDeflateMutex)
+    {
+        VmRESTFreeMutex(pGlobals->pDeflateMutex);
+        pGlobals->pDeflateMutex = NULL;
+    }
+}
+
+uint32_t
+VmRESTDeflateStart(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_REST_HTTP_RESPONSE_PACKET    pResPacket,
+    uint64_t                         nBodyLen,
+    BOOLEAN                          bBodyLenKnown
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    char*                            pszEncoding = NULL;
+    char*                            pszVary = NULL;
+    char*                            pszNewVary = NULL;
+    size_t                           nVary = 0;
+    int                              windowBits = 0;
+    PVM_REST_DEFLATE                 pDeflate = NULL;
+
+    if (!pRESTHandle || !pResPacket)
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid params");
+        dwError = VMREST_HTTP_INVALID_PARAMS;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    /**** Decided once, before the header goes out ****/
+    pResPacket->bDeflateChecked = TRUE;
+
+    if (!pRESTHandle->pRESTConfig->useCompression || !pResPacket->requestPacket)
+    {
+        goto cleanup;
+    }
+
+    if (bBodyLenKnown && (nBodyLen < pRESTHandle->pRESTConfig->compressionMinSize))
+    {
+        goto cleanup;
+    }
+
+    /**** Application already picked an encoding, body is left alone ****/
+    dwError = VmRESTGetHttpResponseHeader(
+                  pResPacket,
+                  HTTP_HEADER_STR_CONTENT_ENCODING,
+                  &pszEncoding
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    if (pszEncoding != NULL)
+    {
+        goto cleanup;
+    }
+
+    /**** Body depends on Accept-Encoding from here on, even for clients getting it plain ****/
+    dwError = VmRESTGetHttpResponseHeader(
+                  pResPacket,
+                  HTTP_HEADER_STR_VARY,
+                  &pszVary
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    if (pszVary == NULL)
+    {
+        dwError = VmRESTSetHTTPMiscHeader(
+                      pResPacket->pArena,
+                      pResPacket->miscHeader,
+                      HTTP_HEADER_STR_VARY,
+                      HTTP_HEADER_STR_ACCEPT_ENCODING
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+    else if (!VmRESTDeflateVaryHasToken(pszVary, HTTP_HEADER_STR_ACCEPT_ENCODING))
+    {
+        /**** Keep what the application listed, the cache keys on every name in it ****/
+        nVary = strlen(pszVary);
+        dwError = VmRESTArenaAllocate(
+                      pResPacket->pArena,
+                      nVary + sizeof(", " HTTP_HEADER_STR_ACCEPT_ENCODING),
+                      (void**)&pszNewVary
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        memcpy(pszNewVary, pszVary, nVary);
+        memcpy(pszNewVary + nVary, ", " HTTP_HEADER_STR_ACCEPT_ENCODING, sizeof(", " HTTP_HEADER_STR_ACCEPT_ENCODING));
+
+        dwError = VmRESTRemoveHTTPMiscHeader(
+                      pResPacket->miscHeader,
+                      HTTP_HEADER_STR_VARY
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        dwError = VmRESTSetHTTPMiscHeader(
+                      pResPacket->pArena,
+                      pResPacket->miscHeader,
+                      HTTP_HEADER_STR_VARY,
+                      pszNewVary
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    windowBits = VmRESTDeflateNegotiate(pResPacket->requestPacket);
+    if (windowBits == 0)
+    {
+        goto cleanup;
+    }
+
+    dwError = VmRESTDeflateGet(
+                  pRESTHandle,
+                  windowBits,
+                  &pDeflate
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTSetHTTPMiscHeader(
+                  pResPacket->pArena,
+                  pResPacket->miscHeader,
+                  HTTP_HEADER_STR_CONTENT_ENCODING,
+                  (windowBits == HTTP_GZIP_WINDOW_BITS) ? "gzip" : "deflate"
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    pResPacket->pDeflate = pDeflate;
+    pDeflate = NULL;
+
+cleanup:
+    return dwError;
+error:
+    if (pDeflate)
+    {
+        VmRESTDeflateFree(pDeflate);
+    }
+    goto cleanup;
+}
+
+uint32_t
+VmRESTDeflateChunked(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_REST_HTTP_RESPONSE_PACKET*   ppResPacket,
+    char const*                      pszData,
+    uint32_t                         dataLen
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    PVM_REST_HTTP_RESPONSE_PACKET    pResPacket = NULL;
+    PVM_REST_DEFLATE                 pDeflate = NULL;
+    int                              flush = Z_NO_FLUSH;
+    int                              ret = Z_OK;
+
+    if (!pRESTHandle || !ppResPacket || (*ppResPacket == NULL) || !(*ppResPacket)->pDeflate || (!pszData && (dataLen > 0)))
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid params");
+        dwError = VMREST_HTTP_INVALID_PARAMS;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    pResPacket = *ppResPacket;
+    pDeflate = pResPacket->pDeflate;
+
+    /**** Zero length is the end of the body, same as for plain chunked data ****/
+    flush = (dataLen == 0) ? Z_FINISH : Z_NO_FLUSH;
+
+    pDeflate->stream.next_in = (Bytef*)pszData;
+    pDeflate->stream.avail_in = dataLen;
+
+    for (;;)
+    {
+        pDeflate->stream.next_out = (Bytef*)(pDeflate->pOut + pDeflate->nOut);
+        pDeflate->stream.avail_out = pDeflate->nOutSize - pDeflate->nOut;
+
+        ret = deflate(&pDeflate->stream, flush);
+        if ((ret != Z_OK) && (ret != Z_STREAM_END) && (ret != Z_BUF_ERROR))
+        {
+            VMREST_LOG_ERROR(pRESTHandle,"deflate failed, ret %d", ret);
+            dwError = VMREST_HTTP_VALIDATION_FAILED;
+        }
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        pDeflate->nOut = pDeflate->nOutSize - pDeflate->stream.avail_out;
+
+        if (ret == Z_STREAM_END)
+        {
+            /**** Whatever is left rides with the last chunk ****/
+            dwError = VmRESTDeflateSendChunk(
+                          pRESTHandle,
+                          pResPacket,
+                          pDeflate->pOut,
+                          pDeflate->nOut,
+                          TRUE
+                          );
+            BAIL_ON_VMREST_ERROR(dwError);
+            pDeflate->nOut = 0;
+            break;
+        }
+
+        if (pDeflate->nOut == pDeflate->nOutSize)
+        {
+            dwError = VmRESTDeflateSendChunk(
+                          pRESTHandle,
+                          pResPacket,
+                          pDeflate->pOut,
+                          pDeflate->nOut,
+                          FALSE
+                          );
+            BAIL_ON_VMREST_ERROR(dwError);
+            pDeflate->nOut = 0;
+        }
+        else if ((flush == Z_NO_FLUSH) && (pDeflate->stream.avail_in == 0))
+        {
+            /**** Input taken, output waits until a full chunk builds up ****/
+            break;
+        }
+    }
+
+cleanup:
+    return dwError;
+error:
+    goto cleanup;
+}
+
+uint32_t
+VmRESTDeflateContentLength(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_REST_HTTP_RESPONSE_PACKET*   ppResPacket,
+    char const*                      pszData,
+    uint32_t                         dataLen,
+    BOOLEAN                          bLast
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    PVM_REST_HTTP_RESPONSE_PACKET    pResPacket = NULL;
+    PVM_REST_DEFLATE                 pDeflate = NULL;
+    char*                            pszNew = NULL;
+    size_t                           nNewSize = 0;
+    size_t                           nSpace = 0;
+    size_t                           nSent = 0;
+    uint32_t                         nSend = 0;
+    int                              flush = Z_NO_FLUSH;
+    int                              ret = Z_OK;
+    char                             pszContentLen[MAX_FILE_LEN_STR_SIZE] = {0};
+
+    if (!pRESTHandle || !ppResPacket || (*ppResPacket == NULL) || !(*ppResPacket)->pDeflate || (!pszData && (dataLen > 0)))
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid params");
+        dwError = VMREST_HTTP_INVALID_PARAMS;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    pResPacket = *ppResPacket;
+    pDeflate = pResPacket->pDeflate;
+
+    flush = bLast ? Z_FINISH : Z_NO_FLUSH;
+
+    pDeflate->stream.next_in = (Bytef*)pszData;
+    pDeflate->stream.avail_in = dataLen;
+
+    /**** Compressed length is only known at the end, body is held until then ****/
+    for (;;)
+    {
+        if (pResPacket->nDeflated == pResPacket->nDeflatedSize)
+        {
+            nNewSize = (pResPacket->nDeflatedSize > 0) ? (pResPacket->nDeflatedSize * 2) : pDeflate->nOutSize;
+
+            dwError = VmRESTReallocateMemory(
+                          pResPacket->pDeflated,
+                          (void**)&pszNew,
+                          nNewSize
+                          );
+            BAIL_ON_VMREST_ERROR(dwError);
+
+            pResPacket->pDeflated = pszNew;
+            pResPacket->nDeflatedSize = nNewSize;
+        }
+
+        nSpace = pResPacket->nDeflatedSize - pResPacket->nDeflated;
+        if (nSpace > UINT32_MAX)
+        {
+            nSpace = UINT32_MAX;
+        }
+
+        pDeflate->stream.next_out = (Bytef*)(pResPacket->pDeflated + pResPacket->nDeflated);
+        pDeflate->stream.avail_out = (uInt)nSpace;
+
+        ret = deflate(&pDeflate->stream, flush);
+        if ((ret != Z_OK) && (ret != Z_STREAM_END) && (ret != Z_BUF_ERROR))
+        {
+            VMREST_LOG_ERROR(pRESTHandle,"deflate failed, ret %d", ret);
+            dwError = VMREST_HTTP_VALIDATION_FAILED;
+        }
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        pResPacket->nDeflated += (nSpace - pDeflate->stream.avail_out);
+
+        if (ret == Z_STREAM_END)
+        {
+            break;
+        }
+
+        if ((flush == Z_NO_FLUSH) && (pDeflate->stream.avail_in == 0) && (pDeflate->stream.avail_out > 0))
+        {
+            break;
+        }
+    }
+
+    if (!bLast)
+    {
+        goto cleanup;
+    }
+
+    /**** Content-Length now tells the compressed size ****/
+    snprintf(pszContentLen, sizeof(pszContentLen), "%llu", (unsigned long long)pResPacket->nDeflated);
+
+    dwError = VmRESTRemoveHTTPMiscHeader(
+                  pResPacket->miscHeader,
+                  HTTP_HEADER_STR_CONTENT_LENGTH
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTSetHTTPMiscHeader(
+                  pResPacket->pArena,
+                  pResPacket->miscHeader,
+                  HTTP_HEADER_STR_CONTENT_LENGTH,
+                  pszContentLen
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    nSend = (pResPacket->nDeflated > HTTP_DEFLATE_MAX_WRITE) ? HTTP_DEFLATE_MAX_WRITE : (uint32_t)pResPacket->nDeflated;
+
+    dwError = VmRESTSendHeaderAndPayload(
+                  pRESTHandle,
+                  ppResPacket,
+                  pResPacket->pDeflated,
+                  nSend
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    pResPacket->bHeaderSent = TRUE;
+
+    for (nSent = nSend; nSent < pResPacket->nDeflated; nSent += nSend)
+    {
+        nSend = ((pResPacket->nDeflated - nSent) > HTTP_DEFLATE_MAX_WRITE) ? HTTP_DEFLATE_MAX_WRITE : (uint32_t)(pResPacket->nDeflated - nSent);
+
+        dwError = VmRESTSendPayload(
+                      pRESTHandle,
+                      ppResPacket,
+                      pResPacket->pDeflated + nSent,
+                      nSend
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+cleanup:
+    return dwError;
+error:
+    goto cleanup;
+}
+
+void
+VmRESTDeflateRelease(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_REST_HTTP_RESPONSE_PACKET    pResPacket
+    )
+{
+    PREST_ENG_GLOBALS                pGlobals = NULL;
+    PVM_REST_DEFLATE                 pDeflate = NULL;
+
+    if (!pRESTHandle || !pResPacket)
+    {
+        return;
+    }
+
+    if (pResPacket->pDeflated)
+    {
+        VmRESTFreeMemory(pResPacket->pDeflated);
+        pResPacket->pDeflated = NULL;
+        pResPacket->nDeflated = 0;
+        pResPacket->nDeflatedSize = 0;
+    }
+
+    pDeflate = pResPacket->pDeflate;
+    pResPacket->pDeflate = NULL;
+
+    if (pDeflate == NULL)
+    {
+        return;
+    }
+
+    pGlobals = pRESTHandle->pInstanceGlobal;
+
+    /**** Reset keeps the allocated state, that is the point of pooling ****/
+    deflateReset(&pDeflate->stream);
+    pDeflate->nOut = 0;
+
+    VmRESTLockMutex(pGlobals->pDeflateMutex);
+    if (pGlobals->nDeflatePool < VMREST_MAX_DEFLATE_POOL_SIZE)
+    {
+        pDeflate->pNext = pGlobals->pDeflatePool;
+        pGlobals->pDeflatePool = pDeflate;
+        pGlobals->nDeflatePool++;
+        pDeflate = NULL;
+    }
+    VmRESTUnlockMutex(pGlobals->pDeflateMutex);
+
+    if (pDeflate)
+    {
+        VmRESTDeflateFree(pDeflate);
+    }
+}
+
+static
+BOOLEAN
+VmRESTDeflateVaryHasToken(
+    char const*                      pszVary,
+    char const*                      pszToken
+    )
+{
+    char const*                      pszName = NULL;
+    char const*                      p = pszVary;
+    size_t                           nName = 0;
+    size_t                           nToken = strlen(pszToken);
+
+    while (*p != '\0')
+    {
+        while ((*p == ' ') || (*p == '\t') || (*p == ','))
+        {
+            p++;
+        }
+
+        pszName = p;
+        while ((*p != '\0') && (*p != ',') && (*p != ' ') && (*p != '\t'))
+        {
+            p++;
+        }
+        nName = p - pszName;
+
+        /**** "*" already says the response varies on everything ****/
+        if (((nName == 1) && (*pszName == '*')) ||
+            ((nName == nToken) && (strncasecmp(pszName, pszToken, nToken) == 0)))
+        {
+            return TRUE;
+        }
+    }
+
+    return FALSE;
+}
+
+static
+int
+VmRESTDeflateNegotiate(
+    PVM_REST_HTTP_REQUEST_PACKET     pRequest
+    )
+{
+    char const*                      pszAccept = NULL;
+    char const*                      pszName = NULL;
+    char const*                      p = NULL;
+    size_t                           nName = 0;
+    BOOLEAN                          bRefused = FALSE;
+    int                              gzip = 0;
+    int                              deflate = 0;
+    int                              any = 0;
+    int                              accept = 0;
+    uint32_t                         i = 0;
+
+    for (i = 0; i < pRequest->nHeaders; i++)
+    {
+        if (strcasecmp(VmRESTGetRequestSpan(pRequest, &pRequest->pHeaders[i].header), HTTP_HEADER_STR_ACCEPT_ENCODING) == 0)
+        {
+            pszAccept = VmRESTGetRequestSpan(pRequest, &pRequest->pHeaders[i].value);
+            break;
+        }
+    }
+
+    if (pszAccept == NULL)
+    {
+        return 0;
+    }
+
+    /**** Coding names with an optional q value, q=0 refuses the coding ****/
+    p = pszAccept;
+    while (*p != '\0')
+    {
+        while ((*p == ' ') || (*p == '\t') || (*p == ','))
+        {
+            p++;
+        }
+
+        pszName = p;
+        while ((*p != '\0') && (*p != ',') && (*p != ';') && (*p != ' ') && (*p != '\t'))
+        {
+            p++;
+        }
+        nName = p - pszName;
+
+        bRefused = FALSE;
+        while ((*p != '\0') && (*p != ','))
+        {
+            if (((*p == 'q') || (*p == 'Q')) && (*(p + 1) == '='))
+            {
+                bRefused = TRUE;
+                for (p += 2; ((*p >= '0') && (*p <= '9')) || (*p == '.'); p++)
+                {
+                    if ((*p >= '1') && (*p <= '9'))
+                    {
+                        bRefused = FALSE;
+                    }
+                }
+                continue;
+            }
+            p++;
+        }
+
+        accept = bRefused ? -1 : 1;
+
+        if (((nName == 4) && (strncasecmp(pszName, "gzip", 4) == 0)) ||
+            ((nName == 6) && (strncasecmp(pszName, "x-gzip", 6) == 0)))
+        {
+            gzip = accept;
+        }
+        else if ((nName == 7) && (strncasecmp(pszName, "deflate", 7) == 0))
+        {
+            deflate = accept;
+        }
+        else if ((nName == 1) && (*pszName == '*'))
+        {
+            any = accept;
+        }
+    }
+
+    if ((gzip > 0) || ((gzip == 0) && (any > 0)))
+    {
+        return HTTP_GZIP_WINDOW_BITS;
+    }
+    if ((deflate > 0) || ((deflate == 0) && (any > 0)))
+    {
+        return HTTP_DEFLATE_WINDOW_BITS;
+    }
+
+    return 0;
+}
+
+static
+uint32_t
+VmRESTDeflateGet(
+    PVMREST_HANDLE                   pRESTHandle,
+    int                              windowBits,
+    PVM_REST_DEFLATE*                ppDeflate
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    PREST_ENG_GLOBALS                pGlobals = pRESTHandle->pInstanceGlobal;
+    PVM_REST_DEFLATE*                ppNode = NULL;
+    PVM_REST_DEFLATE                 pDeflate = NULL;
+    int                              ret = Z_OK;
+
+    dwError = VmRESTLockMutex(pGlobals->pDeflateMutex);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    for (ppNode = &pGlobals->pDeflatePool; *ppNode != NULL; ppNode = &(*ppNode)->pNext)
+    {
+        if ((*ppNode)->windowBits == windowBits)
+        {
+            pDeflate = *ppNode;
+            *ppNode = pDeflate->pNext;
+            pDeflate->pNext = NULL;
+            pGlobals->nDeflatePool--;
+            break;
+        }
+    }
+
+    VmRESTUnlockMutex(pGlobals->pDeflateMutex);
+
+    if (pDeflate == NULL)
+    {
+        dwError = VmRESTAllocateMemory(
+                      sizeof(VM_REST_DEFLATE),
+                      (void**)&pDeflate
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        pDeflate->nOutSize = pRESTHandle->pRESTConfig->nResponseChunkSize;
+
+        dwError = VmRESTAllocateMemory(
+                      pDeflate->nOutSize,
+                      (void**)&pDeflate->pOut
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        ret = deflateInit2(
+                  &pDeflate->stream,
+                  (int)pRESTHandle->pRESTConfig->compressionLevel,
+                  Z_DEFLATED,
+                  windowBits,
+                  8,
+                  Z_DEFAULT_STRATEGY
+                  );
+        if (ret != Z_OK)
+        {
+            VMREST_LOG_ERROR(pRESTHandle,"deflateInit2 failed, ret %d", ret);
+            dwError = ENOMEM;
+        }
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        pDeflate->windowBits = windowBits;
+    }
+
+    *ppDeflate = pDeflate;
+
+cleanup:
+    return dwError;
+error:
+    if (pDeflate)
+    {
+        VmRESTDeflateFree(pDeflate);
+    }
+    goto cleanup;
+}
+
+static
+void
+VmRESTDeflateFree(
+    PVM_REST_DEFLATE                 pDeflate
+    )
+{
+    if (pDeflate)
+    {
+        /**** Harmless on a stream that never got initialized ****/
+        deflateEnd(&pDeflate->stream);
+
+        if (pDeflate->pOut)
+        {
+            VmRESTFreeMemory(pDeflate->pOut);
+        }
+        VmRESTFreeMemory(pDeflate);
+    }
+}
+
+static
+uint32_t
+VmRESTDeflateSendChunk(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_REST_HTTP_RESPONSE_PACKET    pResPacket,
+    char const*                      pszData,
+    uint32_t                         nData,
+    BOOLEAN                          bLast
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    char*                            pszHeader = NULL;
+    uint32_t                         nHeaderBytes = 0;
+    char                             chunkSize[HTTP_CHUNKED_DATA_LEN + MAX_EXTRA_CRLF_BUF_SIZE] = {0};
+    VM_SOCK_IO_VEC                   vec[5];
+    uint32_t                         nVec = 0;
+
+    if (pResPacket->bHeaderSent == FALSE)
+    {
+        dwError = VmRESTBuildResponseHeaderStream(
+                      pResPacket,
+                      &pszHeader,
+                      &nHeaderBytes
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        vec[nVec].pBuffer = pszHeader;
+        vec[nVec].nBytes = nHeaderBytes;
+        nVec++;
+    }
+
+    if (nData > 0)
+    {
+        snprintf(chunkSize, sizeof(chunkSize), "%x\r\n", nData);
+
+        vec[nVec].pBuffer = chunkSize;
+        vec[nVec].nBytes = (uint32_t)strlen(chunkSize);
+        nVec++;
+        vec[nVec].pBuffer = (char*)pszData;
+        vec[nVec].nBytes = nData;
+        nVec++;
+        vec[nVec].pBuffer = "\r\n";
+        vec[nVec].nBytes = 2;
+        nVec++;
+    }
+
+    if (bLast)
+    {
+        vec[nVec].pBuffer = "0\r\n\r\n";
+        vec[nVec].nBytes = 5;
+        nVec++;
+    }
+
+    if (nVec == 0)
+    {
+        goto cleanup;
+    }
+
+    VmRESTCacheCapture(
+        pRESTHandle,
+        pResPacket,
+        vec,
+        nVec,
+        (pszHeader != NULL)
+        );
+
+    dwError = VmRESTCommonWriteDataVec(
+                  pRESTHandle,
+                  pResPacket->pSocket,
+                  vec,
+                  nVec
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    pResPacket->bHeaderSent = TRUE;
+
+cleanup:
+    return dwError;
+error:
+    VMREST_LOG_ERROR(pRESTHandle,"%s","Sending compressed chunk failed");
+    goto cleanup;
+}
@@ -48,6 +48,24 @@ VmHTTPInit(
 
     pRESTHandle->debugLogLevel = pRESTHandle->pRESTConfig->debugLogLevel;
 
+    /**** Pool of deflate streams for compressed responses ****/
+    dwError = VmRESTDeflateInit(
+                  pRESTHandle
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    /**** Pool of buffers that collect small chunked writes ****/
+    dwError = VmRESTChunkBufInit(
+                  pRESTHandle
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    /**** Response cache, when nResponseCacheSize gives it a budget ****/
+    dwError = VmRESTCacheInit(
+                  pRESTHandle
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
     /**** Update context Info for this lib instance ****/
     pRESTHandle->pInstanceGlobal->useEndPoint = 0;
 
@@ -162,6 +180,18 @@ VmHTTPShutdown(
         pRESTHandle
         );
 
+    VmRESTCacheShutdown(
+        pRESTHandle
+        );
+
+    VmRESTDeflateShutdown(
+        pRESTHandle
+        );
+
+    VmRESTChunkBufShutdown(
+        pRESTHandle
+        );
+
     if (pRESTHandle)
     {
         VmRESTFreeHandle(pRESTHandle);        
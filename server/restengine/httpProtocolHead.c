@@ -13,9 +13,23 @@
 
 #include "includes.h"
 
+static
+uint32_t
+VmRESTChunkBufGet(
+    PVMREST_HANDLE                   pRESTHandle,
+    char**                           ppBuf
+    );
+
+static
+void
+VmRESTChunkBufRelease(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_REST_HTTP_RESPONSE_PACKET    pResPacket
+    );
+
 BOOLEAN
 VmRESTIsValidHTTPMethod(
-    char*                            pszMethod
+    char const*                      pszMethod
     )
 {
     int                              i = 0;
@@ -47,7 +61,7 @@ VmRESTIsValidHTTPMethod(
 
 BOOLEAN
 VmRESTIsValidHTTPVesion(
-   char*                             pszVersion
+   char const*                       pszVersion
    )
 {
     size_t                           nLen;
@@ -165,9 +179,6 @@ VmRESTHandleExpect(
 {
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
     char*                            pszExpect = NULL;
-    char*                            pszHttpURI = NULL;
-    char*                            pszEndPointURI = NULL;
-    PREST_ENDPOINT                   pEndPoint = NULL;
     uint32_t                         nWrite = 0;
     PREST_RESPONSE                   pIntResPacket = NULL;
 
@@ -193,32 +204,16 @@ VmRESTHandleExpect(
 
         if (pRESTHandle->pInstanceGlobal->useEndPoint == 1)
         {
-            dwError = VmRESTGetHttpURI(
-                          pRequest,
-                          TRUE,
-                          &pszHttpURI
-                          );
-            BAIL_ON_VMREST_ERROR(dwError);
-
-            if (pszHttpURI)
-            {
-                dwError = VmRestGetEndPointURIfromRequestURI(
-                              pszHttpURI,
-                              &pszEndPointURI
-                              );
-                BAIL_ON_VMREST_ERROR(dwError);
-            }
-
-            /**** For bad endpoint, this will return error ****/
-            dwError = VmRestEngineGetEndPoint(
+            /**** For bad endpoint, this will return error, the match is kept for the handler ****/
+            dwError = VmRESTRouteRequest(
                           pRESTHandle,
-                          pszEndPointURI,
-                          &pEndPoint
+                          pRequest
                           );
             BAIL_ON_VMREST_ERROR(dwError);
         }
 
         dwError = VmRESTAllocateHTTPResponsePacket(
+                      pRequest->pArena,
                       &pIntResPacket
                       );
         BAIL_ON_VMREST_ERROR(dwError);
@@ -261,22 +256,6 @@ cleanup:
         VmRESTFreeMemory(pszExpect);
         pszExpect = NULL;
     }
-    if (pszHttpURI)
-    {
-        VmRESTFreeMemory(pszHttpURI);
-        pszHttpURI = NULL;
-    }
-    if (pszEndPointURI)
-    {
-        VmRESTFreeMemory(pszEndPointURI);
-        pszEndPointURI = NULL;
-    }
-
-    if (pIntResPacket)
-    {
-        VmRESTFreeHTTPResponsePacket(&pIntResPacket);
-        pIntResPacket = NULL;
-    }
 
     return dwError;
 
@@ -287,108 +266,6 @@ error:
 
 }
 
-uint32_t
-VMRESTWriteChunkedMessageInResponseStream(
-    char*                            src,
-    uint32_t                         srcSize,
-    char*                            buffer,
-    uint32_t*                        nWritten
-)
-{
-    uint32_t                         dwError = REST_ENGINE_SUCCESS;
-    char*                            curr = NULL;
-    char                             chunkSize[HTTP_CHUNKED_DATA_LEN] = {0};
-    size_t                           chunkLen = 0;
-
-    if (!buffer || srcSize > MAX_DATA_BUFFER_LEN)
-    {
-        dwError = VMREST_HTTP_INVALID_PARAMS;
-    }
-    BAIL_ON_VMREST_ERROR(dwError);
-
-    sprintf(chunkSize, "%x", srcSize);
-    curr = buffer;
-
-    if (srcSize == 0)
-    {
-        /**** This is the last chunk ****/
-        memcpy(curr,"0",1);
-        curr = curr + 1;
-        memcpy(curr,"\r\n\r\n",4);
-        curr = curr + 4;
-        *nWritten = 5;
-    }
-    else
-    {
-        /**** Write the chunk length ****/
-        chunkLen = strlen(chunkSize);
-        memcpy(curr,chunkSize,chunkLen);
-        curr = curr + chunkLen;
-        memcpy(curr,"\r\n",2);
-        curr = curr + 2;
-
-        /**** Write actual chunk data ****/
-        memcpy(curr, src, srcSize);
-        curr = curr + srcSize;
-        memcpy(curr,"\r\n",2);
-        curr = curr + 2;
-        *nWritten = (uint32_t)(srcSize + chunkLen + 4);
-    }
-
-cleanup:
-    return dwError;
-error:
-    goto cleanup;
-}
-
-uint32_t
-VMRESTWriteMessageBodyInResponseStream(
-    PVM_REST_HTTP_RESPONSE_PACKET    pResPacket,
-    char*                            buffer,
-    uint32_t*                        nWritten
-)
-{
-    uint32_t                         dwError = REST_ENGINE_SUCCESS;
-    char*                            curr = NULL;
-    uint32_t                         pszContentLen = 0;
-    char*                            lenBytes = NULL;
-
-    if (!pResPacket || !buffer)
-    {
-        dwError = VMREST_HTTP_INVALID_PARAMS;
-    }
-    BAIL_ON_VMREST_ERROR(dwError);
-
-    curr = buffer;
-
-    dwError = VmRESTGetHttpResponseHeader(
-                  pResPacket,
-                  HTTP_HEADER_STR_CONTENT_LENGTH,
-                  &lenBytes
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
-    if ((lenBytes != NULL) && (strlen(lenBytes) > 0))
-    {
-        pszContentLen = strtoul(lenBytes,NULL, 10);
-        if ((pszContentLen > 0) && (pszContentLen <= MAX_DATA_BUFFER_LEN))
-        {
-            memcpy(curr, pResPacket->messageBody->buffer, pszContentLen);
-        }
-    }
-    else
-    {
-        dwError = VMREST_HTTP_VALIDATION_FAILED;
-    }
-    BAIL_ON_VMREST_ERROR(dwError);
-
-    *nWritten = pszContentLen;
-
-cleanup:
-    return dwError;
-error:
-    goto cleanup;
-}
-
 uint32_t
 VMRESTWriteStatusLineInResponseStream(
     PVM_REST_HTTP_RESPONSE_PACKET    pResPacket,
@@ -513,9 +390,10 @@ error:
 }
 
 uint32_t
-VmRESTSendHeader(
-    PVMREST_HANDLE                   pRESTHandle,
-    PVM_REST_HTTP_RESPONSE_PACKET*   ppResPacket
+VmRESTBuildResponseHeaderStream(
+    PVM_REST_HTTP_RESPONSE_PACKET    pResPacket,
+    char**                           ppszBuffer,
+    uint32_t*                        pnBytes
     )
 {
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
@@ -524,33 +402,30 @@ VmRESTSendHeader(
     uint32_t                         bytes = 0;
     char*                            curr = NULL;
     uint32_t                         size = 0;
-    PVM_REST_HTTP_RESPONSE_PACKET    pResPacket = NULL;
 
-    if (!ppResPacket  || (*ppResPacket == NULL))
+    if (!pResPacket || !ppszBuffer || !pnBytes)
     {
-        VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid params");
         dwError = VMREST_HTTP_INVALID_PARAMS;
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
-    /**** Get the size of buffer big enough to hold response packet ****/
+    /**** Get the size of buffer big enough to hold status line and headers ****/
     dwError = VmRESTGetResponseBufferSize(
-                  *ppResPacket,
+                  pResPacket,
                   &size
                   );
     BAIL_ON_VMREST_ERROR(dwError);
 
-    /**** Allocate buffer to hold stream data *****/
-    dwError = VmRESTAllocateMemory(
+    /**** Only needed until the write completes, the request arena releases it ****/
+    dwError = VmRESTArenaAllocate(
+                  pResPacket->pArena,
                   size,
                   (void**)&buffer
                   );
     BAIL_ON_VMREST_ERROR(dwError);
 
-    pResPacket = *ppResPacket;
     curr = buffer;
 
-    /* Use response object to write to buffer */
     /* 1. Status Line */
     dwError = VMRESTWriteStatusLineInResponseStream(
                   pResPacket,
@@ -571,105 +446,344 @@ VmRESTSendHeader(
                   );
     BAIL_ON_VMREST_ERROR(dwError);
 
-    curr = curr + bytes;
     totalBytes = totalBytes + bytes;
-    bytes = 0;
 
-    dwError = VmRESTCommonWriteDataAtOnce(
-                  pRESTHandle,
-                  pResPacket->pSocket,
-                  buffer,
-                  totalBytes
+    *ppszBuffer = buffer;
+    *pnBytes = totalBytes;
+
+cleanup:
+    return dwError;
+error:
+    goto cleanup;
+}
+
+uint32_t
+VmRESTSendHeader(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_REST_HTTP_RESPONSE_PACKET*   ppResPacket
+    )
+{
+    return VmRESTSendHeaderAndPayload(
+               pRESTHandle,
+               ppResPacket,
+               NULL,
+               0
+               );
+}
+
+uint32_t
+VmRESTChunkBufInit(
+    PVMREST_HANDLE                   pRESTHandle
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+
+    if (!pRESTHandle || !pRESTHandle->pInstanceGlobal)
+    {
+        dwError = REST_ERROR_INVALID_HANDLER;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTAllocateMutex(
+                  &pRESTHandle->pInstanceGlobal->pChunkBufMutex
                   );
     BAIL_ON_VMREST_ERROR(dwError);
 
-    VmRESTFreeMemory(
-        buffer
-        );
-    buffer = NULL;
+    pRESTHandle->pInstanceGlobal->pChunkBufPool = NULL;
+    pRESTHandle->pInstanceGlobal->nChunkBufPool = 0;
 
 cleanup:
     return dwError;
 error:
-    if (buffer)
+    goto cleanup;
+}
+
+void
+VmRESTChunkBufShutdown(
+    PVMREST_HANDLE                   pRESTHandle
+    )
+{
+    PREST_ENG_GLOBALS                pGlobals = NULL;
+    char*                            pBuf = NULL;
+
+    if (!pRESTHandle || !pRESTHandle->pInstanceGlobal)
     {
-        VmRESTFreeMemory(
-            buffer
-            );
-        buffer = NULL;
+        return;
     }
-    VMREST_LOG_ERROR(pRESTHandle,"%s","Sending header data failed");
+
+    pGlobals = pRESTHandle->pInstanceGlobal;
+
+    /**** Engine is stopped, no response holds a buffer any more ****/
+    while (pGlobals->pChunkBufPool != NULL)
+    {
+        pBuf = pGlobals->pChunkBufPool;
+        pGlobals->pChunkBufPool = *(char**)pBuf;
+        VmRESTFreeMemory(pBuf);
+    }
+    pGlobals->nChunkBufPool = 0;
+
+    if (pGlobals->pChunkBufMutex)
+    {
+        VmRESTFreeMutex(pGlobals->pChunkBufMutex);
+        pGlobals->pChunkBufMutex = NULL;
+    }
+}
+
+/**** Buffers are nResponseChunkSize each, an idle one keeps the free list link in its first bytes ****/
+static
+uint32_t
+VmRESTChunkBufGet(
+    PVMREST_HANDLE                   pRESTHandle,
+    char**                           ppBuf
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    PREST_ENG_GLOBALS                pGlobals = pRESTHandle->pInstanceGlobal;
+    char*                            pBuf = NULL;
+    size_t                           nSize = 0;
+
+    VmRESTLockMutex(pGlobals->pChunkBufMutex);
+    if (pGlobals->pChunkBufPool != NULL)
+    {
+        pBuf = pGlobals->pChunkBufPool;
+        pGlobals->pChunkBufPool = *(char**)pBuf;
+        pGlobals->nChunkBufPool--;
+    }
+    VmRESTUnlockMutex(pGlobals->pChunkBufMutex);
+
+    if (pBuf == NULL)
+    {
+        nSize = pRESTHandle->pRESTConfig->nResponseChunkSize;
+        dwError = VmRESTAllocateMemory(
+                      (nSize < sizeof(char*)) ? sizeof(char*) : nSize,
+                      (void**)&pBuf
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    *ppBuf = pBuf;
+
+cleanup:
+    return dwError;
+error:
     goto cleanup;
 }
 
+static
+void
+VmRESTChunkBufRelease(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_REST_HTTP_RESPONSE_PACKET    pResPacket
+    )
+{
+    PREST_ENG_GLOBALS                pGlobals = pRESTHandle->pInstanceGlobal;
+    char*                            pBuf = pResPacket->pChunkBuf;
+
+    if (pBuf == NULL)
+    {
+        return;
+    }
+
+    pResPacket->pChunkBuf = NULL;
+    pResPacket->nChunkBuf = 0;
+
+    VmRESTLockMutex(pGlobals->pChunkBufMutex);
+    if (pGlobals->nChunkBufPool < VMREST_MAX_CHUNK_BUFFER_POOL_SIZE)
+    {
+        *(char**)pBuf = pGlobals->pChunkBufPool;
+        pGlobals->pChunkBufPool = pBuf;
+        pGlobals->nChunkBufPool++;
+        pBuf = NULL;
+    }
+    VmRESTUnlockMutex(pGlobals->pChunkBufMutex);
+
+    if (pBuf)
+    {
+        VmRESTFreeMemory(pBuf);
+    }
+}
+
 uint32_t
 VmRESTSendChunkedPayload(
     PVMREST_HANDLE                   pRESTHandle,
     PVM_REST_HTTP_RESPONSE_PACKET*   ppResPacket,
+    char const*                      pszData,
     uint32_t                         dataLen
     )
 {
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
-    char*                            buffer = NULL;
-    uint32_t                         totalBytes = 0;
-    uint32_t                         bytes = 0;
-    char*                            curr = NULL;
+    char*                            pszHeader = NULL;
+    uint32_t                         nHeaderBytes = 0;
+    char                             bufChunkSize[HTTP_CHUNKED_DATA_LEN + MAX_EXTRA_CRLF_BUF_SIZE] = {0};
+    char                             dataChunkSize[HTTP_CHUNKED_DATA_LEN + MAX_EXTRA_CRLF_BUF_SIZE] = {0};
+    VM_SOCK_IO_VEC                   vec[7];
+    uint32_t                         nVec = 0;
+    uint32_t                         nChunkSize = 0;
+    BOOLEAN                          bKeepData = FALSE;
     PVM_REST_HTTP_RESPONSE_PACKET    pResPacket = NULL;
 
-    if (!ppResPacket  || (*ppResPacket == NULL))
+    if (!pRESTHandle || !ppResPacket  || (*ppResPacket == NULL) || (!pszData && (dataLen > 0)))
     {
         VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid params");
         dwError = VMREST_HTTP_INVALID_PARAMS;
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
-    dwError = VmRESTAllocateMemory(
-                  (MAX_DATA_BUFFER_LEN + MAX_EXTRA_CRLF_BUF_SIZE),
-                  (void**)&buffer
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
-
     pResPacket = *ppResPacket;
-    curr = buffer;
+    nChunkSize = pRESTHandle->pRESTConfig->nResponseChunkSize;
 
-    dwError = VMRESTWriteChunkedMessageInResponseStream(
-                  pResPacket->messageBody->buffer,
-                  dataLen,
-                  curr,
-                  &bytes
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
+    if (pResPacket->pDeflate)
+    {
+        dwError = VmRESTDeflateChunked(
+                      pRESTHandle,
+                      ppResPacket,
+                      pszData,
+                      dataLen
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+        goto cleanup;
+    }
 
-    /**** reset the buffer in response packet ****/
-    memset(pResPacket->messageBody->buffer, '\0', MAX_DATA_BUFFER_LEN);
+    /**** Small writes are merged into one chunk, nothing goes out until it is full ****/
+    if ((dataLen > 0) && (dataLen < nChunkSize) && ((pResPacket->nChunkBuf + dataLen) <= nChunkSize))
+    {
+        /**** Pooled, an arena block this size would be a slab of its own malloc'd per response ****/
+        if (pResPacket->pChunkBuf == NULL)
+        {
+            dwError = VmRESTChunkBufGet(
+                          pRESTHandle,
+                          &pResPacket->pChunkBuf
+                          );
+            BAIL_ON_VMREST_ERROR(dwError);
+        }
 
-    totalBytes = totalBytes + bytes;
-    bytes = 0;
+        memcpy(pResPacket->pChunkBuf + pResPacket->nChunkBuf, pszData, dataLen);
+        pResPacket->nChunkBuf += dataLen;
+        goto cleanup;
+    }
 
-    
-    dwError = VmRESTCommonWriteDataAtOnce(
+    /**** Compression is decided on the first chunk that leaves ****/
+    if ((pResPacket->bHeaderSent == FALSE) && (pResPacket->bDeflateChecked == FALSE))
+    {
+        dwError = VmRESTDeflateStart(
+                      pRESTHandle,
+                      pResPacket,
+                      (uint64_t)pResPacket->nChunkBuf + dataLen,
+                      (dataLen == 0)
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        if (pResPacket->pDeflate)
+        {
+            if (pResPacket->nChunkBuf > 0)
+            {
+                dwError = VmRESTDeflateChunked(
+                              pRESTHandle,
+                              ppResPacket,
+                              pResPacket->pChunkBuf,
+                              pResPacket->nChunkBuf
+                              );
+                BAIL_ON_VMREST_ERROR(dwError);
+                pResPacket->nChunkBuf = 0;
+            }
+
+            dwError = VmRESTDeflateChunked(
+                          pRESTHandle,
+                          ppResPacket,
+                          pszData,
+                          dataLen
+                          );
+            BAIL_ON_VMREST_ERROR(dwError);
+            goto cleanup;
+        }
+    }
+
+    /**** First write carries the header along ****/
+    if (pResPacket->bHeaderSent == FALSE)
+    {
+        dwError = VmRESTBuildResponseHeaderStream(
+                      pResPacket,
+                      &pszHeader,
+                      &nHeaderBytes
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        vec[nVec].pBuffer = pszHeader;
+        vec[nVec].nBytes = nHeaderBytes;
+        nVec++;
+    }
+
+    if (pResPacket->nChunkBuf > 0)
+    {
+        snprintf(bufChunkSize, sizeof(bufChunkSize), "%x\r\n", pResPacket->nChunkBuf);
+
+        vec[nVec].pBuffer = bufChunkSize;
+        vec[nVec].nBytes = (uint32_t)strlen(bufChunkSize);
+        nVec++;
+        vec[nVec].pBuffer = pResPacket->pChunkBuf;
+        vec[nVec].nBytes = pResPacket->nChunkBuf;
+        nVec++;
+        vec[nVec].pBuffer = "\r\n";
+        vec[nVec].nBytes = 2;
+        nVec++;
+    }
+
+    if (dataLen == 0)
+    {
+        /**** This is the last chunk ****/
+        vec[nVec].pBuffer = "0\r\n\r\n";
+        vec[nVec].nBytes = 5;
+        nVec++;
+    }
+    else if (dataLen >= nChunkSize)
+    {
+        /**** Large buffer is a chunk of its own, framed around the caller's data ****/
+        snprintf(dataChunkSize, sizeof(dataChunkSize), "%x\r\n", dataLen);
+
+        vec[nVec].pBuffer = dataChunkSize;
+        vec[nVec].nBytes = (uint32_t)strlen(dataChunkSize);
+        nVec++;
+        vec[nVec].pBuffer = (char*)pszData;
+        vec[nVec].nBytes = dataLen;
+        nVec++;
+        vec[nVec].pBuffer = "\r\n";
+        vec[nVec].nBytes = 2;
+        nVec++;
+    }
+    else
+    {
+        /**** Did not fit behind the buffered data, starts the next chunk ****/
+        bKeepData = TRUE;
+    }
+
+    VmRESTCacheCapture(
+        pRESTHandle,
+        pResPacket,
+        vec,
+        nVec,
+        (pszHeader != NULL)
+        );
+
+    dwError = VmRESTCommonWriteDataVec(
                   pRESTHandle,
                   pResPacket->pSocket,
-                  buffer,
-                  totalBytes
+                  vec,
+                  nVec
                   );
     BAIL_ON_VMREST_ERROR(dwError);
 
-    VmRESTFreeMemory(
-        buffer
-        );
-    buffer = NULL;
+    pResPacket->bHeaderSent = TRUE;
+    pResPacket->nChunkBuf = 0;
+
+    if (bKeepData)
+    {
+        memcpy(pResPacket->pChunkBuf, pszData, dataLen);
+        pResPacket->nChunkBuf = dataLen;
+    }
 
 cleanup:
     return dwError;
 error:
-    if (buffer)
-    {
-        VmRESTFreeMemory(
-            buffer
-            );
-        buffer = NULL;
-    }
     VMREST_LOG_ERROR(pRESTHandle,"%s","Sending chunked payload data failed");
     goto cleanup;
 }
@@ -677,109 +791,113 @@ error:
 uint32_t
 VmRESTSendHeaderAndPayload(
     PVMREST_HANDLE                   pRESTHandle,
-    PVM_REST_HTTP_RESPONSE_PACKET*   ppResPacket
+    PVM_REST_HTTP_RESPONSE_PACKET*   ppResPacket,
+    char const*                      pszPayload,
+    uint32_t                         nPayloadLen
     )
 {
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
-    char*                            buffer = NULL;
-    uint32_t                         totalBytes = 0;
-    uint32_t                         bytes = 0;
-    char*                            curr = NULL;
-    uint32_t                         size = 0;
-    PVM_REST_HTTP_RESPONSE_PACKET    pResPacket = NULL;
+    char*                            pszHeader = NULL;
+    uint32_t                         nHeaderBytes = 0;
+    VM_SOCK_IO_VEC                   vec[2];
+    uint32_t                         nVec = 0;
 
-    if (!ppResPacket || (*ppResPacket == NULL))
+    if (!ppResPacket || (*ppResPacket == NULL) || (!pszPayload && (nPayloadLen > 0)))
     {
         VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid params");
         dwError = VMREST_HTTP_INVALID_PARAMS;
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
-    dwError = VmRESTGetResponseBufferSize(
+    dwError = VmRESTBuildResponseHeaderStream(
                   *ppResPacket,
-                  &size
+                  &pszHeader,
+                  &nHeaderBytes
                   );
     BAIL_ON_VMREST_ERROR(dwError);
 
-    /**** This fuction is called only when size of payload is 
-          less than 4096. Adding 10 extra bytes on top of it ****/
-
-    size += MAX_DATA_BUFFER_LEN;
-    size += 10;
+    /**** Header and body leave in one write, body is not copied ****/
+    vec[nVec].pBuffer = pszHeader;
+    vec[nVec].nBytes = nHeaderBytes;
+    nVec++;
 
-    dwError = VmRESTAllocateMemory(
-                  size,
-                  (void**)&buffer
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
-
-    pResPacket = *ppResPacket;
-    curr = buffer;
-
-    /* Use response object to write to buffer */
-    /* 1. Status Line */
-    dwError = VMRESTWriteStatusLineInResponseStream(
-                  pResPacket,
-                  curr,
-                  &bytes
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
+    if (nPayloadLen > 0)
+    {
+        vec[nVec].pBuffer = (char*)pszPayload;
+        vec[nVec].nBytes = nPayloadLen;
+        nVec++;
+    }
 
-    curr = curr + bytes;
-    totalBytes = totalBytes + bytes;
-    bytes = 0;
+    VmRESTCacheCapture(
+        pRESTHandle,
+        *ppResPacket,
+        vec,
+        nVec,
+        TRUE
+        );
 
-    /* 2. Response Headers */
-    dwError = VmRESTAddAllHeaderInResponseStream(
-                  pResPacket,
-                  curr,
-                  &bytes
+    dwError = VmRESTCommonWriteDataVec(
+                  pRESTHandle,
+                  (*ppResPacket)->pSocket,
+                  vec,
+                  nVec
                   );
     BAIL_ON_VMREST_ERROR(dwError);
 
-    curr = curr + bytes;
-    totalBytes = totalBytes + bytes;
-    bytes = 0;
+cleanup:
+    return dwError;
+error:
+    VMREST_LOG_ERROR(pRESTHandle,"%s","Sending header and payload data failed");
+    goto cleanup;
+}
 
-    /* 3. Message Body */
+uint32_t
+VmRESTSendPayload(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_REST_HTTP_RESPONSE_PACKET*   ppResPacket,
+    char const*                      pszPayload,
+    uint32_t                         nPayloadLen
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    VM_SOCK_IO_VEC                   vec[1];
 
-    dwError = VMRESTWriteMessageBodyInResponseStream(
-                  pResPacket,
-                  curr,
-                  &bytes
-                  );
+    if (!ppResPacket || (*ppResPacket == NULL) || (!pszPayload && (nPayloadLen > 0)))
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid params");
+        dwError = VMREST_HTTP_INVALID_PARAMS;
+    }
     BAIL_ON_VMREST_ERROR(dwError);
 
-    curr = curr + bytes;
-    totalBytes = totalBytes + bytes;
-    bytes = 0;
+    if (nPayloadLen == 0)
+    {
+        goto cleanup;
+    }
 
-    /**** This is for debug purpose:: will be removed ****/
+    /**** Rest of a Content-Length body, straight from the caller's buffer ****/
+    vec[0].pBuffer = (char*)pszPayload;
+    vec[0].nBytes = nPayloadLen;
 
-    dwError = VmRESTCommonWriteDataAtOnce(
+    VmRESTCacheCapture(
+        pRESTHandle,
+        *ppResPacket,
+        vec,
+        1,
+        FALSE
+        );
+
+    dwError = VmRESTCommonWriteDataVec(
                   pRESTHandle,
-                  pResPacket->pSocket,
-                  buffer,
-                  totalBytes
+                  (*ppResPacket)->pSocket,
+                  vec,
+                  1
                   );
     BAIL_ON_VMREST_ERROR(dwError);
 
-    VmRESTFreeMemory(
-        buffer
-        );
-    buffer = NULL;
-
 cleanup:
     return dwError;
 error:
-    if (buffer)
-    {
-        VmRESTFreeMemory(
-            buffer
-            );
-        buffer = NULL;
-    }
-    VMREST_LOG_ERROR(pRESTHandle,"%s","Sending header and payload data failed");
+    VMREST_LOG_ERROR(pRESTHandle,"%s","Sending payload data failed");
     goto cleanup;
 }
 
@@ -807,11 +925,11 @@ VmRESTGetRequestHandle(
     BAIL_ON_VMREST_ERROR(dwError);
 
     dwError = VmRESTAllocateHTTPResponsePacket(
+                  pRequest->pArena,
                   &pResponse
                   );
     BAIL_ON_VMREST_ERROR(dwError);
 
-    pRequest->miscHeader->head = NULL;
     pRequest->pSocket = pSocket;
     pRequest->dataNotRcvd  = 0;
     pRequest->nPayload = 0;
@@ -848,6 +966,7 @@ cleanup:
 
 error:
 
+    /**** Response, if any, was carved from the request arena ****/
     if (pRequest)
     {
         VmRESTFreeHTTPRequestPacket(
@@ -856,14 +975,6 @@ error:
         pRequest = NULL;
     }
 
-    if (pResponse)
-    {
-        VmRESTFreeHTTPResponsePacket(
-            &pResponse
-            );
-        pResponse = NULL;
-    }
-
     goto cleanup;
 
 }
@@ -880,20 +991,33 @@ VmRESTFreeRequestHandle(
         return;
     }
 
+    /**** A complete cacheable response is kept before the arena goes ****/
     if (pRequest->pResponse)
     {
-        VmRESTFreeHTTPResponsePacket(
-            &(pRequest->pResponse)
+        VmRESTCacheRelease(
+            pRESTHandle,
+            pRequest->pResponse
             );
-        pRequest->pResponse = NULL;
     }
 
-    if (pRequest)
+    /**** Deflate stream and its output live outside the arena, so does the chunk buffer ****/
+    if (pRequest->pResponse)
     {
-        VmRESTFreeHTTPRequestPacket(
-            &pRequest
+        VmRESTDeflateRelease(
+            pRESTHandle,
+            pRequest->pResponse
+            );
+
+        VmRESTChunkBufRelease(
+            pRESTHandle,
+            pRequest->pResponse
             );
     }
+
+    /**** Payload aside, request and response go back to the slabs in one step ****/
+    VmRESTFreeHTTPRequestPacket(
+        &pRequest
+        );
 }
 
 uint32_t
@@ -911,6 +1035,7 @@ VmRESTProcessRequestLine(
     char*                            pszFirstSpace = NULL;
     char*                            pszSecondSpace = NULL;
     uint32_t                         nLineLen = 0;
+    VM_REST_LINE_SCAN                lineScan = {0};
 
     if (!pRESTHandle || !pRequest || !nProcessed || !pszBuffer)
     {
@@ -920,22 +1045,27 @@ VmRESTProcessRequestLine(
     BAIL_ON_VMREST_ERROR(dwError);
 
     *nProcessed = 0;
- 
-    pszEndNewLine = strstr(pszStartNewLine, "\r\n");
-    if (pszEndNewLine != NULL)
+
+    if (VmRESTScanLine(pszStartNewLine, nBytes, &lineScan))
     {
-        nLineLen = pszEndNewLine - pszStartNewLine;
+        nLineLen = lineScan.nLineLen;
+        pszEndNewLine = pszStartNewLine + nLineLen;
 
         if (nLineLen < MAX_REQ_LIN_LEN)
         {
             /**** 1. Parsing HTTP METHOD ****/
-            pszFirstSpace = strchr(pszStartNewLine, ' ');
+            pszFirstSpace = (lineScan.nFirstSpace != HTTP_SCAN_NOT_FOUND) ? (pszStartNewLine + lineScan.nFirstSpace) : NULL;
             if (pszFirstSpace != NULL && ((pszFirstSpace - pszStartNewLine) <= MAX_METHOD_LEN) && ((pszFirstSpace - pszStartNewLine) > 0))
             {
-                strncpy(pRequest->requestLine->method, pszStartNewLine, (pszFirstSpace - pszStartNewLine));
-                pRequest->requestLine->method[pszFirstSpace - pszStartNewLine] = '\0';
+                dwError = VmRESTAppendRequestHead(
+                              pRequest,
+                              pszStartNewLine,
+                              (pszFirstSpace - pszStartNewLine),
+                              &pRequest->requestLine.method
+                              );
+                BAIL_ON_VMREST_ERROR(dwError);
 
-                if(!VmRESTIsValidHTTPMethod(pRequest->requestLine->method))
+                if(!VmRESTIsValidHTTPMethod(VmRESTGetRequestSpan(pRequest, &pRequest->requestLine.method)))
                 {
                     VMREST_LOG_ERROR(pRESTHandle,"%s","Bad HTTP method in request");
                     dwError = METHOD_NOT_ALLOWED;
@@ -943,20 +1073,30 @@ VmRESTProcessRequestLine(
                 BAIL_ON_VMREST_ERROR(dwError);
 
                 /**** 2. Parse HTTP URI****/
-                pszSecondSpace = strchr((pszFirstSpace + 1), ' ');
+                pszSecondSpace = (lineScan.nSecondSpace != HTTP_SCAN_NOT_FOUND) ? (pszStartNewLine + lineScan.nSecondSpace) : NULL;
              
                 if (pszSecondSpace != NULL && ((pszSecondSpace - pszFirstSpace) < MAX_URI_LEN) && ((pszSecondSpace - pszFirstSpace) > 0))
                 {
-                    strncpy(pRequest->requestLine->uri, (pszFirstSpace + 1), (pszSecondSpace - pszFirstSpace - 1));
-                    pRequest->requestLine->uri[pszSecondSpace - pszFirstSpace - 1] = '\0';
+                    dwError = VmRESTAppendRequestHead(
+                                  pRequest,
+                                  (pszFirstSpace + 1),
+                                  (pszSecondSpace - pszFirstSpace - 1),
+                                  &pRequest->requestLine.uri
+                                  );
+                    BAIL_ON_VMREST_ERROR(dwError);
 
                     /**** 3. Parse HTTP Version ****/
                     if (((pszEndNewLine - pszSecondSpace - 1) <= HTTP_VER_LEN) && ((pszEndNewLine - pszSecondSpace - 1) > 0))
                     {
-                        strncpy(pRequest->requestLine->version, (pszSecondSpace + 1), (pszEndNewLine - pszSecondSpace - 1));
-                        pRequest->requestLine->version[pszEndNewLine - pszSecondSpace - 1] = '\0';
-
-                        if(!VmRESTIsValidHTTPVesion(pRequest->requestLine->version))
+                        dwError = VmRESTAppendRequestHead(
+                                      pRequest,
+                                      (pszSecondSpace + 1),
+                                      (pszEndNewLine - pszSecondSpace - 1),
+                                      &pRequest->requestLine.version
+                                      );
+                        BAIL_ON_VMREST_ERROR(dwError);
+
+                        if(!VmRESTIsValidHTTPVesion(VmRESTGetRequestSpan(pRequest, &pRequest->requestLine.version)))
                         {
                             VMREST_LOG_ERROR(pRESTHandle,"%s","Validation failed for HTTP version");
                             dwError = HTTP_VERSION_NOT_SUPPORTED;
@@ -1032,9 +1172,8 @@ VmRESTProcessHeaders(
     uint32_t                         nLineLen = 0;
     uint32_t                         nAttrLen = 0;
     uint32_t                         nValueLen = 0;
-    char                             attribute[MAX_HTTP_HEADER_ATTR_LEN] = {0};
-    char                             value[MAX_HTTP_HEADER_VAL_LEN] = {0};
     uint32_t                         bytesProcessed  = 0;
+    VM_REST_LINE_SCAN                lineScan = {0};
 
     if (!pRESTHandle || !pRequest || !nProcessed || !pszBuffer)
     {
@@ -1045,11 +1184,10 @@ VmRESTProcessHeaders(
 
     *nProcessed = 0;
 
-    pszEndNewLine = strstr(pszStartNewLine, "\r\n");
-
-    if (pszEndNewLine)
+    if (VmRESTScanLine(pszStartNewLine, nBytes, &lineScan))
     {
-        nLineLen = pszEndNewLine - pszStartNewLine;
+        nLineLen = lineScan.nLineLen;
+        pszEndNewLine = pszStartNewLine + nLineLen;
         VMREST_LOG_DEBUG(pRESTHandle,"Start processing header line, nLineLen %u", nLineLen);
         if (nLineLen == 0)
         {
@@ -1079,17 +1217,12 @@ VmRESTProcessHeaders(
         }
         BAIL_ON_VMREST_ERROR(dwError);
 
-        pszColonSeparator = strchr(pszStartNewLine, ':' );
+        pszColonSeparator = (lineScan.nColon != HTTP_SCAN_NOT_FOUND) ? (pszStartNewLine + lineScan.nColon) : NULL;
 
         if (pszColonSeparator)
         {
             nAttrLen = pszColonSeparator - pszStartNewLine;
-            if ((nAttrLen > 0) && (nAttrLen < MAX_HTTP_HEADER_ATTR_LEN) && (nAttrLen < nLineLen))
-            {
-                strncpy(attribute,pszStartNewLine, nAttrLen);
-                attribute[nAttrLen] = '\0';
-            }
-            else
+            if (!((nAttrLen > 0) && (nAttrLen < MAX_HTTP_HEADER_ATTR_LEN) && (nAttrLen < nLineLen)))
             {
                 VMREST_LOG_ERROR(pRESTHandle,"Header name empty or too large, AttLen %u, nLineLen %u", nAttrLen, nLineLen);
                 dwError = BAD_REQUEST;
@@ -1098,22 +1231,20 @@ VmRESTProcessHeaders(
 
             nValueLen = pszEndNewLine - pszColonSeparator - 1;
 
-            if ((nValueLen > 0) && (nValueLen < MAX_HTTP_HEADER_VAL_LEN) && (nValueLen < nLineLen))
-            {
-                strncpy(value,(pszColonSeparator + 1), nValueLen);
-                value[nValueLen] = '\0';
-            }
-            else
+            if (!((nValueLen > 0) && (nValueLen < MAX_HTTP_HEADER_VAL_LEN) && (nValueLen < nLineLen)))
             {
                 VMREST_LOG_ERROR(pRESTHandle,"%s","Header value empty or too large");
                 dwError = BAD_REQUEST;
             }
             BAIL_ON_VMREST_ERROR(dwError);
 
+            /**** Name and value are copied once, straight from the read buffer ****/
             dwError = VmRESTSetHttpRequestHeader(
                           pRequest,
-                          attribute,
-                          value
+                          pszStartNewLine,
+                          nAttrLen,
+                          (pszColonSeparator + 1),
+                          nValueLen
                           );
             BAIL_ON_VMREST_ERROR(dwError);
 
@@ -1281,6 +1412,8 @@ VmRESTProcessBuffer(
     uint32_t                         nProcessed = 0;
     uint32_t                         nTotalProcessed = 0;
     BOOLEAN                          bInitiateClose = FALSE;
+    BOOLEAN                          bQueued = FALSE;
+    BOOLEAN                          bServed = FALSE;
 
     if (!pRESTHandle || !pRequest || !pszBuffer || nBytes == 0)
     {
@@ -1334,6 +1467,38 @@ VmRESTProcessBuffer(
                  break;
 
              case PROCESS_APPLICATION_CALLBACK:
+                 /**** Cached response, the application is not called ****/
+                 dwError = VmRESTCacheServe(
+                               pRESTHandle,
+                               pRequest,
+                               &bServed
+                               );
+                 BAIL_ON_VMREST_ERROR(dwError);
+
+                 if (bServed)
+                 {
+                     bInitiateClose = TRUE;
+                     break;
+                 }
+
+                 if (pRESTHandle->pSockContext && pRESTHandle->pSockContext->pHandlerPool)
+                 {
+                     dwError = VmRESTHandlerPoolSubmit(
+                                   pRESTHandle->pSockContext->pHandlerPool,
+                                   pRequest->pSocket,
+                                   pRequest,
+                                   &bQueued
+                                   );
+                     BAIL_ON_VMREST_ERROR(dwError);
+
+                     /**** Request belongs to a handler thread now, do not touch it again ****/
+                     if (bQueued)
+                     {
+                         dwError = VMREST_APPLICATION_CB_QUEUED;
+                         goto cleanup;
+                     }
+                 }
+
                  /**** Give callback to application ****/
                  VMREST_LOG_INFO(pRESTHandle,"%s","C-REST-ENGINE: Giving callback to application...");
                  dwError = VmRESTTriggerAppCb(
@@ -1342,6 +1507,12 @@ VmRESTProcessBuffer(
                                &(pRequest->pResponse)
                                );
                  VMREST_LOG_INFO(pRESTHandle,"C-REST-ENGINE: Application callback returns dwError %u", dwError);
+
+                 /**** Application finishes the response later, do not touch the request again ****/
+                 if (dwError == REST_ENGINE_RESPONSE_PENDING)
+                 {
+                     goto cleanup;
+                 }
                  BAIL_ON_VMREST_ERROR(dwError);
                  bInitiateClose = TRUE;
                  break;
@@ -1381,6 +1552,57 @@ error:
 
 }
 
+uint32_t
+VmRESTRunApplicationCallback(
+    PVMREST_HANDLE                   pRESTHandle,
+    PREST_REQUEST                    pRequest
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+
+    if (!pRESTHandle || !pRequest)
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid REST Handler or Request Handle");
+        dwError = REST_ERROR_INVALID_HANDLER;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    VMREST_LOG_INFO(pRESTHandle,"%s","C-REST-ENGINE: Giving callback to application from handler thread...");
+    dwError = VmRESTTriggerAppCb(
+                  pRESTHandle,
+                  pRequest,
+                  &(pRequest->pResponse)
+                  );
+    VMREST_LOG_INFO(pRESTHandle,"C-REST-ENGINE: Application callback returns dwError %u", dwError);
+
+    /**** Left pending, VmRESTCompleteResponse() posts the completion ****/
+    if (dwError == REST_ENGINE_RESPONSE_PENDING)
+    {
+        goto cleanup;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    /**** Same as an inline callback, failure goes to the client and the connection carries on ****/
+    if (pRequest)
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"Application callback failed with error code %u, sending failure response", dwError);
+        VmRESTSendFailureResponse(
+            pRESTHandle,
+            dwError,
+            pRequest
+            );
+        dwError = REST_ENGINE_SUCCESS;
+    }
+
+    goto cleanup;
+}
+
 uint32_t
 VmRESTTriggerAppCb(
     PVMREST_HANDLE                   pRESTHandle,
@@ -1406,7 +1628,13 @@ VmRESTTriggerAppCb(
 
     if (pRESTHandle->pHttpHandler->pfnHandleRequest)
     {
+        /**** Counted until VmRESTCompleteResponse() when left pending, VmRESTStop() waits for it ****/
+        __atomic_add_fetch(&pRESTHandle->pInstanceGlobal->nPendingResponses, 1, __ATOMIC_SEQ_CST);
         dwError = pRESTHandle->pHttpHandler->pfnHandleRequest(pRESTHandle,pRequest, ppResponse);
+        if (dwError != REST_ENGINE_RESPONSE_PENDING)
+        {
+            __atomic_sub_fetch(&pRESTHandle->pInstanceGlobal->nPendingResponses, 1, __ATOMIC_SEQ_CST);
+        }
     }
     else
     {
@@ -1563,7 +1791,6 @@ VmRESTSetHttpPayloadZeroCopy(
 {
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
     int                              ret = 0;
-    PREST_RESPONSE                   pResponse = NULL;
     char                             pszContentLen[MAX_CONTENT_LEN_STR_SIZE] = {0};
 
     if (!pRESTHandle  || !ppResponse)
@@ -1591,25 +1818,89 @@ VmRESTSetHttpPayloadZeroCopy(
                   );
     BAIL_ON_VMREST_ERROR(dwError);
 
-    pResponse = *ppResponse;
+    /**** Header and caller's buffer go out together ****/
+    dwError = VmRESTSendHeaderAndPayload(
+                  pRESTHandle,
+                  ppResponse,
+                  pszBuffer,
+                  nBytes
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    (*ppResponse)->bPayloadDone = TRUE;
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    VMREST_LOG_ERROR(pRESTHandle,"%s","Set Zero copy payload Failed");
+    goto cleanup;
+}
+
+uint32_t
+VmRESTSetHttpPayloadFromFd(
+    PVMREST_HANDLE                   pRESTHandle,
+    PREST_RESPONSE*                  ppResponse,
+    int                              fd,
+    uint64_t                         offset,
+    uint64_t                         nBytes
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    int                              ret = 0;
+    struct stat                      fileStat = {0};
+    char                             pszContentLen[MAX_FILE_LEN_STR_SIZE] = {0};
+
+    if (!pRESTHandle  || !ppResponse || (*ppResponse == NULL) || (fd < 0))
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid params");
+        dwError = VMREST_HTTP_INVALID_PARAMS;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    /**** Range is checked before the header commits to a length ****/
+    if ((fstat(fd, &fileStat) < 0) || ((uint64_t)fileStat.st_size < offset) || (((uint64_t)fileStat.st_size - offset) < nBytes))
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"File fd %d cannot supply %llu bytes at offset %llu", fd, (unsigned long long)nBytes, (unsigned long long)offset);
+        dwError = VMREST_HTTP_INVALID_PARAMS;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    ret = snprintf(pszContentLen, MAX_FILE_LEN_STR_SIZE ,"%llu", (unsigned long long)nBytes);
+
+    if ((ret < 0) || (ret >= MAX_FILE_LEN_STR_SIZE))
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"Bad content length, nBytes %llu", (unsigned long long)nBytes);
+        dwError = VMREST_HTTP_INVALID_PARAMS;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTSetHttpHeader(
+                  ppResponse,
+                  HTTP_HEADER_STR_CONTENT_LENGTH,
+                  pszContentLen
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
 
-    /**** Send Header first ****/
     dwError = VmRESTSendHeader(
                   pRESTHandle,
                   ppResponse
                   );
     BAIL_ON_VMREST_ERROR(dwError);
 
-    if (nBytes > 0)
-    {
-        dwError = VmRESTCommonWriteDataAtOnce(
-                      pRESTHandle,
-                      pResponse->pSocket,
-                      (char*)pszBuffer,
-                      nBytes
-                      );
-        BAIL_ON_VMREST_ERROR(dwError);
-    }
+    (*ppResponse)->bHeaderSent = TRUE;
+
+    /**** Transport streams the file, this worker does not wait for it ****/
+    dwError = VmRESTCommonSendFile(
+                  pRESTHandle,
+                  (*ppResponse)->pSocket,
+                  fd,
+                  offset,
+                  nBytes
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
 
 cleanup:
 
@@ -1617,7 +1908,7 @@ cleanup:
 
 error:
 
-    VMREST_LOG_ERROR(pRESTHandle,"%s","Set Zero copy payload Failed");
+    VMREST_LOG_ERROR(pRESTHandle,"Set payload from file fd %d Failed, dwError %u", fd, dwError);
     goto cleanup;
 }
 
@@ -0,0 +1,311 @@
+/* C-REST-Engine
+*
+* Copyright (c) 2017 VMware, Inc. All Rights Reserved.
+*
+* This product is licensed to you under the Apache 2.0 license (the "License").
+* You may not use this product except in compliance with the Apache 2.0 License.
+*
+* This product may include a number of subcomponents with separate copyright
+* notices and license terms. Your use of these subcomponents is subject to the
+* terms and conditions of the subcomponent's license, as noted in the LICENSE file.
+*
+*/
+
+/**** Length bounded line scanner, finds CRLF, spaces and colon of a line in one pass ****/
+
+#include "includes.h"
+
+#if defined(HAVE_IMMINTRIN_H) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define VMREST_SCAN_X86 1
+#include <immintrin.h>
+#endif
+
+typedef BOOLEAN (*PFN_VMREST_SCAN_LINE)(
+                    char const*          pszBuffer,
+                    uint32_t             nBytes,
+                    PVM_REST_LINE_SCAN   pScan
+                    );
+
+static pthread_once_t                    gScanOnce = PTHREAD_ONCE_INIT;
+static PFN_VMREST_SCAN_LINE              gpfnScanLine = NULL;
+
+static
+void
+VmRESTSelectScanKernel(
+    void
+    );
+
+static
+BOOLEAN
+VmRESTScanTail(
+    char const*                      pszBuffer,
+    uint32_t                         nBytes,
+    uint32_t                         nStart,
+    PVM_REST_LINE_SCAN               pScan
+    );
+
+static
+BOOLEAN
+VmRESTScanLineScalar(
+    char const*                      pszBuffer,
+    uint32_t                         nBytes,
+    PVM_REST_LINE_SCAN               pScan
+    );
+
+#ifdef VMREST_SCAN_X86
+static
+BOOLEAN
+VmRESTScanMasks(
+    char const*                      pszBuffer,
+    uint32_t                         nBytes,
+    uint32_t                         nBase,
+    uint32_t                         crMask,
+    uint32_t                         spaceMask,
+    uint32_t                         colonMask,
+    PVM_REST_LINE_SCAN               pScan
+    );
+
+static
+BOOLEAN
+VmRESTScanLineSSE2(
+    char const*                      pszBuffer,
+    uint32_t                         nBytes,
+    PVM_REST_LINE_SCAN               pScan
+    );
+
+static
+BOOLEAN
+VmRESTScanLineAVX2(
+    char const*                      pszBuffer,
+    uint32_t                         nBytes,
+    PVM_REST_LINE_SCAN               pScan
+    );
+#endif
+
+BOOLEAN
+VmRESTScanLine(
+    char const*                      pszBuffer,
+    uint32_t                         nBytes,
+    PVM_REST_LINE_SCAN               pScan
+    )
+{
+    pthread_once(&gScanOnce, VmRESTSelectScanKernel);
+
+    pScan->nLineLen = HTTP_SCAN_NOT_FOUND;
+    pScan->nFirstSpace = HTTP_SCAN_NOT_FOUND;
+    pScan->nSecondSpace = HTTP_SCAN_NOT_FOUND;
+    pScan->nColon = HTTP_SCAN_NOT_FOUND;
+
+    if (!pszBuffer || nBytes < HTTP_CRLF_LEN)
+    {
+        return FALSE;
+    }
+
+    return gpfnScanLine(pszBuffer, nBytes, pScan);
+}
+
+static
+void
+VmRESTSelectScanKernel(
+    void
+    )
+{
+    gpfnScanLine = VmRESTScanLineScalar;
+
+#ifdef VMREST_SCAN_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+    {
+        gpfnScanLine = VmRESTScanLineAVX2;
+    }
+    else if (__builtin_cpu_supports("sse2"))
+    {
+        gpfnScanLine = VmRESTScanLineSSE2;
+    }
+#endif
+}
+
+static
+BOOLEAN
+VmRESTScanTail(
+    char const*                      pszBuffer,
+    uint32_t                         nBytes,
+    uint32_t                         nStart,
+    PVM_REST_LINE_SCAN               pScan
+    )
+{
+    uint32_t                         i = 0;
+
+    for (i = nStart; i < nBytes; i++)
+    {
+        switch (pszBuffer[i])
+        {
+            case '\r':
+                if (((i + 1) < nBytes) && (pszBuffer[i + 1] == '\n'))
+                {
+                    pScan->nLineLen = i;
+                    return TRUE;
+                }
+                break;
+
+            case ' ':
+                if (pScan->nFirstSpace == HTTP_SCAN_NOT_FOUND)
+                {
+                    pScan->nFirstSpace = i;
+                }
+                else if (pScan->nSecondSpace == HTTP_SCAN_NOT_FOUND)
+                {
+                    pScan->nSecondSpace = i;
+                }
+                break;
+
+            case ':':
+                if (pScan->nColon == HTTP_SCAN_NOT_FOUND)
+                {
+                    pScan->nColon = i;
+                }
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    return FALSE;
+}
+
+static
+BOOLEAN
+VmRESTScanLineScalar(
+    char const*                      pszBuffer,
+    uint32_t                         nBytes,
+    PVM_REST_LINE_SCAN               pScan
+    )
+{
+    return VmRESTScanTail(pszBuffer, nBytes, 0, pScan);
+}
+
+#ifdef VMREST_SCAN_X86
+
+/**** Records one block worth of match masks, TRUE once the line end is in this block ****/
+static
+BOOLEAN
+VmRESTScanMasks(
+    char const*                      pszBuffer,
+    uint32_t                         nBytes,
+    uint32_t                         nBase,
+    uint32_t                         crMask,
+    uint32_t                         spaceMask,
+    uint32_t                         colonMask,
+    PVM_REST_LINE_SCAN               pScan
+    )
+{
+    uint32_t                         nPos = 0;
+    uint32_t                         lineMask = 0xFFFFFFFF;
+    BOOLEAN                          bLineEnd = FALSE;
+
+    while (crMask)
+    {
+        nPos = nBase + __builtin_ctz(crMask);
+        if (((nPos + 1) < nBytes) && (pszBuffer[nPos + 1] == '\n'))
+        {
+            pScan->nLineLen = nPos;
+            lineMask = (1U << (nPos - nBase)) - 1;
+            bLineEnd = TRUE;
+            break;
+        }
+        crMask &= (crMask - 1);
+    }
+
+    /**** Only characters before the CRLF belong to this line ****/
+    spaceMask &= lineMask;
+    colonMask &= lineMask;
+
+    if (spaceMask && (pScan->nFirstSpace == HTTP_SCAN_NOT_FOUND))
+    {
+        pScan->nFirstSpace = nBase + __builtin_ctz(spaceMask);
+        spaceMask &= (spaceMask - 1);
+    }
+    if (spaceMask && (pScan->nSecondSpace == HTTP_SCAN_NOT_FOUND))
+    {
+        pScan->nSecondSpace = nBase + __builtin_ctz(spaceMask);
+    }
+    if (colonMask && (pScan->nColon == HTTP_SCAN_NOT_FOUND))
+    {
+        pScan->nColon = nBase + __builtin_ctz(colonMask);
+    }
+
+    return bLineEnd;
+}
+
+__attribute__((target("sse2")))
+static
+BOOLEAN
+VmRESTScanLineSSE2(
+    char const*                      pszBuffer,
+    uint32_t                         nBytes,
+    PVM_REST_LINE_SCAN               pScan
+    )
+{
+    uint32_t                         i = 0;
+    uint32_t                         crMask = 0;
+    uint32_t                         spaceMask = 0;
+    uint32_t                         colonMask = 0;
+    __m128i                          block;
+    __m128i const                    cr = _mm_set1_epi8('\r');
+    __m128i const                    space = _mm_set1_epi8(' ');
+    __m128i const                    colon = _mm_set1_epi8(':');
+
+    for (i = 0; (i + 16) <= nBytes; i += 16)
+    {
+        block = _mm_loadu_si128((__m128i const*)(pszBuffer + i));
+        crMask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, cr));
+        spaceMask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, space));
+        colonMask = (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, colon));
+
+        if ((crMask | spaceMask | colonMask) &&
+            VmRESTScanMasks(pszBuffer, nBytes, i, crMask, spaceMask, colonMask, pScan))
+        {
+            return TRUE;
+        }
+    }
+
+    return VmRESTScanTail(pszBuffer, nBytes, i, pScan);
+}
+
+__attribute__((target("avx2")))
+static
+BOOLEAN
+VmRESTScanLineAVX2(
+    char const*                      pszBuffer,
+    uint32_t                         nBytes,
+    PVM_REST_LINE_SCAN               pScan
+    )
+{
+    uint32_t                         i = 0;
+    uint32_t                         crMask = 0;
+    uint32_t                         spaceMask = 0;
+    uint32_t                         colonMask = 0;
+    __m256i                          block;
+    __m256i const                    cr = _mm256_set1_epi8('\r');
+    __m256i const                    space = _mm256_set1_epi8(' ');
+    __m256i const                    colon = _mm256_set1_epi8(':');
+
+    for (i = 0; (i + 32) <= nBytes; i += 32)
+    {
+        block = _mm256_loadu_si256((__m256i const*)(pszBuffer + i));
+        crMask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, cr));
+        spaceMask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, space));
+        colonMask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, colon));
+
+        if ((crMask | spaceMask | colonMask) &&
+            VmRESTScanMasks(pszBuffer, nBytes, i, crMask, spaceMask, colonMask, pScan))
+        {
+            return TRUE;
+        }
+    }
+
+    return VmRESTScanTail(pszBuffer, nBytes, i, pScan);
+}
+
+#endif
@@ -26,26 +26,26 @@ VmRESTGetHttpMethod(
     size_t                           methodLen = 0;
     char*                            pMethod = NULL;
 
-    if (!(pRequest) || !(pRequest->requestLine) || !(ppResponse))
+    if (!(pRequest) || !(ppResponse))
     {
         dwError = VMREST_HTTP_INVALID_PARAMS;
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
-    methodLen = strlen(pRequest->requestLine->method);
-    if (methodLen == 0)
+    methodLen = pRequest->requestLine.method.len;
+    if (methodLen == 0 || methodLen > MAX_METHOD_LEN)
     {
         dwError = VMREST_HTTP_VALIDATION_FAILED;
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
     dwError = VmRESTAllocateMemory(
-                 MAX_METHOD_LEN,
+                 (methodLen + 1),
                  (void **)&pMethod
                  );
     BAIL_ON_VMREST_ERROR(dwError);
 
-    strncpy(pMethod,pRequest->requestLine->method, (MAX_METHOD_LEN -1));
+    memcpy(pMethod, VmRESTGetRequestSpan(pRequest, &pRequest->requestLine.method), methodLen);
 
     *ppResponse = pMethod;
 
@@ -70,21 +70,22 @@ VmRESTGetHttpURI(
     size_t                           uriLen = 0;
     char*                            pHttpURI = NULL;
 
-    if (!(pRequest) || !(pRequest->requestLine) || !(ppResponse))
+    if (!(pRequest) || !(ppResponse))
     {
         dwError = VMREST_HTTP_INVALID_PARAMS;
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
-    uriLen = strlen(pRequest->requestLine->uri);
+    uriLen = pRequest->requestLine.uri.len;
     if (uriLen == 0 || uriLen > MAX_URI_LEN)
     {
         dwError = VMREST_HTTP_VALIDATION_FAILED;
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
+    /**** Decoding never grows the string ****/
     dwError = VmRESTAllocateMemory(
-                 MAX_URI_LEN,
+                 (uriLen + 1),
                  (void **)&pHttpURI
                  );
     BAIL_ON_VMREST_ERROR(dwError);
@@ -92,13 +93,13 @@ VmRESTGetHttpURI(
     if (bDecoded)
     {
         VmRESTDecodeEncodedURLString(
-            pRequest->requestLine->uri,
+            VmRESTGetRequestSpan(pRequest, &pRequest->requestLine.uri),
             pHttpURI
             );
     }
     else
     {
-        strncpy(pHttpURI, pRequest->requestLine->uri, (MAX_URI_LEN - 1));
+        memcpy(pHttpURI, VmRESTGetRequestSpan(pRequest, &pRequest->requestLine.uri), uriLen);
     }
 
     *ppResponse = pHttpURI;
@@ -123,13 +124,13 @@ VmRESTGetHttpVersion(
     size_t                           versionLen = 0;
     char*                            pVersion = NULL;
 
-    if (!(pRequest) || !(pRequest->requestLine) || !(ppResponse))
+    if (!(pRequest) || !(ppResponse))
     {
         dwError = VMREST_HTTP_INVALID_PARAMS;
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
-    versionLen = strlen(pRequest->requestLine->version);
+    versionLen = pRequest->requestLine.version.len;
     if (versionLen == 0 || versionLen > MAX_VERSION_LEN)
     {
         dwError = VMREST_HTTP_VALIDATION_FAILED;
@@ -137,12 +138,12 @@ VmRESTGetHttpVersion(
     BAIL_ON_VMREST_ERROR(dwError);
 
     dwError = VmRESTAllocateMemory(
-                 MAX_VERSION_LEN,
+                 (versionLen + 1),
                  (void **)&pVersion
                  );
     BAIL_ON_VMREST_ERROR(dwError);
 
-    strncpy(pVersion, pRequest->requestLine->version, (MAX_VERSION_LEN -1));
+    memcpy(pVersion, VmRESTGetRequestSpan(pRequest, &pRequest->requestLine.version), versionLen);
 
     *ppResponse = pVersion;
 
@@ -166,7 +167,8 @@ VmRESTGetHttpHeader(
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
     size_t                           headerValLen = 0;
     char*                            headerValue = NULL;
-    char*                            temp = NULL;
+    PVM_REST_HTTP_HEADER_SPAN        pHeaderSpan = NULL;
+    uint32_t                         i = 0;
 
     if (!(pRequest) || !(pcszHeader) || !(ppszResponse))
     {
@@ -174,26 +176,29 @@ VmRESTGetHttpHeader(
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
-    dwError = VmRESTGetHTTPMiscHeader(
-                  pRequest->miscHeader,
-                  pcszHeader,
-                  &temp
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
-    if (temp != NULL)
+    for (i = 0; i < pRequest->nHeaders; i++)
+    {
+        if (strcmp(VmRESTGetRequestSpan(pRequest, &pRequest->pHeaders[i].header), pcszHeader) == 0)
+        {
+            pHeaderSpan = &pRequest->pHeaders[i];
+            break;
+        }
+    }
+
+    if (pHeaderSpan != NULL)
     {
-         headerValLen = strlen(temp);
+         headerValLen = pHeaderSpan->value.len;
          if (headerValLen == 0 || headerValLen > MAX_HTTP_HEADER_VAL_LEN)
          {
              dwError = VMREST_HTTP_VALIDATION_FAILED;
          }
          BAIL_ON_VMREST_ERROR(dwError);
          dwError = VmRESTAllocateMemory(
-                       MAX_HTTP_HEADER_VAL_LEN,
+                       (headerValLen + 1),
                        (void **)&headerValue
                        );
          BAIL_ON_VMREST_ERROR(dwError);
-         strncpy(headerValue, temp, (MAX_HTTP_HEADER_VAL_LEN - 1));
+         memcpy(headerValue, VmRESTGetRequestSpan(pRequest, &pHeaderSpan->value), headerValLen);
          *ppszResponse = headerValue;
     }
     else
@@ -273,7 +278,8 @@ VmRESTSetHttpPayload(
     )
 {
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
-    uint32_t                         contentLen = 0;
+    uint64_t                         contentLen = 0;
+    uint32_t                         nWrite = 0;
     PREST_RESPONSE                   pResponse = NULL;
     char*                            contentLength = NULL;
     char*                            transferEncoding = NULL;
@@ -306,51 +312,86 @@ VmRESTSetHttpPayload(
     /**** Either of Content-Length or chunked-Encoding header must be set ****/
     if ((contentLength != NULL) && (strlen(contentLength) > 0))
     {
-        contentLen = atoi(contentLength);
-        if (contentLen <= MAX_DATA_BUFFER_LEN)
+        dwError = VmRESTParseContentLength(
+                      contentLength,
+                      &contentLen
+                      );
+        if (dwError || (pResponse->nPayloadSent > contentLen))
+        {
+            VMREST_LOG_ERROR(pRESTHandle,"Invalid content length %s", contentLength);
+            dwError = VMREST_HTTP_VALIDATION_FAILED;
+        }
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        /**** Body may come in any number of calls, never more than Content-Length in total ****/
+        nWrite = ((contentLen - pResponse->nPayloadSent) < dataLen) ?
+                     (uint32_t)(contentLen - pResponse->nPayloadSent) : dataLen;
+
+        /**** Compressed body is held back until the last byte, plain body goes out as it comes ****/
+        if ((pResponse->bDeflateChecked == FALSE) && (pResponse->bHeaderSent == FALSE))
+        {
+            dwError = VmRESTDeflateStart(
+                          pRESTHandle,
+                          pResponse,
+                          contentLen,
+                          TRUE
+                          );
+            BAIL_ON_VMREST_ERROR(dwError);
+        }
+
+        if (pResponse->pDeflate)
+        {
+            dwError = VmRESTDeflateContentLength(
+                          pRESTHandle,
+                          ppResponse,
+                          buffer,
+                          nWrite,
+                          ((pResponse->nPayloadSent + nWrite) == contentLen)
+                          );
+            BAIL_ON_VMREST_ERROR(dwError);
+        }
+        else if (pResponse->bHeaderSent == FALSE)
         {
-            memcpy(pResponse->messageBody->buffer, buffer, contentLen);
+            dwError = VmRESTSendHeaderAndPayload(
+                          pRESTHandle,
+                          ppResponse,
+                          buffer,
+                          nWrite
+                          );
+            VMREST_LOG_DEBUG(pRESTHandle,"Sending Header and Payload done, returned code %u", dwError);
+            BAIL_ON_VMREST_ERROR(dwError);
+            pResponse->bHeaderSent = TRUE;
         }
         else
         {
-            VMREST_LOG_ERROR(pRESTHandle,"Invalid content length %u", contentLen);
-            dwError = VMREST_HTTP_VALIDATION_FAILED;
+            dwError = VmRESTSendPayload(
+                          pRESTHandle,
+                          ppResponse,
+                          buffer,
+                          nWrite
+                          );
+            BAIL_ON_VMREST_ERROR(dwError);
         }
-        BAIL_ON_VMREST_ERROR(dwError);
 
-        dwError = VmRESTSendHeaderAndPayload(
-                      pRESTHandle,
-                      ppResponse
-                      );
-       VMREST_LOG_DEBUG(pRESTHandle,"Sending Header and Payload done, returned code %u", dwError);
-       BAIL_ON_VMREST_ERROR(dwError);
-       pResponse->bHeaderSent = TRUE;
-       *bytesWritten = contentLen;
-       dwError = REST_ENGINE_IO_COMPLETED;
+        pResponse->nPayloadSent += nWrite;
+        *bytesWritten = nWrite;
+
+        if (pResponse->nPayloadSent == contentLen)
+        {
+            dwError = REST_ENGINE_IO_COMPLETED;
+        }
+        else
+        {
+            dwError = REST_ENGINE_MORE_IO_REQUIRED;
+        }
     }
     else if ((transferEncoding != NULL) && (strcmp(transferEncoding, "chunked") == 0))
     {
-         if (dataLen > MAX_DATA_BUFFER_LEN)
-         {
-             VMREST_LOG_ERROR(pRESTHandle,"Chunked data length %u not allowed", dataLen);
-             dwError = VMREST_HTTP_VALIDATION_FAILED;
-         }
-         BAIL_ON_VMREST_ERROR(dwError);
-
-         memcpy(pResponse->messageBody->buffer, buffer, dataLen);
-         if (pResponse->bHeaderSent == FALSE)
-         {
-             /**** Send Header first ****/
-             dwError = VmRESTSendHeader(
-                           pRESTHandle,
-                           ppResponse
-                           );
-             BAIL_ON_VMREST_ERROR(dwError);
-             pResponse->bHeaderSent = TRUE;
-         }
+         /**** Header goes out with the first chunk, small writes are coalesced ****/
          dwError = VmRESTSendChunkedPayload(
                        pRESTHandle,
                        ppResponse,
+                       buffer,
                        dataLen
                        );
          BAIL_ON_VMREST_ERROR(dwError);
@@ -372,6 +413,11 @@ VmRESTSetHttpPayload(
         BAIL_ON_VMREST_ERROR(dwError);
     }
 
+    if (dwError == REST_ENGINE_IO_COMPLETED)
+    {
+        pResponse->bPayloadDone = TRUE;
+    }
+
 cleanup:
     return dwError;
 error:
@@ -399,6 +445,7 @@ VmRESTSetHttpHeader(
     pResponse = *ppResponse;
 
     dwError = VmRESTSetHTTPMiscHeader(
+                  pResponse->pArena,
                   pResponse->miscHeader,
                   header,
                   value
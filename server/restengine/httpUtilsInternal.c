@@ -91,6 +91,50 @@ error:
     goto cleanup;
 }
 
+uint32_t
+VmRESTParseContentLength(
+    char const*                      pszContentLen,
+    uint64_t*                        pnContentLen
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    uint64_t                         nContentLen = 0;
+    uint32_t                         nDigit = 0;
+    char const*                      pszDigit = NULL;
+
+    if (!pszContentLen || !pnContentLen || (*pszContentLen == '\0'))
+    {
+        dwError = VMREST_HTTP_INVALID_PARAMS;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    /**** Digits only, anything that does not fit in 64 bits is rejected ****/
+    for (pszDigit = pszContentLen; *pszDigit != '\0'; pszDigit++)
+    {
+        if ((*pszDigit < '0') || (*pszDigit > '9'))
+        {
+            dwError = VMREST_HTTP_INVALID_PARAMS;
+            break;
+        }
+
+        nDigit = (uint32_t)(*pszDigit - '0');
+        if (nContentLen > ((UINT64_MAX - nDigit) / 10))
+        {
+            dwError = VMREST_HTTP_INVALID_PARAMS;
+            break;
+        }
+        nContentLen = (nContentLen * 10) + nDigit;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    *pnContentLen = nContentLen;
+
+cleanup:
+    return dwError;
+error:
+    goto cleanup;
+}
+
 uint32_t
 VmRESTMapStatusCodeToEnumAndReasonPhrase(
     char*                            statusCode,
@@ -322,31 +366,175 @@ error:
 uint32_t
 VmRESTSetHttpRequestHeader(
     PVM_REST_HTTP_REQUEST_PACKET     pRequest,
-    char*                            header,
-    char*                            value
+    char const*                      pszHeader,
+    uint32_t                         nHeader,
+    char const*                      pszValue,
+    uint32_t                         nValue
     )
 {
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    uint32_t                         nNewSlots = 0;
+    PVM_REST_HTTP_HEADER_SPAN        pNewHeaders = NULL;
+    PVM_REST_HTTP_HEADER_SPAN        pHeaderSpan = NULL;
 
-    if (!pRequest || !header || !value)
+    if (!pRequest || !pszHeader || !pszValue || (nHeader >= MAX_HTTP_HEADER_ATTR_LEN) || (nValue >= MAX_HTTP_HEADER_VAL_LEN))
     {
         dwError =  VMREST_HTTP_INVALID_PARAMS;
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
-    dwError = VmRESTSetHTTPMiscHeader(
-                  pRequest->miscHeader,
-                  header,
-                  value
+    /**** Same trimming as VmRESTTrimSpaces, done on the line before it is copied ****/
+    while ((nHeader > 0) && (*pszHeader == ' '))
+    {
+        pszHeader++;
+        nHeader--;
+    }
+    while ((nHeader > 0) && (pszHeader[nHeader - 1] == ' '))
+    {
+        nHeader--;
+    }
+    while ((nValue > 0) && (*pszValue == ' '))
+    {
+        pszValue++;
+        nValue--;
+    }
+    while ((nValue > 0) && (pszValue[nValue - 1] == ' '))
+    {
+        nValue--;
+    }
+
+    if (nHeader == 0 || nValue == 0)
+    {
+        dwError = VMREST_HTTP_VALIDATION_FAILED;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    if (pRequest->nHeaders == pRequest->nHeaderSlots)
+    {
+        nNewSlots = pRequest->nHeaderSlots ? (pRequest->nHeaderSlots * 2) : HTTP_REQUEST_HEADER_SLOTS;
+
+        dwError = VmRESTArenaReallocate(
+                      pRequest->pArena,
+                      pRequest->pHeaders,
+                      (pRequest->nHeaderSlots * sizeof(VM_REST_HTTP_HEADER_SPAN)),
+                      (nNewSlots * sizeof(VM_REST_HTTP_HEADER_SPAN)),
+                      (void**)&pNewHeaders
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        pRequest->pHeaders = pNewHeaders;
+        pRequest->nHeaderSlots = nNewSlots;
+    }
+
+    pHeaderSpan = &pRequest->pHeaders[pRequest->nHeaders];
+
+    dwError = VmRESTAppendRequestHead(
+                  pRequest,
+                  pszHeader,
+                  nHeader,
+                  &pHeaderSpan->header
                   );
     BAIL_ON_VMREST_ERROR(dwError);
 
+    dwError = VmRESTAppendRequestHead(
+                  pRequest,
+                  pszValue,
+                  nValue,
+                  &pHeaderSpan->value
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    pRequest->nHeaders++;
+
 cleanup:
     return dwError;
 error:
     goto cleanup;
 }
 
+uint32_t
+VmRESTAppendRequestHead(
+    PVM_REST_HTTP_REQUEST_PACKET     pRequest,
+    char const*                      pszData,
+    uint32_t                         nData,
+    PVM_REST_HTTP_SPAN               pSpan
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    uint32_t                         nNeeded = 0;
+    uint32_t                         nNewSize = 0;
+    char*                            pszNewHead = NULL;
+
+    if (!pRequest || !pszData || !pSpan)
+    {
+        dwError =  VMREST_HTTP_INVALID_PARAMS;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    /**** Byte 0 stays '\0' so an unset span reads as an empty string ****/
+    if (!pRequest->pszHead)
+    {
+        dwError = VmRESTArenaAllocate(
+                      pRequest->pArena,
+                      HTTP_REQUEST_HEAD_SIZE,
+                      (void**)&pRequest->pszHead
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        pRequest->nHeadSize = HTTP_REQUEST_HEAD_SIZE;
+        pRequest->nHead = 1;
+    }
+
+    nNeeded = pRequest->nHead + nData + 1;
+    if (nNeeded > pRequest->nHeadSize)
+    {
+        nNewSize = pRequest->nHeadSize;
+        while (nNewSize < nNeeded)
+        {
+            nNewSize = nNewSize * 2;
+        }
+
+        dwError = VmRESTArenaReallocate(
+                      pRequest->pArena,
+                      pRequest->pszHead,
+                      pRequest->nHeadSize,
+                      nNewSize,
+                      (void**)&pszNewHead
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        pRequest->pszHead = pszNewHead;
+        pRequest->nHeadSize = nNewSize;
+    }
+
+    memcpy((pRequest->pszHead + pRequest->nHead), pszData, nData);
+    pRequest->pszHead[pRequest->nHead + nData] = '\0';
+
+    pSpan->offset = pRequest->nHead;
+    pSpan->len = nData;
+    pRequest->nHead = nNeeded;
+
+cleanup:
+    return dwError;
+error:
+    goto cleanup;
+}
+
+char const*
+VmRESTGetRequestSpan(
+    PVM_REST_HTTP_REQUEST_PACKET     pRequest,
+    PVM_REST_HTTP_SPAN               pSpan
+    )
+{
+    /**** Valid until the next append, the head buffer may move when it grows ****/
+    if (!pRequest || !pRequest->pszHead || !pSpan)
+    {
+        return "";
+    }
+
+    return (pRequest->pszHead + pSpan->offset);
+}
+
 void
 VmRESTFreeConfigFileStruct(
     PVM_REST_CONFIG                  pRESTConfig
@@ -436,6 +624,15 @@ VmRESTValidateConfig(
     /**** convert MB to KB ****/
     pRESTConfig->maxDataPerConnMB = (pRESTConfig->maxDataPerConnMB * 1024 * 1024);
 
+    if (pRESTConfig->maxOutputPerConnMB == 0)
+    {
+        pRESTConfig->maxOutputPerConnMB = VMREST_DEFAULT_CONN_OUTPUT_LIMIT_MB;
+    }
+    else if (pRESTConfig->maxOutputPerConnMB > VMREST_MAX_CONN_OUTPUT_LIMIT_MB)
+    {
+        pRESTConfig->maxOutputPerConnMB = VMREST_MAX_CONN_OUTPUT_LIMIT_MB;
+    }
+
     if (pRESTConfig->nWorkerThr == 0)
     {
         pRESTConfig->nWorkerThr = VMREST_DEFAULT_WORKER_THR_COUNT;
@@ -471,6 +668,81 @@ VmRESTValidateConfig(
         strncpy(pRESTConfig->pszDaemonName, "VMREST-UNKOWN", (MAX_DEAMON_NAME_LEN - 1));
     }
 
+    if (pRESTConfig->useAsyncLog && (pRESTConfig->asyncLogFlushMSec == 0))
+    {
+        pRESTConfig->asyncLogFlushMSec = VMREST_LOG_DEFAULT_FLUSH_MSEC;
+    }
+
+    /**** No handler threads means callbacks run on the I/O workers ****/
+    if (pRESTConfig->nHandlerThr > VMREST_MAX_HANDLER_THR_COUNT)
+    {
+        pRESTConfig->nHandlerThr = VMREST_MAX_HANDLER_THR_COUNT;
+    }
+
+    if (pRESTConfig->nHandlerQueueSize == 0)
+    {
+        pRESTConfig->nHandlerQueueSize = VMREST_DEFAULT_HANDLER_QUEUE_SIZE;
+    }
+    else if (pRESTConfig->nHandlerQueueSize > VMREST_MAX_HANDLER_QUEUE_SIZE)
+    {
+        pRESTConfig->nHandlerQueueSize = VMREST_MAX_HANDLER_QUEUE_SIZE;
+    }
+
+    if (pRESTConfig->nResponseChunkSize == 0)
+    {
+        pRESTConfig->nResponseChunkSize = VMREST_DEFAULT_RESPONSE_CHUNK_SIZE;
+    }
+    else if (pRESTConfig->nResponseChunkSize > VMREST_MAX_RESPONSE_CHUNK_SIZE)
+    {
+        pRESTConfig->nResponseChunkSize = VMREST_MAX_RESPONSE_CHUNK_SIZE;
+    }
+
+    if (pRESTConfig->compressionLevel == 0)
+    {
+        pRESTConfig->compressionLevel = VMREST_DEFAULT_COMPRESSION_LEVEL;
+    }
+    else if (pRESTConfig->compressionLevel > VMREST_MAX_COMPRESSION_LEVEL)
+    {
+        pRESTConfig->compressionLevel = VMREST_MAX_COMPRESSION_LEVEL;
+    }
+
+    if (pRESTConfig->compressionMinSize == 0)
+    {
+        pRESTConfig->compressionMinSize = VMREST_DEFAULT_COMPRESSION_MIN_SIZE;
+    }
+
+    /**** 0 keeps the response cache off ****/
+    if (pRESTConfig->nResponseCacheSize > VMREST_MAX_RESPONSE_CACHE_SIZE)
+    {
+        pRESTConfig->nResponseCacheSize = VMREST_MAX_RESPONSE_CACHE_SIZE;
+    }
+
+    /**** 0 leaves TLS sessions to the OpenSSL cache of the context ****/
+    if (pRESTConfig->nSSLSessionCacheSize > VMREST_MAX_SSL_SESSION_CACHE_SIZE)
+    {
+        pRESTConfig->nSSLSessionCacheSize = VMREST_MAX_SSL_SESSION_CACHE_SIZE;
+    }
+
+    if (pRESTConfig->SSLSessionTimeoutSec == 0)
+    {
+        pRESTConfig->SSLSessionTimeoutSec = VMREST_DEFAULT_SSL_SESSION_TIMEOUT_SEC;
+    }
+    else if (pRESTConfig->SSLSessionTimeoutSec > VMREST_MAX_SSL_SESSION_TIMEOUT_SEC)
+    {
+        pRESTConfig->SSLSessionTimeoutSec = VMREST_MAX_SSL_SESSION_TIMEOUT_SEC;
+    }
+
+    if (pRESTConfig->SSLTicketKeyRotateSec == 0)
+    {
+        pRESTConfig->SSLTicketKeyRotateSec = VMREST_DEFAULT_SSL_TICKET_KEY_ROTATE_SEC;
+    }
+
+    /**** Retired ticket keys must outlive the tickets they issued ****/
+    if (pRESTConfig->SSLTicketKeyRotateSec < (pRESTConfig->SSLSessionTimeoutSec + VMREST_SSL_TICKET_KEYS - 2) / (VMREST_SSL_TICKET_KEYS - 1))
+    {
+        pRESTConfig->SSLTicketKeyRotateSec = (pRESTConfig->SSLSessionTimeoutSec + VMREST_SSL_TICKET_KEYS - 2) / (VMREST_SSL_TICKET_KEYS - 1);
+    }
+
     if (IsNullOrEmptyString(pRESTConfig->pszSSLCipherList))
     {
         strncpy(pRESTConfig->pszSSLCipherList, VMREST_DEFAULT_SSL_CIPHER_LIST, (VMREST_MAX_SSL_CIPHER_LIST_LEN - 1));
@@ -542,6 +814,24 @@ VmRESTCopyConfig(
     pRESTConfig->debugLogLevel = pConfig->debugLogLevel;
     pRESTConfig->isSecure = pConfig->isSecure;
     pRESTConfig->useSysLog = pConfig->useSysLog;
+    pRESTConfig->usePerWorkerReactor = pConfig->usePerWorkerReactor;
+    pRESTConfig->useIoUring = pConfig->useIoUring;
+    pRESTConfig->useAsyncLog = pConfig->useAsyncLog;
+    pRESTConfig->asyncLogBlockOnFull = pConfig->asyncLogBlockOnFull;
+    pRESTConfig->asyncLogFlushMSec = pConfig->asyncLogFlushMSec;
+    pRESTConfig->nHandlerThr = pConfig->nHandlerThr;
+    pRESTConfig->nHandlerQueueSize = pConfig->nHandlerQueueSize;
+    pRESTConfig->nResponseChunkSize = pConfig->nResponseChunkSize;
+    pRESTConfig->useCompression = pConfig->useCompression;
+    pRESTConfig->compressionLevel = pConfig->compressionLevel;
+    pRESTConfig->compressionMinSize = pConfig->compressionMinSize;
+    pRESTConfig->nResponseCacheSize = pConfig->nResponseCacheSize;
+    pRESTConfig->nSSLSessionCacheSize = pConfig->nSSLSessionCacheSize;
+    pRESTConfig->SSLSessionTimeoutSec = pConfig->SSLSessionTimeoutSec;
+    pRESTConfig->SSLTicketKeyRotateSec = pConfig->SSLTicketKeyRotateSec;
+    pRESTConfig->useSSLMemoryBIO = pConfig->useSSLMemoryBIO;
+    pRESTConfig->useKTLS = pConfig->useKTLS;
+    pRESTConfig->maxOutputPerConnMB = pConfig->maxOutputPerConnMB;
     pRESTConfig->SSLCtxOptionsFlag = pConfig->SSLCtxOptionsFlag;
 
 cleanup:
@@ -555,6 +845,7 @@ error:
 
 uint32_t
 VmRESTSetHTTPMiscHeader(
+    PVM_REST_ARENA                   pArena,
     PMISC_HEADER_QUEUE               miscHeaderQueue,
     char const*                      header,
     char const*                      value
@@ -570,7 +861,7 @@ VmRESTSetHTTPMiscHeader(
     char*                            noSpaceHeader = NULL;
     char*                            noSpaceValue = NULL;
 
-    if (!miscHeaderQueue || !header || !value || (strlen(header) > MAX_HTTP_HEADER_ATTR_LEN) || (strlen(value) > MAX_HTTP_HEADER_VAL_LEN))
+    if (!pArena || !miscHeaderQueue || !header || !value || (strlen(header) > MAX_HTTP_HEADER_ATTR_LEN) || (strlen(value) > MAX_HTTP_HEADER_VAL_LEN))
     {
         dwError =  VMREST_HTTP_INVALID_PARAMS;
     }
@@ -602,15 +893,30 @@ VmRESTSetHTTPMiscHeader(
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
-    /**** Allocate the node ****/
-    dwError = VmRESTAllocateMemory(
+    /**** Node and strings are sized to fit and live as long as the request ****/
+    dwError = VmRESTArenaAllocate(
+                  pArena,
                   sizeof(VM_REST_HTTP_HEADER_NODE),
                   (void**)&node
                   );
     BAIL_ON_VMREST_ERROR(dwError);
 
-    strcpy(node->header, noSpaceHeader);
-    strcpy(node->value, noSpaceValue);
+    dwError = VmRESTArenaAllocate(
+                  pArena,
+                  (headerLen + 1),
+                  (void**)&node->header
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTArenaAllocate(
+                  pArena,
+                  (valueLen + 1),
+                  (void**)&node->value
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    memcpy(node->header, noSpaceHeader, headerLen);
+    memcpy(node->value, noSpaceValue, valueLen);
 
     node->next = NULL;
 
@@ -631,11 +937,6 @@ VmRESTSetHTTPMiscHeader(
 cleanup:
     return dwError;
 error:
-    if (node != NULL)
-    {
-        VmRESTFreeMemory(node);
-        node = NULL;
-    }
     goto cleanup;
 }
 
@@ -645,20 +946,14 @@ VmRESTRemoveAllHTTPMiscHeader(
     )
 {
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
-    PVM_REST_HTTP_HEADER_NODE        node = NULL;
-    PVM_REST_HTTP_HEADER_NODE        temp = NULL;
 
-    temp = miscHeaderQueue->head;
-    while (temp != NULL)
+    if (!miscHeaderQueue)
     {
-        node = temp;
-        temp = temp->next;
-        
-        VmRESTFreeMemory(
-            node
-            );
+        dwError = VMREST_HTTP_INVALID_PARAMS;
     }
     BAIL_ON_VMREST_ERROR(dwError);
+
+    /**** Nodes belong to the request arena, just forget them ****/
     miscHeaderQueue->head = NULL;
 
 cleanup:
@@ -667,6 +962,41 @@ error:
     goto cleanup;
 }
 
+uint32_t
+VmRESTRemoveHTTPMiscHeader(
+    PMISC_HEADER_QUEUE               miscHeaderQueue,
+    char const*                      header
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    PVM_REST_HTTP_HEADER_NODE*       ppNode = NULL;
+
+    if (!miscHeaderQueue || !header)
+    {
+        dwError = VMREST_HTTP_INVALID_PARAMS;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    /**** Unlinked nodes stay in the request arena ****/
+    ppNode = &miscHeaderQueue->head;
+    while (*ppNode != NULL)
+    {
+        if (strcmp((*ppNode)->header, header) == 0)
+        {
+            *ppNode = (*ppNode)->next;
+        }
+        else
+        {
+            ppNode = &(*ppNode)->next;
+        }
+    }
+
+cleanup:
+    return dwError;
+error:
+    goto cleanup;
+}
+
 uint32_t
 VmRESTGetHTTPMiscHeader(
     PMISC_HEADER_QUEUE               miscHeaderQueue,
@@ -710,13 +1040,12 @@ VmRESTGetChunkSize(
     )
 {
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
-    char*                            temp = NULL;
-    char*                            line = NULL;
     char                             local[HTTP_CHUNKED_DATA_LEN] = {0};
     uint32_t                         count = 0;
     uint32_t                         done = 0;
     long int                         hexToDec = 0;
     char*                            ignoreSpace = NULL;
+    VM_REST_LINE_SCAN                lineScan = {0};
 
     if (!lineStart || !skipBytes || !chunkSize)
     {
@@ -737,22 +1066,21 @@ VmRESTGetChunkSize(
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
-    memset(local,'\0', HTTP_CHUNKED_DATA_LEN);
-    temp = lineStart;
-    line = local;
-    while ((count < (HTTP_CHUNKED_DATA_LEN - 1)) && (count < (nLineLen - 1)) && (*temp != '\0'))
+    /**** Size line is looked for in the first HTTP_CHUNKED_DATA_LEN bytes only ****/
+    if (VmRESTScanLine(lineStart, ((nLineLen < HTTP_CHUNKED_DATA_LEN) ? nLineLen : HTTP_CHUNKED_DATA_LEN), &lineScan))
     {
-         if(*temp == '\r' && *(temp + 1) == '\n')
-         {
-             *line = '\0';
-             done = 1;
-             break;
-         }
-         *line = *temp;
-         line++;
-         temp++;
-         count++;
+        count = lineScan.nLineLen;
+        memcpy(local, lineStart, count);
+        local[count] = '\0';
+        done = 1;
+    }
+    else if (nLineLen < HTTP_CHUNKED_DATA_LEN)
+    {
+        /**** Rest of the size line is yet to be read ****/
+        dwError = REST_ENGINE_MORE_IO_REQUIRED;
     }
+    BAIL_ON_VMREST_ERROR(dwError);
+
     if (done)
     {
         /**** Remove any space present in string ****/
@@ -916,19 +1244,19 @@ VmRESTGetResponseBufferSize(
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
-    /**** 1. Maximum status line length ****/
-    size += MAX_METHOD_LEN;
-    size += MAX_URI_LEN;
-    size += MAX_VERSION_LEN;
+    /**** 1. Status line length ****/
+    size += strlen(pResPacket->statusLine->version);
+    size += strlen(pResPacket->statusLine->statusCode);
+    size += strlen(pResPacket->statusLine->reason_phrase);
     /* CRLF 2, SPACE 2, EXTRA 1 */
     size += 5;
 
     miscHeaderNode = pResPacket->miscHeader->head;
     while (miscHeaderNode != NULL)
     {
-        /**** 2. Maximum per node length ****/
-        size += MAX_HTTP_HEADER_ATTR_LEN;
-        size += MAX_HTTP_HEADER_VAL_LEN;
+        /**** 2. Per node length ****/
+        size += strlen(miscHeaderNode->header);
+        size += strlen(miscHeaderNode->value);
         /* CRLF 2, ':'1 */
         size += 3;
         miscHeaderNode = miscHeaderNode->next;
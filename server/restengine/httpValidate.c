@@ -311,6 +311,7 @@ VmRESTValidateHTTPVersion(
 {
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
     size_t                           len = 0;
+    char const*                      version = NULL;
 
     if ( !pRequest || !result || !err )
     {
@@ -321,10 +322,11 @@ VmRESTValidateHTTPVersion(
     *err = HTTP_VERSION_NOT_SUPPORTED;
     *result = FAIL;
 
-    len = strlen(pRequest->requestLine->version);
+    len = pRequest->requestLine.version.len;
+    version = VmRESTGetRequestSpan(pRequest, &pRequest->requestLine.version);
     if (len > 0)
     {
-        if ((strcmp(pRequest->requestLine->version, "HTTP/1.1") == 0) || (strcmp(pRequest->requestLine->version, "HTTP/1.0") == 0))
+        if ((strcmp(version, "HTTP/1.1") == 0) || (strcmp(version, "HTTP/1.0") == 0))
         {
             *err = 0;
             *result = PASS;
@@ -347,7 +349,7 @@ VmRESTValidateHTTPRequestURI(
 {
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
     size_t                           len = 0;
-    char*                            temp = NULL;
+    char const*                      temp = NULL;
     char*                            host = NULL;
 
     if ( !pRequest || !result || !err )
@@ -370,14 +372,14 @@ VmRESTValidateHTTPRequestURI(
 
     */
 
-    len = strlen(pRequest->requestLine->uri);
+    len = pRequest->requestLine.uri.len;
     if (len > MAX_URI_LEN)
     {
         *err = REQUEST_URI_TOO_LARGE;
         goto cleanup;
     }
 
-    temp = pRequest->requestLine->uri;
+    temp = VmRESTGetRequestSpan(pRequest, &pRequest->requestLine.uri);
 
     if ((memcmp((void*)temp, "http", 4) != 0))
     {
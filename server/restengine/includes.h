@@ -23,6 +23,7 @@ typedef unsigned __int16 uint16_t;
 typedef unsigned __int8 uint8_t;
 #endif
 #include <stdio.h>
+#include <zlib.h>
 
 #include <vmrestsys.h>
 #include <vmrestdefines.h>
@@ -243,7 +243,14 @@ VmRESTRegisterHandler(
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
     PREST_PROCESSOR                  pzHandler = NULL;
 
-    if (!pHandler || !pRESTHandle || (pRESTHandle->instanceState != VMREST_INSTANCE_INITIALIZED))
+    if (!pHandler || !pRESTHandle || ((pRESTHandle->instanceState != VMREST_INSTANCE_INITIALIZED) && (pRESTHandle->instanceState != VMREST_INSTANCE_STARTED)))
+    {
+        dwError = REST_ENGINE_ERROR_INVALID_PARAM;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    /**** Running instance can only change its endpoint routes ****/
+    if ((pRESTHandle->instanceState == VMREST_INSTANCE_STARTED) && (!pszEndpoint || (pRESTHandle->pInstanceGlobal->useEndPoint == 0)))
     {
         dwError = REST_ENGINE_ERROR_INVALID_PARAM;
     }
@@ -296,7 +303,6 @@ VmRESTFindEndpoint(
     )
 {
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
-    PREST_ENDPOINT                   temp = NULL;
     PREST_ENDPOINT                   pEndPoint = NULL;
 
     if (!pRESTHandle || !pszEndpoint || !ppEndpoint || (pRESTHandle->instanceState == VMREST_INSTANCE_UNINITIALIZED) || (pRESTHandle->instanceState == VMREST_INSTANCE_SHUTDOWN))
@@ -305,32 +311,14 @@ VmRESTFindEndpoint(
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
+    /**** Returns a copy of the registered endpoint ****/
     dwError = VmRestEngineGetEndPoint(
                   pRESTHandle,
                   (char*)pszEndpoint,
-                  &temp
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
-
-    /**** Allocate and copy ****/
-    dwError = VmRESTAllocateEndPoint(
                   &pEndPoint
                   );
     BAIL_ON_VMREST_ERROR(dwError);
 
-    strcpy(pEndPoint->pszEndPointURI,temp->pszEndPointURI);
-    if (temp->pHandler != NULL)
-    {
-        pEndPoint->pHandler->pfnHandleRequest = temp->pHandler->pfnHandleRequest;
-        pEndPoint->pHandler->pfnHandleCreate = temp->pHandler->pfnHandleCreate;
-        pEndPoint->pHandler->pfnHandleDelete = temp->pHandler->pfnHandleDelete;
-        pEndPoint->pHandler->pfnHandleUpdate = temp->pHandler->pfnHandleUpdate;
-        pEndPoint->pHandler->pfnHandleRead = temp->pHandler->pfnHandleRead;
-        pEndPoint->pHandler->pfnHandleOthers = temp->pHandler->pfnHandleOthers;
-        /**** Dont give the next pointer ****/
-        temp->next = NULL;
-    }
-
     *ppEndpoint = pEndPoint;
     
 cleanup:
@@ -347,7 +335,7 @@ VmRESTUnRegisterHandler(
 {
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
 
-    if (!pRESTHandle || !pcszEndPointURI || (pRESTHandle->instanceState != VMREST_INSTANCE_STOPPED))
+    if (!pRESTHandle || !pcszEndPointURI || ((pRESTHandle->instanceState != VMREST_INSTANCE_STOPPED) && (pRESTHandle->instanceState != VMREST_INSTANCE_STARTED)))
     {
         dwError = REST_ENGINE_ERROR_INVALID_PARAM;
     }
@@ -383,6 +371,8 @@ VmRESTStop(
     )
 {
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    PREST_ENG_GLOBALS                pGlobals = NULL;
+    uint64_t                         waitUSec = 0;
 
     if (!pRESTHandle || (waitSeconds > MAX_STOP_WAIT_SECONDS) || (pRESTHandle->instanceState != VMREST_INSTANCE_STARTED))
     {  
@@ -390,7 +380,26 @@ VmRESTStop(
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
-    pRESTHandle->instanceState = VMREST_INSTANCE_STOPPED;
+    pGlobals = pRESTHandle->pInstanceGlobal;
+
+    /**** Responses left pending may still complete for up to waitSeconds ****/
+    __atomic_store_n(&pRESTHandle->instanceState, VMREST_INSTANCE_STOPPING, __ATOMIC_SEQ_CST);
+    while ((__atomic_load_n(&pGlobals->nPendingResponses, __ATOMIC_SEQ_CST) > 0) && (waitUSec < (uint64_t)waitSeconds * 1000000))
+    {
+        usleep(PENDING_POLL_USEC);
+        waitUSec += PENDING_POLL_USEC;
+    }
+    if (__atomic_load_n(&pGlobals->nPendingResponses, __ATOMIC_SEQ_CST) > 0)
+    {
+        VMREST_LOG_WARNING(pRESTHandle,"Stopping with %u responses still pending, completing them is refused", __atomic_load_n(&pGlobals->nPendingResponses, __ATOMIC_SEQ_CST));
+    }
+
+    /**** A completion that saw the instance serving posts before the event queues go away ****/
+    __atomic_store_n(&pRESTHandle->instanceState, VMREST_INSTANCE_STOPPED, __ATOMIC_SEQ_CST);
+    while (__atomic_load_n(&pGlobals->nCompleting, __ATOMIC_SEQ_CST) > 0)
+    {
+        usleep(PENDING_POLL_USEC);
+    }
 
     dwError = VmHTTPStop(
                   pRESTHandle,
@@ -433,7 +442,7 @@ VmRESTGetData(
 {
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
 
-    if (!pRESTHandle || (pRESTHandle->instanceState != VMREST_INSTANCE_STARTED))
+    if (!pRESTHandle || !VMREST_INSTANCE_SERVING(pRESTHandle))
     {
         dwError = REST_ENGINE_ERROR_INVALID_PARAM;
     }
@@ -468,7 +477,7 @@ VmRESTGetDataZC(
 {
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
 
-    if (!pRESTHandle || !pRequest || !ppBuffer  || !nBytes || (pRESTHandle->instanceState != VMREST_INSTANCE_STARTED))
+    if (!pRESTHandle || !pRequest || !ppBuffer  || !nBytes || !VMREST_INSTANCE_SERVING(pRESTHandle))
     {
         VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid params");
         dwError = REST_ENGINE_ERROR_INVALID_PARAM;
@@ -508,7 +517,7 @@ VmRESTSetData(
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
 
 
-    if (!pRESTHandle || !ppResponse || !pcszBuffer || !bytesWritten || (pRESTHandle->instanceState != VMREST_INSTANCE_STARTED))
+    if (!pRESTHandle || !ppResponse || !pcszBuffer || !bytesWritten || !VMREST_INSTANCE_SERVING(pRESTHandle))
     {
         VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid params");
         dwError = REST_ENGINE_ERROR_INVALID_PARAM;
@@ -546,7 +555,7 @@ VmRESTSetDataZC(
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
 
 
-    if (!pRESTHandle || !ppResponse || !pcszBuffer || (pRESTHandle->instanceState != VMREST_INSTANCE_STARTED))
+    if (!pRESTHandle || !ppResponse || !pcszBuffer || !VMREST_INSTANCE_SERVING(pRESTHandle))
     {
         VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid params");
         dwError = REST_ENGINE_ERROR_INVALID_PARAM;
@@ -572,6 +581,213 @@ error:
 
 }
 
+uint32_t
+VmRESTSetDataFromFd(
+    PVMREST_HANDLE                   pRESTHandle,
+    PREST_RESPONSE*                  ppResponse,
+    int                              fd,
+    uint64_t                         offset,
+    uint64_t                         nBytes
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+
+    if (!pRESTHandle || !ppResponse || (fd < 0) || !VMREST_INSTANCE_SERVING(pRESTHandle))
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid params");
+        dwError = REST_ENGINE_ERROR_INVALID_PARAM;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTSetHttpPayloadFromFd(
+                  pRESTHandle,
+                  ppResponse,
+                  fd,
+                  offset,
+                  nBytes
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+
+}
+
+uint32_t
+VmRESTCompleteResponse(
+    PVMREST_HANDLE                   pRESTHandle,
+    PREST_REQUEST                    pRequest,
+    uint32_t                         dwStatus
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    PREST_ENG_GLOBALS                pGlobals = NULL;
+
+    if (!pRESTHandle || !pRequest || !pRequest->pSocket)
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid params");
+        dwError = REST_ENGINE_ERROR_INVALID_PARAM;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    pGlobals = pRESTHandle->pInstanceGlobal;
+
+    /**** Counted before the state is read, VmRESTStop() waits for it before tearing down the event queues ****/
+    __atomic_add_fetch(&pGlobals->nCompleting, 1, __ATOMIC_SEQ_CST);
+    if (!VMREST_INSTANCE_SERVING(pRESTHandle))
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"%s","Pending response completed after the instance stopped, refused");
+        dwError = REST_ENGINE_ERROR_INSTANCE_STOPPED;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    if (dwStatus != REST_ENGINE_SUCCESS)
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"Pending response failed with error code %u, sending failure response", dwStatus);
+        VmRESTSendFailureResponse(
+            pRESTHandle,
+            dwStatus,
+            pRequest
+            );
+    }
+
+    /**** Keep alive, re-arm and free happen back on the owning I/O loop ****/
+    dwError = VmwSockPostCompletion(
+                  pRESTHandle,
+                  pRequest->pSocket,
+                  pRequest
+                  );
+    if (dwError)
+    {
+        /**** Application let go of the request, it is not leaked when the post fails ****/
+        VMREST_LOG_ERROR(pRESTHandle,"Failed to hand completed request back to its event queue, dwError %u, closing connection", dwError);
+        VmRESTCommonDropRequest(
+            pRESTHandle,
+            pRequest->pSocket,
+            pRequest
+            );
+    }
+    __atomic_sub_fetch(&pGlobals->nPendingResponses, 1, __ATOMIC_SEQ_CST);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+cleanup:
+
+    /**** Handle may be gone once this drops, nothing touches it after ****/
+    if (pGlobals)
+    {
+        __atomic_sub_fetch(&pGlobals->nCompleting, 1, __ATOMIC_SEQ_CST);
+    }
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+
+}
+
+uint32_t
+VmRESTSetCacheable(
+    PVMREST_HANDLE                   pRESTHandle,
+    PREST_RESPONSE*                  ppResponse,
+    uint32_t                         nMaxAgeSec
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+
+    if (!pRESTHandle || !ppResponse || (*ppResponse == NULL) || (nMaxAgeSec == 0))
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid params");
+        dwError = REST_ENGINE_ERROR_INVALID_PARAM;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTCacheMark(
+                  pRESTHandle,
+                  *ppResponse,
+                  nMaxAgeSec
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+uint32_t
+VmRESTInvalidateCache(
+    PVMREST_HANDLE                   pRESTHandle,
+    char const*                      pcszURIPrefix
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+
+    if (!pRESTHandle)
+    {
+        dwError = REST_ENGINE_ERROR_INVALID_PARAM;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    VmRESTCacheInvalidate(
+        pRESTHandle,
+        pcszURIPrefix
+        );
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+uint32_t
+VmRESTGetTLSStats(
+    PVMREST_HANDLE                   pRESTHandle,
+    PREST_TLS_STATS                  pStats
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    PVM_SOCK_SSL_INFO                pSSLInfo = NULL;
+
+    if (!pRESTHandle || !pRESTHandle->pSSLInfo || !pStats)
+    {
+        dwError = REST_ENGINE_ERROR_INVALID_PARAM;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    pSSLInfo = pRESTHandle->pSSLInfo;
+
+    pStats->nHandshakes = __atomic_load_n(&pSSLInfo->nHandshakes, __ATOMIC_RELAXED);
+    pStats->nHandshakeFailures = __atomic_load_n(&pSSLInfo->nHandshakeFailures, __ATOMIC_RELAXED);
+    pStats->handshakeTimeUSec = __atomic_load_n(&pSSLInfo->handshakeTimeUSec, __ATOMIC_RELAXED);
+    pStats->handshakeMaxUSec = __atomic_load_n(&pSSLInfo->handshakeMaxUSec, __ATOMIC_RELAXED);
+    pStats->handshakeWorkUSec = __atomic_load_n(&pSSLInfo->handshakeWorkUSec, __ATOMIC_RELAXED);
+    pStats->nResumed = __atomic_load_n(&pSSLInfo->nResumed, __ATOMIC_RELAXED);
+    pStats->nSessionCacheHits = __atomic_load_n(&pSSLInfo->nSessionCacheHits, __ATOMIC_RELAXED);
+    pStats->nSessionCacheMisses = __atomic_load_n(&pSSLInfo->nSessionCacheMisses, __ATOMIC_RELAXED);
+    pStats->nKTLS = __atomic_load_n(&pSSLInfo->nKTLS, __ATOMIC_RELAXED);
+    pStats->nKTLSFallbacks = __atomic_load_n(&pSSLInfo->nKTLSFallbacks, __ATOMIC_RELAXED);
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
 uint32_t
 VmRESTSetSuccessResponse(
     PREST_REQUEST                    pRequest,
@@ -714,16 +930,23 @@ VmRESTSetDataLength(
     )
 {
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    uint64_t                         nContentLen = 0;
 
-    if ((dataLen != NULL) && (atoi(dataLen) <= MAX_DATA_BUFFER_LEN))
+    if (dataLen != NULL)
     {
+        dwError = VmRESTParseContentLength(
+                      dataLen,
+                      &nContentLen
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+
         dwError = VmRESTSetHttpHeader(
                       ppResponse,
                       "Content-Length",
                       dataLen
                       );
     }
-    else if (dataLen == NULL)
+    else
     {
         dwError = VmRESTSetHttpHeader(
                       ppResponse,
@@ -731,10 +954,6 @@ VmRESTSetDataLength(
                       "chunked"
                       );
     }
-    else
-    {
-        dwError = VMREST_HTTP_INVALID_PARAMS;
-    }
     BAIL_ON_VMREST_ERROR(dwError);
 
 cleanup:
@@ -15,12 +15,12 @@
 
 BOOLEAN
 VmRESTIsValidHTTPMethod(
-    char*                            pszMethod
+    char const*                      pszMethod
     );
 
 BOOLEAN
 VmRESTIsValidHTTPVesion(
-   char*                             pszVersion
+   char const*                       pszVersion
    );
 
 uint32_t
@@ -76,20 +76,12 @@ VMRESTWriteStatusLineInResponseStream(
     );
 
 uint32_t
-VMRESTWriteMessageBodyInResponseStream(
+VmRESTBuildResponseHeaderStream(
     PVM_REST_HTTP_RESPONSE_PACKET    pResPacket,
-    char*                            buffer,
-    uint32_t*                        bytes
+    char**                           ppszBuffer,
+    uint32_t*                        pnBytes
     );
 
-uint32_t
-VMRESTWriteChunkedMessageInResponseStream(
-    char*                            src,
-    uint32_t                         srcSize,
-    char*                            buffer,
-    uint32_t*                        bytes
-);
-
 uint32_t
 VmRESTSendHeader(
     PVMREST_HANDLE                   pRESTHandle,
@@ -100,13 +92,34 @@ uint32_t
 VmRESTSendChunkedPayload(
     PVMREST_HANDLE                   pRESTHandle,
     PVM_REST_HTTP_RESPONSE_PACKET*   ppResPacket,
+    char const*                      pszData,
     uint32_t                         dataLen
     );
 
+uint32_t
+VmRESTChunkBufInit(
+    PVMREST_HANDLE                   pRESTHandle
+    );
+
+void
+VmRESTChunkBufShutdown(
+    PVMREST_HANDLE                   pRESTHandle
+    );
+
 uint32_t
 VmRESTSendHeaderAndPayload(
     PVMREST_HANDLE                   pRESTHandle,
-    PVM_REST_HTTP_RESPONSE_PACKET*   ppResPacket
+    PVM_REST_HTTP_RESPONSE_PACKET*   ppResPacket,
+    char const*                      pszPayload,
+    uint32_t                         nPayloadLen
+    );
+
+uint32_t
+VmRESTSendPayload(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_REST_HTTP_RESPONSE_PACKET*   ppResPacket,
+    char const*                      pszPayload,
+    uint32_t                         nPayloadLen
     );
 
 uint32_t
@@ -124,6 +137,24 @@ VmRESTSetHttpPayloadZeroCopy(
     uint32_t                         nBytes
     );
 
+uint32_t
+VmRESTSetHttpPayloadFromFd(
+    PVMREST_HANDLE                   pRESTHandle,
+    PREST_RESPONSE*                  ppResponse,
+    int                              fd,
+    uint64_t                         offset,
+    uint64_t                         nBytes
+    );
+
+/***************** httpScan.c  ********************/
+
+BOOLEAN
+VmRESTScanLine(
+    char const*                      pszBuffer,
+    uint32_t                         nBytes,
+    PVM_REST_LINE_SCAN               pScan
+    );
+
 /***************** httpAllocStruct.c  *************/
 
 uint32_t
@@ -138,11 +169,7 @@ VmRESTFreeHTTPRequestPacket(
 
 uint32_t
 VmRESTAllocateHTTPResponsePacket(
-    PVM_REST_HTTP_RESPONSE_PACKET*   ppResPacket
-    );
-
-void
-VmRESTFreeHTTPResponsePacket(
+    PVM_REST_ARENA                   pArena,
     PVM_REST_HTTP_RESPONSE_PACKET*   ppResPacket
     );
 
@@ -190,11 +217,33 @@ VmRESTGetHttpResponseHeader(
     char**                           response
     );
 
+uint32_t
+VmRESTParseContentLength(
+    char const*                      pszContentLen,
+    uint64_t*                        pnContentLen
+    );
+
 uint32_t
 VmRESTSetHttpRequestHeader(
     PVM_REST_HTTP_REQUEST_PACKET     pRequest,
-    char*                            header,
-    char*                            value
+    char const*                      pszHeader,
+    uint32_t                         nHeader,
+    char const*                      pszValue,
+    uint32_t                         nValue
+    );
+
+uint32_t
+VmRESTAppendRequestHead(
+    PVM_REST_HTTP_REQUEST_PACKET     pRequest,
+    char const*                      pszData,
+    uint32_t                         nData,
+    PVM_REST_HTTP_SPAN               pSpan
+    );
+
+char const*
+VmRESTGetRequestSpan(
+    PVM_REST_HTTP_REQUEST_PACKET     pRequest,
+    PVM_REST_HTTP_SPAN               pSpan
     );
 
 void
@@ -222,6 +271,7 @@ VmRESTCopyConfig(
 
 uint32_t
 VmRESTSetHTTPMiscHeader(
+    PVM_REST_ARENA                   pArena,
     PMISC_HEADER_QUEUE               miscHeaderQueue,
     char const*                      header,
     char const*                      value
@@ -232,6 +282,12 @@ VmRESTRemoveAllHTTPMiscHeader(
     PMISC_HEADER_QUEUE               miscHeaderQueue
     );
 
+uint32_t
+VmRESTRemoveHTTPMiscHeader(
+    PMISC_HEADER_QUEUE               miscHeaderQueue,
+    char const*                      header
+    );
+
 uint32_t
 VmRESTGetHTTPMiscHeader(
     PMISC_HEADER_QUEUE               miscHeaderQueue,
@@ -308,38 +364,72 @@ VmRestEngineGetEndPoint(
 
 uint32_t
 VmRestGetParamsCountInReqURI(
-    char*                            pRequestURI,
+    char const*                      pRequestURI,
     uint32_t*                        paramCount
     );
 
 uint32_t
 VmRestParseParams(
     PVMREST_HANDLE                   pRESTHandle,
-    char*                            pRequestURI,
     uint32_t                         paramsCount,
     PREST_REQUEST                    pRequest
     );
 
 uint32_t
-VmRESTMatchEndPointURI(
-    char*                            pattern,
-    char*                            pEndPointURI
+VmRESTRouteRequest(
+    PVMREST_HANDLE                   pRESTHandle,
+    PREST_REQUEST                    pRequest
     );
 
+/***************** restRouter.c  ************/
+
 uint32_t
-VmRESTGetPreSlashIndex(
-    char*                            patternURI,
-    uint32_t                         wildCardIndex,
-    uint32_t*                        preSlashIndex
+VmRESTRouterAdd(
+    PVM_REST_ROUTE_NODE*             ppRoot,
+    PREST_ENDPOINT                   pEndPoint
     );
 
 uint32_t
-VmRESTCopyWCStringByIndex(
-    char*                            requestEndPointURI,
-    char*                            des,
-    uint32_t                         wcIndex,
-    uint32_t                         totalWC,
-    uint32_t                         preSlashIndex
+VmRESTRouterFind(
+    PVM_REST_ROUTE_NODE              pRoot,
+    char const*                      pszPath,
+    uint32_t                         nPath,
+    PVM_REST_HTTP_SPAN               pWildCards,
+    uint32_t*                        pnWildCards,
+    PREST_ENDPOINT*                  ppEndPoint
+    );
+
+void
+VmRESTRouterFree(
+    PVM_REST_ROUTE_NODE              pRoot
+    );
+
+uint32_t
+VmRESTRouteTableAdd(
+    PREST_ENG_GLOBALS                pGlobals,
+    PREST_ENDPOINT                   pEndPoint
+    );
+
+uint32_t
+VmRESTRouteTableRemove(
+    PREST_ENG_GLOBALS                pGlobals,
+    char const*                      pszEndPointURI
+    );
+
+void
+VmRESTRouteTableFree(
+    PREST_ENG_GLOBALS                pGlobals
+    );
+
+uint32_t
+VmRESTEnterRouteTable(
+    PREST_ENG_GLOBALS                pGlobals,
+    PVM_REST_ROUTE_TABLE*            ppTable
+    );
+
+void
+VmRESTLeaveRouteTable(
+    void
     );
 
 /***************** httpMain.c  ************/
@@ -424,4 +514,94 @@ VmRESTValidateHTTPContentType(
     uint32_t*                        err
     );
 
+/********************* httpCompress.c *******************/
+
+uint32_t
+VmRESTDeflateInit(
+    PVMREST_HANDLE                   pRESTHandle
+    );
+
+void
+VmRESTDeflateShutdown(
+    PVMREST_HANDLE                   pRESTHandle
+    );
+
+uint32_t
+VmRESTDeflateStart(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_REST_HTTP_RESPONSE_PACKET    pResPacket,
+    uint64_t                         nBodyLen,
+    BOOLEAN                          bBodyLenKnown
+    );
+
+uint32_t
+VmRESTDeflateChunked(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_REST_HTTP_RESPONSE_PACKET*   ppResPacket,
+    char const*                      pszData,
+    uint32_t                         dataLen
+    );
+
+uint32_t
+VmRESTDeflateContentLength(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_REST_HTTP_RESPONSE_PACKET*   ppResPacket,
+    char const*                      pszData,
+    uint32_t                         dataLen,
+    BOOLEAN                          bLast
+    );
+
+void
+VmRESTDeflateRelease(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_REST_HTTP_RESPONSE_PACKET    pResPacket
+    );
+
+
+
+/********************* httpCache.c *******************/
+
+uint32_t
+VmRESTCacheInit(
+    PVMREST_HANDLE                   pRESTHandle
+    );
+
+void
+VmRESTCacheShutdown(
+    PVMREST_HANDLE                   pRESTHandle
+    );
+
+uint32_t
+VmRESTCacheMark(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_REST_HTTP_RESPONSE_PACKET    pResPacket,
+    uint32_t                         nMaxAgeSec
+    );
+
+void
+VmRESTCacheCapture(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_REST_HTTP_RESPONSE_PACKET    pResPacket,
+    PVM_SOCK_IO_VEC                  pVec,
+    uint32_t                         nVec,
+    BOOLEAN                          bHeader
+    );
+
+void
+VmRESTCacheRelease(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_REST_HTTP_RESPONSE_PACKET    pResPacket
+    );
 
+uint32_t
+VmRESTCacheServe(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_REST_HTTP_REQUEST_PACKET     pRequest,
+    BOOLEAN*                         pbServed
+    );
+
+void
+VmRESTCacheInvalidate(
+    PVMREST_HANDLE                   pRESTHandle,
+    char const*                      pszURIPrefix
+    );
@@ -20,106 +20,53 @@ VmRestEngineHandler(
     PREST_RESPONSE*                  ppResponse
     )
 {
-    char                             httpMethod[MAX_METHOD_LEN] = {0};
-    char*                            httpURI = NULL;
-    char*                            endPointURI = NULL;
-    char*                            ptr = NULL;
+    char const*                      httpMethod = NULL;
+    char const*                      endPointURI = NULL;
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
     uint32_t                         paramsCount = 0;
-    PREST_ENDPOINT                   pEndPoint = NULL;
+    PREST_PROCESSOR                  pHandler = NULL;
 
     VMREST_LOG_DEBUG(pRESTHandle,"%s","Internal Handler called");
 
-    /**** 1. Allocate the memory of holding URI *****/
-
-    dwError = VmRESTAllocateMemory(
-                  MAX_URI_LEN,
-                  (void**)&endPointURI
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
+    /**** 1. Get the method name, read in place from the request head ****/
 
-    dwError = VmRESTAllocateMemory(
-                  MAX_URI_LEN,
-                  (void**)&httpURI
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
-
-    /**** 2. Get the method name ****/
-
-    dwError = VmRESTGetHttpMethod(
-                  pRequest,
-                  &ptr
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
-    memset(httpMethod, '\0', MAX_METHOD_LEN);
-    strncpy(httpMethod,ptr, (MAX_METHOD_LEN - 1));
-    if (ptr != NULL)
+    if ((pRequest->requestLine.method.len == 0) || (pRequest->requestLine.method.len >= MAX_METHOD_LEN))
     {
-        VmRESTFreeMemory(ptr);
-        ptr = NULL;
+        dwError = VMREST_HTTP_VALIDATION_FAILED;
     }
-    VMREST_LOG_DEBUG(pRESTHandle,"HTTP method %s", httpMethod);
-
-    /**** 3. Get the URI ****/
-
-    dwError = VmRESTGetHttpURI(
-                  pRequest,
-                  TRUE,
-                  &ptr
-                  );
     BAIL_ON_VMREST_ERROR(dwError);
-    memset(httpURI, '\0',MAX_URI_LEN);
-    strncpy(httpURI,ptr,(MAX_URI_LEN - 1));
-    if (ptr != NULL)
-    {
-        VmRESTFreeMemory(ptr);
-        ptr = NULL;
-    }
-
-    VMREST_LOG_INFO(pRESTHandle,"C-REST-ENGINE: HTTP URI %s", httpURI);
 
-    /**** 4. Get the End point from URI ****/
-    dwError = VmRestGetEndPointURIfromRequestURI(
-                  httpURI,
-                  &ptr
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
-    memset(endPointURI, '\0',MAX_URI_LEN);
-    strncpy(endPointURI,ptr,(MAX_URI_LEN - 1));
-    if (ptr != NULL)
-    {
-        free(ptr);
-        ptr = NULL;
-    }
+    httpMethod = VmRESTGetRequestSpan(pRequest, &pRequest->requestLine.method);
+    VMREST_LOG_DEBUG(pRESTHandle,"HTTP method %s", httpMethod);
 
-    VMREST_LOG_DEBUG(pRESTHandle,"EndPoint URI %s", endPointURI);
+    /**** 2. Route the URI to its End point ****/
 
-    dwError = VmRestEngineGetEndPoint(
+    dwError = VmRESTRouteRequest(
                   pRESTHandle,
-                  endPointURI,
-                  &pEndPoint
+                  pRequest
                   );
     BAIL_ON_VMREST_ERROR(dwError);
 
-    VMREST_LOG_DEBUG(pRESTHandle,"EndPoint found for URI %s",endPointURI);
+    pHandler = &pRequest->endPointHandler;
+
+    VMREST_LOG_DEBUG(pRESTHandle,"EndPoint found for URI %s", VmRESTGetRequestSpan(pRequest, &pRequest->endPointURI));
 
-    /**** 5. Get Params count ****/
+    /**** 3. Get Params count ****/
 
     dwError = VmRestGetParamsCountInReqURI(
-                  pRequest->requestLine->uri,
+                  VmRESTGetRequestSpan(pRequest, &pRequest->requestLine.uri),
                   &paramsCount
                   );
     BAIL_ON_VMREST_ERROR(dwError);
 
     VMREST_LOG_DEBUG(pRESTHandle,"Params count %u", paramsCount);
 
-    /**** 6. Parse and populate all params in request URL ****/
+    /**** 4. Parse and populate all params in request URL ****/
 
     if (paramsCount > 0)
     {
         dwError = VmRestParseParams(
                       pRESTHandle,
-                      pRequest->requestLine->uri,
                       paramsCount,
                       pRequest
                       );
@@ -127,13 +74,15 @@ VmRestEngineHandler(
         VMREST_LOG_DEBUG(pRESTHandle,"Params parsing done, returned code %u", dwError);
     }
 
-    /**** 7. Give App CB based on HTTP method and registered endpoint ****/
+    /**** 5. Give App CB based on HTTP method and registered endpoint ****/
+
+    endPointURI = VmRESTGetRequestSpan(pRequest, &pRequest->endPointURI);
 
     if (strcmp(httpMethod,"GET") == 0)
     {
-        if (pEndPoint && pEndPoint->pHandler && pEndPoint->pHandler->pfnHandleRead)
+        if (pHandler->pfnHandleRead)
         {
-            dwError = pEndPoint->pHandler->pfnHandleRead(pRESTHandle, pRequest, ppResponse, paramsCount);
+            dwError = pHandler->pfnHandleRead(pRESTHandle, pRequest, ppResponse, paramsCount);
             VMREST_LOG_DEBUG(pRESTHandle,"Callback, returned code %u", dwError);
         }
         else
@@ -144,9 +93,9 @@ VmRestEngineHandler(
     }
     else if (strcmp(httpMethod,"POST") == 0)
     {
-        if (pEndPoint && pEndPoint->pHandler && pEndPoint->pHandler->pfnHandleCreate)
+        if (pHandler->pfnHandleCreate)
         {
-            dwError = pEndPoint->pHandler->pfnHandleCreate(pRESTHandle, pRequest, ppResponse, paramsCount);
+            dwError = pHandler->pfnHandleCreate(pRESTHandle, pRequest, ppResponse, paramsCount);
         }
         else
         {
@@ -156,9 +105,9 @@ VmRestEngineHandler(
     }
     else if (strcmp(httpMethod,"PUT") == 0)
     {
-        if (pEndPoint && pEndPoint->pHandler && pEndPoint->pHandler->pfnHandleUpdate)
+        if (pHandler->pfnHandleUpdate)
         {
-            dwError = pEndPoint->pHandler->pfnHandleUpdate(pRESTHandle, pRequest, ppResponse, paramsCount);
+            dwError = pHandler->pfnHandleUpdate(pRESTHandle, pRequest, ppResponse, paramsCount);
         }
         else
         {
@@ -168,9 +117,9 @@ VmRestEngineHandler(
     }
     else if (strcmp(httpMethod,"DELETE") == 0)
     {
-        if (pEndPoint && pEndPoint->pHandler && pEndPoint->pHandler->pfnHandleDelete)
+        if (pHandler->pfnHandleDelete)
         {
-            dwError = pEndPoint->pHandler->pfnHandleDelete(pRESTHandle, pRequest, ppResponse, paramsCount);
+            dwError = pHandler->pfnHandleDelete(pRESTHandle, pRequest, ppResponse, paramsCount);
         }
         else
         {
@@ -181,9 +130,9 @@ VmRestEngineHandler(
     else if ((strcmp(httpMethod,"OPTIONS") == 0) || (strcmp(httpMethod,"PATCH") == 0))
     {
         /**** Add all allowed HTTP methods ****/
-        if (pEndPoint && pEndPoint->pHandler && pEndPoint->pHandler->pfnHandleOthers)
+        if (pHandler->pfnHandleOthers)
         {
-            dwError = pEndPoint->pHandler->pfnHandleOthers(pRESTHandle, pRequest, ppResponse, paramsCount);
+            dwError = pHandler->pfnHandleOthers(pRESTHandle, pRequest, ppResponse, paramsCount);
         }
         else
         {
@@ -199,16 +148,6 @@ VmRestEngineHandler(
     BAIL_ON_VMREST_ERROR(dwError);
 
 cleanup:
-    if (endPointURI != NULL)
-    {
-        VmRESTFreeMemory(endPointURI);
-        endPointURI = NULL;
-    }
-    if (httpURI != NULL)
-    {
-        VmRESTFreeMemory(httpURI);
-        httpURI = NULL;
-    }
     return dwError;
 error:
     goto cleanup;
@@ -238,7 +177,8 @@ VmRestEngineInitEndPointRegistration(
         BAIL_ON_VMREST_ERROR(dwError);
 
         pthread_mutex_lock(&(pRESTHandle->pInstanceGlobal->mutex));
-        pRESTHandle->pInstanceGlobal->pEndPointQueue = NULL;
+        pRESTHandle->pInstanceGlobal->pRouteTable = NULL;
+        pRESTHandle->pInstanceGlobal->pRetiredRouteTables = NULL;
         pRESTHandle->pInstanceGlobal->useEndPoint = 1;
         pthread_mutex_unlock(&(pRESTHandle->pInstanceGlobal->mutex));
 
@@ -261,9 +201,6 @@ VmRestEngineShutdownEndPointRegistration(
     PVMREST_HANDLE                   pRESTHandle
     )
 {
-    PREST_ENDPOINT                   temp = NULL;
-    PREST_ENDPOINT                   prev = NULL;
-
     if (!pRESTHandle)
     {
         VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid REST handler");
@@ -274,16 +211,7 @@ VmRestEngineShutdownEndPointRegistration(
 
     pthread_mutex_lock(&(pRESTHandle->pInstanceGlobal->mutex));
 
-    temp = pRESTHandle->pInstanceGlobal->pEndPointQueue;
-
-    while(temp != NULL)
-    {
-        prev = temp;
-        temp = temp->next;
-
-        VmRESTFreeEndPoint(prev);
-    }
-    pRESTHandle->pInstanceGlobal->pEndPointQueue = NULL;
+    VmRESTRouteTableFree(pRESTHandle->pInstanceGlobal);
     pRESTHandle->pInstanceGlobal->useEndPoint = 0; 
     pthread_mutex_unlock(&(pRESTHandle->pInstanceGlobal->mutex));
 
@@ -302,7 +230,6 @@ VmRestEngineAddEndpoint(
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
     size_t                           endPointURILen = 0;
     PREST_ENDPOINT                   pEndPoint = NULL;
-    PREST_ENDPOINT                   temp = NULL;
     char*                            hasSpace = NULL;
 
     /**** TODO: Add check to perform this only when engine is not running ****/
@@ -325,26 +252,6 @@ VmRestEngineAddEndpoint(
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
-    /**** If Endpoint already exists - return****/
-    dwError = VmRestEngineGetEndPoint(
-                  pRESTHandle,
-                  pEndPointURI,
-                  &temp
-                  );
-    if(dwError != NOT_FOUND)
-    {
-        dwError = REST_ERROR_ENDPOINT_EXISTS;
-    }
-    else
-    {
-        dwError = 0;
-    }
-    BAIL_ON_VMREST_ERROR(dwError);
-
-    temp = NULL;
-
-    
-
     /**** Allocate and Assign Endpoint ****/
     dwError = VmRESTAllocateEndPoint(
                   &pEndPoint
@@ -368,23 +275,15 @@ VmRestEngineAddEndpoint(
         BAIL_ON_VMREST_ERROR(dwError);
     }
 
-    /**** Add to list of endpoints ****/
+    /**** Publish a new route table, fails if the same URI is already registered ****/
     pthread_mutex_lock(&(pRESTHandle->pInstanceGlobal->mutex));
-
-    if (pRESTHandle->pInstanceGlobal->pEndPointQueue == NULL)
-    {
-        pRESTHandle->pInstanceGlobal->pEndPointQueue = pEndPoint;
-    }
-    else
-    {
-        temp = pRESTHandle->pInstanceGlobal->pEndPointQueue;
-        while(temp->next != NULL)
-        { 
-            temp = temp->next;
-        }
-        temp->next = pEndPoint;
-    }
+    dwError = VmRESTRouteTableAdd(
+                  pRESTHandle->pInstanceGlobal,
+                  pEndPoint
+                  );
     pthread_mutex_unlock(&(pRESTHandle->pInstanceGlobal->mutex));
+    BAIL_ON_VMREST_ERROR(dwError);
+
 cleanup:
     return dwError;
 error:
@@ -403,8 +302,6 @@ VmRestEngineRemoveEndpoint(
     )
 {
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
-    PREST_ENDPOINT                   temp = NULL;
-    PREST_ENDPOINT                   prev = NULL;
 
     /**** TODO: Add check to perform this only when engine is not running ****/
 
@@ -415,38 +312,14 @@ VmRestEngineRemoveEndpoint(
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
-    /**** Remove from list of endpoints ****/
+    /**** Publish a table without it, the endpoint is freed once no request can be reading it ****/
     pthread_mutex_lock(&(pRESTHandle->pInstanceGlobal->mutex));
-
-    temp = pRESTHandle->pInstanceGlobal->pEndPointQueue;
-    prev = temp;
-
-    if ((temp != NULL) && (temp->pszEndPointURI != NULL) && (strcmp(temp->pszEndPointURI,pEndPointURI) == 0))
+    if (VmRESTRouteTableRemove(pRESTHandle->pInstanceGlobal, pEndPointURI) != REST_ENGINE_SUCCESS)
     {
-        pRESTHandle->pInstanceGlobal->pEndPointQueue = temp->next;
-    }
-    else
-    {
-       while(temp != NULL && (temp->pszEndPointURI != NULL) && (strcmp(temp->pszEndPointURI,pEndPointURI) != 0))
-       {
-           prev = temp;
-           temp = temp->next;
-       }
-       if (temp == NULL)
-       {
-           VMREST_LOG_ERROR(pRESTHandle,"%s","Requested endpoint %s not registered");
-       }
-       else
-       {
-           prev->next = temp->next;
-       }
+        VMREST_LOG_ERROR(pRESTHandle,"Requested endpoint %s not registered", pEndPointURI);
     }
     pthread_mutex_unlock(&(pRESTHandle->pInstanceGlobal->mutex));
 
-    if (temp)
-    {
-        VmRESTFreeEndPoint(temp);
-    }
 cleanup:
     return dwError;
 error:
@@ -461,66 +334,194 @@ VmRestEngineGetEndPoint(
     )
 {
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
-    uint32_t                         found = 0;
-
+    uint32_t                         nWildCards = 0;
+    BOOLEAN                          bEntered = FALSE;
+    VM_REST_HTTP_SPAN                wildCards[MAX_URI_WILD_CARDS];
+    PVM_REST_ROUTE_TABLE             pTable = NULL;
     PREST_ENDPOINT                   temp = NULL;
+    PREST_ENDPOINT                   pEndPoint = NULL;
 
-    if (!pEndPointURI || !pRESTHandle)
+    if (!pEndPointURI || !pRESTHandle || !ppEndPoint)
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid params");
+        dwError =  VMREST_HTTP_INVALID_PARAMS;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTAllocateEndPoint(
+                  &pEndPoint
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTEnterRouteTable(
+                  pRESTHandle->pInstanceGlobal,
+                  &pTable
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+    bEntered = TRUE;
+
+    dwError = VmRESTRouterFind(
+                  pTable ? pTable->pRoot : NULL,
+                  pEndPointURI,
+                  strlen(pEndPointURI),
+                  wildCards,
+                  &nWildCards,
+                  &temp
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    /**** Registered endpoint may be freed once the table is left, hand out a copy ****/
+    strcpy(pEndPoint->pszEndPointURI, temp->pszEndPointURI);
+    *(pEndPoint->pHandler) = *(temp->pHandler);
+    pEndPoint->next = NULL;
+
+    *ppEndPoint = pEndPoint;
+
+cleanup:
+    if (bEntered)
+    {
+        VmRESTLeaveRouteTable();
+    }
+    return dwError;
+error:
+    if (pEndPoint)
+    {
+        VmRESTFreeEndPoint(pEndPoint);
+        pEndPoint = NULL;
+    }
+    if (ppEndPoint)
+    {
+        *ppEndPoint = NULL;
+    }
+    goto cleanup;
+}
+
+uint32_t
+VmRESTRouteRequest(
+    PVMREST_HANDLE                   pRESTHandle,
+    PREST_REQUEST                    pRequest
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    uint32_t                         i = 0;
+    uint32_t                         nURI = 0;
+    BOOLEAN                          bEntered = FALSE;
+    char*                            httpURI = NULL;
+    char*                            pszQuery = NULL;
+    PVM_REST_ROUTE_TABLE             pTable = NULL;
+    PREST_ENDPOINT                   pEndPoint = NULL;
+
+    if (!pRESTHandle || !pRequest)
     {
         VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid params");
         dwError =  VMREST_HTTP_INVALID_PARAMS;
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
-    *ppEndPoint = NULL;
-    temp = pRESTHandle->pInstanceGlobal->pEndPointQueue;
+    /**** Routed once per request, later calls reuse the match ****/
+    if (pRequest->bRouted)
+    {
+        goto cleanup;
+    }
 
-    while (temp != NULL)
+    nURI = pRequest->requestLine.uri.len;
+    if ((nURI == 0) || (nURI > MAX_URI_LEN))
     {
-        if (temp->pszEndPointURI != NULL)
-        {
-            found = VmRESTMatchEndPointURI(
-                        temp->pszEndPointURI,
-                        pEndPointURI
-                        );
-            if (found == 0)
-            {
-                found = VmRESTMatchEndPointURI(
-                            pEndPointURI,
-                            temp->pszEndPointURI
-                            );
-            }
+        dwError = VMREST_HTTP_VALIDATION_FAILED;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
 
-            if(found == 1)
-            {
-                *ppEndPoint = temp;
-                break;
-            }
-        }
-        temp = temp->next;
+    /**** Decoding never grows the string, scratch copy goes away with the request ****/
+    dwError = VmRESTArenaAllocate(
+                  pRequest->pArena,
+                  (nURI + 1),
+                  (void**)&httpURI
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    VmRESTDecodeEncodedURLString(
+        VmRESTGetRequestSpan(pRequest, &pRequest->requestLine.uri),
+        httpURI
+        );
+
+    VMREST_LOG_INFO(pRESTHandle,"C-REST-ENGINE: HTTP URI %s", httpURI);
+
+    /**** End point is the path without the query string ****/
+    pszQuery = strchr(httpURI, '?');
+    if (pszQuery != NULL)
+    {
+        *pszQuery = '\0';
+    }
+
+    if ((httpURI[0] == '\0') || (strchr(httpURI, ' ') != NULL))
+    {
+        dwError = BAD_REQUEST;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    VMREST_LOG_DEBUG(pRESTHandle,"EndPoint URI %s", httpURI);
+
+    /**** Keep the decoded path with the request, wild card captures point into it ****/
+    dwError = VmRESTAppendRequestHead(
+                  pRequest,
+                  httpURI,
+                  strlen(httpURI),
+                  &pRequest->endPointURI
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTEnterRouteTable(
+                  pRESTHandle->pInstanceGlobal,
+                  &pTable
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+    bEntered = TRUE;
+
+    dwError = VmRESTRouterFind(
+                  pTable ? pTable->pRoot : NULL,
+                  httpURI,
+                  pRequest->endPointURI.len,
+                  pRequest->wildCards,
+                  &pRequest->nWildCards,
+                  &pEndPoint
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    /**** Request keeps its own copy of the handlers, the endpoint can go away with the table ****/
+    pRequest->endPointHandler = *(pEndPoint->pHandler);
+    pRequest->bRouted = TRUE;
+
+    for (i = 0; i < pRequest->nWildCards; i++)
+    {
+        pRequest->wildCards[i].offset += pRequest->endPointURI.offset;
     }
 
 cleanup:
-    if (temp == NULL)
+    if (bEntered)
     {
-        dwError = NOT_FOUND;
+        VmRESTLeaveRouteTable();
     }
     return dwError;
 error:
+    if (pRequest)
+    {
+        pRequest->bRouted = FALSE;
+        pRequest->nWildCards = 0;
+    }
     goto cleanup;
 }
 
 uint32_t
 VmRestGetParamsCountInReqURI(
-    char*                            pRequestURI,
+    char const*                      pRequestURI,
     uint32_t*                        paramCount
     )
 {
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
     uint32_t                         ampCnt = 0;
     uint32_t                         eqCnt = 0;
-    char*                            temp = NULL;
-    char*                            hasSpace = NULL;
+    char const*                      temp = NULL;
+    char const*                      hasSpace = NULL;
 
 
     if (!pRequestURI || !paramCount)
@@ -574,21 +575,19 @@ error:
 uint32_t
 VmRestParseParams(
     PVMREST_HANDLE                   pRESTHandle,
-    char*                            pRequestURI,
     uint32_t                         paramsCount,
     PREST_REQUEST                    pRequest
     )
 {
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
-    char*                            key = NULL;
-    char*                            value = NULL;
-    char*                            res = NULL;
+    char const*                      pRequestURI = NULL;
+    char const*                      key = NULL;
+    char const*                      value = NULL;
+    PVM_REST_URL_PARAMS              res = NULL;
     uint32_t                         i = 0;
     uint64_t                         diff = 0;
-    
 
-    
-    if (!pRequestURI || !pRequest)
+    if (!pRequest)
     {
         dwError =  VMREST_HTTP_INVALID_PARAMS;
     }
@@ -600,13 +599,10 @@ VmRestParseParams(
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
-    for (i=0; i < MAX_URL_PARAMS_ARR_SIZE; i++)
-    {
-        memset(pRequest->paramArray[i].key, '\0', MAX_KEY_VAL_PARAM_LEN);
-        memset(pRequest->paramArray[i].value, '\0', MAX_KEY_VAL_PARAM_LEN);
-    }
+    memset(pRequest->paramArray, 0, sizeof(pRequest->paramArray));
 
-    i = 0;
+    /**** Params are spans into the URI already held in the request head ****/
+    pRequestURI = VmRESTGetRequestSpan(pRequest, &pRequest->requestLine.uri);
 
     key = strchr(pRequestURI, '?');
 
@@ -627,12 +623,12 @@ VmRestParseParams(
             value = strchr(key,'=');
             if (value)
             {
-                res = pRequest->paramArray[i].key;
+                res = &pRequest->paramArray[i];
                 diff = value - key - 1;
                 if (diff < MAX_KEY_VAL_PARAM_LEN)
                 {
-                    strncpy(res, (key + 1), diff);
-                    *(res + diff) = '\0';
+                    res->key.offset = pRequest->requestLine.uri.offset + (key + 1 - pRequestURI);
+                    res->key.len = diff;
                 }
                 else
                 {
@@ -642,38 +638,29 @@ VmRestParseParams(
 
                 key = NULL;
                 key = strchr(value, '&');
-                res= pRequest->paramArray[i].value;
                 if (key)
                 {
                     diff = key - value - 1;
-                    if (diff < MAX_KEY_VAL_PARAM_LEN)
-                    {
-                        strncpy(res, (value + 1), diff);
-                        *(res + diff) = '\0';
-                    }
-                    else
-                    {
-                        dwError = REQUEST_ENTITY_TOO_LARGE;
-                    }
-                    BAIL_ON_VMREST_ERROR(dwError);
                 }
                 else
                 {
-                    if ((*(value +1) != '\0') && (strlen(value+1) < MAX_KEY_VAL_PARAM_LEN))
-                    {
-                        strncpy(res, (value +1), (MAX_KEY_VAL_PARAM_LEN -1));
-                    }
-                    else if ((*(value +1) == '\0'))
+                    diff = strlen(value + 1);
+                    if (diff == 0)
                     {
                         VMREST_LOG_DEBUG(pRESTHandle, "Missing value in key-value pair");
-                        memset(res, '\0', MAX_KEY_VAL_PARAM_LEN);
                     }
-                    else
-                    {
-                        VMREST_LOG_ERROR(pRESTHandle, "Value too large");
-                        dwError = REQUEST_ENTITY_TOO_LARGE;
-                    }
-                } 
+                }
+
+                if (diff < MAX_KEY_VAL_PARAM_LEN)
+                {
+                    res->value.offset = pRequest->requestLine.uri.offset + (value + 1 - pRequestURI);
+                    res->value.len = diff;
+                }
+                else
+                {
+                    VMREST_LOG_ERROR(pRESTHandle, "Value too large");
+                    dwError = REQUEST_ENTITY_TOO_LARGE;
+                }
             }
             else
             {
@@ -691,166 +678,11 @@ VmRestParseParams(
 cleanup:
     return dwError;
 error:
-    for (i=0; i < MAX_URL_PARAMS_ARR_SIZE; i++)
-    {
-        memset(pRequest->paramArray[i].key, '\0', MAX_KEY_VAL_PARAM_LEN);
-        memset(pRequest->paramArray[i].value, '\0', MAX_KEY_VAL_PARAM_LEN);
-    }
-    goto cleanup;
-}
-
-uint32_t
-VmRESTMatchEndPointURI(
-    char*                            pattern,
-    char*                            pEndPointURI
-    )
-{
-    /**** return 0 = fail, return 1 = success ****/
-
-    if (*pattern == '\0' && *pEndPointURI == '\0')
-    {
-        return 1;
-    }
-
-    if (*pattern == '*' && *(pattern+1) != '\0' && *pEndPointURI == '\0')
-    {
-        return 0;
-    }
-
-    if (*pattern == *pEndPointURI)
-    {
-        return VmRESTMatchEndPointURI(pattern+1, pEndPointURI+1);
-    }
-
-    if (*pattern == '*')
-    {
-        return VmRESTMatchEndPointURI(pattern+1, pEndPointURI) || VmRESTMatchEndPointURI(pattern, pEndPointURI+1);
-    }
-    return 0;
-}
-
-uint32_t
-VmRESTGetPreSlashIndex(
-    char*                            patternURI,
-    uint32_t                         wildCardIndex,
-    uint32_t*                        preSlashIndex
-    )
-{
-    uint32_t                         dwError = REST_ENGINE_SUCCESS;
-    char*                            ptr = NULL;
-    uint32_t                         slashCnt = 0;
-    uint32_t                         wcCharCnt = 0;
-
-    if (patternURI == NULL || preSlashIndex == NULL)
-    {
-        dwError = VMREST_HTTP_INVALID_PARAMS;
-    }
-    BAIL_ON_VMREST_ERROR(dwError);
-
-    ptr = patternURI;
-    *preSlashIndex = 0;
-
-    while(*ptr != '\0')
-    {
-        if (*ptr == '*')
-        {
-            wcCharCnt++;
-        }
-        if (wcCharCnt == wildCardIndex)
-        {
-            break;
-        }
-        if (*ptr == '/')
-        {
-            slashCnt++;
-        }
-        ptr++;
-    }
-
-    *preSlashIndex = slashCnt;
-
-cleanup:
-    return dwError;
-error:
-    goto cleanup;
-}
-
-uint32_t
-VmRESTCopyWCStringByIndex(
-    char*                            requestEndPointURI,
-    char*                            des,
-    uint32_t                         wcIndex,
-    uint32_t                         totalWC,
-    uint32_t                         preSlashIndex
-    )
-{
-     uint32_t                         dwError = REST_ENGINE_SUCCESS;
-     char*                            ptr = NULL;
-     uint32_t                         slashCnt = 0;
-     uint32_t                         copyBytes = 0;
-     char*                            lastChar = NULL;
-
-    if (requestEndPointURI == NULL || des == NULL)
-    {
-        dwError = VMREST_HTTP_INVALID_PARAMS;
-    }
-    BAIL_ON_VMREST_ERROR(dwError);
-
-    ptr = requestEndPointURI;
-
-    while(*ptr != '\0')
-    {
-        if (*ptr == '/')
-        {
-            slashCnt++;
-        }
-        ptr++;
-        if(slashCnt == preSlashIndex)
-        {
-            break;
-        }
-    }
-
-    if (*ptr != '\0')
-    {
-        lastChar = strchr(ptr,'/');
-
-        if (lastChar != NULL)
-        {
-            copyBytes = lastChar - ptr;
-            strncpy(des, ptr, copyBytes);
-            *(des + copyBytes) = '\0';
-        }
-        else if (wcIndex == totalWC)
-        {
-            lastChar = strchr(ptr, '\0');
-            if (lastChar != NULL)
-            {
-                copyBytes = lastChar - ptr;
-                strncpy(des, ptr, copyBytes);
-                *(des + copyBytes) = '\0';
-            }
-            else
-            {
-                dwError = BAD_REQUEST;
-            }
-        }
-        else
-        {
-            dwError = BAD_REQUEST;
-        }
-    }
-    else
+    if (pRequest)
     {
-        /**** URL end with '/' - nothing to copy ****/
+        memset(pRequest->paramArray, 0, sizeof(pRequest->paramArray));
     }
-    BAIL_ON_VMREST_ERROR(dwError);
-
-cleanup:
-    return dwError;
-error:
     goto cleanup;
-
 }
 
 /**** Exposed API to manupulate over params present in URI ****/
@@ -897,11 +729,13 @@ VmRESTGetParamsByIndex(
 
     memset(pszKey, '\0', MAX_KEY_VAL_PARAM_LEN);
     memset(pszValue, '\0', MAX_KEY_VAL_PARAM_LEN);
-    
-    if ((pRequest != NULL) && (strlen(pRequest->paramArray[index].key) > 0))
+
+    /**** Spans are not terminated inside the URI, copy out and decode in place ****/
+    if ((pRequest != NULL) && (pRequest->paramArray[index].key.len > 0))
     {
+        memcpy(pszKey, VmRESTGetRequestSpan(pRequest, &pRequest->paramArray[index].key), pRequest->paramArray[index].key.len);
         VmRESTDecodeEncodedURLString(
-            pRequest->paramArray[index].key,
+            pszKey,
             pszKey);
     }
     else
@@ -909,10 +743,11 @@ VmRESTGetParamsByIndex(
         dwError = VMREST_HTTP_INVALID_PARAMS;
     }
 
-    if ((pRequest != NULL) && (strlen(pRequest->paramArray[index].value) > 0))
+    if ((pRequest != NULL) && (pRequest->paramArray[index].value.len > 0))
     {
+        memcpy(pszValue, VmRESTGetRequestSpan(pRequest, &pRequest->paramArray[index].value), pRequest->paramArray[index].value.len);
         VmRESTDecodeEncodedURLString(
-            pRequest->paramArray[index].value,
+            pszValue,
             pszValue);
     }
 
@@ -950,12 +785,7 @@ VmRESTGetWildCardCount(
     uint32_t*                        wildCardCount
     )
 {
-    char*                            httpURI = NULL;
-    char*                            endPointURI = NULL;
-    char*                            ptr = NULL;
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
-    uint32_t                         count = 0;
-    PREST_ENDPOINT                   pEndPoint = NULL;
 
     if (pRequest == NULL || wildCardCount == NULL)
     {
@@ -965,75 +795,15 @@ VmRESTGetWildCardCount(
     BAIL_ON_VMREST_ERROR(dwError);
     *wildCardCount = 0;
 
-    dwError = VmRESTAllocateMemory(
-                  MAX_URI_LEN,
-                  (void**)&endPointURI
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
-
-    dwError = VmRESTAllocateMemory(
-                  MAX_URI_LEN,
-                  (void**)&httpURI
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
-
-    dwError = VmRESTGetHttpURI(
-                  pRequest,
-                  TRUE,
-                  &ptr
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
-    strncpy(httpURI,ptr,(MAX_URI_LEN - 1));
-    if (ptr != NULL)
-    {
-        VmRESTFreeMemory(ptr);
-        ptr = NULL;
-    }
-    
-    dwError = VmRestGetEndPointURIfromRequestURI(
-                  httpURI,
-                  &ptr
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
-    strncpy(endPointURI, ptr, (MAX_URI_LEN - 1));
-    if (ptr != NULL)
-    {
-        VmRESTFreeMemory(ptr);
-        ptr = NULL;    
-    }
-
-    dwError = VmRestEngineGetEndPoint(
+    dwError = VmRESTRouteRequest(
                   pRESTHandle,
-                  endPointURI,
-                  &pEndPoint
+                  pRequest
                   );
     BAIL_ON_VMREST_ERROR(dwError);
 
-    ptr = pEndPoint->pszEndPointURI;
-
-    while(*ptr != '\0')
-    {
-        if(*ptr == '*')
-        {
-            count++;
-        }
-        ptr++;
-    }
-
-    *wildCardCount = count;
+    *wildCardCount = pRequest->nWildCards;
 
 cleanup:
-    if (endPointURI != NULL)
-    {
-        VmRESTFreeMemory(endPointURI);
-        endPointURI = NULL;
-    }
-    if (httpURI != NULL)
-    {
-        VmRESTFreeMemory(httpURI);
-        httpURI = NULL;
-    }
-
     return dwError;
 error:
     if (wildCardCount != NULL)
@@ -1054,32 +824,16 @@ VmRESTGetWildCardByIndex(
 {
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
     uint32_t                         count = 0;
-    uint32_t                         preSlashIndex = 0;
-    char*                            httpURI = NULL;
-    char*                            endPointURI = NULL;
-    char*                            ptr = NULL;
     char*                            pszWildCard = NULL;
-    PREST_ENDPOINT                   pEndPoint = NULL;
+    PVM_REST_HTTP_SPAN               pSpan = NULL;
 
-    if (pRequest == NULL)
+    if (pRequest == NULL || ppszWildCard == NULL)
     {
         VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid Params");
         dwError = VMREST_HTTP_INVALID_PARAMS;
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
-    dwError = VmRESTAllocateMemory(
-                  MAX_URI_LEN,
-                  (void**)&endPointURI
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
-
-    dwError = VmRESTAllocateMemory(
-                  MAX_URI_LEN,
-                  (void**)&httpURI
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
-
     dwError = VmRESTGetWildCardCount(
                   pRESTHandle,
                   pRequest,
@@ -1087,84 +841,27 @@ VmRESTGetWildCardByIndex(
                   );
     BAIL_ON_VMREST_ERROR(dwError);
 
-    if (index > count)
+    if (index == 0 || index > count)
     {
         VMREST_LOG_ERROR(pRESTHandle,"Invalid index count %u index %u", count, index);
         dwError = VMREST_HTTP_INVALID_PARAMS;
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
+    pSpan = &pRequest->wildCards[index - 1];
+
     dwError = VmRESTAllocateMemory(
-                  MAX_URI_LEN,
+                  (pSpan->len + 1),
                   (void **)&pszWildCard
                   );
     BAIL_ON_VMREST_ERROR(dwError);
 
-    memset(httpURI, '\0', MAX_URI_LEN);
-    memset(endPointURI, '\0', MAX_URI_LEN);
-
-    dwError = VmRESTGetHttpURI(
-                  pRequest,
-                  TRUE,
-                  &ptr
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
-    strncpy(httpURI,ptr,(MAX_URI_LEN - 1));
-    if (ptr != NULL)
-    {
-        VmRESTFreeMemory(ptr);
-        ptr = NULL;
-    }
-
-    dwError = VmRestGetEndPointURIfromRequestURI(
-                  httpURI,
-                  &ptr
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
-    strncpy(endPointURI,ptr,(MAX_URI_LEN - 1));
-    if (ptr != NULL)
-    {
-        VmRESTFreeMemory(ptr);
-        ptr = NULL;
-    }
-
-    dwError = VmRestEngineGetEndPoint(
-                  pRESTHandle,
-                  endPointURI,
-                  &pEndPoint
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
-
-    dwError = VmRESTGetPreSlashIndex(
-                  pEndPoint->pszEndPointURI,
-                  index,
-                  &preSlashIndex
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
-
-    dwError = VmRESTCopyWCStringByIndex(
-                  endPointURI,
-                  pszWildCard,
-                  index,
-                  count,
-                  preSlashIndex
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
+    /**** Captured while routing, copy it out of the request head ****/
+    memcpy(pszWildCard, (pRequest->pszHead + pSpan->offset), pSpan->len);
 
     *ppszWildCard = pszWildCard;
 
-
 cleanup:
-    if (endPointURI != NULL)
-    {
-        VmRESTFreeMemory(endPointURI);
-        endPointURI = NULL;
-    }
-    if (httpURI != NULL)
-    {
-        VmRESTFreeMemory(httpURI);
-        httpURI = NULL;
-    }
     return dwError;
 error:
     if (pszWildCard)
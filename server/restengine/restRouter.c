@@ -0,0 +1,1055 @@
+/* C-REST-Engine
+*
+* Copyright (c) 2017 VMware, Inc. All Rights Reserved.
+*
+* This product is licensed to you under the Apache 2.0 license (the "License").
+* You may not use this product except in compliance with the Apache 2.0 License.
+*
+* This product may include a number of subcomponents with separate copyright
+* notices and license terms. Your use of these subcomponents is subject to the
+* terms and conditions of the subcomponent's license, as noted in the LICENSE file.
+*
+*/
+
+/**** Endpoint router, a compressed radix tree keyed on the registered URI ****/
+
+/**** Route tables are published as immutable snapshots. Readers only mark the
+      epoch they entered at, writers swap the table pointer under the instance
+      mutex and free a replaced table once no reader from an older epoch is left ****/
+
+#include "includes.h"
+
+static pthread_once_t                    gRouteReaderOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t                     gRouteReaderKey;
+static PVM_REST_ROUTE_READER             gpRouteReaders = NULL;
+static uint64_t                          gRouteEpoch = 1;
+
+static
+uint32_t
+VmRESTBuildRouteTable(
+    PVM_REST_ROUTE_TABLE             pOldTable,
+    PREST_ENDPOINT                   pAddEndPoint,
+    char const*                      pszRemoveURI,
+    PVM_REST_ROUTE_TABLE*            ppNewTable,
+    PREST_ENDPOINT*                  ppRemovedEndPoint
+    );
+
+static
+void
+VmRESTPublishRouteTable(
+    PREST_ENG_GLOBALS                pGlobals,
+    PVM_REST_ROUTE_TABLE             pNewTable,
+    PREST_ENDPOINT                   pRemovedEndPoint
+    );
+
+static
+void
+VmRESTReclaimRouteTables(
+    PREST_ENG_GLOBALS                pGlobals
+    );
+
+static
+void
+VmRESTFreeRouteTable(
+    PVM_REST_ROUTE_TABLE             pTable,
+    BOOLEAN                          bFreeEndPoints
+    );
+
+static
+void
+VmRESTCreateRouteReaderKey(
+    void
+    );
+
+static
+void
+VmRESTReleaseRouteReader(
+    void*                            pData
+    );
+
+static
+uint32_t
+VmRESTGetRouteReader(
+    PVM_REST_ROUTE_READER*           ppReader
+    );
+
+static
+uint32_t
+VmRESTRouterValidatePattern(
+    char const*                      pszPattern
+    );
+
+static
+uint32_t
+VmRESTRouterAllocateNode(
+    VM_REST_ROUTE_NODE_TYPE          type,
+    char const*                      pszPrefix,
+    uint32_t                         nPrefix,
+    PVM_REST_ROUTE_NODE*             ppNode
+    );
+
+static
+void
+VmRESTRouterFreeNode(
+    PVM_REST_ROUTE_NODE              pNode
+    );
+
+static
+PVM_REST_ROUTE_NODE
+VmRESTRouterGetStaticChild(
+    PVM_REST_ROUTE_NODE              pNode,
+    char                             c
+    );
+
+static
+uint32_t
+VmRESTRouterAddStaticChild(
+    PVM_REST_ROUTE_NODE              pNode,
+    PVM_REST_ROUTE_NODE              pChild
+    );
+
+static
+uint32_t
+VmRESTRouterSplitNode(
+    PVM_REST_ROUTE_NODE              pNode,
+    uint32_t                         nCommon
+    );
+
+static
+PREST_ENDPOINT
+VmRESTRouterMatch(
+    PVM_REST_ROUTE_NODE              pNode,
+    char const*                      pszPath,
+    uint32_t                         nOffset,
+    uint32_t                         nPath,
+    PVM_REST_HTTP_SPAN               pWildCards,
+    uint32_t                         nWildCards,
+    uint32_t*                        pnWildCards
+    );
+
+uint32_t
+VmRESTRouterAdd(
+    PVM_REST_ROUTE_NODE*             ppRoot,
+    PREST_ENDPOINT                   pEndPoint
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    PVM_REST_ROUTE_NODE              pNode = NULL;
+    PVM_REST_ROUTE_NODE              pChild = NULL;
+    char const*                      pszPattern = NULL;
+    uint32_t                         nStatic = 0;
+    uint32_t                         nCommon = 0;
+
+    if (!ppRoot || !pEndPoint || !pEndPoint->pszEndPointURI)
+    {
+        dwError = VMREST_HTTP_INVALID_PARAMS;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    pszPattern = pEndPoint->pszEndPointURI;
+
+    dwError = VmRESTRouterValidatePattern(
+                  pszPattern
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    if (!*ppRoot)
+    {
+        dwError = VmRESTRouterAllocateNode(
+                      VM_REST_ROUTE_STATIC,
+                      "",
+                      0,
+                      ppRoot
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    pNode = *ppRoot;
+
+    while (*pszPattern != '\0')
+    {
+        if (*pszPattern == '*')
+        {
+            if (*(pszPattern + 1) == '\0')
+            {
+                if (!pNode->pCatchAll)
+                {
+                    dwError = VmRESTRouterAllocateNode(
+                                  VM_REST_ROUTE_CATCHALL,
+                                  "",
+                                  0,
+                                  &pNode->pCatchAll
+                                  );
+                    BAIL_ON_VMREST_ERROR(dwError);
+                }
+                pNode = pNode->pCatchAll;
+            }
+            else
+            {
+                if (!pNode->pWildCard)
+                {
+                    dwError = VmRESTRouterAllocateNode(
+                                  VM_REST_ROUTE_WILDCARD,
+                                  "",
+                                  0,
+                                  &pNode->pWildCard
+                                  );
+                    BAIL_ON_VMREST_ERROR(dwError);
+                }
+                pNode = pNode->pWildCard;
+            }
+            pszPattern++;
+            continue;
+        }
+
+        /**** Static text runs up to the next '*' ****/
+        nStatic = strcspn(pszPattern, "*");
+
+        pChild = VmRESTRouterGetStaticChild(
+                     pNode,
+                     *pszPattern
+                     );
+        if (!pChild)
+        {
+            dwError = VmRESTRouterAllocateNode(
+                          VM_REST_ROUTE_STATIC,
+                          pszPattern,
+                          nStatic,
+                          &pChild
+                          );
+            BAIL_ON_VMREST_ERROR(dwError);
+
+            dwError = VmRESTRouterAddStaticChild(
+                          pNode,
+                          pChild
+                          );
+            if (dwError)
+            {
+                VmRESTRouterFreeNode(pChild);
+                pChild = NULL;
+            }
+            BAIL_ON_VMREST_ERROR(dwError);
+
+            pNode = pChild;
+            pszPattern += nStatic;
+            continue;
+        }
+
+        nCommon = 0;
+        while ((nCommon < nStatic) && (nCommon < pChild->nPrefix) && (pChild->pszPrefix[nCommon] == pszPattern[nCommon]))
+        {
+            nCommon++;
+        }
+
+        if (nCommon < pChild->nPrefix)
+        {
+            dwError = VmRESTRouterSplitNode(
+                          pChild,
+                          nCommon
+                          );
+            BAIL_ON_VMREST_ERROR(dwError);
+        }
+
+        pNode = pChild;
+        pszPattern += nCommon;
+    }
+
+    if (pNode->pEndPoint)
+    {
+        dwError = REST_ERROR_ENDPOINT_EXISTS;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    pNode->pEndPoint = pEndPoint;
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+uint32_t
+VmRESTRouterFind(
+    PVM_REST_ROUTE_NODE              pRoot,
+    char const*                      pszPath,
+    uint32_t                         nPath,
+    PVM_REST_HTTP_SPAN               pWildCards,
+    uint32_t*                        pnWildCards,
+    PREST_ENDPOINT*                  ppEndPoint
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    PREST_ENDPOINT                   pEndPoint = NULL;
+
+    if (!pszPath || !pWildCards || !pnWildCards || !ppEndPoint)
+    {
+        dwError = VMREST_HTTP_INVALID_PARAMS;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    *pnWildCards = 0;
+
+    if (pRoot)
+    {
+        pEndPoint = VmRESTRouterMatch(
+                        pRoot,
+                        pszPath,
+                        0,
+                        nPath,
+                        pWildCards,
+                        0,
+                        pnWildCards
+                        );
+    }
+
+    if (!pEndPoint)
+    {
+        dwError = NOT_FOUND;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    *ppEndPoint = pEndPoint;
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    if (ppEndPoint)
+    {
+        *ppEndPoint = NULL;
+    }
+    goto cleanup;
+}
+
+void
+VmRESTRouterFree(
+    PVM_REST_ROUTE_NODE              pRoot
+    )
+{
+    uint32_t                         i = 0;
+
+    if (pRoot)
+    {
+        for (i = 0; i < pRoot->nChildren; i++)
+        {
+            VmRESTRouterFree(pRoot->ppChildren[i]);
+        }
+        VmRESTRouterFree(pRoot->pWildCard);
+        VmRESTRouterFree(pRoot->pCatchAll);
+
+        /**** Endpoints belong to the route table ****/
+        VmRESTRouterFreeNode(pRoot);
+    }
+}
+
+/**** '*' stands for a whole segment, or for the rest of the URI when it is the last character ****/
+static
+uint32_t
+VmRESTRouterValidatePattern(
+    char const*                      pszPattern
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    char const*                      temp = pszPattern;
+    uint32_t                         nWildCards = 0;
+
+    while (*temp != '\0')
+    {
+        if (*temp == '*')
+        {
+            nWildCards++;
+
+            if ((*(temp + 1) != '\0') &&
+                ((*(temp + 1) != '/') || ((temp != pszPattern) && (*(temp - 1) != '/'))))
+            {
+                dwError = REST_ERROR_ENDPOINT_BAD_URI;
+            }
+        }
+        temp++;
+    }
+
+    if (nWildCards > MAX_URI_WILD_CARDS)
+    {
+        dwError = REST_ERROR_ENDPOINT_BAD_URI;
+    }
+
+    return dwError;
+}
+
+static
+uint32_t
+VmRESTRouterAllocateNode(
+    VM_REST_ROUTE_NODE_TYPE          type,
+    char const*                      pszPrefix,
+    uint32_t                         nPrefix,
+    PVM_REST_ROUTE_NODE*             ppNode
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    PVM_REST_ROUTE_NODE              pNode = NULL;
+
+    dwError = VmRESTAllocateMemory(
+                  sizeof(VM_REST_ROUTE_NODE),
+                  (void**)&pNode
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTAllocateMemory(
+                  (nPrefix + 1),
+                  (void**)&pNode->pszPrefix
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    memcpy(pNode->pszPrefix, pszPrefix, nPrefix);
+    pNode->nPrefix = nPrefix;
+    pNode->type = type;
+
+    *ppNode = pNode;
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    VmRESTRouterFreeNode(pNode);
+    goto cleanup;
+}
+
+static
+void
+VmRESTRouterFreeNode(
+    PVM_REST_ROUTE_NODE              pNode
+    )
+{
+    if (pNode)
+    {
+        if (pNode->pszPrefix)
+        {
+            VmRESTFreeMemory(pNode->pszPrefix);
+        }
+        if (pNode->ppChildren)
+        {
+            VmRESTFreeMemory(pNode->ppChildren);
+        }
+        VmRESTFreeMemory(pNode);
+    }
+}
+
+static
+PVM_REST_ROUTE_NODE
+VmRESTRouterGetStaticChild(
+    PVM_REST_ROUTE_NODE              pNode,
+    char                             c
+    )
+{
+    uint32_t                         i = 0;
+
+    /**** Static children never share a first character ****/
+    for (i = 0; i < pNode->nChildren; i++)
+    {
+        if (pNode->ppChildren[i]->pszPrefix[0] == c)
+        {
+            return pNode->ppChildren[i];
+        }
+    }
+
+    return NULL;
+}
+
+static
+uint32_t
+VmRESTRouterAddStaticChild(
+    PVM_REST_ROUTE_NODE              pNode,
+    PVM_REST_ROUTE_NODE              pChild
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    PVM_REST_ROUTE_NODE*             ppNewChildren = NULL;
+
+    dwError = VmRESTReallocateMemory(
+                  pNode->ppChildren,
+                  (void**)&ppNewChildren,
+                  ((pNode->nChildren + 1) * sizeof(PVM_REST_ROUTE_NODE))
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    ppNewChildren[pNode->nChildren] = pChild;
+    pNode->ppChildren = ppNewChildren;
+    pNode->nChildren++;
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+/**** Keeps the first nCommon characters in pNode and moves the rest, with everything below, to a new child ****/
+static
+uint32_t
+VmRESTRouterSplitNode(
+    PVM_REST_ROUTE_NODE              pNode,
+    uint32_t                         nCommon
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    PVM_REST_ROUTE_NODE              pTail = NULL;
+    PVM_REST_ROUTE_NODE*             ppChildren = NULL;
+
+    dwError = VmRESTRouterAllocateNode(
+                  VM_REST_ROUTE_STATIC,
+                  (pNode->pszPrefix + nCommon),
+                  (pNode->nPrefix - nCommon),
+                  &pTail
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTAllocateMemory(
+                  sizeof(PVM_REST_ROUTE_NODE),
+                  (void**)&ppChildren
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    pTail->ppChildren = pNode->ppChildren;
+    pTail->nChildren = pNode->nChildren;
+    pTail->pWildCard = pNode->pWildCard;
+    pTail->pCatchAll = pNode->pCatchAll;
+    pTail->pEndPoint = pNode->pEndPoint;
+
+    ppChildren[0] = pTail;
+    pNode->ppChildren = ppChildren;
+    pNode->nChildren = 1;
+    pNode->pWildCard = NULL;
+    pNode->pCatchAll = NULL;
+    pNode->pEndPoint = NULL;
+    pNode->nPrefix = nCommon;
+    pNode->pszPrefix[nCommon] = '\0';
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    VmRESTRouterFreeNode(pTail);
+    goto cleanup;
+}
+
+/**** Static children are tried first, then the segment wildcard, then catch-all ****/
+static
+PREST_ENDPOINT
+VmRESTRouterMatch(
+    PVM_REST_ROUTE_NODE              pNode,
+    char const*                      pszPath,
+    uint32_t                         nOffset,
+    uint32_t                         nPath,
+    PVM_REST_HTTP_SPAN               pWildCards,
+    uint32_t                         nWildCards,
+    uint32_t*                        pnWildCards
+    )
+{
+    PVM_REST_ROUTE_NODE              pChild = NULL;
+    PREST_ENDPOINT                   pEndPoint = NULL;
+    uint32_t                         nEnd = 0;
+
+    if ((nOffset == nPath) && pNode->pEndPoint)
+    {
+        *pnWildCards = nWildCards;
+        return pNode->pEndPoint;
+    }
+
+    if (nOffset < nPath)
+    {
+        pChild = VmRESTRouterGetStaticChild(
+                     pNode,
+                     pszPath[nOffset]
+                     );
+        if (pChild && (pChild->nPrefix <= (nPath - nOffset)) &&
+            (memcmp(pChild->pszPrefix, (pszPath + nOffset), pChild->nPrefix) == 0))
+        {
+            pEndPoint = VmRESTRouterMatch(
+                            pChild,
+                            pszPath,
+                            (nOffset + pChild->nPrefix),
+                            nPath,
+                            pWildCards,
+                            nWildCards,
+                            pnWildCards
+                            );
+            if (pEndPoint)
+            {
+                return pEndPoint;
+            }
+        }
+    }
+
+    if (nWildCards >= MAX_URI_WILD_CARDS)
+    {
+        return NULL;
+    }
+
+    if (pNode->pWildCard)
+    {
+        nEnd = nOffset;
+        while ((nEnd < nPath) && (pszPath[nEnd] != '/'))
+        {
+            nEnd++;
+        }
+
+        pWildCards[nWildCards].offset = nOffset;
+        pWildCards[nWildCards].len = nEnd - nOffset;
+
+        pEndPoint = VmRESTRouterMatch(
+                        pNode->pWildCard,
+                        pszPath,
+                        nEnd,
+                        nPath,
+                        pWildCards,
+                        (nWildCards + 1),
+                        pnWildCards
+                        );
+        if (pEndPoint)
+        {
+            return pEndPoint;
+        }
+    }
+
+    if (pNode->pCatchAll && pNode->pCatchAll->pEndPoint)
+    {
+        pWildCards[nWildCards].offset = nOffset;
+        pWildCards[nWildCards].len = nPath - nOffset;
+        *pnWildCards = nWildCards + 1;
+        return pNode->pCatchAll->pEndPoint;
+    }
+
+    return NULL;
+}
+
+uint32_t
+VmRESTRouteTableAdd(
+    PREST_ENG_GLOBALS                pGlobals,
+    PREST_ENDPOINT                   pEndPoint
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    PVM_REST_ROUTE_TABLE             pNewTable = NULL;
+
+    if (!pGlobals || !pEndPoint)
+    {
+        dwError = VMREST_HTTP_INVALID_PARAMS;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTBuildRouteTable(
+                  pGlobals->pRouteTable,
+                  pEndPoint,
+                  NULL,
+                  &pNewTable,
+                  NULL
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    VmRESTPublishRouteTable(
+        pGlobals,
+        pNewTable,
+        NULL
+        );
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+uint32_t
+VmRESTRouteTableRemove(
+    PREST_ENG_GLOBALS                pGlobals,
+    char const*                      pszEndPointURI
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    PVM_REST_ROUTE_TABLE             pNewTable = NULL;
+    PREST_ENDPOINT                   pRemovedEndPoint = NULL;
+
+    if (!pGlobals || !pszEndPointURI)
+    {
+        dwError = VMREST_HTTP_INVALID_PARAMS;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTBuildRouteTable(
+                  pGlobals->pRouteTable,
+                  NULL,
+                  pszEndPointURI,
+                  &pNewTable,
+                  &pRemovedEndPoint
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    VmRESTPublishRouteTable(
+        pGlobals,
+        pNewTable,
+        pRemovedEndPoint
+        );
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+void
+VmRESTRouteTableFree(
+    PREST_ENG_GLOBALS                pGlobals
+    )
+{
+    PVM_REST_ROUTE_TABLE             pTable = NULL;
+
+    if (!pGlobals)
+    {
+        return;
+    }
+
+    /**** Engine is stopped, nothing can be reading any more ****/
+    while (pGlobals->pRetiredRouteTables)
+    {
+        pTable = pGlobals->pRetiredRouteTables;
+        pGlobals->pRetiredRouteTables = pTable->pNextRetired;
+        VmRESTFreeRouteTable(pTable, FALSE);
+    }
+
+    VmRESTFreeRouteTable(pGlobals->pRouteTable, TRUE);
+    pGlobals->pRouteTable = NULL;
+}
+
+uint32_t
+VmRESTEnterRouteTable(
+    PREST_ENG_GLOBALS                pGlobals,
+    PVM_REST_ROUTE_TABLE*            ppTable
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    PVM_REST_ROUTE_READER            pReader = NULL;
+
+    if (!pGlobals || !ppTable)
+    {
+        dwError = VMREST_HTTP_INVALID_PARAMS;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTGetRouteReader(
+                  &pReader
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    /**** Slot must be visible before the table is loaded, both are sequentially consistent ****/
+    __atomic_store_n(&pReader->epoch, __atomic_load_n(&gRouteEpoch, __ATOMIC_SEQ_CST), __ATOMIC_SEQ_CST);
+    *ppTable = __atomic_load_n(&pGlobals->pRouteTable, __ATOMIC_SEQ_CST);
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    if (ppTable)
+    {
+        *ppTable = NULL;
+    }
+    goto cleanup;
+}
+
+void
+VmRESTLeaveRouteTable(
+    void
+    )
+{
+    PVM_REST_ROUTE_READER            pReader = NULL;
+
+    pReader = (PVM_REST_ROUTE_READER)pthread_getspecific(gRouteReaderKey);
+    if (pReader)
+    {
+        __atomic_store_n(&pReader->epoch, 0, __ATOMIC_RELEASE);
+    }
+}
+
+/**** Copies the old endpoint set with one added or one removed, and indexes it in a fresh tree ****/
+static
+uint32_t
+VmRESTBuildRouteTable(
+    PVM_REST_ROUTE_TABLE             pOldTable,
+    PREST_ENDPOINT                   pAddEndPoint,
+    char const*                      pszRemoveURI,
+    PVM_REST_ROUTE_TABLE*            ppNewTable,
+    PREST_ENDPOINT*                  ppRemovedEndPoint
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    uint32_t                         nOld = 0;
+    uint32_t                         i = 0;
+    PVM_REST_ROUTE_TABLE             pTable = NULL;
+    PREST_ENDPOINT                   pEndPoint = NULL;
+    PREST_ENDPOINT                   pRemovedEndPoint = NULL;
+
+    nOld = pOldTable ? pOldTable->nEndPoints : 0;
+
+    dwError = VmRESTAllocateMemory(
+                  sizeof(VM_REST_ROUTE_TABLE),
+                  (void**)&pTable
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTAllocateMemory(
+                  ((nOld + 1) * sizeof(PREST_ENDPOINT)),
+                  (void**)&pTable->ppEndPoints
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    for (i = 0; i < nOld; i++)
+    {
+        pEndPoint = pOldTable->ppEndPoints[i];
+
+        if (pszRemoveURI && !pRemovedEndPoint && (strcmp(pEndPoint->pszEndPointURI, pszRemoveURI) == 0))
+        {
+            pRemovedEndPoint = pEndPoint;
+            continue;
+        }
+
+        dwError = VmRESTRouterAdd(
+                      &pTable->pRoot,
+                      pEndPoint
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        pTable->ppEndPoints[pTable->nEndPoints] = pEndPoint;
+        pTable->nEndPoints++;
+    }
+
+    if (pszRemoveURI && !pRemovedEndPoint)
+    {
+        dwError = NOT_FOUND;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    if (pAddEndPoint)
+    {
+        dwError = VmRESTRouterAdd(
+                      &pTable->pRoot,
+                      pAddEndPoint
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        pTable->ppEndPoints[pTable->nEndPoints] = pAddEndPoint;
+        pTable->nEndPoints++;
+    }
+
+    *ppNewTable = pTable;
+    if (ppRemovedEndPoint)
+    {
+        *ppRemovedEndPoint = pRemovedEndPoint;
+    }
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    VmRESTFreeRouteTable(pTable, FALSE);
+    goto cleanup;
+}
+
+static
+void
+VmRESTPublishRouteTable(
+    PREST_ENG_GLOBALS                pGlobals,
+    PVM_REST_ROUTE_TABLE             pNewTable,
+    PREST_ENDPOINT                   pRemovedEndPoint
+    )
+{
+    PVM_REST_ROUTE_TABLE             pOldTable = pGlobals->pRouteTable;
+
+    __atomic_store_n(&pGlobals->pRouteTable, pNewTable, __ATOMIC_SEQ_CST);
+
+    if (pOldTable)
+    {
+        /**** Readers entering from now on can only see the new table ****/
+        pOldTable->retireEpoch = __atomic_add_fetch(&gRouteEpoch, 1, __ATOMIC_SEQ_CST);
+        pOldTable->pRemovedEndPoint = pRemovedEndPoint;
+        pOldTable->pNextRetired = pGlobals->pRetiredRouteTables;
+        pGlobals->pRetiredRouteTables = pOldTable;
+    }
+
+    /**** Writers never wait, whatever is still in use stays for the next update ****/
+    VmRESTReclaimRouteTables(pGlobals);
+}
+
+static
+void
+VmRESTReclaimRouteTables(
+    PREST_ENG_GLOBALS                pGlobals
+    )
+{
+    uint64_t                         minEpoch = UINT64_MAX;
+    uint64_t                         epoch = 0;
+    PVM_REST_ROUTE_READER            pReader = NULL;
+    PVM_REST_ROUTE_TABLE             pTable = NULL;
+    PVM_REST_ROUTE_TABLE*            ppLink = NULL;
+
+    pReader = __atomic_load_n(&gpRouteReaders, __ATOMIC_ACQUIRE);
+    while (pReader)
+    {
+        epoch = __atomic_load_n(&pReader->epoch, __ATOMIC_SEQ_CST);
+        if ((epoch != 0) && (epoch < minEpoch))
+        {
+            minEpoch = epoch;
+        }
+        pReader = pReader->pNext;
+    }
+
+    ppLink = &pGlobals->pRetiredRouteTables;
+    while (*ppLink)
+    {
+        pTable = *ppLink;
+        if (pTable->retireEpoch <= minEpoch)
+        {
+            *ppLink = pTable->pNextRetired;
+            VmRESTFreeRouteTable(pTable, FALSE);
+        }
+        else
+        {
+            ppLink = &pTable->pNextRetired;
+        }
+    }
+}
+
+static
+void
+VmRESTFreeRouteTable(
+    PVM_REST_ROUTE_TABLE             pTable,
+    BOOLEAN                          bFreeEndPoints
+    )
+{
+    uint32_t                         i = 0;
+
+    if (pTable)
+    {
+        VmRESTRouterFree(pTable->pRoot);
+
+        if (bFreeEndPoints)
+        {
+            for (i = 0; i < pTable->nEndPoints; i++)
+            {
+                VmRESTFreeEndPoint(pTable->ppEndPoints[i]);
+            }
+        }
+        if (pTable->pRemovedEndPoint)
+        {
+            VmRESTFreeEndPoint(pTable->pRemovedEndPoint);
+        }
+        if (pTable->ppEndPoints)
+        {
+            VmRESTFreeMemory(pTable->ppEndPoints);
+        }
+        VmRESTFreeMemory(pTable);
+    }
+}
+
+static
+void
+VmRESTCreateRouteReaderKey(
+    void
+    )
+{
+    pthread_key_create(&gRouteReaderKey, VmRESTReleaseRouteReader);
+}
+
+static
+void
+VmRESTReleaseRouteReader(
+    void*                            pData
+    )
+{
+    PVM_REST_ROUTE_READER            pReader = (PVM_REST_ROUTE_READER)pData;
+
+    /**** Slots are never freed, an exiting thread hands its slot to the next new one ****/
+    __atomic_store_n(&pReader->epoch, 0, __ATOMIC_RELEASE);
+    __atomic_store_n(&pReader->bInUse, 0, __ATOMIC_RELEASE);
+}
+
+static
+uint32_t
+VmRESTGetRouteReader(
+    PVM_REST_ROUTE_READER*           ppReader
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    uint32_t                         bFree = 0;
+    PVM_REST_ROUTE_READER            pReader = NULL;
+
+    pthread_once(&gRouteReaderOnce, VmRESTCreateRouteReaderKey);
+
+    pReader = (PVM_REST_ROUTE_READER)pthread_getspecific(gRouteReaderKey);
+    if (pReader)
+    {
+        *ppReader = pReader;
+        goto cleanup;
+    }
+
+    pReader = __atomic_load_n(&gpRouteReaders, __ATOMIC_ACQUIRE);
+    while (pReader)
+    {
+        bFree = 0;
+        if (__atomic_compare_exchange_n(&pReader->bInUse, &bFree, 1, FALSE, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+        {
+            break;
+        }
+        pReader = pReader->pNext;
+    }
+
+    if (!pReader)
+    {
+        dwError = VmRESTAllocateMemory(
+                      sizeof(VM_REST_ROUTE_READER),
+                      (void**)&pReader
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        pReader->bInUse = 1;
+        pReader->pNext = __atomic_load_n(&gpRouteReaders, __ATOMIC_RELAXED);
+        while (!__atomic_compare_exchange_n(&gpRouteReaders, &pReader->pNext, pReader, FALSE, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        {
+        }
+    }
+
+    dwError = pthread_setspecific(gRouteReaderKey, pReader);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    *ppReader = pReader;
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    if (pReader)
+    {
+        __atomic_store_n(&pReader->bInUse, 0, __ATOMIC_RELEASE);
+    }
+    goto cleanup;
+}
@@ -11,27 +11,133 @@
 *
 */
 
+/**** Radix tree node, static nodes hold compressed text, '*' nodes match a segment or the rest ****/
+typedef struct _VM_REST_ROUTE_NODE
+{
+    VM_REST_ROUTE_NODE_TYPE          type;
+    char*                            pszPrefix;
+    uint32_t                         nPrefix;
+    struct _VM_REST_ROUTE_NODE**     ppChildren;
+    uint32_t                         nChildren;
+    struct _VM_REST_ROUTE_NODE*      pWildCard;
+    struct _VM_REST_ROUTE_NODE*      pCatchAll;
+    PREST_ENDPOINT                   pEndPoint;
+
+}VM_REST_ROUTE_NODE, *PVM_REST_ROUTE_NODE;
+
+/**** Published route snapshot, never changed once readers can see it ****/
+typedef struct _VM_REST_ROUTE_TABLE
+{
+    PVM_REST_ROUTE_NODE              pRoot;
+    PREST_ENDPOINT*                  ppEndPoints;
+    uint32_t                         nEndPoints;
+    PREST_ENDPOINT                   pRemovedEndPoint;
+    uint64_t                         retireEpoch;
+    struct _VM_REST_ROUTE_TABLE*     pNextRetired;
+
+}VM_REST_ROUTE_TABLE, *PVM_REST_ROUTE_TABLE;
+
+/**** Per thread reader slot, epoch is 0 outside of a read section ****/
+typedef struct _VM_REST_ROUTE_READER
+{
+    uint64_t                         epoch;
+    uint32_t                         bInUse;
+    struct _VM_REST_ROUTE_READER*    pNext;
+
+}VM_REST_ROUTE_READER, *PVM_REST_ROUTE_READER;
+
+/**** Deflate stream kept for reuse, with the buffer chunked output is framed from ****/
+typedef struct _VM_REST_DEFLATE
+{
+    z_stream                         stream;
+    int                              windowBits;
+    char*                            pOut;
+    uint32_t                         nOut;
+    uint32_t                         nOutSize;
+    struct _VM_REST_DEFLATE*         pNext;
+
+}VM_REST_DEFLATE, *PVM_REST_DEFLATE;
+
+/**** Cached 200 response, everything after the status line except Connection, as it went out ****/
+typedef struct _VM_REST_CACHE_ENTRY
+{
+    uint64_t                         hash;
+    char*                            pszKey;
+    char*                            pszURI;
+    char*                            pszVaryNames;
+    char*                            pszVaryValues;
+    char*                            pszETag;
+    char*                            pszLastModified;
+    time_t                           lastModified;
+    time_t                           expiry;
+    char*                            pData;
+    size_t                           nData;
+    size_t                           nCost;
+    uint32_t                         nRef;
+    BOOLEAN                          bRemoved;
+    struct _VM_REST_CACHE_ENTRY*     pNextHash;
+    struct _VM_REST_CACHE_ENTRY*     pPrevLRU;
+    struct _VM_REST_CACHE_ENTRY*     pNextLRU;
+
+}VM_REST_CACHE_ENTRY, *PVM_REST_CACHE_ENTRY;
+
+/**** One lock, hash table and LRU list per shard, head of the list is the most recent ****/
+typedef struct _VM_REST_CACHE_SHARD
+{
+    PVMREST_MUTEX                    pMutex;
+    PVM_REST_CACHE_ENTRY             pBuckets[HTTP_CACHE_BUCKETS];
+    PVM_REST_CACHE_ENTRY             pLRUHead;
+    PVM_REST_CACHE_ENTRY             pLRUTail;
+    size_t                           nBytes;
+
+}VM_REST_CACHE_SHARD, *PVM_REST_CACHE_SHARD;
+
 typedef struct _REST_ENG_GLOBALS
 {
     PVMREST_THREAD                   pThreadpool;
     uint32_t                         nThreads;
     pthread_mutex_t                  mutex;
-    PREST_ENDPOINT                   pEndPointQueue;
+    PVM_REST_ROUTE_TABLE             pRouteTable;
+    PVM_REST_ROUTE_TABLE             pRetiredRouteTables;
     uint32_t                         useEndPoint;
     REST_PROCESSOR                   internalHandler;
+    PVMREST_MUTEX                    pDeflateMutex;
+    PVM_REST_DEFLATE                 pDeflatePool;
+    uint32_t                         nDeflatePool;
+    PVMREST_MUTEX                    pChunkBufMutex;
+    char*                            pChunkBufPool;
+    uint32_t                         nChunkBufPool;
+    PVM_REST_CACHE_SHARD             pCacheShards;
+    size_t                           nCacheShardBytes;
+    uint64_t                         cacheETagSeq;
+    time_t                           cacheStartTime;
+    uint32_t                         nPendingResponses;
+    uint32_t                         nCompleting;
 
 } REST_ENG_GLOBALS;
 
-typedef struct _VM_REST_HTTP_MESSAGE_BODY
+/**** Offset and length of a field in the request head buffer ****/
+typedef struct _VM_REST_HTTP_SPAN
+{
+    uint32_t                         offset;
+    uint32_t                         len;
+
+}VM_REST_HTTP_SPAN, *PVM_REST_HTTP_SPAN;
+
+/**** Offsets of the structural characters of one CRLF terminated line ****/
+typedef struct _VM_REST_LINE_SCAN
 {
-    char                             buffer[MAX_DATA_BUFFER_LEN];
+    uint32_t                         nLineLen;
+    uint32_t                         nFirstSpace;
+    uint32_t                         nSecondSpace;
+    uint32_t                         nColon;
 
-}VM_REST_HTTP_MESSAGE_BODY, *PVM_REST_HTTP_MESSAGE_BODY;
+}VM_REST_LINE_SCAN, *PVM_REST_LINE_SCAN;
 
 typedef struct _VM_REST_URL_PARAMS
 {
-    char                             key[MAX_KEY_VAL_PARAM_LEN];
-    char                             value[MAX_KEY_VAL_PARAM_LEN];
+    VM_REST_HTTP_SPAN                key;
+    VM_REST_HTTP_SPAN                value;
 
 }VM_REST_URL_PARAMS, *PVM_REST_URL_PARAMS;
 
@@ -39,9 +145,9 @@ typedef struct _VM_REST_URL_PARAMS
 
 typedef struct _VM_REST_HTTP_REQUEST_LINE
 {
-    char                             method[MAX_METHOD_LEN];
-    char                             uri[MAX_URI_LEN];
-    char                             version[MAX_VERSION_LEN];
+    VM_REST_HTTP_SPAN                method;
+    VM_REST_HTTP_SPAN                uri;
+    VM_REST_HTTP_SPAN                version;
 
 }VM_REST_HTTP_REQUEST_LINE, *PVM_REST_HTTP_REQUEST_LINE;
 
@@ -55,22 +161,36 @@ typedef struct _VM_REST_HTTP_STATUS_LINE
 
 typedef struct _VM_REST_HTTP_HEADER_NODE
 {
-    char                             header[MAX_HTTP_HEADER_ATTR_LEN];
-    char                             value[MAX_HTTP_HEADER_VAL_LEN];
+    char*                            header;
+    char*                            value;
     struct _VM_REST_HTTP_HEADER_NODE *next;
 
 }VM_REST_HTTP_HEADER_NODE, *PVM_REST_HTTP_HEADER_NODE;
 
+typedef struct _VM_REST_HTTP_HEADER_SPAN
+{
+    VM_REST_HTTP_SPAN                header;
+    VM_REST_HTTP_SPAN                value;
+
+}VM_REST_HTTP_HEADER_SPAN, *PVM_REST_HTTP_HEADER_SPAN;
+
 typedef struct _MISC_HEADER_QUEUE {
 
     PVM_REST_HTTP_HEADER_NODE        head;
 
 }MISC_HEADER_QUEUE, *PMISC_HEADER_QUEUE;
 
+/**** Packet, head buffer and response live in pArena and are released with it ****/
 typedef struct _VM_REST_HTTP_REQUEST_PACKET
 {
-    PVM_REST_HTTP_REQUEST_LINE       requestLine;
-    PMISC_HEADER_QUEUE               miscHeader;
+    PVM_REST_ARENA                   pArena;
+    VM_REST_HTTP_REQUEST_LINE        requestLine;
+    PVM_REST_HTTP_HEADER_SPAN        pHeaders;
+    uint32_t                         nHeaders;
+    uint32_t                         nHeaderSlots;
+    char*                            pszHead;
+    uint32_t                         nHead;
+    uint32_t                         nHeadSize;
     PVM_SOCKET                       pSocket;
     uint32_t                         dataRemaining;
     VM_REST_URL_PARAMS               paramArray[MAX_URL_PARAMS_ARR_SIZE];
@@ -83,17 +203,35 @@ typedef struct _VM_REST_HTTP_REQUEST_PACKET
     int                              clientPort;
     char                             clientIP[MAX_CLIENT_IP_ADDR_LEN];
     uint32_t                         nBytesGetPayload;
+    BOOLEAN                          bRouted;
+    REST_PROCESSOR                   endPointHandler;
+    VM_REST_HTTP_SPAN                endPointURI;
+    VM_REST_HTTP_SPAN                wildCards[MAX_URI_WILD_CARDS];
+    uint32_t                         nWildCards;
 
 }VM_REST_HTTP_REQUEST_PACKET, *PVM_REST_HTTP_REQUEST_PACKET;
 
 typedef struct _VM_REST_HTTP_RESPONSE_PACKET
 {
+    PVM_REST_ARENA                   pArena;
     PVM_REST_HTTP_STATUS_LINE        statusLine;
-    PVM_REST_HTTP_MESSAGE_BODY       messageBody;
     PMISC_HEADER_QUEUE               miscHeader;
     PVM_SOCKET                       pSocket;
     PVM_REST_HTTP_REQUEST_PACKET     requestPacket;
     BOOLEAN                          bHeaderSent;
+    uint64_t                         nPayloadSent;
+    char*                            pChunkBuf;
+    uint32_t                         nChunkBuf;
+    BOOLEAN                          bDeflateChecked;
+    PVM_REST_DEFLATE                 pDeflate;
+    char*                            pDeflated;
+    size_t                           nDeflated;
+    size_t                           nDeflatedSize;
+    BOOLEAN                          bPayloadDone;
+    uint32_t                         cacheMaxAge;
+    char*                            pCache;
+    size_t                           nCache;
+    size_t                           nCacheSize;
 
 }VM_REST_HTTP_RESPONSE_PACKET, *PVM_REST_HTTP_RESPONSE_PACKET;
 
@@ -99,6 +99,24 @@ int main()
     pConfig->nWorkerThr = 5;
     pConfig->nClientCnt = 5;
     pConfig->useSysLog = FALSE;
+    pConfig->usePerWorkerReactor = TRUE;
+    pConfig->useIoUring = TRUE;
+    pConfig->useAsyncLog = TRUE;
+    pConfig->asyncLogBlockOnFull = FALSE;
+    pConfig->asyncLogFlushMSec = 0;
+    pConfig->nHandlerThr = 0;
+    pConfig->nHandlerQueueSize = 0;
+    pConfig->nResponseChunkSize = 0;
+    pConfig->useCompression = FALSE;
+    pConfig->compressionLevel = 0;
+    pConfig->compressionMinSize = 0;
+    pConfig->nResponseCacheSize = 0;
+    pConfig->nSSLSessionCacheSize = 0;
+    pConfig->SSLSessionTimeoutSec = 0;
+    pConfig->SSLTicketKeyRotateSec = 0;
+    pConfig->useSSLMemoryBIO = FALSE;
+    pConfig->useKTLS = FALSE;
+    pConfig->maxOutputPerConnMB = 0;
     pConfig->pszSSLCertificate = "/root/mycert.pem";
     pConfig->isSecure = FALSE;
     pConfig->pszSSLKey = "/root/mycert.pem";
@@ -117,6 +135,24 @@ int main()
     pConfig1->nWorkerThr = 5;
     pConfig1->nClientCnt = 5;
     pConfig1->useSysLog = TRUE;
+    pConfig1->usePerWorkerReactor = FALSE;
+    pConfig1->useIoUring = FALSE;
+    pConfig1->useAsyncLog = FALSE;
+    pConfig1->asyncLogBlockOnFull = FALSE;
+    pConfig1->asyncLogFlushMSec = 0;
+    pConfig1->nHandlerThr = 0;
+    pConfig1->nHandlerQueueSize = 0;
+    pConfig1->nResponseChunkSize = 0;
+    pConfig1->useCompression = FALSE;
+    pConfig1->compressionLevel = 0;
+    pConfig1->compressionMinSize = 0;
+    pConfig1->nResponseCacheSize = 0;
+    pConfig1->nSSLSessionCacheSize = 0;
+    pConfig1->SSLSessionTimeoutSec = 0;
+    pConfig1->SSLTicketKeyRotateSec = 0;
+    pConfig1->useSSLMemoryBIO = FALSE;
+    pConfig1->useKTLS = FALSE;
+    pConfig1->maxOutputPerConnMB = 0;
     pConfig1->pszSSLCertificate = "/root/mycert.pem";
     pConfig1->isSecure = TRUE;
     pConfig1->pszSSLKey = "/root/mycert.pem";
@@ -18,6 +18,8 @@ pthread_mutex_t                      gTESTGlobalMutex = PTHREAD_MUTEX_INITIALIZE
 int                                  gTESTSSLisedInstaceCount = -1;
 
 
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+
 static
 void
 VmTESTSSLThreadLockCallback(
@@ -33,6 +35,8 @@ VmTESTSSLThreadId(
     void
     );
 
+#endif
+
 static
 uint32_t
 VmTESTSSLThreadLockInit(
@@ -54,6 +58,8 @@ VmTESTSecureSocket(
     );
 
 
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+
 static
 void
 VmTESTSSLThreadLockCallback(
@@ -137,6 +143,29 @@ VmTESTSSLThreadLockShutdown(
     OPENSSL_free(gTESTSSLThreadLock);
 }
 
+#else
+
+/**** OpenSSL 1.1 and later lock their own state ****/
+
+static
+uint32_t
+VmTESTSSLThreadLockInit(
+    void
+    )
+{
+    return REST_ENGINE_SUCCESS;
+}
+
+static
+void
+VmTESTSSLThreadLockShutdown(
+    void
+    )
+{
+}
+
+#endif
+
 static
 uint32_t
 VmTESTSecureSocket(
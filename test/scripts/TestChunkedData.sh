@@ -0,0 +1,64 @@
+# !/bin/bash
+TOPDIR=`pwd`
+OUTDIR=$TOPDIR/data/out
+SRCDIR=$TOPDIR/../..
+IPADDR="127.0.0.1"
+PORT="83"
+
+# Compile the feature server against the built library and start it, chunk size is 1024
+gcc -o $TOPDIR/FeatureServer $TOPDIR/featureServer.c -I$SRCDIR/include -I$SRCDIR/include/public -L$SRCDIR/server/restengine/.libs -Wl,-rpath,$SRCDIR/server/restengine/.libs -lrestengine -lssl -lcrypto -lpthread
+$TOPDIR/FeatureServer $PORT &
+SERVERPID=$!
+sleep 1
+
+# Runs one chunked response, checks the chunk sizes on the wire, the final zero length chunk and the data
+# $1 test number, $2 total bytes, $3 bytes per VmRESTSetData call, $4 expected chunk sizes in hex, $5 name
+runChunkTest()
+{
+    rm -f $OUTDIR/resData.txt
+    rm -f $OUTDIR/resRaw.txt
+
+    curl -s --raw -o $OUTDIR/resRaw.txt "http://$IPADDR:$PORT/v1/chunk?total=$2&piece=$3"
+    curl -s -o $OUTDIR/resData.txt "http://$IPADDR:$PORT/v1/chunk?total=$2&piece=$3"
+
+    # Chunk data is letters only, so sizes are every other line, ending with "0" and an empty line
+    sizes=$(tr -d '\r' < $OUTDIR/resRaw.txt | awk 'NR % 2 == 1' | tr '\n' ' ')
+    data=$(<$OUTDIR/resData.txt)
+    inputData=$(yes abcdefghijklmnopqrstuvwxyz | tr -d '\n' | head -c $2)
+
+    if [ "$sizes" == "$4 " ] && [ "$data" == "$inputData" ]
+    then
+       echo "PASSED-TEST $1: $5"
+    else
+       echo "FAILED-TEST $1: $5 (chunks: $sizes)"
+    fi
+}
+
+#=========================== TEST 1 : Small writes fill the chunk buffer exactly ===============
+runChunkTest 1 4096 256 "400 400 400 400 0" "Small writes coalesced at the chunk size"
+
+#=========================== TEST 2 : Small writes that do not divide the chunk size ==========
+runChunkTest 2 1500 100 "3e8 1f4 0" "Small writes flushed before crossing the chunk size"
+
+#=========================== TEST 3 : One byte under the chunk size ===========================
+runChunkTest 3 3000 1023 "3ff 3ff 3ba 0" "Writes one byte under the chunk size"
+
+#=========================== TEST 4 : Writes of exactly the chunk size ========================
+runChunkTest 4 5000 1024 "400 400 400 400 388 0" "Writes of the chunk size go out on their own"
+
+#=========================== TEST 5 : Large writes ============================================
+runChunkTest 5 200000 65536 "10000 10000 10000 d40 0" "Large writes"
+
+#=========================== TEST 6 : Small writes after a large one ==========================
+runChunkTest 6 70000 65536 "10000 1170 0" "Small tail after a large write"
+
+#=========================== TEST 7 : Empty body ==============================================
+runChunkTest 7 0 10 "0" "Only the final zero length chunk"
+
+#=========================== TEST 8 : Single byte writes ======================================
+runChunkTest 8 2049 1 "400 400 1 0" "Single byte writes"
+
+kill $SERVERPID
+wait $SERVERPID 2> /dev/null
+rm -f $TOPDIR/FeatureServer
+rm -f $OUTDIR/resRaw.txt
@@ -0,0 +1,63 @@
+# !/bin/bash
+TOPDIR=`pwd`
+OUTDIR=$TOPDIR/data/out
+SRCDIR=$TOPDIR/../..
+IPADDR="127.0.0.1"
+PORT="83"
+
+# Must be longer than connTimeoutSec of the feature server, 5 seconds
+STALLMS=6500
+
+gcc -o $TOPDIR/FeatureServer $TOPDIR/featureServer.c -I$SRCDIR/include -I$SRCDIR/include/public -L$SRCDIR/server/restengine/.libs -Wl,-rpath,$SRCDIR/server/restengine/.libs -lrestengine -lssl -lcrypto -lpthread
+$TOPDIR/FeatureServer $PORT &
+SERVERPID=$!
+sleep 1
+
+# Stall the given path, then GET it again on the same keep-alive connection. Writes how many
+# new connections each of the two transfers made, "1 0" when the second one reused the first.
+stallThenReuse()
+{
+    curl -s -H "Connection: keep-alive" -w "%{num_connects} " \
+         -o /dev/null "http://$IPADDR:$PORT/v1/stall?ms=$STALLMS" \
+         -o /dev/null "http://$IPADDR:$PORT/v1/stall?ms=0" > $OUTDIR/connects$1.txt
+}
+
+#=========================== TEST 1 : Timer armed while the wheel lags keeps its full timeout ====
+# An idle connection keeps the timer wheel armed while both workers stall longer than the
+# timeout, so the wheel falls behind. The keep-alive timers armed after the stall must count
+# from now, not from the slot the wheel stopped at, or they expire as soon as it catches up.
+exec 3<>/dev/tcp/$IPADDR/$PORT
+sleep 1
+
+stallThenReuse 1 &
+CLIENT1=$!
+stallThenReuse 2 &
+CLIENT2=$!
+wait $CLIENT1 $CLIENT2
+exec 3<&-
+
+connects1=$(<$OUTDIR/connects1.txt)
+connects2=$(<$OUTDIR/connects2.txt)
+
+if [ "$connects1" == "1 0 " ] && [ "$connects2" == "1 0 " ]
+then
+   echo "PASSED-TEST 1: Connection kept after the timer wheel lagged"
+else
+   echo "FAILED-TEST 1: Connection kept after the timer wheel lagged ($connects1, $connects2)"
+fi
+
+#=========================== TEST 2 : Idle connection still times out =========================
+exec 3<>/dev/tcp/$IPADDR/$PORT
+sleep 7
+if ! timeout 2 cat <&3 > /dev/null
+then
+   echo "FAILED-TEST 2: Idle connection times out"
+else
+   echo "PASSED-TEST 2: Idle connection times out"
+fi
+exec 3<&-
+
+rm -f $OUTDIR/connects1.txt $OUTDIR/connects2.txt
+kill $SERVERPID
+wait $SERVERPID 2> /dev/null
+rm -f $TOPDIR/FeatureServer
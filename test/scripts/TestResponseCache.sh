@@ -0,0 +1,161 @@
+# !/bin/bash
+TOPDIR=`pwd`
+INDIR=$TOPDIR/data/input
+OUTDIR=$TOPDIR/data/out
+SRCDIR=$TOPDIR/../..
+IPADDR="127.0.0.1"
+PORT="83"
+
+# Compile the feature server against the built library and start it, its response cache is on
+gcc -o $TOPDIR/FeatureServer $TOPDIR/featureServer.c -I$SRCDIR/include -I$SRCDIR/include/public -L$SRCDIR/server/restengine/.libs -Wl,-rpath,$SRCDIR/server/restengine/.libs -lrestengine -lssl -lcrypto -lpthread
+$TOPDIR/FeatureServer $PORT &
+SERVERPID=$!
+sleep 1
+
+# Value of the named header in the last response
+header()
+{
+    grep -i "^$1:" $OUTDIR/resHeader.txt | cut -d ':' -f 2- | sed 's/^ *//' | tr -d '\r'
+}
+
+# GET the given path with extra curl arguments, sets status to the response status, count to
+# how often the handler had run when the response was made, and data to the body
+request()
+{
+    rm -f $OUTDIR/resHeader.txt
+    rm -f $OUTDIR/resData.txt
+
+    curl -s -D $OUTDIR/resHeader.txt -o $OUTDIR/resData.txt "${@:2}" "http://$IPADDR:$PORT$1"
+
+    status=$(head -n 1 $OUTDIR/resHeader.txt | cut -d ' ' -f 2)
+    count=$(header X-Count)
+    data=$(cat $OUTDIR/resData.txt 2> /dev/null)
+}
+
+#=========================== TEST 1 : Second identical GET is served from the cache ===========
+request "/v1/cache/item"
+firstCount=$count
+firstData=$data
+request "/v1/cache/item"
+
+if [ -n "$firstCount" ] && [ "$count" == "$firstCount" ] && [ "$data" == "$firstData" ]
+then
+   echo "PASSED-TEST 1: Identical GET served from cache"
+else
+   echo "FAILED-TEST 1: Identical GET served from cache ($firstCount, $count)"
+fi
+
+#=========================== TEST 2 : Another Accept-Encoding misses ==========================
+request "/v1/cache/item" -H "Accept-Encoding: gzip"
+gzipCount=$count
+
+if [ -n "$gzipCount" ] && [ "$gzipCount" != "$firstCount" ]
+then
+   echo "PASSED-TEST 2: Different Accept-Encoding misses"
+else
+   echo "FAILED-TEST 2: Different Accept-Encoding misses ($firstCount, $gzipCount)"
+fi
+
+#=========================== TEST 3 : Each Accept-Encoding value keeps its own copy ===========
+request "/v1/cache/item" -H "Accept-Encoding: gzip"
+secondGzipCount=$count
+request "/v1/cache/item"
+
+if [ "$secondGzipCount" == "$gzipCount" ] && [ "$count" == "$firstCount" ]
+then
+   echo "PASSED-TEST 3: Both Accept-Encoding values cached"
+else
+   echo "FAILED-TEST 3: Both Accept-Encoding values cached ($secondGzipCount, $count)"
+fi
+
+#=========================== TEST 4 : Other URI misses ========================================
+request "/v1/cache/other"
+
+if [ -n "$count" ] && [ "$count" != "$firstCount" ] && [ "$count" != "$gzipCount" ]
+then
+   echo "PASSED-TEST 4: Other URI misses"
+else
+   echo "FAILED-TEST 4: Other URI misses ($count)"
+fi
+
+#=========================== TEST 5 : Response sent from a file is never kept =================
+inputData=$(<$INDIR/smalldata.txt)
+request "/v1/cachefile?path=$INDIR/smalldata.txt"
+fileCount=$count
+fileData=$data
+request "/v1/cachefile?path=$INDIR/smalldata.txt"
+
+if [ -n "$fileCount" ] && [ "$count" != "$fileCount" ] && [ "$fileData" == "$inputData" ] && [ "$data" == "$inputData" ]
+then
+   echo "PASSED-TEST 5: File response not cached"
+else
+   echo "FAILED-TEST 5: File response not cached ($fileCount, $count)"
+fi
+
+#=========================== TEST 6 : If-None-Match with the ETag answers 304 ================
+request "/v1/cache/item"
+etag=$(header ETag)
+request "/v1/cache/item" -H "If-None-Match: $etag"
+
+if [ -n "$etag" ] && [ "$status" == "304" ] && [ "$(header ETag)" == "$etag" ] && [ "$(header Vary)" == "Accept-Encoding" ] && [ -z "$data" ]
+then
+   echo "PASSED-TEST 6: If-None-Match answered 304 with ETag and Vary, no body"
+else
+   echo "FAILED-TEST 6: If-None-Match answered 304 with ETag and Vary, no body ($status, $etag)"
+fi
+
+#=========================== TEST 7 : If-Modified-Since the Last-Modified answers 304 =========
+request "/v1/cache/item"
+lastModified=$(header Last-Modified)
+request "/v1/cache/item" -H "If-Modified-Since: $lastModified"
+
+if [ -n "$lastModified" ] && [ "$status" == "304" ] && [ -z "$data" ]
+then
+   echo "PASSED-TEST 7: If-Modified-Since answered 304"
+else
+   echo "FAILED-TEST 7: If-Modified-Since answered 304 ($status, $lastModified)"
+fi
+
+#=========================== TEST 8 : Entry expires after its max age =========================
+request "/v1/cache/short?ttl=1"
+shortCount=$count
+request "/v1/cache/short?ttl=1"
+cachedCount=$count
+sleep 2
+request "/v1/cache/short?ttl=1"
+
+if [ -n "$shortCount" ] && [ "$cachedCount" == "$shortCount" ] && [ "$count" != "$shortCount" ]
+then
+   echo "PASSED-TEST 8: Entry expired after its max age"
+else
+   echo "FAILED-TEST 8: Entry expired after its max age ($shortCount, $cachedCount, $count)"
+fi
+
+#=========================== TEST 9 : Invalidating a prefix drops only the entries under it ===
+request "/v1/cache/keep/a"
+keepCount=$count
+request "/v1/cache/drop/a"
+dropCountA=$count
+request "/v1/cache/drop/b"
+dropCountB=$count
+
+request "/v1/cacheinvalidate?prefix=/v1/cache/drop/"
+invalidateStatus=$status
+
+request "/v1/cache/keep/a"
+keepAfter=$count
+request "/v1/cache/drop/a"
+dropAfterA=$count
+request "/v1/cache/drop/b"
+dropAfterB=$count
+
+if [ "$invalidateStatus" == "200" ] && [ -n "$keepCount" ] && [ "$keepAfter" == "$keepCount" ] && [ "$dropAfterA" != "$dropCountA" ] && [ "$dropAfterB" != "$dropCountB" ]
+then
+   echo "PASSED-TEST 9: Invalidated prefix dropped, other entries kept"
+else
+   echo "FAILED-TEST 9: Invalidated prefix dropped, other entries kept ($keepCount/$keepAfter, $dropCountA/$dropAfterA, $dropCountB/$dropAfterB)"
+fi
+
+kill $SERVERPID
+wait $SERVERPID 2> /dev/null
+rm -f $TOPDIR/FeatureServer
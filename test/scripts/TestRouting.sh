@@ -0,0 +1,90 @@
+# !/bin/bash
+TOPDIR=`pwd`
+OUTDIR=$TOPDIR/data/out
+EXPECTEDDIR=$TOPDIR/data/expected
+SRCDIR=$TOPDIR/../..
+IPADDR="127.0.0.1"
+PORT="83"
+
+# Compile the feature server against the built library and start it,
+# it registers /v1/route/*, /v1/route/special and /v1/mid/*/end
+gcc -o $TOPDIR/FeatureServer $TOPDIR/featureServer.c -I$SRCDIR/include -I$SRCDIR/include/public -L$SRCDIR/server/restengine/.libs -Wl,-rpath,$SRCDIR/server/restengine/.libs -lrestengine -lssl -lcrypto -lpthread
+$TOPDIR/FeatureServer $PORT &
+SERVERPID=$!
+sleep 1
+
+rm -f $OUTDIR/routeResults.txt
+
+# Status code and body of a request, the body lists the wild card strings matched
+request()
+{
+    rm -f $OUTDIR/resData.txt
+    curl -s -o $OUTDIR/resData.txt -w "%{http_code}" "http://$IPADDR:$PORT$1" > $OUTDIR/resCode.txt
+    echo "$1 $(<$OUTDIR/resCode.txt) $(<$OUTDIR/resData.txt)" | sed "s/ *$//" >> $OUTDIR/routeResults.txt
+}
+
+# Error code VmRESTRegisterHandler or VmRESTUnRegisterHandler returned in the server
+register()
+{
+    rm -f $OUTDIR/resData.txt
+    curl -s -o $OUTDIR/resData.txt "http://$IPADDR:$PORT/v1/admin/$1?uri=$2"
+    echo "$1 $2 $(<$OUTDIR/resData.txt)" >> $OUTDIR/routeResults.txt
+}
+
+STARS16="/*/*/*/*/*/*/*/*/*/*/*/*/*/*/*/*"
+SEGS16="/1/2/3/4/5/6/7/8/9/10/11/12/13/14/15/16"
+
+#=========================== TEST 1-3 : A '*' at the end matches the rest, slashes included =====
+request "/v1/route/a"
+request "/v1/route/a/b/c"
+request "/v1/route/specialx"
+
+#=========================== TEST 4-5 : A '*' in the middle is one whole segment ================
+request "/v1/mid/a/end"
+request "/v1/mid/a/b/end"
+
+#=========================== TEST 6-9 : Bad use of '*', or more than 16 of them =================
+register register "/v1/bad/a*b"
+register register "/v1/bad/*x/end"
+register register "/v1/many$STARS16/*"
+register register "/v1/many$STARS16"
+
+#=========================== TEST 10 : Sixteen wild cards =======================================
+request "/v1/many$SEGS16"
+
+#=========================== TEST 11-12 : Exact text wins, duplicates fail ======================
+request "/v1/route/special"
+register register "/v1/route/special"
+
+#=========================== TEST 13-16 : Register after start takes effect at once ============
+request "/v1/late/x"
+register register "/v1/late/*"
+request "/v1/late/x/y"
+request "/v1/late/x"
+
+#=========================== TEST 17-20 : Unregister after start takes effect at once ==========
+register unregister "/v1/late/*"
+request "/v1/late/x/y"
+register unregister "/v1/route/special"
+request "/v1/route/special"
+
+kill $SERVERPID
+wait $SERVERPID 2> /dev/null
+rm -f $TOPDIR/FeatureServer
+rm -f $OUTDIR/resCode.txt
+
+i=0
+while IFS= read -r expected
+do
+    i=$((i + 1))
+    actual=$(sed -n "${i}p" $OUTDIR/routeResults.txt)
+
+    if [ "$actual" == "$expected" ]
+    then
+       echo "PASSED-TEST $i: $expected"
+    else
+       echo "FAILED-TEST $i: expected \"$expected\" got \"$actual\""
+    fi
+done < $EXPECTEDDIR/RouteResults.txt
+
+rm -f $OUTDIR/routeResults.txt
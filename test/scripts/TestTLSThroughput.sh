@@ -0,0 +1,39 @@
+# !/bin/bash
+TOPDIR=`pwd`
+OUTDIR=$TOPDIR/data/out
+SRCDIR=$TOPDIR/../..
+IPADDR="127.0.0.1"
+PORT="83"
+DURATION=${DURATION:-5}
+MAXCORES=${MAXCORES:-$(nproc)}
+
+# TLS request rate as server worker threads and client threads grow together. Compare runs of a
+# build against OpenSSL 1.0, which goes through the global lock table, with one against 1.1 or later.
+gcc -o $TOPDIR/FeatureServer $TOPDIR/featureServer.c -I$SRCDIR/include -I$SRCDIR/include/public -L$SRCDIR/server/restengine/.libs -Wl,-rpath,$SRCDIR/server/restengine/.libs -lrestengine -lssl -lcrypto -lpthread
+gcc -o $TOPDIR/TLSBench $TOPDIR/tlsBench.c -lssl -lcrypto -lpthread
+
+openssl req -x509 -newkey rsa:2048 -nodes -days 1 -subj "/CN=localhost" -keyout $OUTDIR/benchKey.pem -out $OUTDIR/benchCert.pem 2> /dev/null
+cat $OUTDIR/benchKey.pem $OUTDIR/benchCert.pem > $OUTDIR/bench.pem
+
+echo "$(openssl version), $DURATION seconds per run"
+
+cores=1
+while [ $cores -le $MAXCORES ]
+do
+    $TOPDIR/FeatureServer $PORT $OUTDIR/bench.pem $cores &
+    SERVERPID=$!
+    sleep 1
+
+    # Two client threads per worker keep every worker busy
+    echo "workers $cores keep-alive: $($TOPDIR/TLSBench $IPADDR $PORT /v1/route/bench $((cores * 2)) $DURATION)"
+    echo "workers $cores handshake:  $($TOPDIR/TLSBench $IPADDR $PORT /v1/route/bench $((cores * 2)) $DURATION handshake)"
+
+    kill $SERVERPID
+    wait $SERVERPID 2> /dev/null
+
+    cores=$((cores * 2))
+done
+
+rm -f $TOPDIR/FeatureServer
+rm -f $TOPDIR/TLSBench
+rm -f $OUTDIR/benchKey.pem $OUTDIR/benchCert.pem $OUTDIR/bench.pem
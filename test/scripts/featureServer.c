@@ -0,0 +1,671 @@
+/* C-REST-Engine
+*
+* Copyright (c) 2017 VMware, Inc. All Rights Reserved.
+*
+* This product is licensed to you under the Apache 2.0 license (the "License").
+* You may not use this product except in compliance with the Apache 2.0 License.
+*
+* This product may include a number of subcomponents with separate copyright
+* notices and license terms. Your use of these subcomponents is subject to the
+* terms and conditions of the subcomponent's license, as noted in the LICENSE file.
+*
+*/
+
+/**** Server for TestChunkedData.sh, TestRouting.sh, TestResponseCache.sh, TestConnTimeout.sh and TestTLSThroughput.sh ****/
+
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <vmrestsys.h>
+#include <vmrestdefines.h>
+#include <vmrest.h>
+
+/**** Must match nResponseChunkSize the scripts expect ****/
+#define FEATURE_CHUNK_SIZE                1024
+#define FEATURE_MAX_PAYLOAD               (1024 * 1024)
+#define FEATURE_CACHE_SIZE                (1024 * 1024)
+#define FEATURE_CACHE_MAX_AGE             60
+
+static volatile sig_atomic_t             gStop = 0;
+static uint32_t                          gCacheCalls = 0;
+
+static
+uint32_t
+VmHandleRouteData(
+    PVMREST_HANDLE                   pRESTHandle,
+    PREST_REQUEST                    pRequest,
+    PREST_RESPONSE*                  ppResponse,
+    uint32_t                         paramsCount
+    );
+
+static REST_PROCESSOR                    gRouteHandlers =
+{
+    .pfnHandleRequest = NULL,
+    .pfnHandleCreate = &VmHandleRouteData,
+    .pfnHandleRead = &VmHandleRouteData,
+    .pfnHandleUpdate = &VmHandleRouteData,
+    .pfnHandleDelete = &VmHandleRouteData,
+    .pfnHandleOthers = &VmHandleRouteData
+};
+
+static
+void
+sig_handler(
+    int                              signo
+    )
+{
+    if ((signo == SIGTERM) || (signo == SIGINT))
+    {
+        gStop = 1;
+    }
+}
+
+static
+uint32_t
+VmTESTGetParam(
+    PREST_REQUEST                    pRequest,
+    uint32_t                         paramsCount,
+    char const*                      pszName,
+    char**                           ppszValue
+    )
+{
+    uint32_t                         dwError = 0;
+    uint32_t                         index = 0;
+    char*                            pszKey = NULL;
+    char*                            pszValue = NULL;
+
+    *ppszValue = NULL;
+
+    for (index = 1; index <= paramsCount; index++)
+    {
+        dwError = VmRESTGetParamsByIndex(
+                      pRequest,
+                      paramsCount,
+                      index,
+                      &pszKey,
+                      &pszValue
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        if (pszKey && pszValue && (strcmp(pszKey, pszName) == 0) && (*ppszValue == NULL))
+        {
+            *ppszValue = pszValue;
+            pszValue = NULL;
+        }
+
+        free(pszKey);
+        free(pszValue);
+        pszKey = NULL;
+        pszValue = NULL;
+    }
+
+cleanup:
+    free(pszKey);
+    free(pszValue);
+
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+static
+uint32_t
+VmTESTGetParamNumber(
+    PREST_REQUEST                    pRequest,
+    uint32_t                         paramsCount,
+    char const*                      pszName,
+    uint32_t*                        pValue
+    )
+{
+    uint32_t                         dwError = 0;
+    char*                            pszValue = NULL;
+
+    dwError = VmTESTGetParam(pRequest, paramsCount, pszName, &pszValue);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    *pValue = pszValue ? (uint32_t)strtoul(pszValue, NULL, 10) : 0;
+
+error:
+    free(pszValue);
+
+    return dwError;
+}
+
+/**** 200 response with the given text as Content-Length body ****/
+static
+uint32_t
+VmTESTSendText(
+    PVMREST_HANDLE                   pRESTHandle,
+    PREST_REQUEST                    pRequest,
+    PREST_RESPONSE*                  ppResponse,
+    char const*                      pszText
+    )
+{
+    uint32_t                         dwError = 0;
+    char                             size[16] = {0};
+    uint32_t                         bytesRW = 0;
+
+    dwError = VmRESTSetSuccessResponse(
+                  pRequest,
+                  ppResponse
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    snprintf(size, sizeof(size), "%u", (uint32_t)strlen(pszText));
+
+    dwError = VmRESTSetDataLength(
+                  ppResponse,
+                  size
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTSetData(
+                  pRESTHandle,
+                  ppResponse,
+                  pszText,
+                  (uint32_t)strlen(pszText),
+                  &bytesRW
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+error:
+
+    return dwError;
+}
+
+/**** GET /v1/chunk?total=N&piece=M, N bytes of "abc..z" written as a chunked response M bytes per call ****/
+static
+uint32_t
+VmHandleChunkData(
+    PVMREST_HANDLE                   pRESTHandle,
+    PREST_REQUEST                    pRequest,
+    PREST_RESPONSE*                  ppResponse,
+    uint32_t                         paramsCount
+    )
+{
+    uint32_t                         dwError = 0;
+    static char                      pattern[FEATURE_MAX_PAYLOAD];
+    uint32_t                         total = 0;
+    uint32_t                         piece = 0;
+    uint32_t                         index = 0;
+    uint32_t                         nWrite = 0;
+    uint32_t                         bytesRW = 0;
+
+    dwError = VmTESTGetParamNumber(pRequest, paramsCount, "total", &total);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmTESTGetParamNumber(pRequest, paramsCount, "piece", &piece);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    if ((total > FEATURE_MAX_PAYLOAD) || (piece == 0))
+    {
+        dwError = 400;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    if (pattern[0] == '\0')
+    {
+        for (index = 0; index < FEATURE_MAX_PAYLOAD; index++)
+        {
+            pattern[index] = 'a' + (index % 26);
+        }
+        index = 0;
+    }
+
+    dwError = VmRESTSetSuccessResponse(
+                  pRequest,
+                  ppResponse
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTSetDataLength(
+                  ppResponse,
+                  NULL
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    /**** The call with nothing left ends the response with the zero length chunk ****/
+    dwError = REST_ENGINE_MORE_IO_REQUIRED;
+    while (dwError == REST_ENGINE_MORE_IO_REQUIRED)
+    {
+        nWrite = ((total - index) > piece) ? piece : (total - index);
+
+        dwError = VmRESTSetData(
+                      pRESTHandle,
+                      ppResponse,
+                      pattern + index,
+                      nWrite,
+                      &bytesRW
+                      );
+        index += bytesRW;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+error:
+
+    return dwError;
+}
+
+/**** Any request to a route test endpoint, answers with the wild card strings it matched ****/
+static
+uint32_t
+VmHandleRouteData(
+    PVMREST_HANDLE                   pRESTHandle,
+    PREST_REQUEST                    pRequest,
+    PREST_RESPONSE*                  ppResponse,
+    uint32_t                         paramsCount
+    )
+{
+    uint32_t                         dwError = 0;
+    char                             text[1024] = {0};
+    int                              textLen = 0;
+    uint32_t                         wildCardCount = 0;
+    uint32_t                         index = 0;
+    char*                            pszWildCard = NULL;
+
+    dwError = VmRESTGetWildCardCount(
+                  pRESTHandle,
+                  pRequest,
+                  &wildCardCount
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    textLen = snprintf(text, sizeof(text), "wc=%u", wildCardCount);
+
+    for (index = 1; index <= wildCardCount; index++)
+    {
+        dwError = VmRESTGetWildCardByIndex(
+                      pRESTHandle,
+                      pRequest,
+                      index,
+                      &pszWildCard
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        if (textLen < (int)sizeof(text))
+        {
+            textLen += snprintf(text + textLen, sizeof(text) - textLen, " [%s]", pszWildCard);
+        }
+
+        free(pszWildCard);
+        pszWildCard = NULL;
+    }
+
+    dwError = VmTESTSendText(pRESTHandle, pRequest, ppResponse, text);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+cleanup:
+    free(pszWildCard);
+
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+/**** GET /v1/admin/register?uri=U and /v1/admin/unregister?uri=U, answers with the error code of the call ****/
+static
+uint32_t
+VmTESTChangeRoute(
+    PVMREST_HANDLE                   pRESTHandle,
+    PREST_REQUEST                    pRequest,
+    PREST_RESPONSE*                  ppResponse,
+    uint32_t                         paramsCount,
+    bool                             bRegister
+    )
+{
+    uint32_t                         dwError = 0;
+    uint32_t                         dwResult = 0;
+    char*                            pszURI = NULL;
+    char                             text[16] = {0};
+
+    dwError = VmTESTGetParam(pRequest, paramsCount, "uri", &pszURI);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    if (pszURI == NULL)
+    {
+        dwError = 400;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    if (bRegister)
+    {
+        dwResult = VmRESTRegisterHandler(pRESTHandle, pszURI, &gRouteHandlers, NULL);
+    }
+    else
+    {
+        dwResult = VmRESTUnRegisterHandler(pRESTHandle, pszURI);
+    }
+
+    snprintf(text, sizeof(text), "%u", dwResult);
+
+    dwError = VmTESTSendText(pRESTHandle, pRequest, ppResponse, text);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+cleanup:
+    free(pszURI);
+
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+static
+uint32_t
+VmHandleRegisterData(
+    PVMREST_HANDLE                   pRESTHandle,
+    PREST_REQUEST                    pRequest,
+    PREST_RESPONSE*                  ppResponse,
+    uint32_t                         paramsCount
+    )
+{
+    return VmTESTChangeRoute(pRESTHandle, pRequest, ppResponse, paramsCount, true);
+}
+
+static
+uint32_t
+VmHandleUnRegisterData(
+    PVMREST_HANDLE                   pRESTHandle,
+    PREST_REQUEST                    pRequest,
+    PREST_RESPONSE*                  ppResponse,
+    uint32_t                         paramsCount
+    )
+{
+    return VmTESTChangeRoute(pRESTHandle, pRequest, ppResponse, paramsCount, false);
+}
+
+/**** GET /v1/cache/...[?ttl=S], a cacheable response that tells in X-Count how often the handler ran ****/
+static
+uint32_t
+VmHandleCacheData(
+    PVMREST_HANDLE                   pRESTHandle,
+    PREST_REQUEST                    pRequest,
+    PREST_RESPONSE*                  ppResponse,
+    uint32_t                         paramsCount
+    )
+{
+    uint32_t                         dwError = 0;
+    uint32_t                         ttl = 0;
+    char                             count[16] = {0};
+    char                             text[64] = {0};
+
+    snprintf(count, sizeof(count), "%u", __sync_add_and_fetch(&gCacheCalls, 1));
+    snprintf(text, sizeof(text), "count=%s", count);
+
+    dwError = VmTESTGetParamNumber(pRequest, paramsCount, "ttl", &ttl);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTSetCacheable(
+                  pRESTHandle,
+                  ppResponse,
+                  ttl ? ttl : FEATURE_CACHE_MAX_AGE
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTSetHttpHeader(ppResponse, "X-Count", count);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    /**** One cached copy per Accept-Encoding value ****/
+    dwError = VmRESTSetHttpHeader(ppResponse, "Vary", "Accept-Encoding");
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmTESTSendText(pRESTHandle, pRequest, ppResponse, text);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+error:
+
+    return dwError;
+}
+
+/**** GET /v1/cacheinvalidate?prefix=P, drops the cached responses under P ****/
+static
+uint32_t
+VmHandleCacheInvalidateData(
+    PVMREST_HANDLE                   pRESTHandle,
+    PREST_REQUEST                    pRequest,
+    PREST_RESPONSE*                  ppResponse,
+    uint32_t                         paramsCount
+    )
+{
+    uint32_t                         dwError = 0;
+    char*                            pszPrefix = NULL;
+
+    dwError = VmTESTGetParam(pRequest, paramsCount, "prefix", &pszPrefix);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTInvalidateCache(pRESTHandle, pszPrefix);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmTESTSendText(pRESTHandle, pRequest, ppResponse, "invalidated");
+    BAIL_ON_VMREST_ERROR(dwError);
+
+cleanup:
+    free(pszPrefix);
+
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+/**** GET /v1/cachefile?path=P, the file sent from its descriptor, marked cacheable all the same ****/
+static
+uint32_t
+VmHandleCacheFileData(
+    PVMREST_HANDLE                   pRESTHandle,
+    PREST_REQUEST                    pRequest,
+    PREST_RESPONSE*                  ppResponse,
+    uint32_t                         paramsCount
+    )
+{
+    uint32_t                         dwError = 0;
+    char*                            pszPath = NULL;
+    char                             count[16] = {0};
+    int                              fd = -1;
+    struct stat                      fileStat = {0};
+
+    snprintf(count, sizeof(count), "%u", __sync_add_and_fetch(&gCacheCalls, 1));
+
+    dwError = VmTESTGetParam(pRequest, paramsCount, "path", &pszPath);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    fd = pszPath ? open(pszPath, O_RDONLY) : -1;
+    if ((fd < 0) || (fstat(fd, &fileStat) != 0))
+    {
+        dwError = 404;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTSetSuccessResponse(
+                  pRequest,
+                  ppResponse
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTSetCacheable(
+                  pRESTHandle,
+                  ppResponse,
+                  FEATURE_CACHE_MAX_AGE
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTSetHttpHeader(ppResponse, "X-Count", count);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTSetDataFromFd(
+                  pRESTHandle,
+                  ppResponse,
+                  fd,
+                  0,
+                  (uint64_t)fileStat.st_size
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+cleanup:
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+    free(pszPath);
+
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+/**** GET /v1/stall?ms=N, holds its worker thread for N milliseconds before answering ****/
+static
+uint32_t
+VmHandleStallData(
+    PVMREST_HANDLE                   pRESTHandle,
+    PREST_REQUEST                    pRequest,
+    PREST_RESPONSE*                  ppResponse,
+    uint32_t                         paramsCount
+    )
+{
+    uint32_t                         dwError = 0;
+    char*                            pszMS = NULL;
+
+    dwError = VmTESTGetParam(pRequest, paramsCount, "ms", &pszMS);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    if (pszMS)
+    {
+        usleep((useconds_t)atoi(pszMS) * 1000);
+    }
+
+    dwError = VmTESTSendText(pRESTHandle, pRequest, ppResponse, "stalled");
+    BAIL_ON_VMREST_ERROR(dwError);
+
+cleanup:
+    free(pszMS);
+
+    return dwError;
+
+error:
+    goto cleanup;
+}
+
+int main(int argc, char** argv)
+{
+    uint32_t                         dwError = 0;
+    REST_CONF                        config = {0};
+    PVMREST_HANDLE                   pRESTHandle = NULL;
+    REST_PROCESSOR                   chunkHandlers = {0};
+    REST_PROCESSOR                   registerHandlers = {0};
+    REST_PROCESSOR                   unregisterHandlers = {0};
+    REST_PROCESSOR                   cacheHandlers = {0};
+    REST_PROCESSOR                   cacheFileHandlers = {0};
+    REST_PROCESSOR                   cacheInvalidateHandlers = {0};
+    REST_PROCESSOR                   stallHandlers = {0};
+    char const*                      routes[] =
+    {
+        "/v1/route/*",
+        "/v1/route/special",
+        "/v1/mid/*/end"
+    };
+    uint32_t                         index = 0;
+
+    if (argc < 2)
+    {
+        fprintf(stderr, "Usage: %s <port> [<certificate and key pem> [<worker threads>]]\n", argv[0]);
+        return 1;
+    }
+
+    signal(SIGPIPE, SIG_IGN);
+    signal(SIGTERM, sig_handler);
+    signal(SIGINT, sig_handler);
+
+    chunkHandlers.pfnHandleRead = &VmHandleChunkData;
+    registerHandlers.pfnHandleRead = &VmHandleRegisterData;
+    unregisterHandlers.pfnHandleRead = &VmHandleUnRegisterData;
+    cacheHandlers.pfnHandleRead = &VmHandleCacheData;
+    cacheFileHandlers.pfnHandleRead = &VmHandleCacheFileData;
+    cacheInvalidateHandlers.pfnHandleRead = &VmHandleCacheInvalidateData;
+    stallHandlers.pfnHandleRead = &VmHandleStallData;
+
+    config.serverPort = (uint32_t)atoi(argv[1]);
+    config.connTimeoutSec = 5;
+    config.nWorkerThr = (argc > 3) ? (uint32_t)atoi(argv[3]) : 2;
+    config.nClientCnt = 5;
+    config.nResponseChunkSize = FEATURE_CHUNK_SIZE;
+    config.nResponseCacheSize = FEATURE_CACHE_SIZE;
+    /**** TestTLSThroughput.sh passes a certificate ****/
+    config.isSecure = (argc > 2) ? TRUE : FALSE;
+    config.pszSSLCertificate = (argc > 2) ? argv[2] : NULL;
+    config.pszSSLKey = (argc > 2) ? argv[2] : NULL;
+    config.pszDebugLogFile = "/tmp/restFeatureServer.log";
+    config.debugLogLevel = VMREST_LOG_LEVEL_ERROR;
+    config.pszDaemonName = "VMREST-FEATURESERVER";
+
+    dwError = VmRESTInit(&config, &pRESTHandle);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTRegisterHandler(pRESTHandle, "/v1/chunk", &chunkHandlers, NULL);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTRegisterHandler(pRESTHandle, "/v1/admin/register", &registerHandlers, NULL);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTRegisterHandler(pRESTHandle, "/v1/admin/unregister", &unregisterHandlers, NULL);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTRegisterHandler(pRESTHandle, "/v1/cache/*", &cacheHandlers, NULL);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTRegisterHandler(pRESTHandle, "/v1/cachefile", &cacheFileHandlers, NULL);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTRegisterHandler(pRESTHandle, "/v1/cacheinvalidate", &cacheInvalidateHandlers, NULL);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTRegisterHandler(pRESTHandle, "/v1/stall", &stallHandlers, NULL);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    /**** TestRouting.sh adds and removes the rest while the server runs ****/
+    for (index = 0; index < sizeof(routes) / sizeof(routes[0]); index++)
+    {
+        dwError = VmRESTRegisterHandler(pRESTHandle, routes[index], &gRouteHandlers, NULL);
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    dwError = VmRESTStart(pRESTHandle);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    while (!gStop)
+    {
+        sleep(1);
+    }
+
+    dwError = VmRESTStop(pRESTHandle, 5);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    VmRESTUnRegisterHandler(pRESTHandle, "/v1/chunk");
+    VmRESTUnRegisterHandler(pRESTHandle, "/v1/admin/register");
+    VmRESTUnRegisterHandler(pRESTHandle, "/v1/admin/unregister");
+    VmRESTUnRegisterHandler(pRESTHandle, "/v1/cache/*");
+    VmRESTUnRegisterHandler(pRESTHandle, "/v1/cachefile");
+    VmRESTUnRegisterHandler(pRESTHandle, "/v1/cacheinvalidate");
+    VmRESTUnRegisterHandler(pRESTHandle, "/v1/stall");
+
+cleanup:
+    if (pRESTHandle)
+    {
+        VmRESTShutdown(pRESTHandle);
+    }
+
+    return dwError;
+
+error:
+    fprintf(stderr, "featureServer failed, error %u\n", dwError);
+    goto cleanup;
+}
@@ -0,0 +1,306 @@
+/* C-REST-Engine
+*
+* Copyright (c) 2017 VMware, Inc. All Rights Reserved.
+*
+* This product is licensed to you under the Apache 2.0 license (the "License").
+* You may not use this product except in compliance with the Apache 2.0 License.
+*
+* This product may include a number of subcomponents with separate copyright
+* notices and license terms. Your use of these subcomponents is subject to the
+* terms and conditions of the subcomponent's license, as noted in the LICENSE file.
+*
+*/
+
+/**** TLS request rate client, each thread runs its own connection, see TestTLSThroughput.sh ****/
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <netdb.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <openssl/ssl.h>
+#include <openssl/err.h>
+
+#define BENCH_MAX_THREADS                 1024
+#define BENCH_BUF_SIZE                    16384
+
+typedef struct _BENCH_THREAD
+{
+    pthread_t                        thread;
+    uint64_t                         nRequests;
+    uint64_t                         nHandshakes;
+    uint64_t                         nErrors;
+} BENCH_THREAD, *PBENCH_THREAD;
+
+static SSL_CTX*                          gSSLCtx = NULL;
+static struct sockaddr_in                gServerAddr;
+static char                              gRequest[512];
+static int                               gNewConnPerRequest = 0;
+static volatile int                      gStop = 0;
+
+static
+int
+BenchConnect(
+    SSL**                            ppSSL
+    )
+{
+    int                              fd = -1;
+    int                              one = 1;
+    SSL*                             pSSL = NULL;
+
+    fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0)
+    {
+        goto error;
+    }
+
+    if (connect(fd, (struct sockaddr*)&gServerAddr, sizeof(gServerAddr)) != 0)
+    {
+        goto error;
+    }
+    setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+    pSSL = SSL_new(gSSLCtx);
+    if (!pSSL || (SSL_set_fd(pSSL, fd) != 1) || (SSL_connect(pSSL) != 1))
+    {
+        goto error;
+    }
+
+    *ppSSL = pSSL;
+    return 0;
+
+error:
+    if (pSSL)
+    {
+        SSL_free(pSSL);
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+    return -1;
+}
+
+static
+void
+BenchDisconnect(
+    SSL*                             pSSL
+    )
+{
+    int                              fd = SSL_get_fd(pSSL);
+
+    SSL_shutdown(pSSL);
+    SSL_free(pSSL);
+    close(fd);
+}
+
+/**** Sends the request and reads one Content-Length response, 0 if the connection can be reused ****/
+static
+int
+BenchRequest(
+    SSL*                             pSSL,
+    char*                            buffer
+    )
+{
+    int                              nRead = 0;
+    int                              nHave = 0;
+    int                              nHeader = 0;
+    long                             nBody = 0;
+    char*                            pEnd = NULL;
+    char*                            pLen = NULL;
+    int                              bClose = 0;
+
+    if (SSL_write(pSSL, gRequest, (int)strlen(gRequest)) <= 0)
+    {
+        return -1;
+    }
+
+    while (pEnd == NULL)
+    {
+        if (nHave >= (BENCH_BUF_SIZE - 1))
+        {
+            return -1;
+        }
+        nRead = SSL_read(pSSL, buffer + nHave, BENCH_BUF_SIZE - 1 - nHave);
+        if (nRead <= 0)
+        {
+            return -1;
+        }
+        nHave += nRead;
+        buffer[nHave] = '\0';
+        pEnd = strstr(buffer, "\r\n\r\n");
+    }
+
+    if (strncmp(buffer, "HTTP/1.1 200", 12) != 0)
+    {
+        return -1;
+    }
+
+    nHeader = (int)(pEnd - buffer) + 4;
+    pLen = strcasestr(buffer, "Content-Length:");
+    if (pLen == NULL || pLen > pEnd)
+    {
+        return -1;
+    }
+    nBody = strtol(pLen + strlen("Content-Length:"), NULL, 10);
+    bClose = (strcasestr(buffer, "Connection:close") != NULL) && (strcasestr(buffer, "Connection:close") < pEnd);
+
+    nBody -= (nHave - nHeader);
+    while (nBody > 0)
+    {
+        nRead = SSL_read(pSSL, buffer, (nBody < BENCH_BUF_SIZE) ? (int)nBody : BENCH_BUF_SIZE);
+        if (nRead <= 0)
+        {
+            return -1;
+        }
+        nBody -= nRead;
+    }
+
+    return bClose ? 1 : 0;
+}
+
+static
+void*
+BenchThread(
+    void*                            pArg
+    )
+{
+    PBENCH_THREAD                    pThread = (PBENCH_THREAD)pArg;
+    SSL*                             pSSL = NULL;
+    char                             buffer[BENCH_BUF_SIZE];
+    int                              ret = 0;
+
+    while (!__atomic_load_n(&gStop, __ATOMIC_RELAXED))
+    {
+        if (pSSL == NULL)
+        {
+            if (BenchConnect(&pSSL) != 0)
+            {
+                pThread->nErrors++;
+                usleep(1000);
+                continue;
+            }
+            pThread->nHandshakes++;
+        }
+
+        ret = BenchRequest(pSSL, buffer);
+        if (ret < 0)
+        {
+            pThread->nErrors++;
+        }
+        else
+        {
+            pThread->nRequests++;
+        }
+
+        if ((ret != 0) || gNewConnPerRequest)
+        {
+            BenchDisconnect(pSSL);
+            pSSL = NULL;
+        }
+    }
+
+    if (pSSL)
+    {
+        BenchDisconnect(pSSL);
+    }
+
+    return NULL;
+}
+
+int main(int argc, char** argv)
+{
+    PBENCH_THREAD                    pThreads = NULL;
+    uint32_t                         nThreads = 0;
+    uint32_t                         nSeconds = 0;
+    uint32_t                         index = 0;
+    uint64_t                         nRequests = 0;
+    uint64_t                         nHandshakes = 0;
+    uint64_t                         nErrors = 0;
+    struct hostent*                  pHost = NULL;
+
+    if (argc < 6)
+    {
+        fprintf(stderr, "Usage: %s <host> <port> <path> <threads> <seconds> [handshake]\n", argv[0]);
+        fprintf(stderr, "       handshake: new connection and full handshake for every request\n");
+        return 1;
+    }
+
+    nThreads = (uint32_t)atoi(argv[4]);
+    nSeconds = (uint32_t)atoi(argv[5]);
+    gNewConnPerRequest = (argc > 6) && (strcmp(argv[6], "handshake") == 0);
+
+    if ((nThreads == 0) || (nThreads > BENCH_MAX_THREADS) || (nSeconds == 0))
+    {
+        fprintf(stderr, "Bad thread count or duration\n");
+        return 1;
+    }
+
+    pHost = gethostbyname(argv[1]);
+    if (pHost == NULL)
+    {
+        fprintf(stderr, "Unknown host %s\n", argv[1]);
+        return 1;
+    }
+    memset(&gServerAddr, 0, sizeof(gServerAddr));
+    gServerAddr.sin_family = AF_INET;
+    gServerAddr.sin_port = htons((uint16_t)atoi(argv[2]));
+    memcpy(&gServerAddr.sin_addr, pHost->h_addr_list[0], sizeof(gServerAddr.sin_addr));
+
+    snprintf(gRequest, sizeof(gRequest),
+             "GET %s HTTP/1.1\r\nHost: %s\r\nConnection: %s\r\n\r\n",
+             argv[3], argv[1], gNewConnPerRequest ? "close" : "keep-alive");
+
+    SSL_library_init();
+    SSL_load_error_strings();
+    gSSLCtx = SSL_CTX_new(SSLv23_client_method());
+    if (gSSLCtx == NULL)
+    {
+        fprintf(stderr, "SSL_CTX_new failed\n");
+        return 1;
+    }
+    /**** Every connection pays for a full handshake, no resumption ****/
+    SSL_CTX_set_session_cache_mode(gSSLCtx, SSL_SESS_CACHE_OFF);
+    SSL_CTX_set_verify(gSSLCtx, SSL_VERIFY_NONE, NULL);
+
+    pThreads = calloc(nThreads, sizeof(BENCH_THREAD));
+    if (pThreads == NULL)
+    {
+        return 1;
+    }
+
+    for (index = 0; index < nThreads; index++)
+    {
+        pthread_create(&pThreads[index].thread, NULL, BenchThread, &pThreads[index]);
+    }
+
+    sleep(nSeconds);
+    __atomic_store_n(&gStop, 1, __ATOMIC_RELAXED);
+
+    for (index = 0; index < nThreads; index++)
+    {
+        pthread_join(pThreads[index].thread, NULL);
+        nRequests += pThreads[index].nRequests;
+        nHandshakes += pThreads[index].nHandshakes;
+        nErrors += pThreads[index].nErrors;
+    }
+
+    printf("threads %u requests/s %.0f handshakes/s %.0f errors %llu\n",
+           nThreads,
+           (double)nRequests / nSeconds,
+           (double)nHandshakes / nSeconds,
+           (unsigned long long)nErrors);
+
+    free(pThreads);
+    SSL_CTX_free(gSSLCtx);
+
+    return 0;
+}
@@ -220,6 +220,92 @@ error:
     return dwError;
 }
 
+DWORD
+VmwSockWritev(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    PVM_SOCK_IO_VEC                  pVec,
+    uint32_t                         nVec
+)
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    uint32_t                         iVec = 0;
+
+    if (!pSocket || !pVec || !pRESTHandle)
+    {
+        dwError = ERROR_INVALID_PARAMETER;
+        BAIL_ON_VMSOCK_ERROR(dwError);
+    }
+
+    if (pRESTHandle->pPackage->pfnWritev)
+    {
+        dwError = pRESTHandle->pPackage->pfnWritev(
+                                pRESTHandle,
+                                pSocket,
+                                pVec,
+                                nVec);
+        BAIL_ON_VMSOCK_ERROR(dwError);
+    }
+    else
+    {
+        /**** Package has no vectored write, send the buffers one by one ****/
+        for (iVec = 0; iVec < nVec; iVec++)
+        {
+            if (pVec[iVec].nBytes == 0)
+            {
+                continue;
+            }
+
+            dwError = pRESTHandle->pPackage->pfnWrite(
+                                    pRESTHandle,
+                                    pSocket,
+                                    pVec[iVec].pBuffer,
+                                    pVec[iVec].nBytes);
+            BAIL_ON_VMSOCK_ERROR(dwError);
+        }
+    }
+
+error:
+
+    return dwError;
+}
+
+DWORD
+VmwSockSendFile(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    int                              fd,
+    uint64_t                         offset,
+    uint64_t                         nBytes
+)
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+
+    if (!pSocket || !pRESTHandle || (fd < 0))
+    {
+        dwError = ERROR_INVALID_PARAMETER;
+        BAIL_ON_VMSOCK_ERROR(dwError);
+    }
+
+    if (!pRESTHandle->pPackage->pfnSendFile)
+    {
+        dwError = ERROR_NOT_SUPPORTED;
+        BAIL_ON_VMSOCK_ERROR(dwError);
+    }
+
+    dwError = pRESTHandle->pPackage->pfnSendFile(
+                            pRESTHandle,
+                            pSocket,
+                            fd,
+                            offset,
+                            nBytes);
+    BAIL_ON_VMSOCK_ERROR(dwError);
+
+error:
+
+    return dwError;
+}
+
 VOID
 VmwSockRelease(
     PVMREST_HANDLE                   pRESTHandle,
@@ -278,6 +364,38 @@ VmwSockSetRequestHandle(
      return dwError;
 }
 
+DWORD
+VmwSockPostCompletion(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    PREST_REQUEST                    pRequest
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+
+    if (!pSocket || !pRESTHandle || !pRequest)
+    {
+        dwError = ERROR_INVALID_PARAMETER;
+        BAIL_ON_VMSOCK_ERROR(dwError);
+    }
+
+    if (!pRESTHandle->pPackage->pfnPostCompletion)
+    {
+        dwError = ERROR_NOT_SUPPORTED;
+        BAIL_ON_VMSOCK_ERROR(dwError);
+    }
+
+    dwError = pRESTHandle->pPackage->pfnPostCompletion(
+                            pRESTHandle,
+                            pSocket,
+                            pRequest);
+    BAIL_ON_VMSOCK_ERROR(dwError);
+
+error:
+
+    return dwError;
+}
+
 DWORD
 VmwSockGetPeerInfo(
     PVMREST_HANDLE                   pRESTHandle,
@@ -294,4 +412,30 @@ VmwSockGetPeerInfo(
      return dwError;
 }
 
+DWORD
+VmwSockThreadInit(
+    PVMREST_HANDLE                   pRESTHandle
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+
+    if (!pRESTHandle)
+    {
+        dwError = ERROR_INVALID_PARAMETER;
+        BAIL_ON_VMSOCK_ERROR(dwError);
+    }
+
+    /**** Nothing to prepare for transports without the hook ****/
+    if (pRESTHandle->pPackage->pfnThreadInit)
+    {
+        dwError = pRESTHandle->pPackage->pfnThreadInit(
+                                pRESTHandle);
+        BAIL_ON_VMSOCK_ERROR(dwError);
+    }
+
+error:
+
+    return dwError;
+}
+
 
@@ -25,7 +25,20 @@ VmwSockInitialize(
 #ifdef _WIN32
         dwError = VmWinSockInitialize(&(pRESTHandle->pPackage));
 #else
-        dwError = VmSockPosixInitialize(&(pRESTHandle->pPackage));
+        if (pRESTHandle->pRESTConfig && pRESTHandle->pRESTConfig->useIoUring)
+        {
+            dwError = VmSockUringInitialize(&(pRESTHandle->pPackage));
+            if (dwError == ERROR_NOT_SUPPORTED)
+            {
+                /**** Kernel lacks what the io_uring package needs, stay on epoll ****/
+                VMREST_LOG_WARNING(pRESTHandle,"%s","io_uring not supported, falling back to epoll transport");
+                dwError = VmSockPosixInitialize(&(pRESTHandle->pPackage));
+            }
+        }
+        else
+        {
+            dwError = VmSockPosixInitialize(&(pRESTHandle->pPackage));
+        }
 #endif
     }
 
@@ -20,3 +20,8 @@ VOID
 VmSockPosixShutdown(
     PVM_SOCK_PACKAGE pPackage
     );
+
+DWORD
+VmSockUringInitialize(
+    PVM_SOCK_PACKAGE* ppPackage
+    );
@@ -0,0 +1,233 @@
+/* C-REST-Engine
+*
+* Copyright (c) 2017 VMware, Inc. All Rights Reserved.
+*
+* This product is licensed to you under the Apache 2.0 license (the "License").
+* You may not use this product except in compliance with the Apache 2.0 License.
+*
+* This product may include a number of subcomponents with separate copyright
+* notices and license terms. Your use of these subcomponents is subject to the
+* terms and conditions of the subcomponent's license, as noted in the LICENSE file.
+*
+*/
+
+/**** Read buffers, kept by a connection while it has a request in flight and pooled per event queue otherwise ****/
+
+#include "includes.h"
+
+static
+void
+VmSockPosixLockBufferPool(
+    PVM_SOCK_BUFFER_POOL             pPool
+    );
+
+static
+void
+VmSockPosixUnlockBufferPool(
+    PVM_SOCK_BUFFER_POOL             pPool
+    );
+
+uint32_t
+VmSockPosixInitBufferPool(
+    PVM_SOCK_BUFFER_POOL             pPool,
+    BOOLEAN                          bExclusive
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+
+    if (!pPool)
+    {
+        dwError = ERROR_INVALID_PARAMETER;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTAllocateMemory(
+                  VM_SOCK_POSIX_READ_BUFFER_POOL_SIZE * sizeof(*pPool->ppBuffers),
+                  (PVOID*)&pPool->ppBuffers
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    /**** Owner thread is the only user of an exclusive queue ****/
+    if (!bExclusive)
+    {
+        dwError = VmRESTAllocateMutex(&pPool->pMutex);
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    pPool->nMaxBuffers = VM_SOCK_POSIX_READ_BUFFER_POOL_SIZE;
+    pPool->nBuffers = 0;
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    VmSockPosixFreeBufferPool(pPool);
+
+    goto cleanup;
+}
+
+void
+VmSockPosixFreeBufferPool(
+    PVM_SOCK_BUFFER_POOL             pPool
+    )
+{
+    if (pPool)
+    {
+        if (pPool->ppBuffers)
+        {
+            while (pPool->nBuffers > 0)
+            {
+                pPool->nBuffers--;
+                VmRESTFreeMemory(pPool->ppBuffers[pPool->nBuffers]);
+            }
+            VmRESTFreeMemory(pPool->ppBuffers);
+            pPool->ppBuffers = NULL;
+        }
+        if (pPool->pMutex)
+        {
+            VmRESTFreeMutex(pPool->pMutex);
+            pPool->pMutex = NULL;
+        }
+        pPool->nMaxBuffers = 0;
+    }
+}
+
+uint32_t
+VmSockPosixReserveReadBuffer(
+    PVM_SOCK_BUFFER_POOL             pPool,
+    PVM_SOCKET                       pSocket,
+    uint32_t                         nSpace,
+    uint32_t                         nMaxSize
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    uint32_t                         nNeeded = 0;
+    uint32_t                         nNewSize = 0;
+    char*                            pszNewBuf = NULL;
+
+    if (!pSocket->pszBuffer)
+    {
+        VmSockPosixLockBufferPool(pPool);
+        if (pPool->nBuffers > 0)
+        {
+            pPool->nBuffers--;
+            pSocket->pszBuffer = pPool->ppBuffers[pPool->nBuffers];
+            pPool->ppBuffers[pPool->nBuffers] = NULL;
+        }
+        VmSockPosixUnlockBufferPool(pPool);
+
+        if (!pSocket->pszBuffer)
+        {
+            dwError = VmRESTAllocateMemory(
+                          VM_SOCK_POSIX_READ_BUFFER_SIZE,
+                          (PVOID*)&pSocket->pszBuffer
+                          );
+            BAIL_ON_VMREST_ERROR(dwError);
+        }
+
+        pSocket->nBufSize = VM_SOCK_POSIX_READ_BUFFER_SIZE;
+        pSocket->nBufData = 0;
+        pSocket->nProcessed = 0;
+    }
+    else if (pSocket->nProcessed > 0)
+    {
+        /**** Move the unprocessed tail to the front ****/
+        memmove(pSocket->pszBuffer, (pSocket->pszBuffer + pSocket->nProcessed), (pSocket->nBufData - pSocket->nProcessed));
+        pSocket->nBufData -= pSocket->nProcessed;
+        pSocket->nProcessed = 0;
+    }
+
+    /**** One byte past the data is kept for the terminator ****/
+    nNeeded = pSocket->nBufData + nSpace + 1;
+    if (nNeeded > pSocket->nBufSize)
+    {
+        nNewSize = pSocket->nBufSize;
+        while (nNewSize < nNeeded)
+        {
+            nNewSize = nNewSize * 2;
+        }
+        if ((nNewSize > nMaxSize) && (nMaxSize >= nNeeded))
+        {
+            nNewSize = nMaxSize;
+        }
+
+        dwError = VmRESTReallocateMemory(
+                      pSocket->pszBuffer,
+                      (PVOID*)&pszNewBuf,
+                      nNewSize
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        pSocket->pszBuffer = pszNewBuf;
+        pSocket->nBufSize = nNewSize;
+    }
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+void
+VmSockPosixReleaseReadBuffer(
+    PVM_SOCK_BUFFER_POOL             pPool,
+    PVM_SOCKET                       pSocket
+    )
+{
+    char*                            pszBuffer = pSocket->pszBuffer;
+    uint32_t                         nBufSize = pSocket->nBufSize;
+
+    pSocket->pszBuffer = NULL;
+    pSocket->nBufSize = 0;
+    pSocket->nBufData = 0;
+    pSocket->nProcessed = 0;
+
+    if (!pszBuffer)
+    {
+        return;
+    }
+
+    /**** Grown buffers go back to the allocator, the pool holds base size ones only ****/
+    VmSockPosixLockBufferPool(pPool);
+    if ((nBufSize == VM_SOCK_POSIX_READ_BUFFER_SIZE) && (pPool->nBuffers < pPool->nMaxBuffers))
+    {
+        pPool->ppBuffers[pPool->nBuffers] = pszBuffer;
+        pPool->nBuffers++;
+        pszBuffer = NULL;
+    }
+    VmSockPosixUnlockBufferPool(pPool);
+
+    if (pszBuffer)
+    {
+        VmRESTFreeMemory(pszBuffer);
+    }
+}
+
+static
+void
+VmSockPosixLockBufferPool(
+    PVM_SOCK_BUFFER_POOL             pPool
+    )
+{
+    if (pPool->pMutex)
+    {
+        VmRESTLockMutex(pPool->pMutex);
+    }
+}
+
+static
+void
+VmSockPosixUnlockBufferPool(
+    PVM_SOCK_BUFFER_POOL             pPool
+    )
+{
+    if (pPool->pMutex)
+    {
+        VmRESTUnlockMutex(pPool->pMutex);
+    }
+}
@@ -16,6 +16,44 @@
 #define VM_SOCK_POSIX_DEFAULT_QUEUE_SIZE        (256)
 #define VM_SOCK_POSIX_DEFAULT_WORKER_THR_COUNT   5
 
+/**** Timing wheel, 512 slots of 250 ms cover 128 seconds per round ****/
+#define VM_SOCK_POSIX_TIMER_WHEEL_SLOTS         512
+#define VM_SOCK_POSIX_TIMER_WHEEL_TICK_MS       250
+
+/**** Per connection output queue, past high water (at most half of maxOutputPerConnMB) a writer off the I/O workers waits ****/
+#define VM_SOCK_POSIX_OUTPUT_QUEUE_MIN_SIZE     4096
+#define VM_SOCK_POSIX_OUTPUT_QUEUE_HIGH_WATER   (4 * 1024 * 1024)
+
+/**** Vectored write, TLS responses up to one record are coalesced into a single SSL_write ****/
+#define VM_SOCK_POSIX_MAX_IO_VEC                16
+#define VM_SOCK_POSIX_TLS_COALESCE_SIZE         16384
+
+/**** Memory BIO TLS, records stay under one segment until a connection has sent enough or after a pause ****/
+#define VM_SOCK_POSIX_TLS_HEADER_LEN            5
+#define VM_SOCK_POSIX_TLS_SMALL_RECORD_SIZE     1360
+#define VM_SOCK_POSIX_TLS_MAX_RECORD_SIZE       16384
+#define VM_SOCK_POSIX_TLS_RAMP_BYTES            (1024 * 1024)
+#define VM_SOCK_POSIX_TLS_IDLE_RESET_USEC       1000000
+
+/**** Read buffers start at one TLS record and double, idle ones are pooled per event queue ****/
+#define VM_SOCK_POSIX_READ_BUFFER_SIZE          16384
+#define VM_SOCK_POSIX_READ_BUFFER_POOL_SIZE     256
+#define VM_SOCK_POSIX_READ_MIN_SPACE            4096
+
+/**** io_uring on plain connections, the kernel receives into a ring of provided buffers and responses up to the queue size leave as one send ****/
+#define VM_SOCK_URING_RECV_BUF_COUNT            128
+#define VM_SOCK_URING_RECV_BUF_SIZE             VM_SOCK_POSIX_READ_BUFFER_SIZE
+#define VM_SOCK_URING_RECV_BUF_GROUP            0
+#define VM_SOCK_URING_SEND_QUEUE_SIZE           (64 * 1024)
+
+/**** File responses are sent, or read in for TLS, this much per step ****/
+#define VM_SOCK_POSIX_FILE_CHUNK_SIZE           (256 * 1024)
+
+/**** TLS session cache, hash buckets of one shard ****/
+#define VM_SOCK_POSIX_SSL_SESSION_BUCKETS       4096
+#define VM_SOCK_POSIX_SSL_TICKET_NAME_LEN       16
+#define VM_SOCK_POSIX_SSL_TICKET_KEY_LEN        32
+
 #ifndef PopEntryList
 #define PopEntryList(ListHead) \
     (ListHead)->Next;\
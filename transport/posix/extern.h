@@ -12,6 +12,7 @@
 */
 
 extern int                           gSSLisedInstaceCount;
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
 extern pthread_mutex_t*              gSSLThreadLock;
+#endif
 extern pthread_mutex_t               gGlobalMutex;
-extern SSL_CTX*                      gpSSLCTX;
@@ -14,7 +14,8 @@
 #include "includes.h"
 
 int                                  gSSLisedInstaceCount = INVALID;
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
 pthread_mutex_t*                     gSSLThreadLock = NULL;
+#endif
 pthread_mutex_t                      gGlobalMutex = PTHREAD_MUTEX_INITIALIZER;
-SSL_CTX*                             gpSSLCTX = NULL;
 
@@ -55,11 +55,15 @@ VmRESTGetSockPackagePosix(
     pSockPackagePosix->pfnCloseEventQueue = &VmSockPosixCloseEventQueue;
     pSockPackagePosix->pfnRead = &VmSockPosixRead;
     pSockPackagePosix->pfnWrite = &VmSockPosixWrite;
+    pSockPackagePosix->pfnWritev = &VmSockPosixWritev;
+    pSockPackagePosix->pfnSendFile = &VmSockPosixSendFile;
     pSockPackagePosix->pfnReleaseSocket = &VmSockPosixReleaseSocket;
     pSockPackagePosix->pfnCloseSocket = &VmSockPosixCloseSocket;
     pSockPackagePosix->pfnGetRequestHandle = &VmSockPosixGetRequestHandle;
     pSockPackagePosix->pfnSetRequestHandle = &VmSockPosixSetRequestHandle;
     pSockPackagePosix->pfnGetPeerInfo = &VmSockPosixGetPeerInfo;
+    pSockPackagePosix->pfnPostCompletion = &VmSockPosixPostCompletion;
+    pSockPackagePosix->pfnThreadInit = &VmSockPosixThreadInit;
 
 cleanup:
 
@@ -76,6 +76,23 @@ VmSockPosixWrite(
     uint32_t                         nBufLen
     );
 
+DWORD
+VmSockPosixWritev(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    PVM_SOCK_IO_VEC                  pVec,
+    uint32_t                         nVec
+    );
+
+DWORD
+VmSockPosixSendFile(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    int                              fd,
+    uint64_t                         offset,
+    uint64_t                         nBytes
+    );
+
 VOID
 VmSockPosixReleaseSocket(
     PVMREST_HANDLE                   pRESTHandle,
@@ -104,6 +121,13 @@ VmSockPosixSetRequestHandle(
     BOOLEAN                          bKeepAlive
     );
 
+DWORD
+VmSockPosixPostCompletion(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    PREST_REQUEST                    pRequest
+    );
+
 DWORD
 VmSockPosixGetPeerInfo(
     PVMREST_HANDLE                   pRESTHandle,
@@ -113,6 +137,144 @@ VmSockPosixGetPeerInfo(
     int*                             pPortNo
     );
 
+DWORD
+VmSockPosixThreadInit(
+    PVMREST_HANDLE                   pRESTHandle
+    );
+
+DWORD
+VmSockPosixCreateEventQueueEx(
+    PVMREST_HANDLE                   pRESTHandle,
+    BOOLEAN                          bUseRing,
+    PVM_SOCK_EVENT_QUEUE*            ppQueue
+    );
+
+/**** buffer.c ****/
+
+uint32_t
+VmSockPosixInitBufferPool(
+    PVM_SOCK_BUFFER_POOL             pPool,
+    BOOLEAN                          bExclusive
+    );
+
+void
+VmSockPosixFreeBufferPool(
+    PVM_SOCK_BUFFER_POOL             pPool
+    );
+
+uint32_t
+VmSockPosixReserveReadBuffer(
+    PVM_SOCK_BUFFER_POOL             pPool,
+    PVM_SOCKET                       pSocket,
+    uint32_t                         nSpace,
+    uint32_t                         nMaxSize
+    );
+
+void
+VmSockPosixReleaseReadBuffer(
+    PVM_SOCK_BUFFER_POOL             pPool,
+    PVM_SOCKET                       pSocket
+    );
+
+/**** timer.c ****/
+
+uint32_t
+VmSockPosixInitTimerWheel(
+    PVM_SOCK_TIMER_WHEEL             pWheel,
+    BOOLEAN                          bExclusive
+    );
+
+void
+VmSockPosixFreeTimerWheel(
+    PVM_SOCK_TIMER_WHEEL             pWheel
+    );
+
+uint32_t
+VmSockPosixArmTimer(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    int                              milliSec
+    );
+
+void
+VmSockPosixDisarmTimer(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket
+    );
+
+int
+VmSockPosixGetTimerWaitMS(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCK_EVENT_QUEUE             pQueue
+    );
+
+uint32_t
+VmSockPosixExpireTimers(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCK_EVENT_QUEUE             pQueue
+    );
+
+PVM_SOCKET
+VmSockPosixGetExpiredTimer(
+    PVM_SOCK_EVENT_QUEUE             pQueue
+    );
+
+/**** uring.c ****/
+
+DWORD
+VmSockUringCreateEventQueue(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCK_EVENT_QUEUE*            ppQueue
+    );
+
+DWORD
+VmSockUringCreate(
+    PVM_SOCK_URING*                  ppRing,
+    uint32_t                         nEntries,
+    BOOLEAN                          bDataOps
+    );
+
+VOID
+VmSockUringFree(
+    PVM_SOCK_URING                   pRing
+    );
+
+DWORD
+VmSockUringWatch(
+    PVM_SOCK_EVENT_QUEUE             pQueue,
+    PVM_SOCKET                       pSocket,
+    uint32_t                         events
+    );
+
+DWORD
+VmSockUringUnwatch(
+    PVM_SOCK_EVENT_QUEUE             pQueue,
+    PVM_SOCKET                       pSocket
+    );
+
+int
+VmSockUringWaitForEvents(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCK_EVENT_QUEUE             pQueue,
+    int                              iTimeoutMS
+    );
+
+BOOLEAN
+VmSockUringDeferRelease(
+    PVM_SOCKET                       pSocket
+    );
+
+BOOLEAN
+VmSockUringHasDataOps(
+    PVM_SOCKET                       pSocket
+    );
+
+uint32_t
+VmSockUringTakeRecv(
+    PVM_SOCKET                       pSocket,
+    char*                            pszBuffer
+    );
+
 uint32_t
 VmRESTGetSockPackagePosix(
      PVM_SOCK_PACKAGE*               ppSockPackagePosix
@@ -133,6 +295,11 @@ VmRESTSSLThreadLockShutdown(
     void
     );
 
+void
+VmRESTSSLThreadInit(
+    void
+    );
+
 uint32_t
 VmRESTSecureSocket(
     PVMREST_HANDLE                   pRESTHandle,
@@ -144,3 +311,16 @@ void
 VmRESTSecureSocketShutdown(
     PVMREST_HANDLE                   pRESTHandle
     );
+
+/**** sslSession.c ****/
+
+uint32_t
+VmRESTSSLSessionInit(
+    PVMREST_HANDLE                   pRESTHandle,
+    SSL_CTX*                         pContext
+    );
+
+void
+VmRESTSSLSessionShutdown(
+    SSL_CTX*                         pContext
+    );
@@ -13,6 +13,10 @@
 
 #include "includes.h"
 
+#if OPENSSL_VERSION_NUMBER < 0x10100000L
+
+/**** OpenSSL 1.0 needs the application to lock its shared state ****/
+
 static
 void
 VmRESTSSLThreadLockCallback(
@@ -107,8 +111,67 @@ VmRESTSSLThreadLockShutdown(
         pthread_mutex_destroy(&(gSSLThreadLock[i]));
     }
     OPENSSL_free(gSSLThreadLock);
+    gSSLThreadLock = NULL;
 }
 
+void
+VmRESTSSLThreadInit(
+    void
+    )
+{
+    /**** State is global and guarded by the lock table ****/
+}
+
+#else
+
+/**** OpenSSL 1.1 and later lock their own state, no lock table or callbacks ****/
+
+uint32_t
+VmRESTSSLThreadLockInit(
+    void
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+
+    if (!OPENSSL_init_ssl(OPENSSL_INIT_LOAD_SSL_STRINGS | OPENSSL_INIT_LOAD_CRYPTO_STRINGS, NULL))
+    {
+        dwError = VMREST_TRANSPORT_SSL_ERROR;
+    }
+
+    return dwError;
+}
+
+void
+VmRESTSSLThreadLockShutdown(
+    void
+    )
+{
+}
+
+void
+VmRESTSSLThreadInit(
+    void
+    )
+{
+#if OPENSSL_VERSION_NUMBER < 0x30000000L
+    unsigned char                    byte = 0;
+#endif
+
+    /**** Error queue and random generators are per thread, make them before the first handshake ****/
+    ERR_clear_error();
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    RAND_get0_public(NULL);
+    RAND_get0_private(NULL);
+#elif OPENSSL_VERSION_NUMBER >= 0x10101000L
+    RAND_bytes(&byte, 1);
+    RAND_priv_bytes(&byte, 1);
+#else
+    RAND_bytes(&byte, 1);
+#endif
+}
+
+#endif
+
 uint32_t
 VmRESTSecureSocket(
     PVMREST_HANDLE                   pRESTHandle,
@@ -176,12 +239,23 @@ VmRESTSecureSocket(
         BAIL_ON_VMREST_ERROR(dwError);
     }
 
+    /**** Session cache and ticket keys for resuming clients ****/
+    dwError = VmRESTSSLSessionInit(
+                  pRESTHandle,
+                  context
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
     pRESTHandle->pSSLInfo->sslContext = context;
 
 cleanup:
     return dwError;
 
 error:
+    if (context)
+    {
+        SSL_CTX_free(context);
+    }
      dwError = VMREST_TRANSPORT_SSL_ERROR;
     goto cleanup;
 }
@@ -202,24 +276,21 @@ VmRESTSecureSocketShutdown(
     /**** Free SSL context only when it is allocated and managed by library ****/
     if((pRESTHandle->pSSLInfo->isCertSet == SSL_INFO_FROM_CONFIG_FILE) || (pRESTHandle->pSSLInfo->isCertSet == SSL_INFO_FROM_BUFFER_API))
     {
+        if (pRESTHandle->pSSLInfo->sslContext)
+        {
+            VmRESTSSLSessionShutdown(pRESTHandle->pSSLInfo->sslContext);
+            SSL_CTX_free(pRESTHandle->pSSLInfo->sslContext);
+            pRESTHandle->pSSLInfo->sslContext = NULL;
+        }
+
         pthread_mutex_lock(&gGlobalMutex);
         gSSLisedInstaceCount--;
         if (gSSLisedInstaceCount == 0)
         {
-            if (pRESTHandle->pSSLInfo->sslContext)
-            {
-                VmRESTFreeMemory(pRESTHandle->pSSLInfo->sslContext);
-                pRESTHandle->pSSLInfo->sslContext = NULL;
-            }
             VmRESTSSLThreadLockShutdown();
-            gSSLThreadLock = NULL;
             bDestroyGlobalMutex = TRUE;
             gSSLisedInstaceCount = INVALID;
         }
-        else
-        {
-            pRESTHandle->pSSLInfo->sslContext = NULL;
-        }
         pthread_mutex_unlock(&gGlobalMutex);
 
         if (bDestroyGlobalMutex)
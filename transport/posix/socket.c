@@ -13,6 +13,9 @@
 
 #include "includes.h"
 
+static pthread_once_t                    gIOThreadOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t                     gIOThreadKey;
+
 static
 DWORD
 VmSockPosixCreateSignalSockets(
@@ -20,6 +23,24 @@ VmSockPosixCreateSignalSockets(
     PVM_SOCKET*                      ppWriterSocket
     );
 
+static
+DWORD
+VmSockPosixCreateCompletionSocket(
+    PVM_SOCKET*                      ppSocket
+    );
+
+static
+VOID
+VmSockPosixTakeCompletions(
+    PVM_SOCK_EVENT_QUEUE             pQueue
+    );
+
+static
+PVM_SOCKET
+VmSockPosixGetCompletedRequest(
+    PVM_SOCK_EVENT_QUEUE             pQueue
+    );
+
 static
 DWORD
 VmSockPosixAddEventToQueue(
@@ -32,6 +53,7 @@ static
 DWORD
 VmSockPosixAcceptConnection(
     PVM_SOCKET                       pListener,
+    int                              iAcceptedFd,
     PVM_SOCKET*                      ppSocket
     );
 
@@ -47,6 +69,18 @@ VmSockPosixSetReuseAddress(
     int                              fd
     );
 
+static
+DWORD
+VmSockPosixSetReusePort(
+    int                              fd
+    );
+
+static
+uint32_t
+VmSockPosixGetQueueInUse(
+    PVMREST_HANDLE                   pRESTHandle
+    );
+
 static
 VOID
 VmSockPosixFreeEventQueue(
@@ -61,30 +95,82 @@ VmSockPosixFreeSocket(
 
 static
 uint32_t
-VmSockPosixCreateTimer(
+VmRESTAcceptSSLContext(
     PVMREST_HANDLE                   pRESTHandle,
-    PVM_SOCKET                       pSocket
+    PVM_SOCKET                       pSocket,
+    BOOLEAN                          bWatched
     );
 
 static
 uint32_t
-VmSockPosixReArmTimer(
+VmRESTCreateSSLObject(
     PVMREST_HANDLE                   pRESTHandle,
-    PVM_SOCKET                       pTimerSocket,
-    int                              milliSec
+    PVM_SOCKET                       pSocket
     );
 
 static
-uint32_t
-VmRESTAcceptSSLContext(
+VOID
+VmSockPosixHandshake(
     PVMREST_HANDLE                   pRESTHandle,
     PVM_SOCKET                       pSocket,
     BOOLEAN                          bWatched
     );
 
 static
-uint32_t
-VmRESTCreateSSLObject(
+uint64_t
+VmSockPosixGetTimeUSec(
+    void
+    );
+
+static
+int
+VmSockPosixTLSAccept(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    uint32_t*                        pErrorCode
+    );
+
+static
+int
+VmSockPosixTLSRead(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    char*                            pszBuffer,
+    uint32_t                         nSpace,
+    uint32_t*                        pErrorCode
+    );
+
+static
+ssize_t
+VmSockPosixTLSFill(
+    PVM_SOCKET                       pSocket,
+    char*                            pszBuffer,
+    uint32_t                         nSpace,
+    BOOLEAN                          bOneRecord
+    );
+
+static
+DWORD
+VmSockPosixTLSSend(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    PVM_SOCK_IO_VEC                  pVec,
+    uint32_t                         nVec,
+    uint32_t*                        pnWritten
+    );
+
+static
+DWORD
+VmSockPosixTLSSendRecord(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    char*                            pszBuffer,
+    uint32_t                         nBufLen
+    );
+
+static
+DWORD
+VmSockPosixTLSFlush(
     PVMREST_HANDLE                   pRESTHandle,
     PVM_SOCKET                       pSocket
     );
@@ -96,6 +182,150 @@ VmSockPosixPreProcessTimeouts(
     PVM_SOCK_EVENT_QUEUE             pQueue
     );
 
+static
+DWORD
+VmSockPosixSendData(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    char*                            pszBuffer,
+    uint32_t                         nBufLen,
+    uint32_t*                        pnWritten
+    );
+
+static
+DWORD
+VmSockPosixSendDataVec(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    PVM_SOCK_IO_VEC                  pVec,
+    uint32_t                         nVec,
+    uint32_t*                        pnWritten
+    );
+
+static
+DWORD
+VmSockPosixQueueOutput(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    char*                            pszBuffer,
+    uint32_t                         nBufLen
+    );
+
+static
+DWORD
+VmSockPosixReserveOutput(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    uint32_t                         nBufLen
+    );
+
+static
+DWORD
+VmSockPosixBoundOutput(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket
+    );
+
+static
+DWORD
+VmSockPosixFlushOutput(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket
+    );
+
+static
+DWORD
+VmSockPosixFlushFile(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket
+    );
+
+static
+BOOLEAN
+VmSockPosixHasPendingOutput(
+    PVM_SOCKET                       pSocket
+    );
+
+static
+BOOLEAN
+VmSockPosixQueueForRing(
+    PVM_SOCKET                       pSocket,
+    uint32_t                         nBufLen
+    );
+
+static
+VOID
+VmSockPosixDiscardOutput(
+    PVM_SOCKET                       pSocket
+    );
+
+static
+DWORD
+VmSockPosixReArmSocket(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket
+    );
+
+static
+DWORD
+VmSockPosixResumeOutput(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket
+    );
+
+static
+void
+VmSockPosixCreateIOThreadKey(
+    void
+    );
+
+static
+BOOLEAN
+VmSockPosixCanParkWriter(
+    void
+    );
+
+static
+uint32_t
+VmSockPosixOutputHighWater(
+    PVMREST_HANDLE                   pRESTHandle
+    );
+
+static
+DWORD
+VmSockPosixParkWriter(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket
+    );
+
+static
+BOOLEAN
+VmSockPosixWakeWriter(
+    PVM_SOCKET                       pSocket,
+    DWORD                            dwError
+    );
+
+static
+BOOLEAN
+VmSockPosixWatchParkedWriter(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket
+    );
+
+static
+BOOLEAN
+VmSockPosixFailParkedWriter(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket
+    );
+
+static
+DWORD
+VmSockPosixPostToQueue(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket
+    );
+
 
 DWORD
 VmSockPosixStartServer(
@@ -180,9 +410,14 @@ VmSockPosixStartServer(
             pthread_mutex_lock(&gGlobalMutex);
             bLocked = TRUE;
 
-            if (gSSLisedInstaceCount == INVALID)
+            /**** Every instance builds its own context once for all its listeners, so its certificate, session cache and ticket keys are its own ****/
+            if (!pRESTHandle->pSSLInfo->sslContext)
             {
-                SSL_library_init();
+                if (gSSLisedInstaceCount == INVALID)
+                {
+                    SSL_library_init();
+                }
+
                 dwError = VmRESTSecureSocket(
                               pRESTHandle,
                               pRESTHandle->pRESTConfig->pszSSLCertificate,
@@ -190,16 +425,14 @@ VmSockPosixStartServer(
                               );
                 BAIL_ON_VMREST_ERROR(dwError);
 
-                gSSLisedInstaceCount = 0;
-                dwError = VmRESTSSLThreadLockInit();
-                BAIL_ON_VMREST_ERROR(dwError);
-                gpSSLCTX = pRESTHandle->pSSLInfo->sslContext;
-            }
-            else
-            {
-                pRESTHandle->pSSLInfo->sslContext = gpSSLCTX;
+                if (gSSLisedInstaceCount == INVALID)
+                {
+                    gSSLisedInstaceCount = 0;
+                    dwError = VmRESTSSLThreadLockInit();
+                    BAIL_ON_VMREST_ERROR(dwError);
+                }
+                gSSLisedInstaceCount++;
             }
-            gSSLisedInstaceCount++;
             pthread_mutex_unlock(&gGlobalMutex);
             bLocked = FALSE;
 
@@ -227,6 +460,16 @@ VmSockPosixStartServer(
         BAIL_ON_VMREST_ERROR(dwError);
     }
 
+    if (dwFlags & VM_SOCK_CREATE_FLAGS_REUSE_PORT)
+    {
+        dwError = VmSockPosixSetReusePort(fd);
+        if (dwError)
+        {
+            VMREST_LOG_ERROR(pRESTHandle,"SO_REUSEPORT on fd %d failed with Error code %d", fd, errno);
+        }
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
     memset(&servaddr, 0, sizeof(servaddr));
 
     if (dwFlags & VM_SOCK_CREATE_FLAGS_IPV6)
@@ -299,8 +542,6 @@ VmSockPosixStartServer(
     pSocket->type = VM_SOCK_TYPE_LISTENER;
     pSocket->fd = fd;
     pSocket->ssl = NULL;
-    pSocket->pTimerSocket = NULL;
-    pSocket->pIoSocket = NULL;
 
     *ppSocket = pSocket;
 
@@ -338,12 +579,23 @@ VmSockPosixCreateEventQueue(
     PVMREST_HANDLE                   pRESTHandle,
     PVM_SOCK_EVENT_QUEUE*            ppQueue
     )
+{
+    return VmSockPosixCreateEventQueueEx(pRESTHandle, FALSE, ppQueue);
+}
+
+DWORD
+VmSockPosixCreateEventQueueEx(
+    PVMREST_HANDLE                   pRESTHandle,
+    BOOLEAN                          bUseRing,
+    PVM_SOCK_EVENT_QUEUE*            ppQueue
+    )
 {
     DWORD                            dwError = REST_ENGINE_SUCCESS;
     PVM_SOCK_EVENT_QUEUE             pQueue = NULL;
     uint32_t                         iEventQueueSize = VM_SOCK_POSIX_DEFAULT_QUEUE_SIZE;
+    BOOLEAN                          bLocked = FALSE;
 
-    if (!ppQueue || !pRESTHandle || !pRESTHandle->pRESTConfig)
+    if (!ppQueue || !pRESTHandle || !pRESTHandle->pRESTConfig || !pRESTHandle->pSockContext)
     {
         VMREST_LOG_ERROR(pRESTHandle,"Invalid params");
         dwError = ERROR_INVALID_PARAMETER;
@@ -365,6 +617,15 @@ VmSockPosixCreateEventQueue(
     dwError = VmRESTAllocateMutex(&pQueue->pMutex);
     BAIL_ON_VMREST_ERROR(dwError);
 
+    /**** Handler threads and pending responses post finished requests here, the eventfd wakes the queue ****/
+    dwError = VmRESTAllocateMutex(&pQueue->pCompletionMutex);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmSockPosixCreateCompletionSocket(
+                  &pQueue->pCompletion
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
     dwError = VmRESTAllocateMemory(
                   iEventQueueSize * sizeof(*pQueue->pEventArray),
                   (PVOID*)&pQueue->pEventArray
@@ -372,20 +633,68 @@ VmSockPosixCreateEventQueue(
     BAIL_ON_VMREST_ERROR(dwError);
 
     pQueue->dwSize = iEventQueueSize;
-
-    pQueue->epollFd = epoll_create1(0);
-    if (pQueue->epollFd < 0)
-    {
-        VMREST_LOG_ERROR(pRESTHandle,"epoll create failed with Error code %d", errno);
-        dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
-        BAIL_ON_VMREST_ERROR(dwError);
-    }
+    pQueue->epollFd = -1;
 
     pQueue->state  = VM_SOCK_POSIX_EVENT_STATE_WAIT;
     pQueue->nReady = -1;
     pQueue->iReady = 0;
     pQueue->bShutdown = 0;
-    pQueue->thrCnt = pRESTHandle->pRESTConfig->nWorkerThr;
+
+    /**** A per worker queue is polled by its owner thread only, no need to serialize on it ****/
+    if (pRESTHandle->pRESTConfig->usePerWorkerReactor)
+    {
+        pQueue->bExclusive = TRUE;
+        pQueue->thrCnt = 1;
+    }
+    else
+    {
+        pQueue->bExclusive = FALSE;
+        pQueue->thrCnt = pRESTHandle->pRESTConfig->nWorkerThr;
+    }
+
+    dwError = VmSockPosixInitTimerWheel(
+                  &pQueue->timerWheel,
+                  pQueue->bExclusive
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmSockPosixInitBufferPool(
+                  &pQueue->readBufPool,
+                  pQueue->bExclusive
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    if (bUseRing)
+    {
+        /**** TLS connections read and write through OpenSSL, only plain ones use ring receives and sends ****/
+        dwError = VmSockUringCreate(
+                      &pQueue->pRing,
+                      iEventQueueSize,
+                      !pRESTHandle->pSSLInfo->isSecure
+                      );
+        if (dwError)
+        {
+            VMREST_LOG_ERROR(pRESTHandle,"io_uring setup failed with Error code %d", errno);
+        }
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        /**** Multishot accept hands over the new fd with the event ****/
+        dwError = VmRESTAllocateMemory(
+                      iEventQueueSize * sizeof(*pQueue->pAcceptFd),
+                      (PVOID*)&pQueue->pAcceptFd
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+    else
+    {
+        pQueue->epollFd = epoll_create1(0);
+        if (pQueue->epollFd < 0)
+        {
+            VMREST_LOG_ERROR(pRESTHandle,"epoll create failed with Error code %d", errno);
+            dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
+            BAIL_ON_VMREST_ERROR(dwError);
+        }
+    }
 
     dwError = VmSockPosixAddEventToQueue(
                   pQueue,
@@ -394,13 +703,34 @@ VmSockPosixCreateEventQueue(
                   );
     BAIL_ON_VMREST_ERROR(dwError);
 
+    if (pQueue->pCompletion)
+    {
+        dwError = VmSockPosixAddEventToQueue(
+                      pQueue,
+                      FALSE,
+                      pQueue->pCompletion
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    dwError = VmRESTLockMutex(pRESTHandle->pSockContext->pMutex);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    bLocked = TRUE;
+
+    pRESTHandle->pSSLInfo->nQueueInUse++;
+
     *ppQueue = pQueue;
-    pRESTHandle->pSSLInfo->bQueueInUse = TRUE;
 
     VMREST_LOG_DEBUG(pRESTHandle,"Event queue creation successful");
 
 cleanup:
 
+    if (bLocked)
+    {
+        VmRESTUnlockMutex(pRESTHandle->pSockContext->pMutex);
+    }
+
     return dwError;
 
 error:
@@ -477,7 +807,15 @@ VmSockPosixDeleteEventFromQueue(
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
-    if (epoll_ctl(pQueue->epollFd, EPOLL_CTL_DEL, pSocket->fd, &event) < 0)
+    if (pQueue->pRing)
+    {
+        dwError = VmSockUringUnwatch(
+                      pQueue,
+                      pSocket
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+    else if (epoll_ctl(pQueue->epollFd, EPOLL_CTL_DEL, pSocket->fd, &event) < 0)
     {
         dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
         BAIL_ON_VMREST_ERROR(dwError);
@@ -507,7 +845,10 @@ VmSockPosixWaitForEvent(
     BOOLEAN                          bLocked = FALSE;
     VM_SOCK_EVENT_TYPE               eventType = VM_SOCK_EVENT_TYPE_UNKNOWN;
     PVM_SOCKET                       pSocket = NULL;
+    PVM_SOCKET                       pHandshake = NULL;
+    BOOLEAN                          bHandshakeWatched = FALSE;
     BOOLEAN                          bFreeEventQueue = 0;
+    int                              iWaitMS = 0;
 
     if (!pQueue || !ppSocket || !pEventType)
     {
@@ -516,13 +857,25 @@ VmSockPosixWaitForEvent(
         BAIL_ON_VMREST_ERROR(dwError);
     }
 
-    dwError = VmRESTLockMutex(pQueue->pMutex);
-    BAIL_ON_VMREST_ERROR(dwError);
+    /**** Writers on this thread are never parked, it is the one draining the queues ****/
+    pthread_once(&gIOThreadOnce, VmSockPosixCreateIOThreadKey);
+    if (!pthread_getspecific(gIOThreadKey))
+    {
+        pthread_setspecific(gIOThreadKey, pQueue);
+    }
 
-    bLocked = TRUE;
+    if (!pQueue->bExclusive)
+    {
+        dwError = VmRESTLockMutex(pQueue->pMutex);
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        bLocked = TRUE;
+    }
 
     if ((pQueue->state == VM_SOCK_POSIX_EVENT_STATE_PROCESS) &&
-        (pQueue->iReady >= pQueue->nReady))
+        (pQueue->iReady >= pQueue->nReady) &&
+        (pQueue->timerWheel.pExpired == NULL) &&
+        (pQueue->pCompleted == NULL))
     {
         pQueue->state = VM_SOCK_POSIX_EVENT_STATE_WAIT;
     }
@@ -532,37 +885,110 @@ VmSockPosixWaitForEvent(
         pQueue->iReady = 0;
         pQueue->nReady = -1;
 
+        /**** Wake up no later than the next tick of the timing wheel ****/
+        iWaitMS = VmSockPosixGetTimerWaitMS(
+                      pRESTHandle,
+                      pQueue
+                      );
+        if ((iTimeoutMS >= 0) && (iTimeoutMS < iWaitMS))
+        {
+            iWaitMS = iTimeoutMS;
+        }
+
         while (pQueue->nReady < 0)
         {
-            pQueue->nReady = epoll_wait(
-                                 pQueue->epollFd,
-                                 pQueue->pEventArray,
-                                 pQueue->dwSize,
-                                 iTimeoutMS
-                                 );
+            if (pQueue->pRing)
+            {
+                pQueue->nReady = VmSockUringWaitForEvents(
+                                     pRESTHandle,
+                                     pQueue,
+                                     iWaitMS
+                                     );
+            }
+            else
+            {
+                pQueue->nReady = epoll_wait(
+                                     pQueue->epollFd,
+                                     pQueue->pEventArray,
+                                     pQueue->dwSize,
+                                     iWaitMS
+                                     );
+            }
             if ((pQueue->nReady < 0) && (errno != EINTR))
             {
-                VMREST_LOG_ERROR(pRESTHandle,"epoll_wait() failed with Error code %d", errno);
+                VMREST_LOG_ERROR(pRESTHandle,"Wait on event queue failed with Error code %d", errno);
                 dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
                 BAIL_ON_VMREST_ERROR(dwError);
             }
         }
         pQueue->state = VM_SOCK_POSIX_EVENT_STATE_PROCESS;
+
+        /**** Expire due timers, drop events of expired sockets from this batch ****/
+        if (VmSockPosixExpireTimers(pRESTHandle, pQueue) > 0)
+        {
+            VmSockPosixPreProcessTimeouts(
+                pRESTHandle,
+                pQueue
+                );
+        }
     }
 
     if (pQueue->state == VM_SOCK_POSIX_EVENT_STATE_PROCESS)
     {
-        if (pQueue->iReady < pQueue->nReady)
+        /**** Timed out connections are handed out before the IO events ****/
+        pSocket = VmSockPosixGetExpiredTimer(pQueue);
+        if (pSocket)
         {
-            /**** Preprocess timeouts ****/
-            if (pQueue->iReady == 0)
+            VMREST_LOG_INFO(pRESTHandle, "Timeout event happened on IO Socket fd %d", pSocket->fd);
+
+            if (VmSockPosixFailParkedWriter(pRESTHandle, pSocket))
+            {
+                /**** Writer parked on another thread gets the error, its completion closes the connection ****/
+                pSocket = NULL;
+            }
+            else if (VmSockPosixHasPendingOutput(pSocket))
+            {
+                /**** Peer stopped reading the response, drop the connection ****/
+                VmSockPosixDiscardOutput(pSocket);
+                VmSockPosixCloseSocket(pRESTHandle,pSocket);
+                VmSockPosixReleaseSocket(pRESTHandle,pSocket);
+                pSocket = NULL;
+            }
+            else if ((pRESTHandle->pSSLInfo->isSecure) && (!(pSocket->bSSLHandShakeCompleted)))
+            {
+                /**** SSL handshake is not completed, no response will be sent, free IoSocket ****/
+                __atomic_add_fetch(&pRESTHandle->pSSLInfo->nHandshakeFailures, 1, __ATOMIC_RELAXED);
+                VmSockPosixCloseSocket(pRESTHandle,pSocket);
+                VmSockPosixReleaseSocket(pRESTHandle,pSocket);
+                pSocket = NULL;
+            }
+            else
             {
-                VmSockPosixPreProcessTimeouts(
-                    pRESTHandle,
-                    pQueue
-                    ); 
+                eventType = VM_SOCK_EVENT_TYPE_CONNECTION_TIMEOUT;
             }
 
+            *ppSocket = pSocket;
+            *pEventType = eventType;
+
+            goto cleanup;
+        }
+
+        /**** Then requests handed back by the handler threads, parked writers only need their watch ****/
+        do
+        {
+            pSocket = VmSockPosixGetCompletedRequest(pQueue);
+        } while (pSocket && VmSockPosixWatchParkedWriter(pRESTHandle, pSocket));
+
+        if (pSocket)
+        {
+            *ppSocket = pSocket;
+            *pEventType = VM_SOCK_EVENT_TYPE_REQUEST_COMPLETED;
+
+            goto cleanup;
+        }
+
+        if (pQueue->iReady < pQueue->nReady)
+        {
             struct epoll_event* pEvent = &pQueue->pEventArray[pQueue->iReady];
             PVM_SOCKET pEventSocket = (PVM_SOCKET)pEvent->data.ptr;
 
@@ -577,59 +1003,83 @@ VmSockPosixWaitForEvent(
 
             if (pEvent->events & (EPOLLERR | EPOLLHUP))
             {
-                eventType = VM_SOCK_EVENT_TYPE_CONNECTION_CLOSED;
                 pSocket = pEventSocket;
+                if (pSocket->bWriteFailed || VmSockPosixFailParkedWriter(pRESTHandle, pSocket))
+                {
+                    /**** Writer on another thread still owns the connection, its completion closes it ****/
+                    pSocket = NULL;
+                }
+                else if (pSocket->bCloseOnFlush)
+                {
+                    /**** Owner already closed this connection, finish it here ****/
+                    VmSockPosixDiscardOutput(pSocket);
+                    VmSockPosixCloseSocket(pRESTHandle,pSocket);
+                    VmSockPosixReleaseSocket(pRESTHandle,pSocket);
+                    pSocket = NULL;
+                }
+                else
+                {
+                    VmSockPosixDiscardOutput(pSocket);
+                    eventType = VM_SOCK_EVENT_TYPE_CONNECTION_CLOSED;
+                }
             }
             else if (pEventSocket->type == VM_SOCK_TYPE_LISTENER)    // New connection request
             {
                 dwError = VmSockPosixAcceptConnection(
                               pEventSocket,
+                              pQueue->pRing ? pQueue->pAcceptFd[pQueue->iReady] : INVALID,
                               &pSocket);
                 BAIL_ON_VMREST_ERROR(dwError);
+                pSocket->pEventQueue = pQueue;
                 VMREST_LOG_INFO(pRESTHandle,"C-REST-ENGINE: ( NEW REQUEST ) Accepted new connection with socket fd %d", pSocket->fd);
 
                 dwError = VmSockPosixSetNonBlocking(pRESTHandle,pSocket);
                 BAIL_ON_VMREST_ERROR(dwError);
 
-                /**** If conn is over SSL, do the needful ****/
+                /**** If conn is over SSL, the handshake starts once the queue is released ****/
                 if (pRESTHandle->pSSLInfo->isSecure)
                 {
-                    dwError = VmRESTCreateSSLObject(
-                                   pRESTHandle,
-                                   pSocket
-                                   );
+                    pSocket->handshakeStartUSec = VmSockPosixGetTimeUSec();
+                    pHandshake = pSocket;
+                    pSocket = NULL;
+                    eventType = VM_SOCK_EVENT_TYPE_TCP_NEW_CONNECTION;
+                }
+                else
+                {
+                    /**** Start watching new connection ****/
+                    dwError = VmSockPosixAddEventToQueue(
+                                  pQueue,
+                                  TRUE,
+                                  pSocket
+                                  );
                     BAIL_ON_VMREST_ERROR(dwError);
 
-                    /**** Try SSL Handshake ****/
-                    dwError  = VmRESTAcceptSSLContext(
-                                   pRESTHandle,
-                                   pSocket,
-                                   FALSE
-                                   );
+                    /**** Start the connection timer ****/
+                    dwError = VmSockPosixArmTimer(
+                                  pRESTHandle,
+                                  pSocket,
+                                  ((pRESTHandle->pRESTConfig->connTimeoutSec) * 1000)
+                                  );
                     BAIL_ON_VMREST_ERROR(dwError);
-                }
-
-                /**** Start watching new connection ****/
-                dwError = VmSockPosixAddEventToQueue(
-                              pQueue,
-                              TRUE,
-                              pSocket
-                              );
-                BAIL_ON_VMREST_ERROR(dwError);
-
-                /**** Create and add the timer socket also ****/
-                dwError = VmSockPosixCreateTimer(
-                              pRESTHandle,
-                              pSocket
-                              );
-                BAIL_ON_VMREST_ERROR(dwError);
 
-                eventType = VM_SOCK_EVENT_TYPE_TCP_NEW_CONNECTION;
+                    eventType = VM_SOCK_EVENT_TYPE_TCP_NEW_CONNECTION;
 
-                VMREST_LOG_DEBUG(pRESTHandle,"Timer fd %d associated with socket fd %d", pSocket->pTimerSocket->fd ,pSocket->fd);
+                    VMREST_LOG_DEBUG(pRESTHandle,"Timer armed for socket fd %d", pSocket->fd);
+                }
             }
             else if (pEventSocket->type == VM_SOCK_TYPE_SIGNAL) // Shutdown library
             {
+                /**** Ring polls are one shot, keep the signal visible to the other workers ****/
+                if (pQueue->pRing)
+                {
+                    dwError = VmSockUringWatch(
+                                  pQueue,
+                                  pEventSocket,
+                                  EPOLLIN
+                                  );
+                    BAIL_ON_VMREST_ERROR(dwError);
+                }
+
                 if (pQueue->bShutdown)
                 {
                     pQueue->thrCnt--;
@@ -647,33 +1097,28 @@ VmSockPosixWaitForEvent(
                     eventType = VM_SOCK_EVENT_TYPE_DATA_AVAILABLE;
                 }
             }
-            else if (pEventSocket->type == VM_SOCK_TYPE_TIMER) // Time out event
+            else if (pEventSocket->type == VM_SOCK_TYPE_COMPLETION) // Handler threads finished requests
             {
-                pSocket = pEventSocket;
-
-                if (pSocket->pIoSocket)
+                if (pQueue->pRing)
                 {
-                   VMREST_LOG_INFO(pRESTHandle, "Timeout event happened on IO Socket fd %d, timer fd %d", pSocket->pIoSocket->fd, pSocket->fd);
-                   /**** Delete IO socket from queue so that we don't get any further notification ****/
-                    dwError = VmSockPosixDeleteEventFromQueue(
-                                  pRESTHandle,
+                    dwError = VmSockUringWatch(
                                   pQueue,
-                                  pSocket->pIoSocket
+                                  pEventSocket,
+                                  EPOLLIN
                                   );
                     BAIL_ON_VMREST_ERROR(dwError);
+                }
 
-                    if ((pRESTHandle->pSSLInfo->isSecure) && (!(pSocket->pIoSocket->bSSLHandShakeCompleted)))
-                    {
-                        /**** SSL handshake is not completed, no response will be sent, free IoSocket ****/
-                        VmSockPosixCloseSocket(pRESTHandle,pSocket->pIoSocket);
-                        VmSockPosixReleaseSocket(pRESTHandle,pSocket->pIoSocket);
-                        pSocket = NULL;
-                    }
-                    else
-                    {
-                        pSocket = pSocket->pIoSocket;
-                        eventType = VM_SOCK_EVENT_TYPE_CONNECTION_TIMEOUT;
-                    }
+                VmSockPosixTakeCompletions(pQueue);
+
+                do
+                {
+                    pSocket = VmSockPosixGetCompletedRequest(pQueue);
+                } while (pSocket && VmSockPosixWatchParkedWriter(pRESTHandle, pSocket));
+
+                if (pSocket)
+                {
+                    eventType = VM_SOCK_EVENT_TYPE_REQUEST_COMPLETED;
                 }
             }
             else  // Data available on IO Socket
@@ -682,22 +1127,31 @@ VmSockPosixWaitForEvent(
                  VMREST_LOG_DEBUG(pRESTHandle,"Data notification on socket fd %d", pSocket->fd);
 
                  /**** stop the timer ****/
-                 dwError = VmSockPosixReArmTimer(
-                               pRESTHandle,
-                               pSocket->pTimerSocket,
-                               0
-                               );
-                 BAIL_ON_VMREST_ERROR(dwError);
-
-                 /**** If SSL handshake is not yet complete, do the needful ****/
-                 if ((pRESTHandle->pSSLInfo->isSecure) && (!(pSocket->bSSLHandShakeCompleted)))
+                 VmSockPosixDisarmTimer(
+                     pRESTHandle,
+                     pSocket
+                     );
+
+                 /**** Late event of a connection whose writer failed, its completion closes it ****/
+                 if (pSocket->bWriteFailed)
+                 {
+                      pSocket = NULL;
+                 }
+                 /**** Socket became writable, continue with the queued response ****/
+                 else if (VmSockPosixHasPendingOutput(pSocket))
                  {
-                      dwError = VmRESTAcceptSSLContext(
+                      dwError = VmSockPosixResumeOutput(
                                     pRESTHandle,
-                                    pSocket,
-                                    TRUE
+                                    pSocket
                                     );
-                      BAIL_ON_VMREST_ERROR(dwError); 
+                      BAIL_ON_VMREST_ERROR(dwError);
+                      pSocket = NULL;
+                 }
+                 /**** If SSL handshake is not yet complete, continue it once the queue is released ****/
+                 else if ((pRESTHandle->pSSLInfo->isSecure) && (!(pSocket->bSSLHandShakeCompleted)))
+                 {
+                      pHandshake = pSocket;
+                      bHandshakeWatched = TRUE;
                       pSocket = NULL;
                  }
                  else
@@ -709,6 +1163,22 @@ VmSockPosixWaitForEvent(
         pQueue->iReady++;
     }
 
+    /**** Handshakes run on this worker without holding up the others ****/
+    if (pHandshake)
+    {
+        if (bLocked)
+        {
+            VmRESTUnlockMutex(pQueue->pMutex);
+            bLocked = FALSE;
+        }
+
+        VmSockPosixHandshake(
+            pRESTHandle,
+            pHandshake,
+            bHandshakeWatched
+            );
+    }
+
     *ppSocket = pSocket;
     *pEventType = eventType;
 
@@ -722,12 +1192,15 @@ cleanup:
     if (dwError == ERROR_SHUTDOWN_IN_PROGRESS && bFreeEventQueue)
     {
         VmSockPosixFreeEventQueue(pQueue);
-        pRESTHandle->pSSLInfo->bQueueInUse = FALSE;
 
-        if (pRESTHandle->pSSLInfo->isSecure == 1)
+        /**** Last queue of this instance going away also tears down SSL ****/
+        VmRESTLockMutex(pRESTHandle->pSockContext->pMutex);
+        if ((pRESTHandle->pSSLInfo->nQueueInUse == 1) && (pRESTHandle->pSSLInfo->isSecure == 1))
         {
             VmRESTSecureSocketShutdown(pRESTHandle);
         }
+        pRESTHandle->pSSLInfo->nQueueInUse--;
+        VmRESTUnlockMutex(pRESTHandle->pSockContext->pMutex);
     }
 
     return dwError;
@@ -757,6 +1230,7 @@ error:
 
     if (pSocket)
     {
+        VmSockPosixDiscardOutput(pSocket);
         VmSockPosixCloseSocket(pRESTHandle,pSocket);
         VmSockPosixReleaseSocket(pRESTHandle,pSocket);
     }
@@ -780,6 +1254,10 @@ VmSockPosixCloseEventQueue(
  
     DWORD                            dwError = REST_ENGINE_SUCCESS;
     uint32_t                         retry = 0;
+    uint32_t                         nQueueInUse = 0;
+
+    /**** Queue is freed by its last worker, so wait for the instance wide count to drop ****/
+    nQueueInUse = VmSockPosixGetQueueInUse(pRESTHandle);
 
     if (pQueue)
     {
@@ -795,7 +1273,7 @@ VmSockPosixCloseEventQueue(
 
     while(retry <= waitSecond)
     {
-        if (pRESTHandle->pSSLInfo->bQueueInUse == FALSE)
+        if (VmSockPosixGetQueueInUse(pRESTHandle) < nQueueInUse)
         {
            break;
         }
@@ -803,7 +1281,7 @@ VmSockPosixCloseEventQueue(
         retry++;
     }
 
-    if (pRESTHandle->pSSLInfo->bQueueInUse == TRUE)
+    if (VmSockPosixGetQueueInUse(pRESTHandle) >= nQueueInUse)
     {
         /**** This is not a clean stop of the server ****/
         dwError = REST_ENGINE_FAILURE;
@@ -856,8 +1334,8 @@ VmSockPosixRead(
     BOOLEAN                          bLocked = FALSE;
     ssize_t                          nRead   = 0;
     uint32_t                         errorCode = 0;
-    char*                            pszBufPrev = NULL;
-    uint32_t                         nPrevBuf = 0;
+    uint32_t                         nSpace = 0;
+    uint32_t                         nMaxSize = 0;
 
     if (!pSocket || !ppszBuffer || !nBufLen || !pRESTHandle)
     {
@@ -870,70 +1348,91 @@ VmSockPosixRead(
     BAIL_ON_VMREST_ERROR(dwError);
 
     bLocked = TRUE;
-    if (pSocket->pszBuffer)
-    {
-        nPrevBuf = pSocket->nBufData - pSocket->nProcessed;
-        VMREST_LOG_DEBUG(pRESTHandle,"Data from prev read %u", nPrevBuf);
-        /**** copy unprocessed data in local buffer ****/
-
-        if (nPrevBuf > 0)
-        {
-            dwError = VmRESTAllocateMemory(
-                          nPrevBuf,
-                          (void **)&pszBufPrev
-                          );
-            BAIL_ON_VMREST_ERROR(dwError);
 
-            memcpy(pszBufPrev, (pSocket->pszBuffer + pSocket->nProcessed), nPrevBuf);
-        }
-        VmRESTFreeMemory(pSocket->pszBuffer);
-        pSocket->pszBuffer = NULL;
-        pSocket->nBufData = 0;
-        pSocket->nProcessed = 0;
-    }
+    /**** Room for the request limit and one read past it ****/
+    nMaxSize = pRESTHandle->pRESTConfig->maxDataPerConnMB + VM_SOCK_POSIX_READ_MIN_SPACE + 1;
 
-    dwError = VmRESTReallocateMemory(
-                  (void*)pszBufPrev,
-                  (void **)&pszBufPrev,
-                  (nPrevBuf + MAX_DATA_BUFFER_LEN)
+    /**** Unprocessed data of the previous read is kept, the buffer is reused ****/
+    dwError = VmSockPosixReserveReadBuffer(
+                  &pSocket->pEventQueue->readBufPool,
+                  pSocket,
+                  VM_SOCK_POSIX_READ_MIN_SPACE,
+                  nMaxSize
                   );
     BAIL_ON_VMREST_ERROR(dwError);
 
-    memset((pszBufPrev + nPrevBuf), '\0', MAX_DATA_BUFFER_LEN);
+    VMREST_LOG_DEBUG(pRESTHandle,"Data from prev read %u", pSocket->nBufData);
 
-    do
+    if (pSocket->nUringRecv > 0)
     {
-        nRead = 0;
-        errno = 0;
-        errorCode = 0;
-        if (pRESTHandle->pSSLInfo->isSecure && (pSocket->ssl != NULL))
-        {
-            nRead = SSL_read(pSocket->ssl, (pszBufPrev + nPrevBuf), MAX_DATA_BUFFER_LEN);
-            errorCode = SSL_get_error(pSocket->ssl, nRead);
-        }
-        else if (pSocket->fd > 0)
-        {
-            nRead = read(pSocket->fd, (void*)(pszBufPrev + nPrevBuf), MAX_DATA_BUFFER_LEN);
-            errorCode = errno;
-        }
+        /**** Ring received the data with the event, copy it over, the socket has nothing more for now ****/
+        dwError = VmSockPosixReserveReadBuffer(
+                      &pSocket->pEventQueue->readBufPool,
+                      pSocket,
+                      pSocket->nUringRecv,
+                      nMaxSize
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
 
-        if (nRead > 0)
+        pSocket->nBufData += VmSockUringTakeRecv(
+                                 pSocket,
+                                 (pSocket->pszBuffer + pSocket->nBufData)
+                                 );
+        nRead = -1;
+        errorCode = EAGAIN;
+    }
+    else
+    {
+        do
         {
-            nPrevBuf += nRead;
-            dwError = VmRESTReallocateMemory(
-                  (void*)pszBufPrev,
-                  (void **)&pszBufPrev,
-                  (nPrevBuf + MAX_DATA_BUFFER_LEN)
-                  );
-            BAIL_ON_VMREST_ERROR(dwError);
-            memset((pszBufPrev + nPrevBuf), '\0', MAX_DATA_BUFFER_LEN);
-        }
-    }while((nRead > 0) && (nPrevBuf < pRESTHandle->pRESTConfig->maxDataPerConnMB));
+            nRead = 0;
+            errno = 0;
+            errorCode = 0;
+            nSpace = pSocket->nBufSize - pSocket->nBufData - 1;
+            if (pRESTHandle->pSSLInfo->isSecure && (pSocket->ssl != NULL) && pSocket->bSSLMemoryBIO)
+            {
+                nRead = VmSockPosixTLSRead(
+                            pRESTHandle,
+                            pSocket,
+                            (pSocket->pszBuffer + pSocket->nBufData),
+                            nSpace,
+                            &errorCode
+                            );
+            }
+            else if (pRESTHandle->pSSLInfo->isSecure && (pSocket->ssl != NULL))
+            {
+                nRead = SSL_read(pSocket->ssl, (pSocket->pszBuffer + pSocket->nBufData), nSpace);
+                errorCode = SSL_get_error(pSocket->ssl, nRead);
+            }
+            else if (pSocket->fd > 0)
+            {
+                nRead = read(pSocket->fd, (void*)(pSocket->pszBuffer + pSocket->nBufData), nSpace);
+                errorCode = errno;
+            }
+
+            if (nRead > 0)
+            {
+                pSocket->nBufData += nRead;
+                if (pSocket->nBufData < pRESTHandle->pRESTConfig->maxDataPerConnMB)
+                {
+                    dwError = VmSockPosixReserveReadBuffer(
+                                  &pSocket->pEventQueue->readBufPool,
+                                  pSocket,
+                                  VM_SOCK_POSIX_READ_MIN_SPACE,
+                                  nMaxSize
+                                  );
+                    BAIL_ON_VMREST_ERROR(dwError);
+                }
+            }
+        }while((nRead > 0) && (pSocket->nBufData < pRESTHandle->pRESTConfig->maxDataPerConnMB));
+    }
 
-    if (nPrevBuf >= pRESTHandle->pRESTConfig->maxDataPerConnMB)
+    pSocket->pszBuffer[pSocket->nBufData] = '\0';
+
+    if (pSocket->nBufData >= pRESTHandle->pRESTConfig->maxDataPerConnMB)
     {
         /**** Discard the request here itself. This might be the first read IO cycle ****/
-        VMREST_LOG_ERROR(pRESTHandle,"Total Data in request %u bytes is over allowed limit of %u bytes, closing connection with fd %d", nPrevBuf, pRESTHandle->pRESTConfig->maxDataPerConnMB, pSocket->fd);
+        VMREST_LOG_ERROR(pRESTHandle,"Total Data in request %u bytes is over allowed limit of %u bytes, closing connection with fd %d", pSocket->nBufData, pRESTHandle->pRESTConfig->maxDataPerConnMB, pSocket->fd);
         dwError = VMREST_TRANSPORT_SOCK_DATA_OVER_LIMIT;
     }
     BAIL_ON_VMREST_ERROR(dwError);
@@ -967,10 +1466,6 @@ VmSockPosixRead(
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
-    pSocket->pszBuffer = pszBufPrev;
-    pSocket->nProcessed = 0;
-    pSocket->nBufData = nPrevBuf;
-    
     *ppszBuffer = pSocket->pszBuffer;
     *nBufLen = pSocket->nBufData;
 
@@ -987,17 +1482,12 @@ cleanup:
 
 error:
 
-    if (pSocket)
+    if (bLocked)
     {
-        pSocket->pszBuffer = NULL;
-        pSocket->nProcessed = 0;
-        pSocket->nBufData = 0;
-    }
-
-    if (pszBufPrev)
-    {   
-        VmRESTFreeMemory(pszBufPrev);
-        pszBufPrev = NULL;
+        VmSockPosixReleaseReadBuffer(
+            &pSocket->pEventQueue->readBufPool,
+            pSocket
+            );
     }
 
     if (nBufLen)
@@ -1023,14 +1513,8 @@ VmSockPosixWrite(
 {
     DWORD                            dwError = REST_ENGINE_SUCCESS;
     BOOLEAN                          bLocked  = FALSE;
-    ssize_t                          nWritten = 0;
-    uint32_t                         nRemaining = 0;
     uint32_t                         nWrittenTotal = 0;
-    uint32_t                         errorCode = 0;
-    uint32_t                         cntRty = 0;
-    int                              maxTry = 1000;
-    uint32_t                         timerMs = 1;
-    int                              timeOutSec = 5;
+    VM_SOCK_IO_VEC                   vec = {0};
 
     if (!pRESTHandle || !pSocket || !pszBuffer)
     {
@@ -1039,74 +1523,71 @@ VmSockPosixWrite(
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
-    nRemaining = nBufLen;
-
     dwError = VmRESTLockMutex(pSocket->pMutex);
     BAIL_ON_VMREST_ERROR(dwError);
 
     bLocked = TRUE;
 
-    while(nWrittenTotal < nBufLen )
-    {
-         nWritten = 0;
-         errorCode = 0;
-         errno = 0;
-         if (pRESTHandle->pSSLInfo->isSecure && (pSocket->ssl != NULL))
-         {
-             nWritten = SSL_write(pSocket->ssl,(pszBuffer + nWrittenTotal),nRemaining);
-             errorCode = SSL_get_error(pSocket->ssl, nWritten);
-         }
-         else if (pSocket->fd > 0)
-         {
-             nWritten = write(pSocket->fd, (pszBuffer + nWrittenTotal) ,nRemaining);
-             errorCode = errno;
-         }
-         if (nWritten > 0)
-         {
-             nWrittenTotal += nWritten;
-             nRemaining -= nWritten;
-             VMREST_LOG_DEBUG(pRESTHandle,"\nBytes written this write %d, Total bytes written %u", nWritten, nWrittenTotal);
-             nWritten = 0;
-             /**** reset to original values ****/
-             maxTry = 1000;
-             timerMs = 1;
-             timeOutSec = 5;
-         }
-         else
-         {
-             if ((nWritten < 0) && (errorCode == EAGAIN || errorCode == EWOULDBLOCK || errorCode == SSL_ERROR_WANT_WRITE))
-             {
-                 if (timeOutSec >= 0)
-                 {
-                     cntRty++;
-                     usleep((timerMs * 1000));
-                     if (cntRty >= maxTry)
-                     {
-                         timerMs = ((timerMs >= 1000) ? 1000 : (timerMs*10));
-                         maxTry = ((maxTry <= 1) ? 1 : (maxTry/10));
-                         timeOutSec--;
-                         cntRty = 0;
-                     }
-                     VMREST_LOG_DEBUG(pRESTHandle,"retry write");
-                     nWritten = 0;
-                     continue;
-                 }
-                 else
-                 {
-                     VMREST_LOG_ERROR(pRESTHandle,"%s", "Exhausted maximum time to write data");
-                     dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
-                     BAIL_ON_VMREST_ERROR(dwError);
-                 }
-             }
-             else
-             {
-                 dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
-                 VMREST_LOG_ERROR(pRESTHandle,"Socket write failed with error code %u, dwError %u, nWritten %d", errorCode, dwError, nWritten);
-                 BAIL_ON_VMREST_ERROR(dwError);
-             }
-        }
+    if (pSocket->outFileRemaining > 0)
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"Socket fd %d is still sending a file response", pSocket->fd);
+        dwError = ERROR_INVALID_STATE;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    if (pSocket->bWriteFailed)
+    {
+        dwError = VMREST_TRANSPORT_SOCK_WRITE_FAILED;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    if (pSocket->bSSLMemoryBIO)
+    {
+        /**** Encrypted right away, the output queue then only holds records ****/
+        vec.pBuffer = pszBuffer;
+        vec.nBytes = nBufLen;
+
+        dwError = VmSockPosixTLSSend(
+                      pRESTHandle,
+                      pSocket,
+                      &vec,
+                      1,
+                      &nWrittenTotal
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+    /**** Nothing goes out directly while older data is still queued ****/
+    else if ((pSocket->nOutData == pSocket->nOutSent) && !VmSockPosixQueueForRing(pSocket, nBufLen))
+    {
+        dwError = VmSockPosixSendData(
+                      pRESTHandle,
+                      pSocket,
+                      pszBuffer,
+                      nBufLen,
+                      &nWrittenTotal
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    /**** Peer is not keeping up, rest is flushed from the event loop on EPOLLOUT ****/
+    if (nWrittenTotal < nBufLen)
+    {
+        dwError = VmSockPosixQueueOutput(
+                      pRESTHandle,
+                      pSocket,
+                      (pszBuffer + nWrittenTotal),
+                      (nBufLen - nWrittenTotal)
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
     }
-    VMREST_LOG_DEBUG(pRESTHandle,"\nWrite Status on Socket with fd = %d\nRequested: %d nBufLen\nWritten %d bytes\n", pSocket->fd, nBufLen, nWrittenTotal);
+
+    dwError = VmSockPosixBoundOutput(
+                  pRESTHandle,
+                  pSocket
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    VMREST_LOG_DEBUG(pRESTHandle,"\nWrite Status on Socket with fd = %d\nRequested: %d nBufLen\nWritten %d bytes\nQueued %u bytes\n", pSocket->fd, nBufLen, nWrittenTotal, (pSocket->nOutData - pSocket->nOutSent));
 
 cleanup:
 
@@ -1123,101 +1604,377 @@ error:
 
 }
 
-VOID
-VmSockPosixReleaseSocket(
-    PVMREST_HANDLE                   pRESTHandle,
-    PVM_SOCKET                       pSocket
-    )
-{
-    if (pSocket)
-    {
-        if (pSocket->pTimerSocket)
-        {
-            VmSockPosixFreeSocket(pSocket->pTimerSocket);
-            pSocket->pTimerSocket = NULL;
-        }
-        VmSockPosixFreeSocket(pSocket);
-    }
-}
-
 DWORD
-VmSockPosixCloseSocket(
+VmSockPosixWritev(
     PVMREST_HANDLE                   pRESTHandle,
-    PVM_SOCKET                       pSocket
+    PVM_SOCKET                       pSocket,
+    PVM_SOCK_IO_VEC                  pVec,
+    uint32_t                         nVec
     )
 {
     DWORD                            dwError = REST_ENGINE_SUCCESS;
-    int                              ret = 0;
-    uint32_t                         errorCode = 0;
-    BOOLEAN                          bLockedIO = FALSE;
-    BOOLEAN                          bLockedTimer = FALSE;
-    PVM_SOCKET                       pTimerSocket = NULL;
+    BOOLEAN                          bLocked  = FALSE;
+    uint32_t                         nBufLen = 0;
+    uint32_t                         nWritten = 0;
+    uint32_t                         nWrittenTotal = 0;
+    uint32_t                         nSkip = 0;
+    uint32_t                         iVec = 0;
+    char*                            pszCoalesced = NULL;
+    char*                            curr = NULL;
 
-    if (!pRESTHandle || !pSocket || !(pRESTHandle->pSockContext))
+    if (!pRESTHandle || !pSocket || !pVec || (nVec == 0) || (nVec > VM_SOCK_POSIX_MAX_IO_VEC))
     {
-        VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid Params..");
+        VMREST_LOG_ERROR(pRESTHandle,"Invalid params");
         dwError = ERROR_INVALID_PARAMETER;
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
-    pTimerSocket = pSocket->pTimerSocket;
-
-    /**** Close the timer socket ****/
-    if (pTimerSocket)
+    for (iVec = 0; iVec < nVec; iVec++)
     {
-        dwError = VmRESTLockMutex(pTimerSocket->pMutex);
-        BAIL_ON_VMREST_ERROR(dwError);
+        nBufLen += pVec[iVec].nBytes;
+    }
 
-        bLockedTimer = TRUE;
+    dwError = VmRESTLockMutex(pSocket->pMutex);
+    BAIL_ON_VMREST_ERROR(dwError);
 
-        dwError = VmSockPosixDeleteEventFromQueue(
-                      pRESTHandle,
-                      pRESTHandle->pSockContext->pEventQueue,
-                      pTimerSocket
-                      );
-        BAIL_ON_VMREST_ERROR(dwError);
+    bLocked = TRUE;
 
-        if (pTimerSocket->fd > 0)
-        {
-            close(pTimerSocket->fd);
-            pTimerSocket->fd = INVALID;
-        }
-        VmRESTUnlockMutex(pTimerSocket->pMutex);
-        bLockedTimer = FALSE;
+    if (pSocket->outFileRemaining > 0)
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"Socket fd %d is still sending a file response", pSocket->fd);
+        dwError = ERROR_INVALID_STATE;
     }
-
-    dwError = VmRESTLockMutex(pSocket->pMutex);
     BAIL_ON_VMREST_ERROR(dwError);
 
-    bLockedIO = TRUE;
+    if (pSocket->bWriteFailed)
+    {
+        dwError = VMREST_TRANSPORT_SOCK_WRITE_FAILED;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
 
-    /**** Delete from queue if this is NOT timeout ****/
-    if ((pSocket->type == VM_SOCK_TYPE_SERVER) && (!(pSocket->bTimerExpired)))
+    if (pSocket->bSSLMemoryBIO)
     {
-        dwError = VmSockPosixDeleteEventFromQueue(
+        /**** Records are cut across the buffers and all of them leave in one write ****/
+        dwError = VmSockPosixTLSSend(
                       pRESTHandle,
-                      pRESTHandle->pSockContext->pEventQueue,
-                      pSocket
+                      pSocket,
+                      pVec,
+                      nVec,
+                      &nWrittenTotal
                       );
-        if (dwError == VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED)
-        {
-            VMREST_LOG_WARNING(pRESTHandle,"Delete of IO socket fd %d from event queue failed, still progressing with conn close", pSocket->fd);
-            dwError = REST_ENGINE_SUCCESS;
-        }
         BAIL_ON_VMREST_ERROR(dwError);
     }
-
-    /**** Cleanup the SSL object associated with connection ****/
-    if (pRESTHandle->pSSLInfo->isSecure && pSocket->ssl && (pSocket->type != VM_SOCK_TYPE_TIMER))
+    /**** Nothing goes out directly while older data is still queued ****/
+    else if ((pSocket->nOutData == pSocket->nOutSent) && !VmSockPosixQueueForRing(pSocket, nBufLen))
     {
-        if (pSocket->bSSLHandShakeCompleted)
+        if (pRESTHandle->pSSLInfo->isSecure && (pSocket->ssl != NULL) && !pSocket->bKTLSSend)
         {
-            ret =  SSL_shutdown(pSocket->ssl);
-            if (ret < 0)
+            if (nBufLen <= VM_SOCK_POSIX_TLS_COALESCE_SIZE)
             {
-                errorCode = SSL_get_error(pSocket->ssl, ret);
+                /**** There is no vectored SSL_write, one record beats one record per buffer ****/
+                dwError = VmRESTAllocateMemory(
+                              (nBufLen > 0) ? nBufLen : 1,
+                              (PVOID*)&pszCoalesced
+                              );
+                BAIL_ON_VMREST_ERROR(dwError);
+
+                curr = pszCoalesced;
+                for (iVec = 0; iVec < nVec; iVec++)
+                {
+                    memcpy(curr, pVec[iVec].pBuffer, pVec[iVec].nBytes);
+                    curr += pVec[iVec].nBytes;
+                }
+
+                dwError = VmSockPosixSendData(
+                              pRESTHandle,
+                              pSocket,
+                              pszCoalesced,
+                              nBufLen,
+                              &nWrittenTotal
+                              );
+                BAIL_ON_VMREST_ERROR(dwError);
+            }
+            else
+            {
+                for (iVec = 0; iVec < nVec; iVec++)
+                {
+                    dwError = VmSockPosixSendData(
+                                  pRESTHandle,
+                                  pSocket,
+                                  pVec[iVec].pBuffer,
+                                  pVec[iVec].nBytes,
+                                  &nWritten
+                                  );
+                    BAIL_ON_VMREST_ERROR(dwError);
+
+                    nWrittenTotal += nWritten;
+                    if (nWritten < pVec[iVec].nBytes)
+                    {
+                        break;
+                    }
+                }
+            }
+        }
+        else
+        {
+            dwError = VmSockPosixSendDataVec(
+                          pRESTHandle,
+                          pSocket,
+                          pVec,
+                          nVec,
+                          &nWrittenTotal
+                          );
+            BAIL_ON_VMREST_ERROR(dwError);
+        }
+    }
+
+    /**** Peer is not keeping up, queue whatever is left of each buffer ****/
+    nSkip = nWrittenTotal;
+    for (iVec = 0; (iVec < nVec) && (nWrittenTotal < nBufLen); iVec++)
+    {
+        if (nSkip >= pVec[iVec].nBytes)
+        {
+            nSkip -= pVec[iVec].nBytes;
+            continue;
+        }
+
+        dwError = VmSockPosixQueueOutput(
+                      pRESTHandle,
+                      pSocket,
+                      (pVec[iVec].pBuffer + nSkip),
+                      (pVec[iVec].nBytes - nSkip)
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+        nSkip = 0;
+    }
+
+    dwError = VmSockPosixBoundOutput(
+                  pRESTHandle,
+                  pSocket
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    VMREST_LOG_DEBUG(pRESTHandle,"\nWritev Status on Socket with fd = %d\nRequested: %u bytes in %u buffers\nWritten %u bytes\nQueued %u bytes\n", pSocket->fd, nBufLen, nVec, nWrittenTotal, (pSocket->nOutData - pSocket->nOutSent));
+
+cleanup:
+
+    if (bLocked)
+    {
+        VmRESTUnlockMutex(pSocket->pMutex);
+    }
+    if (pszCoalesced)
+    {
+        VmRESTFreeMemory(pszCoalesced);
+    }
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+
+}
+
+DWORD
+VmSockPosixSendFile(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    int                              fd,
+    uint64_t                         offset,
+    uint64_t                         nBytes
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    BOOLEAN                          bLocked  = FALSE;
+    int                              fileFd = -1;
+
+    if (!pRESTHandle || !pSocket || (fd < 0))
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"Invalid params");
+        dwError = ERROR_INVALID_PARAMETER;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    if (nBytes == 0)
+    {
+        goto cleanup;
+    }
+
+    /**** Caller may close its descriptor once this returns ****/
+    fileFd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+    if (fileFd < 0)
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"Failed to duplicate file descriptor %d, errno %d", fd, errno);
+        dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTLockMutex(pSocket->pMutex);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    bLocked = TRUE;
+
+    if (pSocket->outFileRemaining > 0)
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"Socket fd %d is already sending a file response", pSocket->fd);
+        dwError = ERROR_INVALID_STATE;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    if (pSocket->bWriteFailed)
+    {
+        dwError = VMREST_TRANSPORT_SOCK_WRITE_FAILED;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    pSocket->outFileFd = fileFd;
+    pSocket->outFileOffset = offset;
+    pSocket->outFileRemaining = nBytes;
+    fileFd = -1;
+
+    /**** Send what fits now, the event loop carries on from EPOLLOUT without holding this worker ****/
+    dwError = VmSockPosixFlushOutput(
+                  pRESTHandle,
+                  pSocket
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    VMREST_LOG_DEBUG(pRESTHandle,"\nSendFile Status on Socket with fd = %d\nRequested: %llu bytes\nPending %llu bytes\n", pSocket->fd, (unsigned long long)nBytes, (unsigned long long)pSocket->outFileRemaining);
+
+cleanup:
+
+    if (bLocked)
+    {
+        VmRESTUnlockMutex(pSocket->pMutex);
+    }
+    if (fileFd >= 0)
+    {
+        close(fileFd);
+    }
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+VOID
+VmSockPosixReleaseSocket(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket
+    )
+{
+    if (pSocket)
+    {
+        if (pSocket->bCloseOnFlush)
+        {
+            /**** Event queue owns the connection until the queued response is out ****/
+            if (VmSockPosixReArmSocket(pRESTHandle, pSocket) == REST_ENGINE_SUCCESS)
+            {
+                return;
+            }
+
+            VMREST_LOG_WARNING(pRESTHandle,"Unable to watch socket fd %d for pending output, closing", pSocket->fd);
+            VmSockPosixDiscardOutput(pSocket);
+            VmSockPosixCloseSocket(pRESTHandle,pSocket);
+        }
+
+        /**** Ring still holds a poll on it, freed when that completes ****/
+        if (VmSockUringDeferRelease(pSocket))
+        {
+            return;
+        }
+        VmSockPosixFreeSocket(pSocket);
+    }
+}
+
+DWORD
+VmSockPosixCloseSocket(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    int                              ret = 0;
+    uint32_t                         errorCode = 0;
+    BOOLEAN                          bLockedIO = FALSE;
+    BOOLEAN                          bDeferred = FALSE;
+    char*                            pData = NULL;
+    long                             nData = 0;
+
+    if (!pRESTHandle || !pSocket || !(pRESTHandle->pSockContext))
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid Params..");
+        dwError = ERROR_INVALID_PARAMETER;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    /**** Stop the timer ****/
+    VmSockPosixDisarmTimer(
+        pRESTHandle,
+        pSocket
+        );
+
+    dwError = VmRESTLockMutex(pSocket->pMutex);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    bLockedIO = TRUE;
+
+    if (pSocket->pEventQueue)
+    {
+        VmSockPosixReleaseReadBuffer(
+            &pSocket->pEventQueue->readBufPool,
+            pSocket
+            );
+        VmSockUringTakeRecv(pSocket, NULL);
+    }
+
+    /**** Response is still draining to the peer, close once it is flushed ****/
+    if (VmSockPosixHasPendingOutput(pSocket))
+    {
+        VMREST_LOG_DEBUG(pRESTHandle,"Deferring close of socket fd %d, %u bytes and %llu file bytes pending", pSocket->fd, (pSocket->nOutData - pSocket->nOutSent), (unsigned long long)pSocket->outFileRemaining);
+        pSocket->bCloseOnFlush = TRUE;
+        bDeferred = TRUE;
+        goto cleanup;
+    }
+
+    /**** Delete from queue if this is NOT timeout ****/
+    if ((pSocket->type == VM_SOCK_TYPE_SERVER) && (!(pSocket->bTimerExpired)))
+    {
+        dwError = VmSockPosixDeleteEventFromQueue(
+                      pRESTHandle,
+                      pSocket->pEventQueue,
+                      pSocket
+                      );
+        if (dwError == VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED)
+        {
+            VMREST_LOG_WARNING(pRESTHandle,"Delete of IO socket fd %d from event queue failed, still progressing with conn close", pSocket->fd);
+            dwError = REST_ENGINE_SUCCESS;
+        }
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    /**** Cleanup the SSL object associated with connection ****/
+    if (pRESTHandle->pSSLInfo->isSecure && pSocket->ssl)
+    {
+        if (pSocket->bSSLHandShakeCompleted)
+        {
+            ret =  SSL_shutdown(pSocket->ssl);
+            if (ret < 0)
+            {
+                errorCode = SSL_get_error(pSocket->ssl, ret);
                 VMREST_LOG_ERROR(pRESTHandle,"Error on SSL_shutdown on socket %d, return value %d, errorCode %u, errno %d", pSocket->fd, ret, errorCode, errno);
             }
+            else if (pSocket->bSSLMemoryBIO)
+            {
+                /**** close_notify is best effort, nothing is queued on a closing socket ****/
+                nData = BIO_get_mem_data(SSL_get_wbio(pSocket->ssl), &pData);
+                if ((nData > 0) && (write(pSocket->fd, pData, nData) < 0))
+                {
+                    VMREST_LOG_DEBUG(pRESTHandle,"close_notify not sent on socket %d, errno %d", pSocket->fd, errno);
+                }
+            }
         }
         SSL_free(pSocket->ssl);
         pSocket->ssl = NULL;
@@ -1226,9 +1983,9 @@ VmSockPosixCloseSocket(
 cleanup:
 
     /**** Close IO socket fd ****/
-    if (pSocket && pSocket->fd >= 0)
+    if (pSocket && !bDeferred && pSocket->fd >= 0)
     {
-        VMREST_LOG_INFO(pRESTHandle,"C-REST-ENGINE: Closing socket with fd %d, Socket Type %u ( 2-Io / 5-Timer )", pSocket->fd, pSocket->type);
+        VMREST_LOG_INFO(pRESTHandle,"C-REST-ENGINE: Closing socket with fd %d, Socket Type %u ( 2-Io )", pSocket->fd, pSocket->type);
         close(pSocket->fd);
         pSocket->fd = -1;
     }
@@ -1244,12 +2001,6 @@ cleanup:
 error:
     VMREST_LOG_ERROR(pRESTHandle,"Error while closing socket..dwError = %u", dwError);
 
-    if (bLockedTimer)
-    {
-        VmRESTUnlockMutex(pTimerSocket->pMutex);
-        bLockedTimer = FALSE;
-    }
-
     goto cleanup;
 }
 
@@ -1339,53 +2090,29 @@ error:
 
 static
 DWORD
-VmSockPosixAddEventToQueue(
-    PVM_SOCK_EVENT_QUEUE             pQueue,
-    BOOLEAN                          bOneShot,
-    PVM_SOCKET                       pSocket
+VmSockPosixCreateCompletionSocket(
+    PVM_SOCKET*                      ppSocket
     )
 {
     DWORD                            dwError = REST_ENGINE_SUCCESS;
-    struct                           epoll_event event = {0};
+    PVM_SOCKET                       pSocket = NULL;
+    int                              fd = -1;
 
-    if (!pSocket || !pQueue)
+    if (!ppSocket)
     {
-        dwError = REST_ERROR_INVALID_HANDLER;
+        dwError = ERROR_INVALID_PARAMETER;
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
-    event.data.ptr = pSocket;
-    event.events = EPOLLIN;
-
-    if (bOneShot)
-    {
-       event.events = event.events | EPOLLONESHOT;
-    }
-
-    if (epoll_ctl(pQueue->epollFd, EPOLL_CTL_ADD, pSocket->fd, &event) < 0)
+    fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (fd < 0)
     {
         dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
         BAIL_ON_VMREST_ERROR(dwError);
     }
 
-error:
-
-    return dwError;
-}
-
-static
-DWORD
-VmSockPosixAcceptConnection(
-    PVM_SOCKET                       pListener,
-    PVM_SOCKET*                      ppSocket
-    )
-{
-    DWORD                            dwError = REST_ENGINE_SUCCESS;
-    PVM_SOCKET                       pSocket = NULL;
-    int                              fd = 0;
-
     dwError = VmRESTAllocateMemory(
-                  sizeof(*pSocket),
+                  sizeof(VM_SOCKET),
                   (PVOID*)&pSocket
                   );
     BAIL_ON_VMREST_ERROR(dwError);
@@ -1393,23 +2120,8 @@ VmSockPosixAcceptConnection(
     dwError = VmRESTAllocateMutex(&pSocket->pMutex);
     BAIL_ON_VMREST_ERROR(dwError);
 
-    pSocket->type = VM_SOCK_TYPE_SERVER;
-
-    fd = accept(pListener->fd, &pSocket->addr, &pSocket->addrLen);
-    if (fd < 0)
-    {
-        dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
-        BAIL_ON_VMREST_ERROR(dwError);
-    }
-
+    pSocket->type = VM_SOCK_TYPE_COMPLETION;
     pSocket->fd = fd;
-    pSocket->ssl = NULL;
-    pSocket->pRequest = NULL;
-    pSocket->pszBuffer = NULL;
-    pSocket->pTimerSocket = NULL;
-    pSocket->pIoSocket = NULL;
-    pSocket->bSSLHandShakeCompleted = FALSE;
-    pSocket->bTimerExpired = FALSE;
 
     *ppSocket = pSocket;
 
@@ -1419,8 +2131,10 @@ cleanup:
 
 error:
 
-    *ppSocket = NULL;
-
+    if (ppSocket)
+    {
+        *ppSocket = NULL;
+    }
     if (pSocket)
     {
         VmSockPosixFreeSocket(pSocket);
@@ -1435,11 +2149,150 @@ error:
 
 static
 DWORD
-VmSockPosixSetDescriptorNonBlocking(
-    int                              fd
-    )
-{
-    DWORD                            dwError = REST_ENGINE_SUCCESS;
+VmSockPosixAddEventToQueue(
+    PVM_SOCK_EVENT_QUEUE             pQueue,
+    BOOLEAN                          bOneShot,
+    PVM_SOCKET                       pSocket
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    struct                           epoll_event event = {0};
+    uint32_t                         events = 0;
+
+    if (!pSocket || !pQueue)
+    {
+        dwError = REST_ERROR_INVALID_HANDLER;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    /**** Handshake flight that did not fit in the socket buffer goes out before anything is read ****/
+    events = VmSockPosixHasPendingOutput(pSocket) ? EPOLLOUT : EPOLLIN;
+
+    /**** Ring polls are always one shot, the signal reader is re-armed when it fires ****/
+    if (pQueue->pRing)
+    {
+        dwError = VmSockUringWatch(
+                      pQueue,
+                      pSocket,
+                      events
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+    else
+    {
+        event.data.ptr = pSocket;
+        event.events = events;
+
+        if (bOneShot)
+        {
+           event.events = event.events | EPOLLONESHOT;
+        }
+
+        if (epoll_ctl(pQueue->epollFd, EPOLL_CTL_ADD, pSocket->fd, &event) < 0)
+        {
+            dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
+            BAIL_ON_VMREST_ERROR(dwError);
+        }
+    }
+
+error:
+
+    return dwError;
+}
+
+static
+DWORD
+VmSockPosixAcceptConnection(
+    PVM_SOCKET                       pListener,
+    int                              iAcceptedFd,
+    PVM_SOCKET*                      ppSocket
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    PVM_SOCKET                       pSocket = NULL;
+    int                              fd = iAcceptedFd;
+
+    dwError = VmRESTAllocateMemory(
+                  sizeof(*pSocket),
+                  (PVOID*)&pSocket
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTAllocateMutex(&pSocket->pMutex);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    pSocket->type = VM_SOCK_TYPE_SERVER;
+    pSocket->outFileFd = -1;
+
+    if (fd < 0)
+    {
+        fd = accept(pListener->fd, &pSocket->addr, &pSocket->addrLen);
+    }
+    if (fd < 0)
+    {
+        dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    pSocket->fd = fd;
+    pSocket->ssl = NULL;
+    pSocket->pRequest = NULL;
+    pSocket->pEventQueue = NULL;
+    pSocket->pszBuffer = NULL;
+    pSocket->nBufSize = 0;
+    pSocket->bSSLHandShakeCompleted = FALSE;
+    pSocket->bSSLMemoryBIO = FALSE;
+    pSocket->bKTLSSend = FALSE;
+    pSocket->nTLSHeader = 0;
+    pSocket->nTLSRecordLeft = 0;
+    pSocket->bTimerExpired = FALSE;
+    pSocket->bTimerArmed = FALSE;
+    pSocket->pTimerNext = NULL;
+    pSocket->pTimerPrev = NULL;
+    pSocket->pszOutBuf = NULL;
+    pSocket->nOutBufSize = 0;
+    pSocket->nOutData = 0;
+    pSocket->nOutSent = 0;
+    pSocket->bCloseOnFlush = FALSE;
+    pSocket->pWriterCond = NULL;
+    pSocket->bWriterParked = FALSE;
+    pSocket->bWriteFailed = FALSE;
+    pSocket->outFileOffset = 0;
+    pSocket->outFileRemaining = 0;
+    pSocket->bPollArmed = FALSE;
+    pSocket->bReleasePending = FALSE;
+    pSocket->nUringRecv = 0;
+    pSocket->bUringSendDone = FALSE;
+
+    *ppSocket = pSocket;
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    *ppSocket = NULL;
+
+    if (pSocket)
+    {
+        VmSockPosixFreeSocket(pSocket);
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+
+    goto cleanup;
+}
+
+static
+DWORD
+VmSockPosixSetDescriptorNonBlocking(
+    int                              fd
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
     int                              flags = 0;
 
     if ((flags = fcntl(fd, F_GETFL, 0)) < 0)
@@ -1481,6 +2334,47 @@ error:
     return dwError;
 }
 
+static
+DWORD
+VmSockPosixSetReusePort(
+    int                              fd
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+#ifdef SO_REUSEPORT
+    int                              on = 1;
+
+    /**** Kernel load balances incoming connections across all listeners bound to the port ****/
+    if (setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &on, sizeof(on)) < 0)
+    {
+        dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+#else
+    dwError = ERROR_NOT_SUPPORTED;
+    BAIL_ON_VMREST_ERROR(dwError);
+#endif
+
+error:
+
+    return dwError;
+}
+
+static
+uint32_t
+VmSockPosixGetQueueInUse(
+    PVMREST_HANDLE                   pRESTHandle
+    )
+{
+    uint32_t                         nQueueInUse = 0;
+
+    VmRESTLockMutex(pRESTHandle->pSockContext->pMutex);
+    nQueueInUse = pRESTHandle->pSSLInfo->nQueueInUse;
+    VmRESTUnlockMutex(pRESTHandle->pSockContext->pMutex);
+
+    return nQueueInUse;
+}
+
 static
 VOID
 VmSockPosixFreeEventQueue(
@@ -1502,6 +2396,17 @@ VmSockPosixFreeEventQueue(
         VmSockPosixFreeSocket(pQueue->pSignalWriter);
         pQueue->pSignalWriter = NULL;
     }
+    if (pQueue->pCompletion)
+    {
+        close(pQueue->pCompletion->fd);
+        VmSockPosixFreeSocket(pQueue->pCompletion);
+        pQueue->pCompletion = NULL;
+    }
+    if (pQueue->pCompletionMutex)
+    {
+        VmRESTFreeMutex(pQueue->pCompletionMutex);
+        pQueue->pCompletionMutex = NULL;
+    }
     if (pQueue->pMutex)
     {
         VmRESTFreeMutex(pQueue->pMutex);
@@ -1512,11 +2417,23 @@ VmSockPosixFreeEventQueue(
         close(pQueue->epollFd);
         pQueue->epollFd = -1;
     }
+    if (pQueue->pRing)
+    {
+        VmSockUringFree(pQueue->pRing);
+        pQueue->pRing = NULL;
+    }
+    if (pQueue->pAcceptFd)
+    {
+        VmRESTFreeMemory(pQueue->pAcceptFd);
+        pQueue->pAcceptFd = NULL;
+    }
     if (pQueue->pEventArray)
     {
         VmRESTFreeMemory(pQueue->pEventArray);
         pQueue->pEventArray = NULL;
     }
+    VmSockPosixFreeTimerWheel(&pQueue->timerWheel);
+    VmSockPosixFreeBufferPool(&pQueue->readBufPool);
     if(pQueue)
     {
         VmRESTFreeMemory(pQueue);
@@ -1535,12 +2452,29 @@ VmSockPosixFreeSocket(
         VmRESTFreeMutex(pSocket->pMutex);
     }
 
+    if (pSocket->pWriterCond)
+    {
+        VmRESTFreeCondition(pSocket->pWriterCond);
+    }
+
     if (pSocket->pszBuffer)
     {
         VmRESTFreeMemory(pSocket->pszBuffer);
         pSocket->pszBuffer = NULL;
     }
 
+    if (pSocket->pszOutBuf)
+    {
+        VmRESTFreeMemory(pSocket->pszOutBuf);
+        pSocket->pszOutBuf = NULL;
+    }
+
+    if ((pSocket->type == VM_SOCK_TYPE_SERVER) && (pSocket->outFileFd >= 0))
+    {
+        close(pSocket->outFileFd);
+        pSocket->outFileFd = -1;
+    }
+
     VmRESTFreeMemory(pSocket);
 }
 
@@ -1603,9 +2537,9 @@ VmSockPosixSetRequestHandle(
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
     BOOLEAN                          bLocked = FALSE;
     BOOLEAN                          bCompleted = FALSE;
-    struct                           epoll_event event = {0};
+    BOOLEAN                          bClose = FALSE;
 
-    if (!pSocket || !pRESTHandle || !pRESTHandle->pSockContext || !pRESTHandle->pSockContext->pEventQueue)
+    if (!pSocket || !pRESTHandle || !pSocket->pEventQueue)
     {
         VMREST_LOG_ERROR(pRESTHandle, "%s", "Invalid params ...");
         dwError = ERROR_INVALID_PARAMETER;
@@ -1626,16 +2560,19 @@ VmSockPosixSetRequestHandle(
     {
         pSocket->pRequest = NULL;
 
-        if (bPersistentConn)
+        if (pSocket->bWriteFailed && bPersistentConn)
         {
-            /**** reset the socket object for new request *****/
-            if (pSocket->pszBuffer)
-            {
-                VmRESTFreeMemory(pSocket->pszBuffer);
-                pSocket->pszBuffer = NULL;
-            }
-            pSocket->nProcessed = 0;
-            pSocket->nBufData = 0;
+            /**** Response was cut short, the connection cannot carry another one ****/
+            bClose = TRUE;
+            bCompleted = TRUE;
+        }
+        else if (bPersistentConn)
+        {
+            /**** reset the socket object for new request, idle connection gives back its read buffer *****/
+            VmSockPosixReleaseReadBuffer(
+                &pSocket->pEventQueue->readBufPool,
+                pSocket
+                );
         }
         else
         {
@@ -1643,26 +2580,24 @@ VmSockPosixSetRequestHandle(
         }
     }
 
-    if (!bCompleted)
+    if (bClose)
+    {
+        VmRESTUnlockMutex(pSocket->pMutex);
+        bLocked = FALSE;
+
+        VMREST_LOG_INFO(pRESTHandle,"Closing socket fd %d after a failed response write", pSocket->fd);
+        VmSockPosixDiscardOutput(pSocket);
+        VmSockPosixCloseSocket(pRESTHandle,pSocket);
+        VmSockPosixReleaseSocket(pRESTHandle,pSocket);
+    }
+    else if (!bCompleted)
     {
         /***** Add back IO socket to poller for next IO cycle and restart timer ****/
-        dwError = VmSockPosixReArmTimer(
+        dwError = VmSockPosixReArmSocket(
                       pRESTHandle,
-                      pSocket->pTimerSocket,
-                      ((pRESTHandle->pRESTConfig->connTimeoutSec) * 1000)
+                      pSocket
                       );
         BAIL_ON_VMREST_ERROR(dwError);
-
-        event.data.ptr = pSocket;
-        event.events = EPOLLIN;
-
-        event.events = event.events | EPOLLONESHOT;
-
-        if (epoll_ctl(pRESTHandle->pSockContext->pEventQueue->epollFd, EPOLL_CTL_MOD, pSocket->fd, &event) < 0)
-        {
-            dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
-        }
-        BAIL_ON_VMREST_ERROR(dwError);
     }
 
 cleanup:
@@ -1680,211 +2615,253 @@ error:
     
 }
 
-
 DWORD
-VmSockPosixGetPeerInfo(
+VmSockPosixPostCompletion(
     PVMREST_HANDLE                   pRESTHandle,
     PVM_SOCKET                       pSocket,
-    char*                            pIpAddress,
-    uint32_t                         nLen,
-    int*                             pPortNo
+    PREST_REQUEST                    pRequest
     )
 {
     DWORD                            dwError = REST_ENGINE_SUCCESS;
-    socklen_t                        len = 0;
-    struct sockaddr_storage          addr = {0};
-    int                              ret = 0;
-    struct sockaddr_in*              pIpV4 = NULL;
-    struct sockaddr_in6*             pIpV6 = NULL;
 
-    if (!pRESTHandle || !pSocket || !pIpAddress || !pPortNo || (nLen < INET6_ADDRSTRLEN))
+    if (!pSocket || !pRESTHandle || !pRequest || !pSocket->pEventQueue || !pSocket->pEventQueue->pCompletion)
     {
-        VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid params");
+        VMREST_LOG_ERROR(pRESTHandle, "%s", "Invalid params ...");
         dwError = ERROR_INVALID_PARAMETER;
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
-    len = sizeof(addr);
-
-    ret = getpeername(pSocket->fd, (struct sockaddr*)&addr, &len);
-
-    if (ret < 0)
-    {
-        VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid params");
-        dwError = errno;
-    }
+    dwError = VmRESTLockMutex(pSocket->pMutex);
     BAIL_ON_VMREST_ERROR(dwError);
 
-    if (addr.ss_family == AF_INET) 
-    {
-        pIpV4 = (struct sockaddr_in *)&addr;
-        *pPortNo = ntohs(pIpV4->sin_port);
-        inet_ntop(AF_INET, &pIpV4->sin_addr, pIpAddress, INET6_ADDRSTRLEN);
-    } 
-    else 
-    {
-        pIpV6 = (struct sockaddr_in6 *)&addr;
-        *pPortNo = ntohs(pIpV6->sin6_port);
-        inet_ntop(AF_INET6, &pIpV6->sin6_addr, pIpAddress, INET6_ADDRSTRLEN);
-    }
+    pSocket->pRequest = pRequest;
+
+    VmRESTUnlockMutex(pSocket->pMutex);
 
+    dwError = VmSockPosixPostToQueue(
+                  pRESTHandle,
+                  pSocket
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
 
 cleanup:
 
     return dwError;
 
 error:
-    if (pIpAddress)
-    {
-        pIpAddress = NULL;
-    }
-    if (pPortNo)
-    {
-        pPortNo = NULL;
-    }
 
     goto cleanup;
-
 }
 
 static
-uint32_t
-VmSockPosixReArmTimer(
+DWORD
+VmSockPosixPostToQueue(
     PVMREST_HANDLE                   pRESTHandle,
-    PVM_SOCKET                       pTimerSocket,
-    int                              milliSec
+    PVM_SOCKET                       pSocket
     )
 {
-    uint32_t                         dwError = REST_ENGINE_SUCCESS;
-    struct                           itimerspec ts = {{0}, {0}};
-    int                              timerFd = -1;
-    int                              nSec = 0;
-    int                              nNanoSec = 0;
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    PVM_SOCK_EVENT_QUEUE             pQueue = pSocket->pEventQueue;
+    BOOLEAN                          bLocked = FALSE;
+    BOOLEAN                          bWakeup = FALSE;
+    uint64_t                         one = 1;
+    PVM_SOCKET*                      ppPosted = NULL;
+    BOOLEAN                          bPosted = FALSE;
 
-    if (!pRESTHandle || !pTimerSocket )
-    {
-        VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid params");
-        dwError = ERROR_INVALID_PARAMETER;
-    }
+    dwError = VmRESTLockMutex(pQueue->pCompletionMutex);
     BAIL_ON_VMREST_ERROR(dwError);
 
-    if (milliSec > 0)
-    {
-        nSec = milliSec / 1000;
-        nNanoSec = (milliSec % 1000) * 1000000;
-    }
+    bLocked = TRUE;
 
-    timerFd =pTimerSocket->fd;
+    /**** Only the first post after the queue took the list needs to wake it up ****/
+    bWakeup = (pQueue->pPosted == NULL);
+    pSocket->pCompletedNext = pQueue->pPosted;
+    pQueue->pPosted = pSocket;
 
-    ts.it_interval.tv_sec = 0;
-    ts.it_interval.tv_nsec = 0;
-    ts.it_value.tv_sec = nSec;
-    ts.it_value.tv_nsec = nNanoSec;
-    
-    if (timerfd_settime(timerFd, 0, &ts, NULL) < 0)
+    VmRESTUnlockMutex(pQueue->pCompletionMutex);
+    bLocked = FALSE;
+
+    if (bWakeup && (write(pQueue->pCompletion->fd, &one, sizeof(one)) < 0))
     {
-        VMREST_LOG_ERROR(pRESTHandle,"%s","Set time failed");
-        close(timerFd);
+        VMREST_LOG_ERROR(pRESTHandle,"Wake up of event queue failed with Error code %d", errno);
         dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
+
+        /**** Failure means not posted, the caller cleans up unless the queue took it anyway ****/
+        VmRESTLockMutex(pQueue->pCompletionMutex);
+        bPosted = TRUE;
+        for (ppPosted = &pQueue->pPosted; *ppPosted != NULL; ppPosted = &(*ppPosted)->pCompletedNext)
+        {
+            if (*ppPosted == pSocket)
+            {
+                *ppPosted = pSocket->pCompletedNext;
+                pSocket->pCompletedNext = NULL;
+                bPosted = FALSE;
+                break;
+            }
+        }
+        VmRESTUnlockMutex(pQueue->pCompletionMutex);
+
+        if (bPosted)
+        {
+            dwError = REST_ENGINE_SUCCESS;
+        }
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
 cleanup:
 
+    if (bLocked)
+    {
+        VmRESTUnlockMutex(pQueue->pCompletionMutex);
+    }
+
     return dwError;
 
 error:
 
     goto cleanup;
-
 }
 
-static
-uint32_t
-VmSockPosixCreateTimer(
-    PVMREST_HANDLE                   pRESTHandle,
-    PVM_SOCKET                       pSocket
+DWORD
+VmSockPosixThreadInit(
+    PVMREST_HANDLE                   pRESTHandle
     )
 {
-    uint32_t                         dwError = REST_ENGINE_SUCCESS;
-    int                              timerFd = INVALID;
-    PVM_SOCKET                       pTimerSocket = NULL;
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
 
-    if (!pSocket || !pRESTHandle)
+    if (!pRESTHandle || !pRESTHandle->pRESTConfig)
     {
-        VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid params");
         dwError = ERROR_INVALID_PARAMETER;
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
-    timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK);
-    if (timerFd == INVALID) 
+    if (pRESTHandle->pRESTConfig->isSecure)
     {
-        VMREST_LOG_ERROR(pRESTHandle,"%s","Timer Creation failed");
-        dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
+        VmRESTSSLThreadInit();
     }
-    BAIL_ON_VMREST_ERROR(dwError);
 
-    dwError = VmRESTAllocateMemory(
-                  sizeof(*pTimerSocket),
-                  (PVOID*)&pTimerSocket
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
+cleanup:
 
-    dwError = VmRESTAllocateMutex(&pTimerSocket->pMutex);
-    BAIL_ON_VMREST_ERROR(dwError);
+    return dwError;
 
-    pTimerSocket->type = VM_SOCK_TYPE_TIMER;
-    pTimerSocket->fd = timerFd;
-    pTimerSocket->pIoSocket = pSocket;
-    pTimerSocket->pRequest = NULL;
-    pTimerSocket->pszBuffer = NULL;
-    pTimerSocket->nBufData = 0;
-    pTimerSocket->nProcessed = 0;
-    pTimerSocket->pTimerSocket = NULL;
-    pTimerSocket->bTimerExpired = FALSE;
+error:
 
-    pSocket->pTimerSocket = pTimerSocket;
+    goto cleanup;
+}
 
-    dwError = VmSockPosixReArmTimer(
-                  pRESTHandle,
-                  pTimerSocket,
-                  ((pRESTHandle->pRESTConfig->connTimeoutSec) * 1000)
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);
-    
-    dwError = VmSockPosixAddEventToQueue(
-                  pRESTHandle->pSockContext->pEventQueue,
-                  TRUE,
-                  pTimerSocket
-                  );
-    BAIL_ON_VMREST_ERROR(dwError);     
-    
+static
+VOID
+VmSockPosixTakeCompletions(
+    PVM_SOCK_EVENT_QUEUE             pQueue
+    )
+{
+    uint64_t                         count = 0;
+    PVM_SOCKET                       pSocket = NULL;
 
-cleanup:
+    /**** Reset the eventfd before taking the list, a later post wakes us again ****/
+    if (read(pQueue->pCompletion->fd, &count, sizeof(count)) < 0)
+    {
+        count = 0;
+    }
 
-    return dwError;
+    VmRESTLockMutex(pQueue->pCompletionMutex);
+    pSocket = pQueue->pPosted;
+    pQueue->pPosted = NULL;
+    VmRESTUnlockMutex(pQueue->pCompletionMutex);
 
-error:
+    /**** Posts are stacked, reversing them hands requests out in the order they finished ****/
+    while (pSocket)
+    {
+        PVM_SOCKET pNext = pSocket->pCompletedNext;
+
+        pSocket->pCompletedNext = pQueue->pCompleted;
+        pQueue->pCompleted = pSocket;
+        pSocket = pNext;
+    }
+}
+
+static
+PVM_SOCKET
+VmSockPosixGetCompletedRequest(
+    PVM_SOCK_EVENT_QUEUE             pQueue
+    )
+{
+    PVM_SOCKET                       pSocket = pQueue->pCompleted;
+
+    if (pSocket)
+    {
+        pQueue->pCompleted = pSocket->pCompletedNext;
+        pSocket->pCompletedNext = NULL;
+    }
+
+    return pSocket;
+}
+
+
+DWORD
+VmSockPosixGetPeerInfo(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    char*                            pIpAddress,
+    uint32_t                         nLen,
+    int*                             pPortNo
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    socklen_t                        len = 0;
+    struct sockaddr_storage          addr = {0};
+    int                              ret = 0;
+    struct sockaddr_in*              pIpV4 = NULL;
+    struct sockaddr_in6*             pIpV6 = NULL;
 
-    if (timerFd > 0)
+    if (!pRESTHandle || !pSocket || !pIpAddress || !pPortNo || (nLen < INET6_ADDRSTRLEN))
     {
-        close(timerFd);
+        VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid params");
+        dwError = ERROR_INVALID_PARAMETER;
     }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    len = sizeof(addr);
+
+    ret = getpeername(pSocket->fd, (struct sockaddr*)&addr, &len);
 
-    if (pTimerSocket)
+    if (ret < 0)
     {
-        VmSockPosixFreeSocket(pTimerSocket);
-        pTimerSocket = NULL;
+        VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid params");
+        dwError = errno;
     }
+    BAIL_ON_VMREST_ERROR(dwError);
 
-    if (pSocket)
+    if (addr.ss_family == AF_INET) 
+    {
+        pIpV4 = (struct sockaddr_in *)&addr;
+        *pPortNo = ntohs(pIpV4->sin_port);
+        inet_ntop(AF_INET, &pIpV4->sin_addr, pIpAddress, INET6_ADDRSTRLEN);
+    } 
+    else 
+    {
+        pIpV6 = (struct sockaddr_in6 *)&addr;
+        *pPortNo = ntohs(pIpV6->sin6_port);
+        inet_ntop(AF_INET6, &pIpV6->sin6_addr, pIpAddress, INET6_ADDRSTRLEN);
+    }
+
+
+cleanup:
+
+    return dwError;
+
+error:
+    if (pIpAddress)
+    {
+        pIpAddress = NULL;
+    }
+    if (pPortNo)
     {
-        pSocket->pTimerSocket = NULL;
+        pPortNo = NULL;
     }
 
     goto cleanup;
-    
+
 }
 
 static
@@ -1899,23 +2876,83 @@ VmRESTAcceptSSLContext(
     int                              ret = 0;
     uint32_t                         errorCode = 0;
     BOOLEAN                          bReArm = FALSE;
-    struct                           epoll_event event = {0};
+    PVM_SOCK_SSL_INFO                pSSLInfo = NULL;
+    uint64_t                         startUSec = 0;
+    uint64_t                         endUSec = 0;
+    uint64_t                         elapsedUSec = 0;
+    uint64_t                         maxUSec = 0;
 
-    if (!pSocket || !pRESTHandle || !pRESTHandle->pSSLInfo || !pSocket->ssl || !pRESTHandle->pSockContext || !pRESTHandle->pSockContext->pEventQueue)
+    if (!pSocket || !pRESTHandle || !pRESTHandle->pSSLInfo || !pSocket->ssl || !pSocket->pEventQueue)
     {
         VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid params");
         dwError = ERROR_INVALID_PARAMETER;
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
-    ret = SSL_accept(pSocket->ssl);
-    errorCode = SSL_get_error(pSocket->ssl, ret);
+    pSSLInfo = pRESTHandle->pSSLInfo;
+
+    startUSec = VmSockPosixGetTimeUSec();
+
+    if (pSocket->bSSLMemoryBIO)
+    {
+        ret = VmSockPosixTLSAccept(
+                  pRESTHandle,
+                  pSocket,
+                  &errorCode
+                  );
+    }
+    else
+    {
+        ret = SSL_accept(pSocket->ssl);
+        errorCode = SSL_get_error(pSocket->ssl, ret);
+    }
+
+    endUSec = VmSockPosixGetTimeUSec();
+    __atomic_add_fetch(&pSSLInfo->handshakeWorkUSec, (endUSec - startUSec), __ATOMIC_RELAXED);
 
     if (ret == 1)
     {
         VMREST_LOG_DEBUG(pRESTHandle,"SSL accept successful on socket %d, ret %d, errorCode %u", pSocket->fd, ret, errorCode);
         pSocket->bSSLHandShakeCompleted = TRUE;
         bReArm = TRUE;
+
+        /**** Latency counts from accept, so it includes the round trips to the peer ****/
+        elapsedUSec = endUSec - pSocket->handshakeStartUSec;
+        __atomic_add_fetch(&pSSLInfo->nHandshakes, 1, __ATOMIC_RELAXED);
+        __atomic_add_fetch(&pSSLInfo->handshakeTimeUSec, elapsedUSec, __ATOMIC_RELAXED);
+        if (SSL_session_reused(pSocket->ssl))
+        {
+            __atomic_add_fetch(&pSSLInfo->nResumed, 1, __ATOMIC_RELAXED);
+        }
+
+        if (pRESTHandle->pRESTConfig->useKTLS)
+        {
+#if defined(SSL_OP_ENABLE_KTLS) && !defined(OPENSSL_NO_KTLS)
+            /**** Once the kernel encrypts, responses go out with plain write and sendfile ****/
+            pSocket->bKTLSSend = (BIO_get_ktls_send(SSL_get_wbio(pSocket->ssl)) > 0);
+#endif
+            if (pSocket->bKTLSSend)
+            {
+                __atomic_add_fetch(&pSSLInfo->nKTLS, 1, __ATOMIC_RELAXED);
+            }
+            else
+            {
+                VMREST_LOG_DEBUG(pRESTHandle,"Kernel TLS not available on socket %d, cipher %s, staying in user space", pSocket->fd, SSL_get_cipher_name(pSocket->ssl));
+                __atomic_add_fetch(&pSSLInfo->nKTLSFallbacks, 1, __ATOMIC_RELAXED);
+            }
+        }
+
+        maxUSec = __atomic_load_n(&pSSLInfo->handshakeMaxUSec, __ATOMIC_RELAXED);
+        while ((elapsedUSec > maxUSec) &&
+               !__atomic_compare_exchange_n(
+                    &pSSLInfo->handshakeMaxUSec,
+                    &maxUSec,
+                    elapsedUSec,
+                    FALSE,
+                    __ATOMIC_RELAXED,
+                    __ATOMIC_RELAXED))
+        {
+        }
     }
     else if ((ret == -1) && ((errorCode == SSL_ERROR_WANT_READ) || (errorCode == SSL_ERROR_WANT_WRITE)))
     {
@@ -1926,6 +2963,7 @@ VmRESTAcceptSSLContext(
     else
     {
          VMREST_LOG_ERROR(pRESTHandle,"SSL handshake failed on socket fd %d, ret %d, errorCode %u, errno %d", pSocket->fd, ret, errorCode, errno);
+         __atomic_add_fetch(&pSSLInfo->nHandshakeFailures, 1, __ATOMIC_RELAXED);
          dwError = VMREST_TRANSPORT_SSL_ACCEPT_FAILED;
          BAIL_ON_VMREST_ERROR(dwError);
     }
@@ -1933,33 +2971,92 @@ VmRESTAcceptSSLContext(
     if (bReArm && bWatched)
     {
         /**** Rearm and add the socket ****/
-        dwError = VmSockPosixReArmTimer(
+        dwError = VmSockPosixReArmSocket(
                       pRESTHandle,
-                      pSocket->pTimerSocket,
-                      ((pRESTHandle->pRESTConfig->connTimeoutSec) * 1000)
+                      pSocket
                       );
         BAIL_ON_VMREST_ERROR(dwError);
+    }
+  
+cleanup:
 
-        event.data.ptr = pSocket;
-        event.events = EPOLLIN;
+    return dwError;
+
+error:
 
-        event.events = event.events | EPOLLONESHOT;
+    goto cleanup;
 
-        if (epoll_ctl(pRESTHandle->pSockContext->pEventQueue->epollFd, EPOLL_CTL_MOD, pSocket->fd, &event) < 0)
-        {
-            dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
-            BAIL_ON_VMREST_ERROR(dwError);
-        }
+}
+
+static
+VOID
+VmSockPosixHandshake(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    BOOLEAN                          bWatched
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+
+    if (!pSocket->ssl)
+    {
+        dwError = VmRESTCreateSSLObject(
+                      pRESTHandle,
+                      pSocket
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
     }
-  
+
+    dwError = VmRESTAcceptSSLContext(
+                  pRESTHandle,
+                  pSocket,
+                  bWatched
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    if (!bWatched)
+    {
+        /**** Timer goes first, the socket belongs to whichever worker sees it once watched ****/
+        dwError = VmSockPosixArmTimer(
+                      pRESTHandle,
+                      pSocket,
+                      ((pRESTHandle->pRESTConfig->connTimeoutSec) * 1000)
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        dwError = VmSockPosixAddEventToQueue(
+                      pSocket->pEventQueue,
+                      TRUE,
+                      pSocket
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
 cleanup:
 
-    return dwError;
+    return;
 
 error:
 
+    VMREST_LOG_DEBUG(pRESTHandle,"Dropping connection after handshake error %u", dwError);
+
+    VmSockPosixCloseSocket(pRESTHandle,pSocket);
+    VmSockPosixReleaseSocket(pRESTHandle,pSocket);
+
     goto cleanup;
+}
+
+static
+uint64_t
+VmSockPosixGetTimeUSec(
+    void
+    )
+{
+    struct timespec                  ts = {0};
 
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
 }
 
 static
@@ -1971,6 +3068,8 @@ VmRESTCreateSSLObject(
 {
     uint32_t                         dwError = REST_ENGINE_SUCCESS;
     SSL*                             pSSL = NULL;
+    BIO*                             pReadBio = NULL;
+    BIO*                             pWriteBio = NULL;
 
     if (!pSocket || !pRESTHandle || !pRESTHandle->pSSLInfo)
     {
@@ -1987,15 +3086,49 @@ VmRESTCreateSSLObject(
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
-    if (!(SSL_set_fd(pSSL, pSocket->fd)))
+    /**** Kernel TLS needs OpenSSL to own the socket, it wins over memory BIOs ****/
+    if (pRESTHandle->pRESTConfig->useSSLMemoryBIO && !pRESTHandle->pRESTConfig->useKTLS)
+    {
+        /**** Engine moves the ciphertext between these and the socket ****/
+        pReadBio = BIO_new(BIO_s_mem());
+        pWriteBio = BIO_new(BIO_s_mem());
+        if (!pReadBio || !pWriteBio)
+        {
+            VMREST_LOG_ERROR(pRESTHandle, "Memory BIO creation failed for socket fd %d", pSocket->fd);
+            dwError = VMREST_TRANSPORT_SSL_ERROR;
+        }
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        BIO_set_mem_eof_return(pReadBio, -1);
+        SSL_set_bio(pSSL, pReadBio, pWriteBio);
+        pReadBio = NULL;
+        pWriteBio = NULL;
+    }
+    else if (!(SSL_set_fd(pSSL, pSocket->fd)))
     {
         VMREST_LOG_ERROR(pRESTHandle, "Associating SSL CTX with raw socket fd %d failed ...", pSocket->fd);
         dwError = VMREST_TRANSPORT_SSL_ERROR;
     }
     BAIL_ON_VMREST_ERROR(dwError);
 
+    /**** Unsent data is retried from the output queue, which may move ****/
+    SSL_set_mode(pSSL, SSL_MODE_ACCEPT_MOVING_WRITE_BUFFER);
+
+#ifdef SSL_OP_ENABLE_KTLS
+    /**** OpenSSL hands the keys to the kernel as they are set, if the kernel and cipher allow it ****/
+    if (pRESTHandle->pRESTConfig->useKTLS)
+    {
+        SSL_set_options(pSSL, SSL_OP_ENABLE_KTLS);
+    }
+#endif
+
+    /**** Session cache callbacks count their hits on this instance ****/
+    SSL_set_app_data(pSSL, pRESTHandle);
+
     pSocket->ssl = pSSL;
     pSocket->bSSLHandShakeCompleted = FALSE;
+    pSocket->bSSLMemoryBIO = (pRESTHandle->pRESTConfig->useSSLMemoryBIO && !pRESTHandle->pRESTConfig->useKTLS);
+    pSocket->bKTLSSend = FALSE;
 
 cleanup:
 
@@ -2003,6 +3136,16 @@ cleanup:
 
 error:
 
+    if (pReadBio)
+    {
+        BIO_free(pReadBio);
+        pReadBio = NULL;
+    }
+    if (pWriteBio)
+    {
+        BIO_free(pWriteBio);
+        pWriteBio = NULL;
+    }
     if (pSSL)
     {
         SSL_free(pSSL);
@@ -2027,60 +3170,1269 @@ VmSockPosixPreProcessTimeouts(
 {
     struct epoll_event*              pQueueEvent = NULL;
     PVM_SOCKET                       pSocket = NULL;
-    PVM_SOCKET                       pTimerSocket = NULL;
-    PVM_SOCKET                       pIoSocket = NULL;
     int                              index = 0;
-    uint32_t                         nTimerEvents = 0;
 
-    /**** Mark all IO socket from corresponding timer as expired ****/
+    /**** Set QueueEvent->data.ptr to NULL for all expired IO socket if present in the current queue - worker will not process those ****/
     for (index = 0; index < pQueue->nReady; index++)
     {
         pQueueEvent = &pQueue->pEventArray[index];
-        if (pQueueEvent)
+        pSocket =  (PVM_SOCKET)pQueueEvent->data.ptr;
+        if (pSocket && (pSocket->type == VM_SOCK_TYPE_SERVER) && (pSocket->bTimerExpired == TRUE))
         {
-            pSocket =  (PVM_SOCKET)pQueueEvent->data.ptr;
-            if (pSocket && (pSocket->type == VM_SOCK_TYPE_TIMER))
-            {
-                pTimerSocket = pSocket;
-                pIoSocket = pTimerSocket->pIoSocket;
-                if (pIoSocket)
-                {
-                    pIoSocket->bTimerExpired = TRUE;
-                    nTimerEvents++;
-                    VMREST_LOG_DEBUG(pRESTHandle,"Timeout found for IoSocket fd %d, Timer fd %d", pIoSocket->fd, pTimerSocket->fd);
-                }
-                pTimerSocket = NULL;
-                pIoSocket = NULL;
-            }
-            pSocket = NULL;
+            pQueueEvent->data.ptr = NULL;
+            VMREST_LOG_WARNING(pRESTHandle,"Near race detected for IoSocket fd %d", pSocket->fd);
         }
-        pQueueEvent = NULL;
     }
 
-    /**** Set QueueEvent->data.ptr to NULL for all expired IO socket if present in the current queue - worker will not process those ****/
-    if (nTimerEvents > 0)
+    return;
+}
+
+
+static
+DWORD
+VmSockPosixSendData(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    char*                            pszBuffer,
+    uint32_t                         nBufLen,
+    uint32_t*                        pnWritten
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    ssize_t                          nWritten = 0;
+    uint32_t                         nWrittenTotal = 0;
+    uint32_t                         errorCode = 0;
+
+    while (nWrittenTotal < nBufLen)
     {
-        pSocket = NULL;
-        pQueueEvent = NULL;
-        index = 0;
+        nWritten = -1;
+        errorCode = 0;
+        errno = 0;
+        /**** With memory BIOs the data is already records, with kernel TLS the kernel makes them ****/
+        if (pRESTHandle->pSSLInfo->isSecure && (pSocket->ssl != NULL) && !pSocket->bSSLMemoryBIO && !pSocket->bKTLSSend)
+        {
+            nWritten = SSL_write(pSocket->ssl, (pszBuffer + nWrittenTotal), (nBufLen - nWrittenTotal));
+            errorCode = SSL_get_error(pSocket->ssl, nWritten);
+        }
+        else if (pSocket->fd >= 0)
+        {
+            nWritten = write(pSocket->fd, (pszBuffer + nWrittenTotal), (nBufLen - nWrittenTotal));
+            errorCode = errno;
+        }
 
-        for (index = 0; index < pQueue->nReady; index++)
+        if (nWritten > 0)
         {
-            pQueueEvent = &pQueue->pEventArray[index];
-            if (pQueueEvent)
-            {
-                pSocket =  (PVM_SOCKET)pQueueEvent->data.ptr;
-                if (pSocket && (pSocket->type == VM_SOCK_TYPE_SERVER) && (pSocket->bTimerExpired == TRUE))
-                {
-                    pQueueEvent->data.ptr = NULL;
-                    VMREST_LOG_WARNING(pRESTHandle,"Near race detected for IoSocket fd %d", pSocket->fd);
-                }
-                pSocket = NULL;
-            }
-            pQueueEvent = NULL;
+            nWrittenTotal += nWritten;
+            VMREST_LOG_DEBUG(pRESTHandle,"\nBytes written this write %d, Total bytes written %u", nWritten, nWrittenTotal);
+        }
+        else if ((nWritten < 0) && (errorCode == EAGAIN || errorCode == EWOULDBLOCK || errorCode == SSL_ERROR_WANT_WRITE))
+        {
+            /**** Socket buffer is full, caller keeps the rest ****/
+            break;
+        }
+        else
+        {
+            dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
+            VMREST_LOG_ERROR(pRESTHandle,"Socket write failed with error code %u, dwError %u, nWritten %d", errorCode, dwError, nWritten);
+            BAIL_ON_VMREST_ERROR(dwError);
         }
     }
 
-    return;
-}
+cleanup:
+
+    *pnWritten = nWrittenTotal;
+
+    return dwError;
 
+error:
+
+    goto cleanup;
+}
+
+static
+DWORD
+VmSockPosixSendDataVec(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    PVM_SOCK_IO_VEC                  pVec,
+    uint32_t                         nVec,
+    uint32_t*                        pnWritten
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    struct iovec                     iov[VM_SOCK_POSIX_MAX_IO_VEC];
+    ssize_t                          nWritten = 0;
+    uint32_t                         nWrittenTotal = 0;
+    uint32_t                         nBufLen = 0;
+    uint32_t                         iFirst = 0;
+    uint32_t                         iVec = 0;
+
+    for (iVec = 0; iVec < nVec; iVec++)
+    {
+        iov[iVec].iov_base = pVec[iVec].pBuffer;
+        iov[iVec].iov_len = pVec[iVec].nBytes;
+        nBufLen += pVec[iVec].nBytes;
+    }
+
+    while (nWrittenTotal < nBufLen)
+    {
+        errno = 0;
+        nWritten = writev(pSocket->fd, &iov[iFirst], (int)(nVec - iFirst));
+        if (nWritten > 0)
+        {
+            nWrittenTotal += nWritten;
+            VMREST_LOG_DEBUG(pRESTHandle,"\nBytes written this writev %d, Total bytes written %u", nWritten, nWrittenTotal);
+
+            /**** Step over what went out, a partial buffer is resumed from its middle ****/
+            while ((iFirst < nVec) && ((size_t)nWritten >= iov[iFirst].iov_len))
+            {
+                nWritten -= iov[iFirst].iov_len;
+                iFirst++;
+            }
+            if (iFirst < nVec)
+            {
+                iov[iFirst].iov_base = (char*)iov[iFirst].iov_base + nWritten;
+                iov[iFirst].iov_len -= nWritten;
+            }
+        }
+        else if ((nWritten < 0) && (errno == EAGAIN || errno == EWOULDBLOCK))
+        {
+            /**** Socket buffer is full, caller keeps the rest ****/
+            break;
+        }
+        else
+        {
+            dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
+            VMREST_LOG_ERROR(pRESTHandle,"Socket writev failed with error code %d, dwError %u, nWritten %d", errno, dwError, nWritten);
+            BAIL_ON_VMREST_ERROR(dwError);
+        }
+    }
+
+cleanup:
+
+    *pnWritten = nWrittenTotal;
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+static
+DWORD
+VmSockPosixQueueOutput(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    char*                            pszBuffer,
+    uint32_t                         nBufLen
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    BOOLEAN                          bCanPark = VmSockPosixCanParkWriter();
+    uint32_t                         nLimit = pRESTHandle->pRESTConfig->maxOutputPerConnMB * 1024 * 1024;
+    uint32_t                         nSlice = 0;
+
+    while (nBufLen > 0)
+    {
+        nSlice = nBufLen;
+
+        /**** A writer that can wait takes what fits under the limit and waits below high water for the rest ****/
+        if (bCanPark)
+        {
+            dwError = VmSockPosixBoundOutput(
+                          pRESTHandle,
+                          pSocket
+                          );
+            BAIL_ON_VMREST_ERROR(dwError);
+
+            if (nSlice > (nLimit - (pSocket->nOutData - pSocket->nOutSent)))
+            {
+                nSlice = nLimit - (pSocket->nOutData - pSocket->nOutSent);
+            }
+        }
+
+        dwError = VmSockPosixReserveOutput(
+                      pRESTHandle,
+                      pSocket,
+                      nSlice
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        memcpy((pSocket->pszOutBuf + pSocket->nOutData), pszBuffer, nSlice);
+        pSocket->nOutData += nSlice;
+        pszBuffer += nSlice;
+        nBufLen -= nSlice;
+
+        VMREST_LOG_DEBUG(pRESTHandle,"Queued %u bytes on socket fd %d, %u bytes pending", nSlice, pSocket->fd, (pSocket->nOutData - pSocket->nOutSent));
+    }
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+static
+DWORD
+VmSockPosixReserveOutput(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    uint32_t                         nBufLen
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    char*                            pszNewBuf = NULL;
+    uint32_t                         nNewSize = 0;
+
+    /**** I/O workers never wait for a slow reader, past the limit the connection fails ****/
+    if (((uint64_t)(pSocket->nOutData - pSocket->nOutSent) + nBufLen) > ((uint64_t)pRESTHandle->pRESTConfig->maxOutputPerConnMB * 1024 * 1024))
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"Socket fd %d has %u bytes waiting for a slow reader, dropping response", pSocket->fd, (pSocket->nOutData - pSocket->nOutSent));
+        VmSockPosixDiscardOutput(pSocket);
+        pSocket->bWriteFailed = TRUE;
+        dwError = VMREST_TRANSPORT_SOCK_DATA_OVER_LIMIT;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    if ((pSocket->nOutData + nBufLen) > pSocket->nOutBufSize)
+    {
+        /**** Reclaim the already sent head before growing ****/
+        if (pSocket->nOutSent > 0)
+        {
+            memmove(pSocket->pszOutBuf, (pSocket->pszOutBuf + pSocket->nOutSent), (pSocket->nOutData - pSocket->nOutSent));
+            pSocket->nOutData -= pSocket->nOutSent;
+            pSocket->nOutSent = 0;
+        }
+
+        if ((pSocket->nOutData + nBufLen) > pSocket->nOutBufSize)
+        {
+            nNewSize = (pSocket->nOutBufSize > 0) ? pSocket->nOutBufSize : VM_SOCK_POSIX_OUTPUT_QUEUE_MIN_SIZE;
+            while (nNewSize < (pSocket->nOutData + nBufLen))
+            {
+                nNewSize = nNewSize * 2;
+            }
+
+            dwError = VmRESTReallocateMemory(
+                          pSocket->pszOutBuf,
+                          (PVOID*)&pszNewBuf,
+                          nNewSize
+                          );
+            BAIL_ON_VMREST_ERROR(dwError);
+
+            pSocket->pszOutBuf = pszNewBuf;
+            pSocket->nOutBufSize = nNewSize;
+        }
+    }
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    VMREST_LOG_ERROR(pRESTHandle,"Failed to grow output queue of socket fd %d, dwError %u", pSocket->fd, dwError);
+
+    goto cleanup;
+}
+
+static
+DWORD
+VmSockPosixBoundOutput(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    uint32_t                         nHighWater = VmSockPosixOutputHighWater(pRESTHandle);
+
+    /**** Slow reader, push out what the socket takes now, EPOLLOUT drains the rest after the callback ****/
+    if ((pSocket->nOutData - pSocket->nOutSent) > nHighWater)
+    {
+        dwError = VmSockPosixFlushOutput(
+                      pRESTHandle,
+                      pSocket
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    /**** Handler and application threads wait until EPOLLOUT drained it, an I/O worker never waits ****/
+    if (((pSocket->nOutData - pSocket->nOutSent) > nHighWater) && VmSockPosixCanParkWriter())
+    {
+        dwError = VmSockPosixParkWriter(
+                      pRESTHandle,
+                      pSocket
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+static
+DWORD
+VmSockPosixFlushOutput(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    uint32_t                         nWritten = 0;
+
+    if (pSocket->bUringSendDone)
+    {
+        /**** Ring send of the queue completed, only account for it ****/
+        pSocket->bUringSendDone = FALSE;
+        nWritten = pSocket->nUringSent;
+    }
+    else
+    {
+        dwError = VmSockPosixSendData(
+                      pRESTHandle,
+                      pSocket,
+                      (pSocket->pszOutBuf + pSocket->nOutSent),
+                      (pSocket->nOutData - pSocket->nOutSent),
+                      &nWritten
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    pSocket->nOutSent += nWritten;
+    if (pSocket->nOutSent == pSocket->nOutData)
+    {
+        pSocket->nOutSent = 0;
+        pSocket->nOutData = 0;
+    }
+
+    /**** File data goes out only after everything queued ahead of it ****/
+    if ((pSocket->nOutData == 0) && (pSocket->outFileRemaining > 0))
+    {
+        dwError = VmSockPosixFlushFile(
+                      pRESTHandle,
+                      pSocket
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+static
+DWORD
+VmSockPosixFlushFile(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    ssize_t                          nDone = 0;
+    uint32_t                         nChunk = 0;
+    uint32_t                         nWritten = 0;
+    off_t                            offset = 0;
+    VM_SOCK_IO_VEC                   vec = {0};
+
+    while (pSocket->outFileRemaining > 0)
+    {
+        nChunk = (pSocket->outFileRemaining > VM_SOCK_POSIX_FILE_CHUNK_SIZE) ? VM_SOCK_POSIX_FILE_CHUNK_SIZE : (uint32_t)pSocket->outFileRemaining;
+
+        if (pRESTHandle->pSSLInfo->isSecure && (pSocket->ssl != NULL) && !pSocket->bKTLSSend)
+        {
+            /**** TLS needs the plain text in user space, refill the output queue from the file ****/
+            dwError = VmSockPosixReserveOutput(
+                          pRESTHandle,
+                          pSocket,
+                          nChunk
+                          );
+            BAIL_ON_VMREST_ERROR(dwError);
+
+            do
+            {
+                nDone = pread(pSocket->outFileFd, (pSocket->pszOutBuf + pSocket->nOutData), nChunk, (off_t)pSocket->outFileOffset);
+            } while ((nDone < 0) && (errno == EINTR));
+
+            if (nDone <= 0)
+            {
+                VMREST_LOG_ERROR(pRESTHandle,"Read of response file failed on socket fd %d, ret %d, errno %d", pSocket->fd, (int)nDone, errno);
+                dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
+            }
+            BAIL_ON_VMREST_ERROR(dwError);
+
+            pSocket->outFileOffset += nDone;
+            pSocket->outFileRemaining -= nDone;
+
+            if (pSocket->bSSLMemoryBIO)
+            {
+                /**** Plain text is only borrowed from the queue tail, its records are what gets queued ****/
+                vec.pBuffer = pSocket->pszOutBuf + pSocket->nOutData;
+                vec.nBytes = (uint32_t)nDone;
+
+                dwError = VmSockPosixTLSSend(
+                              pRESTHandle,
+                              pSocket,
+                              &vec,
+                              1,
+                              &nWritten
+                              );
+                BAIL_ON_VMREST_ERROR(dwError);
+
+                if (pSocket->nOutSent < pSocket->nOutData)
+                {
+                    /**** Socket is full, the rest of the records stay queued ****/
+                    break;
+                }
+                continue;
+            }
+
+            pSocket->nOutData += nDone;
+
+            dwError = VmSockPosixSendData(
+                          pRESTHandle,
+                          pSocket,
+                          (pSocket->pszOutBuf + pSocket->nOutSent),
+                          (pSocket->nOutData - pSocket->nOutSent),
+                          &nWritten
+                          );
+            BAIL_ON_VMREST_ERROR(dwError);
+
+            pSocket->nOutSent += nWritten;
+            if (pSocket->nOutSent < pSocket->nOutData)
+            {
+                /**** Socket is full, the rest of this chunk stays queued ****/
+                break;
+            }
+            pSocket->nOutSent = 0;
+            pSocket->nOutData = 0;
+        }
+        else
+        {
+            offset = (off_t)pSocket->outFileOffset;
+            nDone = sendfile(pSocket->fd, pSocket->outFileFd, &offset, nChunk);
+
+            if (nDone > 0)
+            {
+                pSocket->outFileOffset += nDone;
+                pSocket->outFileRemaining -= nDone;
+            }
+            else if ((nDone < 0) && (errno == EAGAIN || errno == EWOULDBLOCK))
+            {
+                /**** Socket buffer is full, continue on EPOLLOUT ****/
+                break;
+            }
+            else if ((nDone < 0) && (errno == EINTR))
+            {
+                continue;
+            }
+            else
+            {
+                /**** A zero return means the file is shorter than announced ****/
+                VMREST_LOG_ERROR(pRESTHandle,"sendfile failed on socket fd %d, ret %d, errno %d", pSocket->fd, (int)nDone, errno);
+                dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
+                BAIL_ON_VMREST_ERROR(dwError);
+            }
+        }
+    }
+
+    if ((pSocket->outFileRemaining == 0) && (pSocket->outFileFd >= 0))
+    {
+        close(pSocket->outFileFd);
+        pSocket->outFileFd = -1;
+    }
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+static
+BOOLEAN
+VmSockPosixHasPendingOutput(
+    PVM_SOCKET                       pSocket
+    )
+{
+    return ((pSocket->nOutData > pSocket->nOutSent) || (pSocket->outFileRemaining > 0));
+}
+
+static
+BOOLEAN
+VmSockPosixQueueForRing(
+    PVM_SOCKET                       pSocket,
+    uint32_t                         nBufLen
+    )
+{
+    /**** Small response leaves in the ring send at re-arm, a timed out connection has its completions dropped and writes directly ****/
+    return (VmSockUringHasDataOps(pSocket) && !pSocket->bTimerExpired &&
+            (nBufLen <= VM_SOCK_URING_SEND_QUEUE_SIZE));
+}
+
+static
+VOID
+VmSockPosixDiscardOutput(
+    PVM_SOCKET                       pSocket
+    )
+{
+    pSocket->nOutData = 0;
+    pSocket->nOutSent = 0;
+    pSocket->bCloseOnFlush = FALSE;
+    pSocket->bUringSendDone = FALSE;
+
+    if (pSocket->outFileFd >= 0)
+    {
+        close(pSocket->outFileFd);
+        pSocket->outFileFd = -1;
+    }
+    pSocket->outFileRemaining = 0;
+}
+
+static
+DWORD
+VmSockPosixReArmSocket(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    struct                           epoll_event event = {0};
+
+    dwError = VmSockPosixArmTimer(
+                  pRESTHandle,
+                  pSocket,
+                  ((pRESTHandle->pRESTConfig->connTimeoutSec) * 1000)
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    /**** Pending output is drained before the next request is read ****/
+    event.data.ptr = pSocket;
+    if (VmSockPosixHasPendingOutput(pSocket))
+    {
+        event.events = EPOLLOUT;
+    }
+    else
+    {
+        event.events = EPOLLIN;
+    }
+
+    if (pSocket->pEventQueue->pRing)
+    {
+        dwError = VmSockUringWatch(
+                      pSocket->pEventQueue,
+                      pSocket,
+                      event.events
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+        goto cleanup;
+    }
+
+    event.events = event.events | EPOLLONESHOT;
+
+    if (epoll_ctl(pSocket->pEventQueue->epollFd, EPOLL_CTL_MOD, pSocket->fd, &event) < 0)
+    {
+        dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+static
+DWORD
+VmSockPosixResumeOutput(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    BOOLEAN                          bLocked = FALSE;
+    BOOLEAN                          bClose = FALSE;
+
+    dwError = VmRESTLockMutex(pSocket->pMutex);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    bLocked = TRUE;
+
+    dwError = VmSockPosixFlushOutput(
+                  pRESTHandle,
+                  pSocket
+                  );
+
+    if (pSocket->bWriterParked)
+    {
+        /**** Writer waits on another thread, it carries on below high water or takes the error ****/
+        if ((dwError == REST_ENGINE_SUCCESS) &&
+            ((pSocket->nOutData - pSocket->nOutSent) > VmSockPosixOutputHighWater(pRESTHandle)))
+        {
+            dwError = VmSockPosixReArmSocket(
+                          pRESTHandle,
+                          pSocket
+                          );
+            if (dwError == REST_ENGINE_SUCCESS)
+            {
+                goto cleanup;
+            }
+        }
+
+        VmSockPosixWakeWriter(pSocket, dwError);
+        dwError = REST_ENGINE_SUCCESS;
+        goto cleanup;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    bClose = (!VmSockPosixHasPendingOutput(pSocket) && pSocket->bCloseOnFlush);
+
+    VmRESTUnlockMutex(pSocket->pMutex);
+    bLocked = FALSE;
+
+    if (bClose)
+    {
+        /**** Response fully sent on a connection its owner already closed ****/
+        VMREST_LOG_DEBUG(pRESTHandle,"Output drained on socket fd %d, closing", pSocket->fd);
+        VmSockPosixDiscardOutput(pSocket);
+        VmSockPosixCloseSocket(pRESTHandle,pSocket);
+        VmSockPosixReleaseSocket(pRESTHandle,pSocket);
+    }
+    else
+    {
+        /**** Keep draining, or go back to reading once the response is out ****/
+        dwError = VmSockPosixReArmSocket(
+                      pRESTHandle,
+                      pSocket
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+cleanup:
+
+    if (bLocked)
+    {
+        VmRESTUnlockMutex(pSocket->pMutex);
+    }
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+static
+void
+VmSockPosixCreateIOThreadKey(
+    void
+    )
+{
+    pthread_key_create(&gIOThreadKey, NULL);
+}
+
+static
+BOOLEAN
+VmSockPosixCanParkWriter(
+    void
+    )
+{
+    pthread_once(&gIOThreadOnce, VmSockPosixCreateIOThreadKey);
+
+    return (pthread_getspecific(gIOThreadKey) == NULL);
+}
+
+static
+uint32_t
+VmSockPosixOutputHighWater(
+    PVMREST_HANDLE                   pRESTHandle
+    )
+{
+    uint32_t                         nHalf = (pRESTHandle->pRESTConfig->maxOutputPerConnMB * 1024 * 1024) / 2;
+
+    return (nHalf < VM_SOCK_POSIX_OUTPUT_QUEUE_HIGH_WATER) ? nHalf : VM_SOCK_POSIX_OUTPUT_QUEUE_HIGH_WATER;
+}
+
+static
+DWORD
+VmSockPosixParkWriter(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+
+    if (!pSocket->pWriterCond)
+    {
+        dwError = VmRESTAllocateCondition(&pSocket->pWriterCond);
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    /**** Timer and EPOLLOUT belong to the worker owning the queue, it arms them when it takes the post ****/
+    pSocket->bWriterParked = TRUE;
+    pSocket->dwWriterError = REST_ENGINE_SUCCESS;
+
+    dwError = VmSockPosixPostToQueue(
+                  pRESTHandle,
+                  pSocket
+                  );
+    if (dwError != REST_ENGINE_SUCCESS)
+    {
+        pSocket->bWriterParked = FALSE;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    VMREST_LOG_DEBUG(pRESTHandle,"Writer parked on socket fd %d, %u bytes pending", pSocket->fd, (pSocket->nOutData - pSocket->nOutSent));
+
+    while (pSocket->bWriterParked)
+    {
+        VmRESTConditionWait(pSocket->pWriterCond, pSocket->pMutex);
+    }
+
+    dwError = pSocket->dwWriterError;
+    BAIL_ON_VMREST_ERROR(dwError);
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+static
+BOOLEAN
+VmSockPosixWakeWriter(
+    PVM_SOCKET                       pSocket,
+    DWORD                            dwError
+    )
+{
+    if (!pSocket->bWriterParked)
+    {
+        return FALSE;
+    }
+
+    /**** A failed connection keeps failing every later write of the response ****/
+    if (dwError != REST_ENGINE_SUCCESS)
+    {
+        VmSockPosixDiscardOutput(pSocket);
+        pSocket->bWriteFailed = TRUE;
+    }
+
+    pSocket->dwWriterError = dwError;
+    pSocket->bWriterParked = FALSE;
+    VmRESTConditionSignal(pSocket->pWriterCond);
+
+    return TRUE;
+}
+
+static
+BOOLEAN
+VmSockPosixWatchParkedWriter(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    BOOLEAN                          bParked = FALSE;
+
+    VmRESTLockMutex(pSocket->pMutex);
+
+    /**** Post came from a parked writer, not a finished request ****/
+    bParked = pSocket->bWriterParked;
+    if (bParked)
+    {
+        dwError = VmSockPosixReArmSocket(
+                      pRESTHandle,
+                      pSocket
+                      );
+        if (dwError != REST_ENGINE_SUCCESS)
+        {
+            VMREST_LOG_ERROR(pRESTHandle,"Unable to watch socket fd %d for a parked writer, dwError %u", pSocket->fd, dwError);
+            VmSockPosixWakeWriter(pSocket, dwError);
+        }
+    }
+
+    VmRESTUnlockMutex(pSocket->pMutex);
+
+    return bParked;
+}
+
+static
+BOOLEAN
+VmSockPosixFailParkedWriter(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket
+    )
+{
+    BOOLEAN                          bParked = FALSE;
+
+    VmRESTLockMutex(pSocket->pMutex);
+
+    bParked = VmSockPosixWakeWriter(pSocket, VMREST_TRANSPORT_SOCK_WRITE_FAILED);
+
+    VmRESTUnlockMutex(pSocket->pMutex);
+
+    if (bParked)
+    {
+        VMREST_LOG_INFO(pRESTHandle,"Peer of socket fd %d stopped reading, failing the parked writer", pSocket->fd);
+        VmSockPosixDisarmTimer(
+            pRESTHandle,
+            pSocket
+            );
+    }
+
+    return bParked;
+}
+
+static
+int
+VmSockPosixTLSAccept(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    uint32_t*                        pErrorCode
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    int                              ret = 0;
+    uint32_t                         errorCode = 0;
+    ssize_t                          nRead = 0;
+
+    /**** Ciphertext passes through the connection's read buffer on its way into the BIO ****/
+    dwError = VmSockPosixReserveReadBuffer(
+                  &pSocket->pEventQueue->readBufPool,
+                  pSocket,
+                  VM_SOCK_POSIX_READ_MIN_SPACE,
+                  VM_SOCK_POSIX_READ_BUFFER_SIZE
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    for (;;)
+    {
+        ret = SSL_accept(pSocket->ssl);
+        errorCode = SSL_get_error(pSocket->ssl, ret);
+        if ((ret != -1) || (errorCode != SSL_ERROR_WANT_READ))
+        {
+            break;
+        }
+
+        nRead = VmSockPosixTLSFill(
+                    pSocket,
+                    pSocket->pszBuffer,
+                    (pSocket->nBufSize - 1),
+                    TRUE
+                    );
+        if (nRead > 0)
+        {
+            continue;
+        }
+        if ((nRead == 0) || ((errno != EAGAIN) && (errno != EWOULDBLOCK)))
+        {
+            /**** Peer went away, or the socket failed, in the middle of the handshake ****/
+            ret = 0;
+            errorCode = SSL_ERROR_SYSCALL;
+        }
+        break;
+    }
+
+    /**** Our flight goes out, or the alert if the handshake failed ****/
+    dwError = VmSockPosixTLSFlush(
+                  pRESTHandle,
+                  pSocket
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+cleanup:
+
+    VmSockPosixReleaseReadBuffer(
+        &pSocket->pEventQueue->readBufPool,
+        pSocket
+        );
+
+    *pErrorCode = errorCode;
+
+    return ret;
+
+error:
+
+    ret = 0;
+    errorCode = SSL_ERROR_SYSCALL;
+
+    goto cleanup;
+}
+
+static
+int
+VmSockPosixTLSRead(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    char*                            pszBuffer,
+    uint32_t                         nSpace,
+    uint32_t*                        pErrorCode
+    )
+{
+    int                              nRead = 0;
+    uint32_t                         errorCode = 0;
+    ssize_t                          nFill = 0;
+
+    for (;;)
+    {
+        nRead = SSL_read(pSocket->ssl, pszBuffer, nSpace);
+        errorCode = SSL_get_error(pSocket->ssl, nRead);
+        if ((nRead > 0) || (errorCode != SSL_ERROR_WANT_READ))
+        {
+            break;
+        }
+
+        /**** Free space takes the ciphertext first, SSL_read then decrypts over it ****/
+        nFill = VmSockPosixTLSFill(
+                    pSocket,
+                    pszBuffer,
+                    nSpace,
+                    FALSE
+                    );
+        if (nFill > 0)
+        {
+            continue;
+        }
+        if (nFill == 0)
+        {
+            nRead = 0;
+            errorCode = SSL_ERROR_ZERO_RETURN;
+        }
+        else if ((errno != EAGAIN) && (errno != EWOULDBLOCK))
+        {
+            nRead = -1;
+            errorCode = SSL_ERROR_SYSCALL;
+        }
+        break;
+    }
+
+    /**** Reading can make records too, alerts and key update replies ****/
+    if ((BIO_ctrl_pending(SSL_get_wbio(pSocket->ssl)) > 0) &&
+        (VmSockPosixTLSFlush(pRESTHandle, pSocket) != REST_ENGINE_SUCCESS))
+    {
+        nRead = -1;
+        errorCode = SSL_ERROR_SYSCALL;
+    }
+
+    *pErrorCode = errorCode;
+
+    return nRead;
+}
+
+static
+ssize_t
+VmSockPosixTLSFill(
+    PVM_SOCKET                       pSocket,
+    char*                            pszBuffer,
+    uint32_t                         nSpace,
+    BOOLEAN                          bOneRecord
+    )
+{
+    ssize_t                          nRead = 0;
+    uint32_t                         nWant = nSpace;
+    BOOLEAN                          bHeader = FALSE;
+
+    /**** During the handshake nothing past the current record is taken, a request sent behind it wakes EPOLLIN ****/
+    if (bOneRecord && (pSocket->nTLSRecordLeft == 0))
+    {
+        bHeader = TRUE;
+        pszBuffer = (char*)(pSocket->tlsHeader + pSocket->nTLSHeader);
+        nWant = VM_SOCK_POSIX_TLS_HEADER_LEN - pSocket->nTLSHeader;
+    }
+    else if (bOneRecord && (pSocket->nTLSRecordLeft < nSpace))
+    {
+        nWant = pSocket->nTLSRecordLeft;
+    }
+
+    do
+    {
+        nRead = read(pSocket->fd, pszBuffer, nWant);
+    } while ((nRead < 0) && (errno == EINTR));
+
+    if (nRead > 0)
+    {
+        if (BIO_write(SSL_get_rbio(pSocket->ssl), pszBuffer, (int)nRead) != (int)nRead)
+        {
+            errno = ENOMEM;
+            nRead = -1;
+        }
+        else if (bHeader)
+        {
+            pSocket->nTLSHeader += nRead;
+            if (pSocket->nTLSHeader == VM_SOCK_POSIX_TLS_HEADER_LEN)
+            {
+                pSocket->nTLSRecordLeft = ((uint32_t)pSocket->tlsHeader[3] << 8) | pSocket->tlsHeader[4];
+                pSocket->nTLSHeader = 0;
+            }
+        }
+        else if (bOneRecord)
+        {
+            pSocket->nTLSRecordLeft -= nRead;
+        }
+    }
+
+    return nRead;
+}
+
+static
+DWORD
+VmSockPosixTLSSend(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    PVM_SOCK_IO_VEC                  pVec,
+    uint32_t                         nVec,
+    uint32_t*                        pnWritten
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    uint64_t                         nowUSec = 0;
+    uint32_t                         nWrittenTotal = 0;
+    uint32_t                         nRecord = 0;
+    uint32_t                         nChunk = 0;
+    uint32_t                         nStaged = 0;
+    uint32_t                         nOffset = 0;
+    uint32_t                         iVec = 0;
+    char*                            pszStage = NULL;
+
+    /**** After a pause the congestion window is small again, so are the records ****/
+    nowUSec = VmSockPosixGetTimeUSec();
+    if ((nowUSec - pSocket->lastTLSSendUSec) > VM_SOCK_POSIX_TLS_IDLE_RESET_USEC)
+    {
+        pSocket->nTLSSent = 0;
+    }
+    pSocket->lastTLSSendUSec = nowUSec;
+
+    while (iVec < nVec)
+    {
+        if (nOffset == pVec[iVec].nBytes)
+        {
+            iVec++;
+            nOffset = 0;
+            continue;
+        }
+
+        /**** Large writes go out as they are encrypted, the queue bounds them instead of the BIO ****/
+        if ((nStaged == 0) && (BIO_ctrl_pending(SSL_get_wbio(pSocket->ssl)) >= VmSockPosixOutputHighWater(pRESTHandle)))
+        {
+            dwError = VmSockPosixTLSFlush(
+                          pRESTHandle,
+                          pSocket
+                          );
+            BAIL_ON_VMREST_ERROR(dwError);
+
+            pszStage = NULL;
+        }
+
+        /**** Records fit one segment until the connection is warmed up, then carry 16 KB ****/
+        nRecord = (pSocket->nTLSSent < VM_SOCK_POSIX_TLS_RAMP_BYTES) ? VM_SOCK_POSIX_TLS_SMALL_RECORD_SIZE : VM_SOCK_POSIX_TLS_MAX_RECORD_SIZE;
+        nChunk = pVec[iVec].nBytes - nOffset;
+
+        if ((nStaged == 0) && ((nChunk >= nRecord) || (iVec == (nVec - 1))))
+        {
+            nChunk = (nChunk > nRecord) ? nRecord : nChunk;
+
+            dwError = VmSockPosixTLSSendRecord(
+                          pRESTHandle,
+                          pSocket,
+                          (pVec[iVec].pBuffer + nOffset),
+                          nChunk
+                          );
+            BAIL_ON_VMREST_ERROR(dwError);
+
+            nOffset += nChunk;
+            nWrittenTotal += nChunk;
+            continue;
+        }
+
+        /**** Pieces of several small buffers share a record, staged in the free tail of the output queue ****/
+        if (!pszStage)
+        {
+            dwError = VmSockPosixReserveOutput(
+                          pRESTHandle,
+                          pSocket,
+                          VM_SOCK_POSIX_TLS_MAX_RECORD_SIZE
+                          );
+            BAIL_ON_VMREST_ERROR(dwError);
+
+            pszStage = pSocket->pszOutBuf + pSocket->nOutData;
+        }
+
+        nChunk = (nChunk > (nRecord - nStaged)) ? (nRecord - nStaged) : nChunk;
+        memcpy((pszStage + nStaged), (pVec[iVec].pBuffer + nOffset), nChunk);
+        nStaged += nChunk;
+        nOffset += nChunk;
+
+        if (nStaged == nRecord)
+        {
+            dwError = VmSockPosixTLSSendRecord(
+                          pRESTHandle,
+                          pSocket,
+                          pszStage,
+                          nStaged
+                          );
+            BAIL_ON_VMREST_ERROR(dwError);
+
+            nWrittenTotal += nStaged;
+            nStaged = 0;
+        }
+    }
+
+    if (nStaged > 0)
+    {
+        dwError = VmSockPosixTLSSendRecord(
+                      pRESTHandle,
+                      pSocket,
+                      pszStage,
+                      nStaged
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        nWrittenTotal += nStaged;
+    }
+
+    dwError = VmSockPosixTLSFlush(
+                  pRESTHandle,
+                  pSocket
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+cleanup:
+
+    *pnWritten = nWrittenTotal;
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+static
+DWORD
+VmSockPosixTLSSendRecord(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    char*                            pszBuffer,
+    uint32_t                         nBufLen
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    int                              ret = 0;
+    uint32_t                         errorCode = 0;
+
+    /**** Memory BIO never pushes back, a short write is an error ****/
+    ret = SSL_write(pSocket->ssl, pszBuffer, (int)nBufLen);
+    if (ret != (int)nBufLen)
+    {
+        errorCode = SSL_get_error(pSocket->ssl, ret);
+        VMREST_LOG_ERROR(pRESTHandle,"TLS record of %u bytes failed on socket fd %d, ret %d, errorCode %u", nBufLen, pSocket->fd, ret, errorCode);
+        dwError = VMREST_TRANSPORT_SSL_ERROR;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    pSocket->nTLSSent += nBufLen;
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+static
+DWORD
+VmSockPosixTLSFlush(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    BIO*                             pBio = SSL_get_wbio(pSocket->ssl);
+    char*                            pData = NULL;
+    long                             nData = 0;
+    VM_SOCK_IO_VEC                   vec[2];
+    uint32_t                         nVec = 0;
+    uint32_t                         nPending = pSocket->nOutData - pSocket->nOutSent;
+    uint32_t                         nWritten = 0;
+
+    nData = BIO_get_mem_data(pBio, &pData);
+    if (nData <= 0)
+    {
+        goto cleanup;
+    }
+
+    /**** Records still queued go first, old and new leave in one writev ****/
+    if (nPending > 0)
+    {
+        vec[nVec].pBuffer = pSocket->pszOutBuf + pSocket->nOutSent;
+        vec[nVec].nBytes = nPending;
+        nVec++;
+    }
+    vec[nVec].pBuffer = pData;
+    vec[nVec].nBytes = (uint32_t)nData;
+    nVec++;
+
+    dwError = VmSockPosixSendDataVec(
+                  pRESTHandle,
+                  pSocket,
+                  vec,
+                  nVec,
+                  &nWritten
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    if (nWritten < nPending)
+    {
+        pSocket->nOutSent += nWritten;
+        nWritten = 0;
+    }
+    else if (nPending > 0)
+    {
+        nWritten -= nPending;
+        pSocket->nOutSent = 0;
+        pSocket->nOutData = 0;
+    }
+
+    /**** Peer is not keeping up, the rest is flushed from the event loop on EPOLLOUT ****/
+    if (nWritten < (uint32_t)nData)
+    {
+        dwError = VmSockPosixQueueOutput(
+                      pRESTHandle,
+                      pSocket,
+                      (pData + nWritten),
+                      ((uint32_t)nData - nWritten)
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+cleanup:
+
+    BIO_reset(pBio);
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
@@ -0,0 +1,826 @@
+/* C-REST-Engine
+*
+* Copyright (c) 2017 VMware, Inc. All Rights Reserved.
+*
+* This product is licensed to you under the Apache 2.0 license (the "License").
+* You may not use this product except in compliance with the Apache 2.0 License.
+*
+* This product may include a number of subcomponents with separate copyright
+* notices and license terms. Your use of these subcomponents is subject to the
+* terms and conditions of the subcomponent's license, as noted in the LICENSE file.
+*
+*/
+
+/**** TLS session resumption, session cache and rotating session ticket keys of each SSL context ****/
+
+#include "includes.h"
+
+#define VM_SSL_SESSION_ID_CONTEXT        "c-rest-engine"
+
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+typedef const unsigned char              VM_SSL_SESSION_ID_DATA;
+#else
+typedef unsigned char                    VM_SSL_SESSION_ID_DATA;
+#endif
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+typedef EVP_MAC_CTX                      VM_SSL_TICKET_MAC_CTX;
+#else
+typedef HMAC_CTX                         VM_SSL_TICKET_MAC_CTX;
+#endif
+
+static pthread_once_t                    gSSLSessionOnce = PTHREAD_ONCE_INIT;
+static int                               gSSLSessionIndex = -1;
+
+static
+void
+VmRESTSSLSessionCreateIndex(
+    void
+    );
+
+static
+PVM_SSL_SESSION_CACHE
+VmRESTSSLSessionGetCache(
+    SSL_CTX*                         pContext
+    );
+
+static
+void
+VmRESTSSLSessionFree(
+    PVM_SSL_SESSION_CACHE            pCache
+    );
+
+static
+int
+VmRESTSSLSessionNew(
+    SSL*                             pSSL,
+    SSL_SESSION*                     pSession
+    );
+
+static
+SSL_SESSION*
+VmRESTSSLSessionGet(
+    SSL*                             pSSL,
+    VM_SSL_SESSION_ID_DATA*          pId,
+    int                              nId,
+    int*                             pCopy
+    );
+
+static
+void
+VmRESTSSLSessionRemove(
+    SSL_CTX*                         pContext,
+    SSL_SESSION*                     pSession
+    );
+
+static
+int
+VmRESTSSLTicketKeyCallback(
+    SSL*                             pSSL,
+    unsigned char*                   pKeyName,
+    unsigned char*                   pIV,
+    EVP_CIPHER_CTX*                  pCipherCtx,
+    VM_SSL_TICKET_MAC_CTX*           pMacCtx,
+    int                              enc
+    );
+
+static
+uint32_t
+VmRESTSSLTicketKeyRotate(
+    PVM_SSL_SESSION_CACHE            pCache,
+    uint64_t                         now
+    );
+
+static
+PVM_SSL_SESSION_ENTRY
+VmRESTSSLSessionFind(
+    PVM_SSL_SESSION_SHARD            pShard,
+    uint32_t                         hash,
+    const unsigned char*             pId,
+    uint32_t                         nId
+    );
+
+static
+void
+VmRESTSSLSessionLink(
+    PVM_SSL_SESSION_SHARD            pShard,
+    PVM_SSL_SESSION_ENTRY            pEntry
+    );
+
+static
+void
+VmRESTSSLSessionUnlink(
+    PVM_SSL_SESSION_SHARD            pShard,
+    PVM_SSL_SESSION_ENTRY            pEntry
+    );
+
+static
+uint32_t
+VmRESTSSLSessionHash(
+    const unsigned char*             pId,
+    uint32_t                         nId
+    );
+
+static
+uint64_t
+VmRESTSSLSessionNow(
+    void
+    );
+
+uint32_t
+VmRESTSSLSessionInit(
+    PVMREST_HANDLE                   pRESTHandle,
+    SSL_CTX*                         pContext
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    PVM_SSL_SESSION_CACHE            pCache = NULL;
+    uint32_t                         nCacheSize = 0;
+    uint32_t                         i = 0;
+
+    if (!pRESTHandle || !pRESTHandle->pRESTConfig || !pContext)
+    {
+        dwError = VMREST_TRANSPORT_INVALID_PARAM;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    pthread_once(&gSSLSessionOnce, VmRESTSSLSessionCreateIndex);
+    if (gSSLSessionIndex < 0)
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"%s","Cannot get SSL context data index for the session cache");
+        dwError = VMREST_TRANSPORT_SSL_CONFIG_ERROR;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    nCacheSize = pRESTHandle->pRESTConfig->nSSLSessionCacheSize;
+
+    dwError = VmRESTAllocateMemory(
+                  sizeof(VM_SSL_SESSION_CACHE),
+                  (void**)&pCache
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    pCache->timeoutSec = pRESTHandle->pRESTConfig->SSLSessionTimeoutSec;
+    pCache->ticketRotateSec = pRESTHandle->pRESTConfig->SSLTicketKeyRotateSec;
+
+    dwError = VmRESTAllocateMutex(
+                  &pCache->pTicketMutex
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTSSLTicketKeyRotate(
+                  pCache,
+                  VmRESTSSLSessionNow()
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    /**** Shards are only needed when the engine keeps the sessions ****/
+    if (nCacheSize > 0)
+    {
+        dwError = VmRESTAllocateMemory(
+                      sizeof(VM_SSL_SESSION_SHARD) * VMREST_SSL_SESSION_CACHE_SHARDS,
+                      (void**)&pCache->pShards
+                      );
+        BAIL_ON_VMREST_ERROR(dwError);
+
+        for (i = 0; i < VMREST_SSL_SESSION_CACHE_SHARDS; i++)
+        {
+            dwError = VmRESTAllocateMutex(
+                          &pCache->pShards[i].pMutex
+                          );
+            BAIL_ON_VMREST_ERROR(dwError);
+        }
+
+        pCache->nShardEntries = (nCacheSize + VMREST_SSL_SESSION_CACHE_SHARDS - 1) / VMREST_SSL_SESSION_CACHE_SHARDS;
+    }
+
+    if (!SSL_CTX_set_session_id_context(
+             pContext,
+             (const unsigned char*)VM_SSL_SESSION_ID_CONTEXT,
+             sizeof(VM_SSL_SESSION_ID_CONTEXT) - 1))
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"%s","Cannot set SSL session id context");
+        dwError = VMREST_TRANSPORT_SSL_CONFIG_ERROR;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    SSL_CTX_set_timeout(pContext, pCache->timeoutSec);
+
+    /**** Callbacks find the cache through the context, so instances never share one ****/
+    if (!SSL_CTX_set_ex_data(pContext, gSSLSessionIndex, pCache))
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"%s","Cannot attach session cache to SSL context");
+        dwError = VMREST_TRANSPORT_SSL_CONFIG_ERROR;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    if (pCache->pShards)
+    {
+        SSL_CTX_set_session_cache_mode(pContext, SSL_SESS_CACHE_SERVER | SSL_SESS_CACHE_NO_INTERNAL);
+        SSL_CTX_sess_set_new_cb(pContext, VmRESTSSLSessionNew);
+        SSL_CTX_sess_set_get_cb(pContext, VmRESTSSLSessionGet);
+        SSL_CTX_sess_set_remove_cb(pContext, VmRESTSSLSessionRemove);
+    }
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    SSL_CTX_set_tlsext_ticket_key_evp_cb(pContext, VmRESTSSLTicketKeyCallback);
+#else
+    SSL_CTX_set_tlsext_ticket_key_cb(pContext, VmRESTSSLTicketKeyCallback);
+#endif
+
+    VMREST_LOG_DEBUG(pRESTHandle,"SSL sessions: cache %u, timeout %u sec, ticket keys rotate every %u sec", nCacheSize, pCache->timeoutSec, pCache->ticketRotateSec);
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    if (pCache)
+    {
+        VmRESTSSLSessionFree(pCache);
+    }
+
+    goto cleanup;
+}
+
+void
+VmRESTSSLSessionShutdown(
+    SSL_CTX*                         pContext
+    )
+{
+    PVM_SSL_SESSION_CACHE            pCache = NULL;
+
+    if (!pContext)
+    {
+        return;
+    }
+
+    pCache = VmRESTSSLSessionGetCache(pContext);
+    if (pCache)
+    {
+        SSL_CTX_set_ex_data(pContext, gSSLSessionIndex, NULL);
+        VmRESTSSLSessionFree(pCache);
+    }
+}
+
+static
+void
+VmRESTSSLSessionCreateIndex(
+    void
+    )
+{
+    gSSLSessionIndex = SSL_CTX_get_ex_new_index(0, NULL, NULL, NULL, NULL);
+}
+
+static
+PVM_SSL_SESSION_CACHE
+VmRESTSSLSessionGetCache(
+    SSL_CTX*                         pContext
+    )
+{
+    if (!pContext || (gSSLSessionIndex < 0))
+    {
+        return NULL;
+    }
+
+    return (PVM_SSL_SESSION_CACHE)SSL_CTX_get_ex_data(pContext, gSSLSessionIndex);
+}
+
+static
+void
+VmRESTSSLSessionFree(
+    PVM_SSL_SESSION_CACHE            pCache
+    )
+{
+    PVM_SSL_SESSION_SHARD            pShard = NULL;
+    PVM_SSL_SESSION_ENTRY            pEntry = NULL;
+    uint32_t                         i = 0;
+
+    if (pCache->pShards)
+    {
+        for (i = 0; i < VMREST_SSL_SESSION_CACHE_SHARDS; i++)
+        {
+            pShard = &pCache->pShards[i];
+
+            while (pShard->pLRUHead != NULL)
+            {
+                pEntry = pShard->pLRUHead;
+                pShard->pLRUHead = pEntry->pNextLRU;
+                VmRESTFreeMemory(pEntry);
+            }
+
+            if (pShard->pMutex)
+            {
+                VmRESTFreeMutex(pShard->pMutex);
+            }
+        }
+
+        VmRESTFreeMemory(pCache->pShards);
+    }
+
+    if (pCache->pTicketMutex)
+    {
+        VmRESTFreeMutex(pCache->pTicketMutex);
+    }
+
+    OPENSSL_cleanse(pCache->ticketKeys, sizeof(pCache->ticketKeys));
+    VmRESTFreeMemory(pCache);
+}
+
+static
+int
+VmRESTSSLSessionNew(
+    SSL*                             pSSL,
+    SSL_SESSION*                     pSession
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    PVM_SSL_SESSION_CACHE            pCache = VmRESTSSLSessionGetCache(SSL_get_SSL_CTX(pSSL));
+    PVM_SSL_SESSION_SHARD            pShard = NULL;
+    PVM_SSL_SESSION_ENTRY            pEntry = NULL;
+    PVM_SSL_SESSION_ENTRY            pOld = NULL;
+    const unsigned char*             pId = NULL;
+    unsigned int                     nId = 0;
+    unsigned char*                   pData = NULL;
+    int                              nData = 0;
+
+    if (!pCache || !pCache->pShards)
+    {
+        goto cleanup;
+    }
+
+    pId = SSL_SESSION_get_id(pSession, &nId);
+    if ((nId == 0) || (nId > SSL_MAX_SSL_SESSION_ID_LENGTH))
+    {
+        goto cleanup;
+    }
+
+    /**** Sessions are kept serialized, the entry owns no OpenSSL object ****/
+    nData = i2d_SSL_SESSION(pSession, NULL);
+    if (nData <= 0)
+    {
+        goto cleanup;
+    }
+
+    dwError = VmRESTAllocateMemory(
+                  sizeof(VM_SSL_SESSION_ENTRY) + nData,
+                  (void**)&pEntry
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    pEntry->pData = (unsigned char*)(pEntry + 1);
+    pData = pEntry->pData;
+    if (i2d_SSL_SESSION(pSession, &pData) != nData)
+    {
+        goto error;
+    }
+
+    memcpy(pEntry->id, pId, nId);
+    pEntry->nId = nId;
+    pEntry->nData = nData;
+    pEntry->hash = VmRESTSSLSessionHash(pId, nId);
+    pEntry->expiry = VmRESTSSLSessionNow() + SSL_SESSION_get_timeout(pSession);
+
+    pShard = &pCache->pShards[pEntry->hash % VMREST_SSL_SESSION_CACHE_SHARDS];
+
+    VmRESTLockMutex(pShard->pMutex);
+
+    pOld = VmRESTSSLSessionFind(pShard, pEntry->hash, pId, nId);
+    if (pOld)
+    {
+        VmRESTSSLSessionUnlink(pShard, pOld);
+        VmRESTFreeMemory(pOld);
+    }
+
+    /**** Least recently used sessions make room ****/
+    while ((pShard->nEntries >= pCache->nShardEntries) && pShard->pLRUTail)
+    {
+        pOld = pShard->pLRUTail;
+        VmRESTSSLSessionUnlink(pShard, pOld);
+        VmRESTFreeMemory(pOld);
+    }
+
+    VmRESTSSLSessionLink(pShard, pEntry);
+    pEntry = NULL;
+
+    VmRESTUnlockMutex(pShard->pMutex);
+
+cleanup:
+
+    /**** No reference to pSession is kept ****/
+    return 0;
+
+error:
+
+    if (pEntry)
+    {
+        VmRESTFreeMemory(pEntry);
+    }
+
+    goto cleanup;
+}
+
+static
+SSL_SESSION*
+VmRESTSSLSessionGet(
+    SSL*                             pSSL,
+    VM_SSL_SESSION_ID_DATA*          pId,
+    int                              nId,
+    int*                             pCopy
+    )
+{
+    PVM_SSL_SESSION_CACHE            pCache = VmRESTSSLSessionGetCache(SSL_get_SSL_CTX(pSSL));
+    PVM_SSL_SESSION_SHARD            pShard = NULL;
+    PVM_SSL_SESSION_ENTRY            pEntry = NULL;
+    PVMREST_HANDLE                   pRESTHandle = NULL;
+    SSL_SESSION*                     pSession = NULL;
+    const unsigned char*             pData = NULL;
+    uint32_t                         hash = 0;
+
+    *pCopy = 0;
+
+    if (!pCache || !pCache->pShards || (nId <= 0) || (nId > SSL_MAX_SSL_SESSION_ID_LENGTH))
+    {
+        goto cleanup;
+    }
+
+    hash = VmRESTSSLSessionHash(pId, nId);
+    pShard = &pCache->pShards[hash % VMREST_SSL_SESSION_CACHE_SHARDS];
+
+    VmRESTLockMutex(pShard->pMutex);
+
+    pEntry = VmRESTSSLSessionFind(pShard, hash, pId, nId);
+    if (pEntry && (pEntry->expiry <= VmRESTSSLSessionNow()))
+    {
+        VmRESTSSLSessionUnlink(pShard, pEntry);
+        VmRESTFreeMemory(pEntry);
+        pEntry = NULL;
+    }
+
+    if (pEntry)
+    {
+        /**** Most recently used first ****/
+        VmRESTSSLSessionUnlink(pShard, pEntry);
+        VmRESTSSLSessionLink(pShard, pEntry);
+
+        pData = pEntry->pData;
+        pSession = d2i_SSL_SESSION(NULL, &pData, pEntry->nData);
+    }
+
+    VmRESTUnlockMutex(pShard->pMutex);
+
+cleanup:
+
+    pRESTHandle = (PVMREST_HANDLE)SSL_get_app_data(pSSL);
+    if (pRESTHandle && pRESTHandle->pSSLInfo)
+    {
+        if (pSession)
+        {
+            __atomic_add_fetch(&pRESTHandle->pSSLInfo->nSessionCacheHits, 1, __ATOMIC_RELAXED);
+        }
+        else
+        {
+            __atomic_add_fetch(&pRESTHandle->pSSLInfo->nSessionCacheMisses, 1, __ATOMIC_RELAXED);
+        }
+    }
+
+    return pSession;
+}
+
+static
+void
+VmRESTSSLSessionRemove(
+    SSL_CTX*                         pContext,
+    SSL_SESSION*                     pSession
+    )
+{
+    PVM_SSL_SESSION_CACHE            pCache = VmRESTSSLSessionGetCache(pContext);
+    PVM_SSL_SESSION_SHARD            pShard = NULL;
+    PVM_SSL_SESSION_ENTRY            pEntry = NULL;
+    const unsigned char*             pId = NULL;
+    unsigned int                     nId = 0;
+    uint32_t                         hash = 0;
+
+    if (!pCache || !pCache->pShards)
+    {
+        return;
+    }
+
+    pId = SSL_SESSION_get_id(pSession, &nId);
+    if ((nId == 0) || (nId > SSL_MAX_SSL_SESSION_ID_LENGTH))
+    {
+        return;
+    }
+
+    hash = VmRESTSSLSessionHash(pId, nId);
+    pShard = &pCache->pShards[hash % VMREST_SSL_SESSION_CACHE_SHARDS];
+
+    VmRESTLockMutex(pShard->pMutex);
+
+    pEntry = VmRESTSSLSessionFind(pShard, hash, pId, nId);
+    if (pEntry)
+    {
+        VmRESTSSLSessionUnlink(pShard, pEntry);
+        VmRESTFreeMemory(pEntry);
+    }
+
+    VmRESTUnlockMutex(pShard->pMutex);
+}
+
+static
+int
+VmRESTSSLTicketKeyCallback(
+    SSL*                             pSSL,
+    unsigned char*                   pKeyName,
+    unsigned char*                   pIV,
+    EVP_CIPHER_CTX*                  pCipherCtx,
+    VM_SSL_TICKET_MAC_CTX*           pMacCtx,
+    int                              enc
+    )
+{
+    PVM_SSL_SESSION_CACHE            pCache = VmRESTSSLSessionGetCache(SSL_get_SSL_CTX(pSSL));
+    PVM_SSL_TICKET_KEY               pKey = NULL;
+    VM_SSL_TICKET_KEY                key = {{0}};
+    uint64_t                         now = 0;
+    uint32_t                         i = 0;
+    uint32_t                         iKey = 0;
+    int                              ret = -1;
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    OSSL_PARAM                       params[3];
+#endif
+
+    if (!pCache)
+    {
+        return -1;
+    }
+
+    now = VmRESTSSLSessionNow();
+
+    VmRESTLockMutex(pCache->pTicketMutex);
+
+    if (enc)
+    {
+        /**** New tickets are always sealed with the newest key ****/
+        if (now >= (pCache->ticketKeys[pCache->iTicketKey].created + pCache->ticketRotateSec))
+        {
+            VmRESTSSLTicketKeyRotate(pCache, now);
+        }
+        key = pCache->ticketKeys[pCache->iTicketKey];
+        ret = 1;
+    }
+    else
+    {
+        ret = 0;
+        for (i = 0; i < pCache->nTicketKeys; i++)
+        {
+            iKey = (pCache->iTicketKey + VMREST_SSL_TICKET_KEYS - i) % VMREST_SSL_TICKET_KEYS;
+            pKey = &pCache->ticketKeys[iKey];
+
+            if (memcmp(pKey->name, pKeyName, VM_SOCK_POSIX_SSL_TICKET_NAME_LEN) != 0)
+            {
+                continue;
+            }
+
+            /**** A retired key opens tickets until they expire, the client gets a fresh one ****/
+            if (i == 0)
+            {
+                ret = 1;
+            }
+            else if ((now - pCache->ticketKeys[(iKey + 1) % VMREST_SSL_TICKET_KEYS].created) < pCache->timeoutSec)
+            {
+                ret = 2;
+            }
+
+            if (ret > 0)
+            {
+                key = *pKey;
+            }
+            break;
+        }
+    }
+
+    VmRESTUnlockMutex(pCache->pTicketMutex);
+
+    if (ret <= 0)
+    {
+        goto cleanup;
+    }
+
+    if (enc)
+    {
+        memcpy(pKeyName, key.name, VM_SOCK_POSIX_SSL_TICKET_NAME_LEN);
+
+        if ((RAND_bytes(pIV, EVP_CIPHER_iv_length(EVP_aes_256_cbc())) <= 0) ||
+            !EVP_EncryptInit_ex(pCipherCtx, EVP_aes_256_cbc(), NULL, key.aesKey, pIV))
+        {
+            ret = -1;
+            goto cleanup;
+        }
+    }
+    else if (!EVP_DecryptInit_ex(pCipherCtx, EVP_aes_256_cbc(), NULL, key.aesKey, pIV))
+    {
+        ret = -1;
+        goto cleanup;
+    }
+
+#if OPENSSL_VERSION_NUMBER >= 0x30000000L
+    params[0] = OSSL_PARAM_construct_octet_string(OSSL_MAC_PARAM_KEY, key.hmacKey, VM_SOCK_POSIX_SSL_TICKET_KEY_LEN);
+    params[1] = OSSL_PARAM_construct_utf8_string(OSSL_MAC_PARAM_DIGEST, "SHA256", 0);
+    params[2] = OSSL_PARAM_construct_end();
+
+    if (!EVP_MAC_CTX_set_params(pMacCtx, params))
+    {
+        ret = -1;
+    }
+#else
+    if (!HMAC_Init_ex(pMacCtx, key.hmacKey, VM_SOCK_POSIX_SSL_TICKET_KEY_LEN, EVP_sha256(), NULL))
+    {
+        ret = -1;
+    }
+#endif
+
+cleanup:
+
+    OPENSSL_cleanse(&key, sizeof(key));
+
+    return ret;
+}
+
+static
+uint32_t
+VmRESTSSLTicketKeyRotate(
+    PVM_SSL_SESSION_CACHE            pCache,
+    uint64_t                         now
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    VM_SSL_TICKET_KEY                key = {{0}};
+    uint32_t                         iKey = 0;
+
+    /**** Called with the ticket lock held, or before the context is in use ****/
+    if ((RAND_bytes(key.name, sizeof(key.name)) <= 0) ||
+        (RAND_bytes(key.aesKey, sizeof(key.aesKey)) <= 0) ||
+        (RAND_bytes(key.hmacKey, sizeof(key.hmacKey)) <= 0))
+    {
+        dwError = VMREST_TRANSPORT_SSL_ERROR;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    key.created = now;
+
+    if (pCache->nTicketKeys > 0)
+    {
+        iKey = (pCache->iTicketKey + 1) % VMREST_SSL_TICKET_KEYS;
+    }
+
+    pCache->ticketKeys[iKey] = key;
+    pCache->iTicketKey = iKey;
+    if (pCache->nTicketKeys < VMREST_SSL_TICKET_KEYS)
+    {
+        pCache->nTicketKeys++;
+    }
+
+cleanup:
+
+    OPENSSL_cleanse(&key, sizeof(key));
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+static
+PVM_SSL_SESSION_ENTRY
+VmRESTSSLSessionFind(
+    PVM_SSL_SESSION_SHARD            pShard,
+    uint32_t                         hash,
+    const unsigned char*             pId,
+    uint32_t                         nId
+    )
+{
+    PVM_SSL_SESSION_ENTRY            pEntry = NULL;
+
+    /**** Called with the shard lock held ****/
+    pEntry = pShard->pBuckets[(hash / VMREST_SSL_SESSION_CACHE_SHARDS) % VM_SOCK_POSIX_SSL_SESSION_BUCKETS];
+    while (pEntry != NULL)
+    {
+        if ((pEntry->hash == hash) && (pEntry->nId == nId) && (memcmp(pEntry->id, pId, nId) == 0))
+        {
+            break;
+        }
+        pEntry = pEntry->pNextHash;
+    }
+
+    return pEntry;
+}
+
+static
+void
+VmRESTSSLSessionLink(
+    PVM_SSL_SESSION_SHARD            pShard,
+    PVM_SSL_SESSION_ENTRY            pEntry
+    )
+{
+    PVM_SSL_SESSION_ENTRY*           ppBucket = NULL;
+
+    /**** Called with the shard lock held ****/
+    ppBucket = &pShard->pBuckets[(pEntry->hash / VMREST_SSL_SESSION_CACHE_SHARDS) % VM_SOCK_POSIX_SSL_SESSION_BUCKETS];
+    pEntry->pNextHash = *ppBucket;
+    *ppBucket = pEntry;
+
+    pEntry->pPrevLRU = NULL;
+    pEntry->pNextLRU = pShard->pLRUHead;
+    if (pShard->pLRUHead)
+    {
+        pShard->pLRUHead->pPrevLRU = pEntry;
+    }
+    else
+    {
+        pShard->pLRUTail = pEntry;
+    }
+    pShard->pLRUHead = pEntry;
+
+    pShard->nEntries++;
+}
+
+static
+void
+VmRESTSSLSessionUnlink(
+    PVM_SSL_SESSION_SHARD            pShard,
+    PVM_SSL_SESSION_ENTRY            pEntry
+    )
+{
+    PVM_SSL_SESSION_ENTRY*           ppNode = NULL;
+
+    /**** Called with the shard lock held, the caller frees the entry ****/
+    ppNode = &pShard->pBuckets[(pEntry->hash / VMREST_SSL_SESSION_CACHE_SHARDS) % VM_SOCK_POSIX_SSL_SESSION_BUCKETS];
+    while (*ppNode != NULL)
+    {
+        if (*ppNode == pEntry)
+        {
+            *ppNode = pEntry->pNextHash;
+            break;
+        }
+        ppNode = &(*ppNode)->pNextHash;
+    }
+
+    if (pEntry->pPrevLRU)
+    {
+        pEntry->pPrevLRU->pNextLRU = pEntry->pNextLRU;
+    }
+    else
+    {
+        pShard->pLRUHead = pEntry->pNextLRU;
+    }
+
+    if (pEntry->pNextLRU)
+    {
+        pEntry->pNextLRU->pPrevLRU = pEntry->pPrevLRU;
+    }
+    else
+    {
+        pShard->pLRUTail = pEntry->pPrevLRU;
+    }
+
+    pEntry->pNextHash = NULL;
+    pEntry->pPrevLRU = NULL;
+    pEntry->pNextLRU = NULL;
+
+    pShard->nEntries--;
+}
+
+static
+uint32_t
+VmRESTSSLSessionHash(
+    const unsigned char*             pId,
+    uint32_t                         nId
+    )
+{
+    uint32_t                         hash = 2166136261U;
+    uint32_t                         i = 0;
+
+    /**** FNV-1a ****/
+    for (i = 0; i < nId; i++)
+    {
+        hash ^= pId[i];
+        hash *= 16777619U;
+    }
+
+    return hash;
+}
+
+static
+uint64_t
+VmRESTSSLSessionNow(
+    void
+    )
+{
+    struct timespec                  ts = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return (uint64_t)ts.tv_sec;
+}
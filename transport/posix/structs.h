@@ -20,18 +20,139 @@ typedef struct _VM_SOCKET
     int                              fd;
     SSL*                             ssl;
     BOOLEAN                          bSSLHandShakeCompleted;
+    uint64_t                         handshakeStartUSec;
+    BOOLEAN                          bSSLMemoryBIO;
+    BOOLEAN                          bKTLSSend;
+    uint32_t                         nTLSHeader;
+    uint32_t                         nTLSRecordLeft;
+    unsigned char                    tlsHeader[VM_SOCK_POSIX_TLS_HEADER_LEN];
+    uint64_t                         nTLSSent;
+    uint64_t                         lastTLSSendUSec;
     BOOLEAN                          bTimerExpired;
     char*                            pszBuffer;
+    uint32_t                         nBufSize;
     uint32_t                         nBufData;
     uint32_t                         nProcessed;
     PREST_REQUEST                    pRequest;
-    struct _VM_SOCKET*               pIoSocket;
-    struct _VM_SOCKET*               pTimerSocket;
+    PVM_SOCK_EVENT_QUEUE             pEventQueue;
+    BOOLEAN                          bTimerArmed;
+    uint32_t                         timerSlot;
+    uint32_t                         timerRounds;
+    struct _VM_SOCKET*               pTimerNext;
+    struct _VM_SOCKET*               pTimerPrev;
+    char*                            pszOutBuf;
+    uint32_t                         nOutBufSize;
+    uint32_t                         nOutData;
+    uint32_t                         nOutSent;
+    BOOLEAN                          bCloseOnFlush;
+    PVMREST_COND                     pWriterCond;
+    BOOLEAN                          bWriterParked;
+    BOOLEAN                          bWriteFailed;
+    DWORD                            dwWriterError;
+    int                              outFileFd;
+    uint64_t                         outFileOffset;
+    uint64_t                         outFileRemaining;
+    BOOLEAN                          bPollArmed;
+    BOOLEAN                          bReleasePending;
+    uint8_t                          uringOp;
+    uint16_t                         uringBufId;
+    uint32_t                         nUringRecv;
+    BOOLEAN                          bUringSendDone;
+    uint32_t                         nUringSent;
+    struct _VM_SOCKET*               pCompletedNext;
 } VM_SOCKET;
 
+typedef struct _VM_SOCK_TIMER_WHEEL
+{
+    PVMREST_MUTEX                    pMutex;
+    PVM_SOCKET*                      pSlots;
+    uint32_t                         nSlots;
+    uint32_t                         iSlot;
+    uint32_t                         nArmed;
+    uint64_t                         nextTickMS;
+    PVM_SOCKET                       pExpired;
+} VM_SOCK_TIMER_WHEEL, *PVM_SOCK_TIMER_WHEEL;
+
+typedef struct _VM_SOCK_BUFFER_POOL
+{
+    PVMREST_MUTEX                    pMutex;
+    char**                           ppBuffers;
+    uint32_t                         nBuffers;
+    uint32_t                         nMaxBuffers;
+} VM_SOCK_BUFFER_POOL, *PVM_SOCK_BUFFER_POOL;
+
+typedef struct _VM_SOCK_URING
+{
+    PVMREST_MUTEX                    pMutex;
+    int                              ringFd;
+    PVOID                            pSqRing;
+    size_t                           sqRingSize;
+    PVOID                            pCqRing;
+    size_t                           cqRingSize;
+    PVOID                            pSqes;
+    size_t                           sqesSize;
+    uint32_t*                        pSqHead;
+    uint32_t*                        pSqTail;
+    uint32_t*                        pSqMask;
+    uint32_t*                        pSqEntries;
+    uint32_t*                        pSqArray;
+    uint32_t*                        pCqHead;
+    uint32_t*                        pCqTail;
+    uint32_t*                        pCqMask;
+    PVOID                            pCqes;
+    BOOLEAN                          bDataOps;
+    PVOID                            pBufRing;
+    size_t                           bufRingSize;
+    char*                            pRecvBufs;
+    uint16_t                         bufRingTail;
+} VM_SOCK_URING, *PVM_SOCK_URING;
+
+typedef struct _VM_SSL_SESSION_ENTRY
+{
+    uint32_t                         hash;
+    unsigned char                    id[SSL_MAX_SSL_SESSION_ID_LENGTH];
+    uint32_t                         nId;
+    uint64_t                         expiry;
+    unsigned char*                   pData;
+    uint32_t                         nData;
+    struct _VM_SSL_SESSION_ENTRY*    pNextHash;
+    struct _VM_SSL_SESSION_ENTRY*    pPrevLRU;
+    struct _VM_SSL_SESSION_ENTRY*    pNextLRU;
+} VM_SSL_SESSION_ENTRY, *PVM_SSL_SESSION_ENTRY;
+
+typedef struct _VM_SSL_SESSION_SHARD
+{
+    PVMREST_MUTEX                    pMutex;
+    PVM_SSL_SESSION_ENTRY            pBuckets[VM_SOCK_POSIX_SSL_SESSION_BUCKETS];
+    PVM_SSL_SESSION_ENTRY            pLRUHead;
+    PVM_SSL_SESSION_ENTRY            pLRUTail;
+    uint32_t                         nEntries;
+} VM_SSL_SESSION_SHARD, *PVM_SSL_SESSION_SHARD;
+
+typedef struct _VM_SSL_TICKET_KEY
+{
+    unsigned char                    name[VM_SOCK_POSIX_SSL_TICKET_NAME_LEN];
+    unsigned char                    aesKey[VM_SOCK_POSIX_SSL_TICKET_KEY_LEN];
+    unsigned char                    hmacKey[VM_SOCK_POSIX_SSL_TICKET_KEY_LEN];
+    uint64_t                         created;
+} VM_SSL_TICKET_KEY, *PVM_SSL_TICKET_KEY;
+
+typedef struct _VM_SSL_SESSION_CACHE
+{
+    PVM_SSL_SESSION_SHARD            pShards;
+    uint32_t                         nShardEntries;
+    uint32_t                         timeoutSec;
+    PVMREST_MUTEX                    pTicketMutex;
+    VM_SSL_TICKET_KEY                ticketKeys[VMREST_SSL_TICKET_KEYS];
+    uint32_t                         iTicketKey;
+    uint32_t                         nTicketKeys;
+    uint32_t                         ticketRotateSec;
+} VM_SSL_SESSION_CACHE, *PVM_SSL_SESSION_CACHE;
+
 typedef struct _VM_SOCK_EVENT_QUEUE
 {
     PVMREST_MUTEX                    pMutex;
+    BOOLEAN                          bExclusive;
     uint32_t                         bShutdown;
     PVM_SOCKET                       pSignalReader;
     PVM_SOCKET                       pSignalWriter;
@@ -42,4 +163,12 @@ typedef struct _VM_SOCK_EVENT_QUEUE
     int                              nReady;
     int                              iReady;
     uint32_t                         thrCnt;
+    VM_SOCK_TIMER_WHEEL              timerWheel;
+    VM_SOCK_BUFFER_POOL              readBufPool;
+    PVM_SOCK_URING                   pRing;
+    int*                             pAcceptFd;
+    PVM_SOCKET                       pCompletion;
+    PVMREST_MUTEX                    pCompletionMutex;
+    PVM_SOCKET                       pPosted;
+    PVM_SOCKET                       pCompleted;
 } VM_SOCK_EVENT_QUEUE;
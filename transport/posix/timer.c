@@ -0,0 +1,369 @@
+/* C-REST-Engine
+*
+* Copyright (c) 2017 VMware, Inc. All Rights Reserved.
+*
+* This product is licensed to you under the Apache 2.0 license (the "License").
+* You may not use this product except in compliance with the Apache 2.0 License.
+*
+* This product may include a number of subcomponents with separate copyright
+* notices and license terms. Your use of these subcomponents is subject to the
+* terms and conditions of the subcomponent's license, as noted in the LICENSE file.
+*
+*/
+
+/**** Hashed timing wheel for connection timeouts, one per event queue ****/
+
+#include "includes.h"
+
+static
+uint64_t
+VmSockPosixGetTimeMS(
+    void
+    );
+
+static
+void
+VmSockPosixLockTimerWheel(
+    PVM_SOCK_TIMER_WHEEL             pWheel
+    );
+
+static
+void
+VmSockPosixUnlockTimerWheel(
+    PVM_SOCK_TIMER_WHEEL             pWheel
+    );
+
+static
+void
+VmSockPosixTimerWheelUnlink(
+    PVM_SOCK_TIMER_WHEEL             pWheel,
+    PVM_SOCKET                       pSocket
+    );
+
+uint32_t
+VmSockPosixInitTimerWheel(
+    PVM_SOCK_TIMER_WHEEL             pWheel,
+    BOOLEAN                          bExclusive
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+
+    if (!pWheel)
+    {
+        dwError = ERROR_INVALID_PARAMETER;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTAllocateMemory(
+                  VM_SOCK_POSIX_TIMER_WHEEL_SLOTS * sizeof(*pWheel->pSlots),
+                  (PVOID*)&pWheel->pSlots
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    /**** Owner thread is the only user of an exclusive wheel ****/
+    if (!bExclusive)
+    {
+        dwError = VmRESTAllocateMutex(&pWheel->pMutex);
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    pWheel->nSlots = VM_SOCK_POSIX_TIMER_WHEEL_SLOTS;
+    pWheel->iSlot = 0;
+    pWheel->nArmed = 0;
+    pWheel->nextTickMS = 0;
+    pWheel->pExpired = NULL;
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    VmSockPosixFreeTimerWheel(pWheel);
+
+    goto cleanup;
+}
+
+void
+VmSockPosixFreeTimerWheel(
+    PVM_SOCK_TIMER_WHEEL             pWheel
+    )
+{
+    if (pWheel)
+    {
+        if (pWheel->pSlots)
+        {
+            VmRESTFreeMemory(pWheel->pSlots);
+            pWheel->pSlots = NULL;
+        }
+        if (pWheel->pMutex)
+        {
+            VmRESTFreeMutex(pWheel->pMutex);
+            pWheel->pMutex = NULL;
+        }
+        pWheel->nArmed = 0;
+        pWheel->pExpired = NULL;
+    }
+}
+
+uint32_t
+VmSockPosixArmTimer(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket,
+    int                              milliSec
+    )
+{
+    uint32_t                         dwError = REST_ENGINE_SUCCESS;
+    PVM_SOCK_TIMER_WHEEL             pWheel = NULL;
+    uint64_t                         nowMS = 0;
+    uint32_t                         nTicks = 0;
+
+    if (!pRESTHandle || !pSocket || !pSocket->pEventQueue || (milliSec <= 0))
+    {
+        VMREST_LOG_ERROR(pRESTHandle,"%s","Invalid params");
+        dwError = ERROR_INVALID_PARAMETER;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    pWheel = &pSocket->pEventQueue->timerWheel;
+
+    /**** One extra tick so that a connection never expires before its full timeout ****/
+    nTicks = ((milliSec + VM_SOCK_POSIX_TIMER_WHEEL_TICK_MS - 1) / VM_SOCK_POSIX_TIMER_WHEEL_TICK_MS) + 1;
+
+    VmSockPosixLockTimerWheel(pWheel);
+
+    if (pSocket->bTimerArmed)
+    {
+        VmSockPosixTimerWheelUnlink(pWheel, pSocket);
+    }
+
+    nowMS = VmSockPosixGetTimeMS();
+
+    if (pWheel->nArmed == 0)
+    {
+        /**** Wheel was idle, restart ticking from now ****/
+        pWheel->nextTickMS = nowMS + VM_SOCK_POSIX_TIMER_WHEEL_TICK_MS;
+    }
+    else if (nowMS >= pWheel->nextTickMS)
+    {
+        /**** Wheel lags behind, count from the slot it catches up to next, not from the one it stopped at ****/
+        nTicks += (uint32_t)((nowMS - pWheel->nextTickMS) / VM_SOCK_POSIX_TIMER_WHEEL_TICK_MS) + 1;
+    }
+
+    pSocket->timerSlot = (pWheel->iSlot + nTicks) % pWheel->nSlots;
+    pSocket->timerRounds = (nTicks - 1) / pWheel->nSlots;
+    pSocket->pTimerPrev = NULL;
+    pSocket->pTimerNext = pWheel->pSlots[pSocket->timerSlot];
+    if (pSocket->pTimerNext)
+    {
+        pSocket->pTimerNext->pTimerPrev = pSocket;
+    }
+    pWheel->pSlots[pSocket->timerSlot] = pSocket;
+    pSocket->bTimerArmed = TRUE;
+    pWheel->nArmed++;
+
+    VmSockPosixUnlockTimerWheel(pWheel);
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+void
+VmSockPosixDisarmTimer(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCKET                       pSocket
+    )
+{
+    PVM_SOCK_TIMER_WHEEL             pWheel = NULL;
+
+    if (!pSocket || !pSocket->pEventQueue)
+    {
+        return;
+    }
+
+    pWheel = &pSocket->pEventQueue->timerWheel;
+
+    VmSockPosixLockTimerWheel(pWheel);
+
+    if (pSocket->bTimerArmed)
+    {
+        VmSockPosixTimerWheelUnlink(pWheel, pSocket);
+    }
+
+    VmSockPosixUnlockTimerWheel(pWheel);
+}
+
+int
+VmSockPosixGetTimerWaitMS(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCK_EVENT_QUEUE             pQueue
+    )
+{
+    PVM_SOCK_TIMER_WHEEL             pWheel = &pQueue->timerWheel;
+    uint64_t                         nowMS = 0;
+    int                              waitMS = 0;
+
+    VmSockPosixLockTimerWheel(pWheel);
+
+    if (pWheel->nArmed == 0)
+    {
+        /**** Any timer armed from now on expires after a full connection timeout at the earliest ****/
+        waitMS = (int)(pRESTHandle->pRESTConfig->connTimeoutSec * 1000);
+    }
+    else
+    {
+        nowMS = VmSockPosixGetTimeMS();
+        waitMS = (pWheel->nextTickMS > nowMS) ? (int)(pWheel->nextTickMS - nowMS) : 0;
+    }
+
+    VmSockPosixUnlockTimerWheel(pWheel);
+
+    return waitMS;
+}
+
+uint32_t
+VmSockPosixExpireTimers(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCK_EVENT_QUEUE             pQueue
+    )
+{
+    PVM_SOCK_TIMER_WHEEL             pWheel = &pQueue->timerWheel;
+    PVM_SOCKET                       pSocket = NULL;
+    PVM_SOCKET                       pNext = NULL;
+    uint64_t                         nowMS = 0;
+    uint32_t                         nExpired = 0;
+
+    VmSockPosixLockTimerWheel(pWheel);
+
+    if (pWheel->nArmed > 0)
+    {
+        nowMS = VmSockPosixGetTimeMS();
+
+        while ((pWheel->nArmed > 0) && (nowMS >= pWheel->nextTickMS))
+        {
+            pWheel->iSlot = (pWheel->iSlot + 1) % pWheel->nSlots;
+            pWheel->nextTickMS += VM_SOCK_POSIX_TIMER_WHEEL_TICK_MS;
+
+            pSocket = pWheel->pSlots[pWheel->iSlot];
+            while (pSocket)
+            {
+                pNext = pSocket->pTimerNext;
+                if (pSocket->timerRounds > 0)
+                {
+                    pSocket->timerRounds--;
+                }
+                else
+                {
+                    VmSockPosixTimerWheelUnlink(pWheel, pSocket);
+
+                    /**** Stop further notification, socket is handed out as timed out ****/
+                    if (VmSockPosixDeleteEventFromQueue(pRESTHandle, pQueue, pSocket) != REST_ENGINE_SUCCESS)
+                    {
+                        VMREST_LOG_WARNING(pRESTHandle,"Delete of timed out socket fd %d from event queue failed", pSocket->fd);
+                    }
+                    pSocket->bTimerExpired = TRUE;
+                    pSocket->pTimerNext = pWheel->pExpired;
+                    pWheel->pExpired = pSocket;
+                    nExpired++;
+
+                    VMREST_LOG_DEBUG(pRESTHandle,"Timeout found for IoSocket fd %d", pSocket->fd);
+                }
+                pSocket = pNext;
+            }
+        }
+    }
+
+    VmSockPosixUnlockTimerWheel(pWheel);
+
+    return nExpired;
+}
+
+PVM_SOCKET
+VmSockPosixGetExpiredTimer(
+    PVM_SOCK_EVENT_QUEUE             pQueue
+    )
+{
+    PVM_SOCK_TIMER_WHEEL             pWheel = &pQueue->timerWheel;
+    PVM_SOCKET                       pSocket = NULL;
+
+    VmSockPosixLockTimerWheel(pWheel);
+
+    pSocket = pWheel->pExpired;
+    if (pSocket)
+    {
+        pWheel->pExpired = pSocket->pTimerNext;
+        pSocket->pTimerNext = NULL;
+    }
+
+    VmSockPosixUnlockTimerWheel(pWheel);
+
+    return pSocket;
+}
+
+static
+void
+VmSockPosixTimerWheelUnlink(
+    PVM_SOCK_TIMER_WHEEL             pWheel,
+    PVM_SOCKET                       pSocket
+    )
+{
+    if (pSocket->pTimerPrev)
+    {
+        pSocket->pTimerPrev->pTimerNext = pSocket->pTimerNext;
+    }
+    else
+    {
+        pWheel->pSlots[pSocket->timerSlot] = pSocket->pTimerNext;
+    }
+    if (pSocket->pTimerNext)
+    {
+        pSocket->pTimerNext->pTimerPrev = pSocket->pTimerPrev;
+    }
+
+    pSocket->pTimerNext = NULL;
+    pSocket->pTimerPrev = NULL;
+    pSocket->bTimerArmed = FALSE;
+    pWheel->nArmed--;
+}
+
+static
+uint64_t
+VmSockPosixGetTimeMS(
+    void
+    )
+{
+    struct timespec                  ts = {0};
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+
+    return ((uint64_t)ts.tv_sec * 1000) + (ts.tv_nsec / 1000000);
+}
+
+static
+void
+VmSockPosixLockTimerWheel(
+    PVM_SOCK_TIMER_WHEEL             pWheel
+    )
+{
+    if (pWheel->pMutex)
+    {
+        VmRESTLockMutex(pWheel->pMutex);
+    }
+}
+
+static
+void
+VmSockPosixUnlockTimerWheel(
+    PVM_SOCK_TIMER_WHEEL             pWheel
+    )
+{
+    if (pWheel->pMutex)
+    {
+        VmRESTUnlockMutex(pWheel->pMutex);
+    }
+}
@@ -0,0 +1,999 @@
+/* C-REST-Engine
+*
+* Copyright (c) 2017 VMware, Inc. All Rights Reserved.
+*
+* This product is licensed to you under the Apache 2.0 license (the "License").
+* You may not use this product except in compliance with the Apache 2.0 License.
+*
+* This product may include a number of subcomponents with separate copyright
+* notices and license terms. Your use of these subcomponents is subject to the
+* terms and conditions of the subcomponent's license, as noted in the LICENSE file.
+*
+*/
+
+/**** io_uring driven event queue, the rest of the posix package is shared ****/
+
+#include "includes.h"
+
+#ifdef HAVE_LINUX_IO_URING_H
+
+static
+DWORD
+VmSockUringProbe(
+    VOID
+    );
+
+static
+struct io_uring_sqe*
+VmSockUringGetSqe(
+    PVM_SOCK_URING                   pRing
+    );
+
+static
+VOID
+VmSockUringPushSqe(
+    PVM_SOCK_URING                   pRing
+    );
+
+static
+DWORD
+VmSockUringSubmit(
+    PVM_SOCK_URING                   pRing
+    );
+
+static
+uint32_t
+VmSockUringGetUnsubmitted(
+    PVM_SOCK_URING                   pRing
+    );
+
+static
+DWORD
+VmSockUringPrepWatch(
+    PVM_SOCK_URING                   pRing,
+    PVM_SOCKET                       pSocket,
+    uint32_t                         events
+    );
+
+static
+DWORD
+VmSockUringSetupBufRing(
+    PVM_SOCK_URING                   pRing
+    );
+
+static
+VOID
+VmSockUringRecycleBuf(
+    PVM_SOCK_URING                   pRing,
+    uint16_t                         bufId
+    );
+
+DWORD
+VmSockUringInitialize(
+    PVM_SOCK_PACKAGE*                ppPackage
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+
+    dwError = VmSockUringProbe();
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTGetSockPackagePosix(ppPackage);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    (*ppPackage)->pfnCreateEventQueue = &VmSockUringCreateEventQueue;
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+DWORD
+VmSockUringCreateEventQueue(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCK_EVENT_QUEUE*            ppQueue
+    )
+{
+    return VmSockPosixCreateEventQueueEx(pRESTHandle, TRUE, ppQueue);
+}
+
+DWORD
+VmSockUringCreate(
+    PVM_SOCK_URING*                  ppRing,
+    uint32_t                         nEntries,
+    BOOLEAN                          bDataOps
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    PVM_SOCK_URING                   pRing = NULL;
+    struct io_uring_params           params = {0};
+
+    if (!ppRing || (nEntries == 0))
+    {
+        dwError = ERROR_INVALID_PARAMETER;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    dwError = VmRESTAllocateMemory(
+                  sizeof(*pRing),
+                  (PVOID*)&pRing
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    pRing->ringFd = INVALID;
+    pRing->pSqRing = MAP_FAILED;
+    pRing->pCqRing = MAP_FAILED;
+    pRing->pSqes = MAP_FAILED;
+    pRing->pBufRing = MAP_FAILED;
+
+    /**** Ring is shared with threads arming sockets, even for a per worker queue ****/
+    dwError = VmRESTAllocateMutex(&pRing->pMutex);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    pRing->ringFd = (int)syscall(__NR_io_uring_setup, nEntries, &params);
+    if (pRing->ringFd < 0)
+    {
+        dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    pRing->sqRingSize = params.sq_off.array + (params.sq_entries * sizeof(uint32_t));
+    pRing->cqRingSize = params.cq_off.cqes + (params.cq_entries * sizeof(struct io_uring_cqe));
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        if (pRing->cqRingSize > pRing->sqRingSize)
+        {
+            pRing->sqRingSize = pRing->cqRingSize;
+        }
+        pRing->cqRingSize = pRing->sqRingSize;
+    }
+
+    pRing->pSqRing = mmap(NULL, pRing->sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, pRing->ringFd, IORING_OFF_SQ_RING);
+    if (pRing->pSqRing == MAP_FAILED)
+    {
+        dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    if (params.features & IORING_FEAT_SINGLE_MMAP)
+    {
+        pRing->pCqRing = pRing->pSqRing;
+    }
+    else
+    {
+        pRing->pCqRing = mmap(NULL, pRing->cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, pRing->ringFd, IORING_OFF_CQ_RING);
+        if (pRing->pCqRing == MAP_FAILED)
+        {
+            dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
+            BAIL_ON_VMREST_ERROR(dwError);
+        }
+    }
+
+    pRing->sqesSize = params.sq_entries * sizeof(struct io_uring_sqe);
+    pRing->pSqes = mmap(NULL, pRing->sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, pRing->ringFd, IORING_OFF_SQES);
+    if (pRing->pSqes == MAP_FAILED)
+    {
+        dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    pRing->pSqHead = (uint32_t*)((char*)pRing->pSqRing + params.sq_off.head);
+    pRing->pSqTail = (uint32_t*)((char*)pRing->pSqRing + params.sq_off.tail);
+    pRing->pSqMask = (uint32_t*)((char*)pRing->pSqRing + params.sq_off.ring_mask);
+    pRing->pSqEntries = (uint32_t*)((char*)pRing->pSqRing + params.sq_off.ring_entries);
+    pRing->pSqArray = (uint32_t*)((char*)pRing->pSqRing + params.sq_off.array);
+    pRing->pCqHead = (uint32_t*)((char*)pRing->pCqRing + params.cq_off.head);
+    pRing->pCqTail = (uint32_t*)((char*)pRing->pCqRing + params.cq_off.tail);
+    pRing->pCqMask = (uint32_t*)((char*)pRing->pCqRing + params.cq_off.ring_mask);
+    pRing->pCqes = (char*)pRing->pCqRing + params.cq_off.cqes;
+
+    /**** Without provided buffers plain connections stay on polls like TLS ones ****/
+    if (bDataOps && (VmSockUringSetupBufRing(pRing) == REST_ENGINE_SUCCESS))
+    {
+        pRing->bDataOps = TRUE;
+    }
+
+    *ppRing = pRing;
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    if (ppRing)
+    {
+        *ppRing = NULL;
+    }
+
+    VmSockUringFree(pRing);
+
+    goto cleanup;
+}
+
+VOID
+VmSockUringFree(
+    PVM_SOCK_URING                   pRing
+    )
+{
+    struct io_uring_buf_reg          reg = {0};
+
+    if (!pRing)
+    {
+        return;
+    }
+
+    /**** Kernel stops picking receive buffers before they are freed ****/
+    if (pRing->bDataOps)
+    {
+        reg.bgid = VM_SOCK_URING_RECV_BUF_GROUP;
+        syscall(__NR_io_uring_register, pRing->ringFd, IORING_UNREGISTER_PBUF_RING, &reg, 1);
+    }
+
+    if (pRing->pSqes != MAP_FAILED)
+    {
+        munmap(pRing->pSqes, pRing->sqesSize);
+    }
+    if ((pRing->pCqRing != MAP_FAILED) && (pRing->pCqRing != pRing->pSqRing))
+    {
+        munmap(pRing->pCqRing, pRing->cqRingSize);
+    }
+    if (pRing->pSqRing != MAP_FAILED)
+    {
+        munmap(pRing->pSqRing, pRing->sqRingSize);
+    }
+    if (pRing->ringFd >= 0)
+    {
+        close(pRing->ringFd);
+    }
+    if (pRing->pBufRing != MAP_FAILED)
+    {
+        munmap(pRing->pBufRing, pRing->bufRingSize);
+    }
+    if (pRing->pRecvBufs)
+    {
+        VmRESTFreeMemory(pRing->pRecvBufs);
+    }
+    if (pRing->pMutex)
+    {
+        VmRESTFreeMutex(pRing->pMutex);
+    }
+
+    VmRESTFreeMemory(pRing);
+}
+
+DWORD
+VmSockUringWatch(
+    PVM_SOCK_EVENT_QUEUE             pQueue,
+    PVM_SOCKET                       pSocket,
+    uint32_t                         events
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    PVM_SOCK_URING                   pRing = NULL;
+    BOOLEAN                          bLocked = FALSE;
+
+    if (!pQueue || !pQueue->pRing || !pSocket)
+    {
+        dwError = ERROR_INVALID_PARAMETER;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    pRing = pQueue->pRing;
+
+    dwError = VmRESTLockMutex(pRing->pMutex);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    bLocked = TRUE;
+
+    dwError = VmSockUringPrepWatch(
+                  pRing,
+                  pSocket,
+                  events
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    /**** Owner of a per worker queue submits its re-arms along with the next wait ****/
+    if (!pQueue->bExclusive)
+    {
+        dwError = VmSockUringSubmit(pRing);
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+cleanup:
+
+    if (bLocked)
+    {
+        VmRESTUnlockMutex(pRing->pMutex);
+    }
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+DWORD
+VmSockUringUnwatch(
+    PVM_SOCK_EVENT_QUEUE             pQueue,
+    PVM_SOCKET                       pSocket
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    PVM_SOCK_URING                   pRing = NULL;
+    struct io_uring_sqe*             pSqe = NULL;
+    BOOLEAN                          bLocked = FALSE;
+
+    if (!pQueue || !pQueue->pRing || !pSocket)
+    {
+        dwError = ERROR_INVALID_PARAMETER;
+    }
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    pRing = pQueue->pRing;
+
+    dwError = VmRESTLockMutex(pRing->pMutex);
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    bLocked = TRUE;
+
+    if (pSocket->bPollArmed)
+    {
+        pSqe = VmSockUringGetSqe(pRing);
+        if (!pSqe)
+        {
+            dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
+            BAIL_ON_VMREST_ERROR(dwError);
+        }
+
+        /**** Cancelled request still completes, the socket stays alive until then ****/
+        pSqe->opcode = (pSocket->uringOp == IORING_OP_POLL_ADD) ? IORING_OP_POLL_REMOVE : IORING_OP_ASYNC_CANCEL;
+        pSqe->fd = -1;
+        pSqe->addr = (uint64_t)(uintptr_t)pSocket;
+        pSqe->user_data = 0;
+        VmSockUringPushSqe(pRing);
+
+        dwError = VmSockUringSubmit(pRing);
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+cleanup:
+
+    if (bLocked)
+    {
+        VmRESTUnlockMutex(pRing->pMutex);
+    }
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+int
+VmSockUringWaitForEvents(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCK_EVENT_QUEUE             pQueue,
+    int                              iTimeoutMS
+    )
+{
+    PVM_SOCK_URING                   pRing = pQueue->pRing;
+    struct io_uring_getevents_arg    arg = {0};
+    struct __kernel_timespec         ts = {0};
+    struct io_uring_cqe*             pCqe = NULL;
+    PVM_SOCKET                       pSocket = NULL;
+    PVM_SOCKET                       pRelease = NULL;
+    uint32_t                         nSubmit = 0;
+    uint32_t                         head = 0;
+    uint32_t                         tail = 0;
+    int                              nReady = 0;
+    int                              ret = 0;
+
+    if (iTimeoutMS >= 0)
+    {
+        ts.tv_sec = iTimeoutMS / 1000;
+        ts.tv_nsec = (iTimeoutMS % 1000) * 1000000;
+        arg.ts = (uint64_t)(uintptr_t)&ts;
+    }
+
+    VmRESTLockMutex(pRing->pMutex);
+    nSubmit = VmSockUringGetUnsubmitted(pRing);
+    VmRESTUnlockMutex(pRing->pMutex);
+
+    /**** Queued re-arms go in with the wait, one syscall for both ****/
+    ret = (int)syscall(
+                   __NR_io_uring_enter,
+                   pRing->ringFd,
+                   nSubmit,
+                   1,
+                   IORING_ENTER_GETEVENTS | IORING_ENTER_EXT_ARG,
+                   &arg,
+                   sizeof(arg)
+                   );
+    if ((ret < 0) && (errno != ETIME) && (errno != EINTR))
+    {
+        return -1;
+    }
+
+    VmRESTLockMutex(pRing->pMutex);
+
+    head = *pRing->pCqHead;
+    tail = __atomic_load_n(pRing->pCqTail, __ATOMIC_ACQUIRE);
+
+    while ((head != tail) && (nReady < (int)pQueue->dwSize))
+    {
+        pCqe = &((struct io_uring_cqe*)pRing->pCqes)[head & *pRing->pCqMask];
+        head++;
+
+        pSocket = (PVM_SOCKET)(uintptr_t)pCqe->user_data;
+        if (!pSocket)
+        {
+            /**** Completion of a cancel request ****/
+            continue;
+        }
+
+        if (pSocket->type == VM_SOCK_TYPE_LISTENER)
+        {
+            if (pCqe->res >= 0)
+            {
+                pQueue->pEventArray[nReady].events = EPOLLIN;
+                pQueue->pEventArray[nReady].data.ptr = pSocket;
+                pQueue->pAcceptFd[nReady] = pCqe->res;
+                nReady++;
+            }
+            else if (pCqe->res != -ECANCELED)
+            {
+                VMREST_LOG_WARNING(pRESTHandle,"Multishot accept on listener fd %d failed with error %d", pSocket->fd, -pCqe->res);
+            }
+
+            /**** Multishot accept ended on its own, start it again ****/
+            if (!(pCqe->flags & IORING_CQE_F_MORE))
+            {
+                pSocket->bPollArmed = FALSE;
+                if ((pCqe->res != -ECANCELED) &&
+                    (VmSockUringPrepWatch(pRing, pSocket, EPOLLIN) != REST_ENGINE_SUCCESS))
+                {
+                    VMREST_LOG_ERROR(pRESTHandle,"Unable to restart accept on listener fd %d", pSocket->fd);
+                }
+            }
+            continue;
+        }
+
+        pSocket->bPollArmed = FALSE;
+
+        if (pSocket->bReleasePending || pSocket->bTimerExpired)
+        {
+            /**** Nobody reads what arrived for a connection on its way out ****/
+            if (pCqe->flags & IORING_CQE_F_BUFFER)
+            {
+                VmSockUringRecycleBuf(pRing, (uint16_t)(pCqe->flags >> IORING_CQE_BUFFER_SHIFT));
+            }
+        }
+
+        if (pSocket->bReleasePending)
+        {
+            /**** Owner let go while the poll was in flight, free it once out of the lock ****/
+            pSocket->bReleasePending = FALSE;
+            pSocket->pTimerNext = pRelease;
+            pRelease = pSocket;
+            continue;
+        }
+        else if (pSocket->bTimerExpired)
+        {
+            continue;
+        }
+
+        if (pSocket->uringOp == IORING_OP_RECV)
+        {
+            /**** Data waits in the ring buffer until read, end of stream and no free buffer are left to read() ****/
+            if ((pCqe->res > 0) && (pCqe->flags & IORING_CQE_F_BUFFER))
+            {
+                pSocket->uringBufId = (uint16_t)(pCqe->flags >> IORING_CQE_BUFFER_SHIFT);
+                pSocket->nUringRecv = (uint32_t)pCqe->res;
+                pQueue->pEventArray[nReady].events = EPOLLIN;
+            }
+            else
+            {
+                pQueue->pEventArray[nReady].events = ((pCqe->res == 0) || (pCqe->res == -ENOBUFS)) ? EPOLLIN : EPOLLERR;
+            }
+        }
+        else if (pSocket->uringOp == IORING_OP_SEND)
+        {
+            /**** Flush accounts for what the ring sent instead of sending again ****/
+            if ((pCqe->res >= 0) || (pCqe->res == -EAGAIN))
+            {
+                pSocket->nUringSent = (pCqe->res > 0) ? (uint32_t)pCqe->res : 0;
+                pSocket->bUringSendDone = TRUE;
+                pQueue->pEventArray[nReady].events = EPOLLOUT;
+            }
+            else
+            {
+                pQueue->pEventArray[nReady].events = EPOLLERR;
+            }
+        }
+        else
+        {
+            pQueue->pEventArray[nReady].events = (pCqe->res < 0) ? EPOLLERR : (uint32_t)pCqe->res;
+        }
+        pQueue->pEventArray[nReady].data.ptr = pSocket;
+        nReady++;
+    }
+
+    __atomic_store_n(pRing->pCqHead, head, __ATOMIC_RELEASE);
+
+    VmRESTUnlockMutex(pRing->pMutex);
+
+    while (pRelease)
+    {
+        pSocket = pRelease;
+        pRelease = pSocket->pTimerNext;
+        pSocket->pTimerNext = NULL;
+        VmSockPosixReleaseSocket(pRESTHandle, pSocket);
+    }
+
+    return nReady;
+}
+
+BOOLEAN
+VmSockUringDeferRelease(
+    PVM_SOCKET                       pSocket
+    )
+{
+    PVM_SOCK_URING                   pRing = NULL;
+    BOOLEAN                          bDeferred = FALSE;
+
+    if (!pSocket || (pSocket->type != VM_SOCK_TYPE_SERVER) ||
+        !pSocket->pEventQueue || !pSocket->pEventQueue->pRing)
+    {
+        return FALSE;
+    }
+
+    pRing = pSocket->pEventQueue->pRing;
+
+    VmRESTLockMutex(pRing->pMutex);
+    if (pSocket->bPollArmed)
+    {
+        pSocket->bReleasePending = TRUE;
+        bDeferred = TRUE;
+    }
+    VmRESTUnlockMutex(pRing->pMutex);
+
+    return bDeferred;
+}
+
+BOOLEAN
+VmSockUringHasDataOps(
+    PVM_SOCKET                       pSocket
+    )
+{
+    return (pSocket && (pSocket->type == VM_SOCK_TYPE_SERVER) &&
+            pSocket->pEventQueue && pSocket->pEventQueue->pRing &&
+            pSocket->pEventQueue->pRing->bDataOps);
+}
+
+uint32_t
+VmSockUringTakeRecv(
+    PVM_SOCKET                       pSocket,
+    char*                            pszBuffer
+    )
+{
+    PVM_SOCK_URING                   pRing = NULL;
+    uint32_t                         nRecv = 0;
+
+    if (!VmSockUringHasDataOps(pSocket) || (pSocket->nUringRecv == 0))
+    {
+        return 0;
+    }
+
+    pRing = pSocket->pEventQueue->pRing;
+    nRecv = pSocket->nUringRecv;
+    pSocket->nUringRecv = 0;
+
+    /**** No destination drops the data ****/
+    if (pszBuffer)
+    {
+        memcpy(pszBuffer, (pRing->pRecvBufs + ((size_t)pSocket->uringBufId * VM_SOCK_URING_RECV_BUF_SIZE)), nRecv);
+    }
+    else
+    {
+        nRecv = 0;
+    }
+
+    VmRESTLockMutex(pRing->pMutex);
+    VmSockUringRecycleBuf(pRing, pSocket->uringBufId);
+    VmRESTUnlockMutex(pRing->pMutex);
+
+    return nRecv;
+}
+
+static
+DWORD
+VmSockUringProbe(
+    VOID
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    struct io_uring_params           params = {0};
+    struct io_uring_probe*           pProbe = NULL;
+    int                              fd = INVALID;
+    uint32_t                         iOp = 0;
+    uint8_t                          ops[] = {
+                                         IORING_OP_POLL_ADD,
+                                         IORING_OP_POLL_REMOVE,
+                                         IORING_OP_ACCEPT,
+                                         IORING_OP_ASYNC_CANCEL,
+                                         IORING_OP_SOCKET,
+                                         IORING_OP_RECV,
+                                         IORING_OP_SEND
+                                         };
+
+    fd = (int)syscall(__NR_io_uring_setup, 2, &params);
+    if (fd < 0)
+    {
+        dwError = ERROR_NOT_SUPPORTED;
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    if (!(params.features & IORING_FEAT_EXT_ARG) || !(params.features & IORING_FEAT_NODROP))
+    {
+        dwError = ERROR_NOT_SUPPORTED;
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    dwError = VmRESTAllocateMemory(
+                  sizeof(*pProbe) + (256 * sizeof(struct io_uring_probe_op)),
+                  (PVOID*)&pProbe
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, pProbe, 256) < 0)
+    {
+        dwError = ERROR_NOT_SUPPORTED;
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    /**** IORING_OP_SOCKET came with multishot accept (5.19), it stands in for the latter ****/
+    for (iOp = 0; iOp < (sizeof(ops) / sizeof(ops[0])); iOp++)
+    {
+        if ((ops[iOp] > pProbe->last_op) || !(pProbe->ops[ops[iOp]].flags & IO_URING_OP_SUPPORTED))
+        {
+            dwError = ERROR_NOT_SUPPORTED;
+            BAIL_ON_VMREST_ERROR(dwError);
+        }
+    }
+
+cleanup:
+
+    if (pProbe)
+    {
+        VmRESTFreeMemory(pProbe);
+    }
+    if (fd >= 0)
+    {
+        close(fd);
+    }
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+static
+struct io_uring_sqe*
+VmSockUringGetSqe(
+    PVM_SOCK_URING                   pRing
+    )
+{
+    struct io_uring_sqe*             pSqe = NULL;
+
+    /**** Ring full, push what is queued to make room ****/
+    if (VmSockUringGetUnsubmitted(pRing) >= *pRing->pSqEntries)
+    {
+        if ((VmSockUringSubmit(pRing) != REST_ENGINE_SUCCESS) ||
+            (VmSockUringGetUnsubmitted(pRing) >= *pRing->pSqEntries))
+        {
+            return NULL;
+        }
+    }
+
+    pSqe = &((struct io_uring_sqe*)pRing->pSqes)[*pRing->pSqTail & *pRing->pSqMask];
+    memset(pSqe, 0, sizeof(*pSqe));
+
+    return pSqe;
+}
+
+static
+VOID
+VmSockUringPushSqe(
+    PVM_SOCK_URING                   pRing
+    )
+{
+    uint32_t                         tail = *pRing->pSqTail;
+
+    /**** Entry becomes visible to a concurrent submit only once it is filled ****/
+    pRing->pSqArray[tail & *pRing->pSqMask] = tail & *pRing->pSqMask;
+    __atomic_store_n(pRing->pSqTail, tail + 1, __ATOMIC_RELEASE);
+}
+
+static
+DWORD
+VmSockUringSubmit(
+    PVM_SOCK_URING                   pRing
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    uint32_t                         nSubmit = 0;
+
+    /**** A waiter may be submitting the same entries, go by what the kernel consumed ****/
+    while ((nSubmit = VmSockUringGetUnsubmitted(pRing)) > 0)
+    {
+        if ((syscall(__NR_io_uring_enter, pRing->ringFd, nSubmit, 0, 0, NULL, 0) < 0) && (errno != EINTR))
+        {
+            dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
+            BAIL_ON_VMREST_ERROR(dwError);
+        }
+    }
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+static
+uint32_t
+VmSockUringGetUnsubmitted(
+    PVM_SOCK_URING                   pRing
+    )
+{
+    return *pRing->pSqTail - __atomic_load_n(pRing->pSqHead, __ATOMIC_ACQUIRE);
+}
+
+static
+DWORD
+VmSockUringPrepWatch(
+    PVM_SOCK_URING                   pRing,
+    PVM_SOCKET                       pSocket,
+    uint32_t                         events
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    struct io_uring_sqe*             pSqe = NULL;
+
+    pSqe = VmSockUringGetSqe(pRing);
+    if (!pSqe)
+    {
+        dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    pSqe->fd = pSocket->fd;
+    pSqe->user_data = (uint64_t)(uintptr_t)pSocket;
+
+    if (pSocket->type == VM_SOCK_TYPE_LISTENER)
+    {
+        /**** One request keeps accepting, completions carry the new fd ****/
+        pSqe->opcode = IORING_OP_ACCEPT;
+        pSqe->ioprio = IORING_ACCEPT_MULTISHOT;
+        pSqe->accept_flags = SOCK_CLOEXEC;
+    }
+    else if (VmSockUringHasDataOps(pSocket) && (events == EPOLLIN))
+    {
+        /**** Kernel picks a ring buffer when data arrives, no poll then read ****/
+        pSqe->opcode = IORING_OP_RECV;
+        pSqe->flags = IOSQE_BUFFER_SELECT;
+        pSqe->buf_group = VM_SOCK_URING_RECV_BUF_GROUP;
+        pSqe->len = VM_SOCK_URING_RECV_BUF_SIZE;
+    }
+    else if (VmSockUringHasDataOps(pSocket) && (events == EPOLLOUT) &&
+             (pSocket->nOutData > pSocket->nOutSent))
+    {
+        /**** Queued response leaves with the next submit, the queue is left alone until it completes ****/
+        pSqe->opcode = IORING_OP_SEND;
+        pSqe->addr = (uint64_t)(uintptr_t)(pSocket->pszOutBuf + pSocket->nOutSent);
+        pSqe->len = pSocket->nOutData - pSocket->nOutSent;
+        pSqe->msg_flags = MSG_NOSIGNAL;
+    }
+    else
+    {
+        /**** One shot, like EPOLLONESHOT on the epoll queue ****/
+        pSqe->opcode = IORING_OP_POLL_ADD;
+        pSqe->poll32_events = events;
+    }
+
+    VmSockUringPushSqe(pRing);
+    pSocket->uringOp = pSqe->opcode;
+    pSocket->bPollArmed = TRUE;
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    goto cleanup;
+}
+
+static
+DWORD
+VmSockUringSetupBufRing(
+    PVM_SOCK_URING                   pRing
+    )
+{
+    DWORD                            dwError = REST_ENGINE_SUCCESS;
+    struct io_uring_buf_reg          reg = {0};
+    uint16_t                         bufId = 0;
+
+    /**** Ring entries are shared with the kernel and have to be page aligned ****/
+    pRing->bufRingSize = VM_SOCK_URING_RECV_BUF_COUNT * sizeof(struct io_uring_buf);
+    pRing->pBufRing = mmap(NULL, pRing->bufRingSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_POPULATE, -1, 0);
+    if (pRing->pBufRing == MAP_FAILED)
+    {
+        dwError = VM_SOCK_POSIX_ERROR_SYS_CALL_FAILED;
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    dwError = VmRESTAllocateMemory(
+                  VM_SOCK_URING_RECV_BUF_COUNT * VM_SOCK_URING_RECV_BUF_SIZE,
+                  (PVOID*)&pRing->pRecvBufs
+                  );
+    BAIL_ON_VMREST_ERROR(dwError);
+
+    reg.ring_addr = (uint64_t)(uintptr_t)pRing->pBufRing;
+    reg.ring_entries = VM_SOCK_URING_RECV_BUF_COUNT;
+    reg.bgid = VM_SOCK_URING_RECV_BUF_GROUP;
+
+    if (syscall(__NR_io_uring_register, pRing->ringFd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0)
+    {
+        dwError = ERROR_NOT_SUPPORTED;
+        BAIL_ON_VMREST_ERROR(dwError);
+    }
+
+    for (bufId = 0; bufId < VM_SOCK_URING_RECV_BUF_COUNT; bufId++)
+    {
+        VmSockUringRecycleBuf(pRing, bufId);
+    }
+
+cleanup:
+
+    return dwError;
+
+error:
+
+    if (pRing->pBufRing != MAP_FAILED)
+    {
+        munmap(pRing->pBufRing, pRing->bufRingSize);
+        pRing->pBufRing = MAP_FAILED;
+    }
+    if (pRing->pRecvBufs)
+    {
+        VmRESTFreeMemory(pRing->pRecvBufs);
+        pRing->pRecvBufs = NULL;
+    }
+
+    goto cleanup;
+}
+
+static
+VOID
+VmSockUringRecycleBuf(
+    PVM_SOCK_URING                   pRing,
+    uint16_t                         bufId
+    )
+{
+    struct io_uring_buf_ring*        pBufRing = (struct io_uring_buf_ring*)pRing->pBufRing;
+    struct io_uring_buf*             pBuf = NULL;
+
+    pBuf = &pBufRing->bufs[pRing->bufRingTail & (VM_SOCK_URING_RECV_BUF_COUNT - 1)];
+    pBuf->addr = (uint64_t)(uintptr_t)(pRing->pRecvBufs + ((size_t)bufId * VM_SOCK_URING_RECV_BUF_SIZE));
+    pBuf->len = VM_SOCK_URING_RECV_BUF_SIZE;
+    pBuf->bid = bufId;
+    pRing->bufRingTail++;
+
+    /**** Kernel sees the entry once the tail moves past it ****/
+    __atomic_store_n(&pBufRing->tail, pRing->bufRingTail, __ATOMIC_RELEASE);
+}
+
+#else
+
+DWORD
+VmSockUringInitialize(
+    PVM_SOCK_PACKAGE*                ppPackage
+    )
+{
+    return ERROR_NOT_SUPPORTED;
+}
+
+DWORD
+VmSockUringCreateEventQueue(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCK_EVENT_QUEUE*            ppQueue
+    )
+{
+    return ERROR_NOT_SUPPORTED;
+}
+
+DWORD
+VmSockUringCreate(
+    PVM_SOCK_URING*                  ppRing,
+    uint32_t                         nEntries,
+    BOOLEAN                          bDataOps
+    )
+{
+    return ERROR_NOT_SUPPORTED;
+}
+
+VOID
+VmSockUringFree(
+    PVM_SOCK_URING                   pRing
+    )
+{
+}
+
+DWORD
+VmSockUringWatch(
+    PVM_SOCK_EVENT_QUEUE             pQueue,
+    PVM_SOCKET                       pSocket,
+    uint32_t                         events
+    )
+{
+    return ERROR_NOT_SUPPORTED;
+}
+
+DWORD
+VmSockUringUnwatch(
+    PVM_SOCK_EVENT_QUEUE             pQueue,
+    PVM_SOCKET                       pSocket
+    )
+{
+    return ERROR_NOT_SUPPORTED;
+}
+
+int
+VmSockUringWaitForEvents(
+    PVMREST_HANDLE                   pRESTHandle,
+    PVM_SOCK_EVENT_QUEUE             pQueue,
+    int                              iTimeoutMS
+    )
+{
+    errno = ENOSYS;
+    return -1;
+}
+
+BOOLEAN
+VmSockUringDeferRelease(
+    PVM_SOCKET                       pSocket
+    )
+{
+    return FALSE;
+}
+
+BOOLEAN
+VmSockUringHasDataOps(
+    PVM_SOCKET                       pSocket
+    )
+{
+    return FALSE;
+}
+
+uint32_t
+VmSockUringTakeRecv(
+    PVM_SOCKET                       pSocket,
+    char*                            pszBuffer
+    )
+{
+    return 0;
+}
+
+#endif